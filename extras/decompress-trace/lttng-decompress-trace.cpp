@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Decompress a stream file written by a channel using packet compression
+ * and convert its CTF index 1.2 file to a CTF index 1.1 file.
+ */
+
+#define _LGPL_SOURCE
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <common/common.hpp>
+#include <common/compat/endian.hpp>
+#include <common/index/ctf-index.hpp>
+#include <common/index/packet-compression.hpp>
+#include <common/readwrite.hpp>
+
+int lttng_opt_quiet;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+/*
+ * Read and validate the header of a compressed stream's index file.
+ */
+static int read_index_header(int fd)
+{
+	int ret;
+	struct ctf_packet_index_file_hdr hdr;
+
+	ret = lttng_read(fd, &hdr, sizeof(hdr));
+	if (ret != (int) sizeof(hdr)) {
+		ERR("Failed to read index header");
+		ret = -1;
+		goto end;
+	}
+
+	if (be32toh(hdr.magic) != CTF_INDEX_MAGIC ||
+			be32toh(hdr.index_major) != CTF_INDEX_MAJOR ||
+			be32toh(hdr.index_minor) != CTF_INDEX_COMPRESSED_MINOR ||
+			be32toh(hdr.packet_index_len) !=
+					ctf_packet_index_len(CTF_INDEX_MAJOR,
+							CTF_INDEX_COMPRESSED_MINOR)) {
+		ERR("Not the index of a compressed stream (index version %u.%u)",
+				be32toh(hdr.index_major),
+				be32toh(hdr.index_minor));
+		ret = -1;
+		goto end;
+	}
+
+	ret = 0;
+end:
+	return ret;
+}
+
+static int write_index_header(int fd)
+{
+	int ret;
+	struct ctf_packet_index_file_hdr hdr;
+
+	hdr.magic = htobe32(CTF_INDEX_MAGIC);
+	hdr.index_major = htobe32(CTF_INDEX_MAJOR);
+	hdr.index_minor = htobe32(CTF_INDEX_MINOR);
+	hdr.packet_index_len = htobe32(
+			ctf_packet_index_len(CTF_INDEX_MAJOR, CTF_INDEX_MINOR));
+
+	ret = lttng_write(fd, &hdr, sizeof(hdr));
+	if (ret != (int) sizeof(hdr)) {
+		PERROR("Failed to write index header");
+		ret = -1;
+		goto end;
+	}
+
+	ret = 0;
+end:
+	return ret;
+}
+
+/*
+ * Decompress every packet listed in the index, appending them to the output
+ * stream file and their (uncompressed) index entry to the output index file.
+ */
+static int decompress_stream(int stream_fd, int index_fd,
+		int out_stream_fd, int out_index_fd)
+{
+	int ret;
+	uint64_t out_offset = 0;
+	struct lttng_dynamic_buffer compressed_packet;
+	struct lttng_dynamic_buffer packet;
+	const size_t entry_len = ctf_packet_index_len(
+			CTF_INDEX_MAJOR, CTF_INDEX_COMPRESSED_MINOR);
+	const size_t out_entry_len = ctf_packet_index_len(
+			CTF_INDEX_MAJOR, CTF_INDEX_MINOR);
+
+	lttng_dynamic_buffer_init(&compressed_packet);
+	lttng_dynamic_buffer_init(&packet);
+
+	for (;;) {
+		struct ctf_packet_index index;
+		struct lttng_buffer_view compressed;
+		uint64_t offset, compressed_size, packet_size;
+		ssize_t read_len;
+
+		read_len = lttng_read(index_fd, &index, entry_len);
+		if (read_len == 0) {
+			break;
+		} else if (read_len != (ssize_t) entry_len) {
+			ERR("Truncated index entry");
+			ret = -1;
+			goto end;
+		}
+
+		offset = be64toh(index.offset);
+		compressed_size = be64toh(index.compressed_size);
+		packet_size = be64toh(index.packet_size) / CHAR_BIT;
+
+		ret = lttng_dynamic_buffer_set_size(&compressed_packet,
+				compressed_size);
+		if (ret) {
+			ERR("Failed to allocate %" PRIu64 " bytes compressed packet buffer",
+					compressed_size);
+			goto end;
+		}
+
+		read_len = pread(stream_fd, compressed_packet.data,
+				compressed_size, (off_t) offset);
+		if (read_len < 0 || (uint64_t) read_len != compressed_size) {
+			PERROR("Failed to read compressed packet at offset %" PRIu64,
+					offset);
+			ret = -1;
+			goto end;
+		}
+
+		compressed = lttng_buffer_view_from_dynamic_buffer(
+				&compressed_packet, 0, compressed_size);
+		ret = lttng_packet_decompress(LTTNG_CHANNEL_COMPRESSION_ZSTD,
+				&compressed, packet_size, &packet);
+		if (ret) {
+			ERR("Failed to decompress packet at offset %" PRIu64,
+					offset);
+			goto end;
+		}
+
+		if (lttng_write(out_stream_fd, packet.data, packet_size) !=
+				(ssize_t) packet_size) {
+			PERROR("Failed to write decompressed packet");
+			ret = -1;
+			goto end;
+		}
+
+		index.offset = htobe64(out_offset);
+		if (lttng_write(out_index_fd, &index, out_entry_len) !=
+				(ssize_t) out_entry_len) {
+			PERROR("Failed to write index entry");
+			ret = -1;
+			goto end;
+		}
+
+		out_offset += packet_size;
+	}
+
+	ret = 0;
+end:
+	lttng_dynamic_buffer_reset(&compressed_packet);
+	lttng_dynamic_buffer_reset(&packet);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int ret = EXIT_FAILURE;
+	int stream_fd = -1, index_fd = -1;
+	int out_stream_fd = -1, out_index_fd = -1;
+	const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+
+	if (argc != 5) {
+		fprintf(stderr, "Usage: %s STREAM INDEX OUT-STREAM OUT-INDEX\n",
+				argv[0]);
+		goto end;
+	}
+
+	stream_fd = open(argv[1], O_RDONLY);
+	if (stream_fd < 0) {
+		PERROR("Failed to open stream file \"%s\"", argv[1]);
+		goto end;
+	}
+
+	index_fd = open(argv[2], O_RDONLY);
+	if (index_fd < 0) {
+		PERROR("Failed to open index file \"%s\"", argv[2]);
+		goto end;
+	}
+
+	if (read_index_header(index_fd)) {
+		goto end;
+	}
+
+	out_stream_fd = open(argv[3], O_WRONLY | O_CREAT | O_TRUNC, mode);
+	if (out_stream_fd < 0) {
+		PERROR("Failed to create stream file \"%s\"", argv[3]);
+		goto end;
+	}
+
+	out_index_fd = open(argv[4], O_WRONLY | O_CREAT | O_TRUNC, mode);
+	if (out_index_fd < 0) {
+		PERROR("Failed to create index file \"%s\"", argv[4]);
+		goto end;
+	}
+
+	if (write_index_header(out_index_fd)) {
+		goto end;
+	}
+
+	if (decompress_stream(stream_fd, index_fd, out_stream_fd,
+			out_index_fd)) {
+		goto end;
+	}
+
+	ret = EXIT_SUCCESS;
+end:
+	for (const int fd : { stream_fd, index_fd, out_stream_fd, out_index_fd }) {
+		if (fd >= 0 && close(fd)) {
+			PERROR("Failed to close file descriptor %d", fd);
+		}
+	}
+	return ret;
+}
@@ -15,6 +15,9 @@ struct lttng_channel_extended {
 	uint64_t lost_packets;
 	uint64_t monitor_timer_interval;
 	int64_t blocking_timeout;
+	/* enum lttng_channel_compression */
+	uint8_t compression;
+	uint8_t suppress_empty_packets;
 } LTTNG_PACKED;
 
 struct lttng_channel_comm {
@@ -38,6 +41,8 @@ struct lttng_channel_comm {
 	uint64_t lost_packets;
 	uint64_t monitor_timer_interval;
 	int64_t blocking_timeout;
+	uint8_t compression;
+	uint8_t suppress_empty_packets;
 } LTTNG_PACKED;
 
 struct lttng_channel *lttng_channel_create_internal(void);
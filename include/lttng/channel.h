@@ -17,6 +17,15 @@
 extern "C" {
 #endif
 
+/*
+ * Compression applied by the consumer daemon to each packet of a channel
+ * before writing it to a local trace file.
+ */
+enum lttng_channel_compression {
+	LTTNG_CHANNEL_COMPRESSION_NONE = 0,
+	LTTNG_CHANNEL_COMPRESSION_ZSTD = 1,
+};
+
 /*
  * Tracer channel attributes. For both kernel and user-space.
  *
@@ -98,6 +107,29 @@ LTTNG_EXPORT extern int lttng_enable_channel(struct lttng_handle *handle,
 LTTNG_EXPORT extern int lttng_disable_channel(struct lttng_handle *handle,
 		const char *name);
 
+/*
+ * Consumption statistics of a channel stream, as sampled in the consumer
+ * daemon. Counters are cumulative since the creation of the stream.
+ */
+#define LTTNG_STREAM_STATS_PADDING1        64
+struct lttng_stream_stats {
+	enum lttng_domain_type domain;
+	char channel_name[LTTNG_SYMBOL_NAME_LEN];
+	char stream_name[LTTNG_SYMBOL_NAME_LEN];
+	uint32_t metadata;                  /* 1 if metadata stream */
+	uint64_t subbuffers_consumed;       /* sub-buffers extracted */
+	uint64_t bytes_written;             /* bytes written to the output */
+	uint64_t write_syscalls;            /* write/splice system calls */
+	uint64_t write_time_ns;             /* time spent writing locally */
+	uint64_t relayd_sends;              /* sub-buffers sent to a relayd */
+	uint64_t relayd_send_time_ns;       /* time spent sending to a relayd */
+	uint64_t relayd_send_max_ns;        /* worst relayd send latency */
+	uint64_t last_lag_ns;               /* packet end to write-out, latest */
+	uint64_t max_lag_ns;                /* packet end to write-out, worst */
+
+	char padding[LTTNG_STREAM_STATS_PADDING1];
+};
+
 /*
  * Set the default channel attributes for a specific domain and an allocated
  * lttng_channel_attr pointer.
@@ -135,6 +167,63 @@ LTTNG_EXPORT extern int lttng_channel_get_blocking_timeout(struct lttng_channel
 LTTNG_EXPORT extern int lttng_channel_set_blocking_timeout(struct lttng_channel *chan,
 		int64_t blocking_timeout);
 
+/*
+ * Get the packet compression of a channel.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_get_compression(struct lttng_channel *chan,
+		enum lttng_channel_compression *compression);
+
+/*
+ * Set the packet compression of a channel.
+ *
+ * Compressed packets are only produced for channels of sessions writing
+ * their trace locally and using the mmap output. Each packet is compressed
+ * independently and its position in the trace file is recorded in the
+ * stream's index (CTF index 1.2) so that packets can be read back
+ * individually.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_set_compression(struct lttng_channel *chan,
+		enum lttng_channel_compression compression);
+
+/*
+ * Get whether the consumer daemon suppresses the empty packets of a channel.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_get_empty_packet_suppression(
+		struct lttng_channel *chan, int *suppress_empty_packets);
+
+/*
+ * Set whether the consumer daemon suppresses the empty packets of a channel.
+ *
+ * Periodic flushes of idle streams produce packets holding only a packet
+ * header and context. When suppression is enabled, the consumer daemon
+ * doesn't write or send those packets, except the first and last ones of each
+ * stream's trace chunk so that the time range covered by each stream is
+ * preserved. Live streams sent to a relay daemon get an inactivity beacon
+ * instead of each suppressed packet.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_set_empty_packet_suppression(
+		struct lttng_channel *chan, int suppress_empty_packets);
+
+/*
+ * List the consumption statistics of every stream of a session's channels.
+ *
+ * On success, *stats is set to an array that must be freed by the caller and
+ * the number of entries is returned. No statistics are available until the
+ * session has been started.
+ *
+ * Returns the number of entries on success, or a negative LTTng error code.
+ */
+LTTNG_EXPORT extern int lttng_list_stream_stats(const char *session_name,
+		struct lttng_stream_stats **stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -493,6 +493,28 @@ LTTNG_EXPORT extern int lttng_enable_event_with_exclusions(struct lttng_handle *
 		const char *filter_expression,
 		int exclusion_count, char **exclusion_names);
 
+/*
+ * Create or enable a batch of events of the same channel.
+ *
+ * This is equivalent to calling lttng_enable_event_with_filter() for each of
+ * the `count` events of the `events` array, except that in the userspace
+ * domain, the session daemon validates the whole batch before enabling any of
+ * its events and updates the traced applications once for the whole batch.
+ * In the other domains, the events are enabled in order: on error, the events
+ * preceding the one which failed remain enabled. Enabling an event which is
+ * already enabled is not an error. Userspace probes can't be part of a batch.
+ *
+ * If channel_name is NULL, the default channel is used (channel0) and created
+ * if not found.
+ * If filter_expression is not NULL, it is the filter of every event of the
+ * batch.
+ *
+ * Return 0 on success else a negative LTTng error code.
+ */
+LTTNG_EXPORT extern int lttng_enable_events(struct lttng_handle *handle,
+		struct lttng_event *events, unsigned int count,
+		const char *channel_name, const char *filter_expression);
+
 /*
  * Disable event(s) of a channel and domain.
  *
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_SESSION_DAEMON_CONNECTION_H
+#define LTTNG_SESSION_DAEMON_CONNECTION_H
+
+#include <lttng/lttng-error.h>
+#include <lttng/lttng-export.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Persistent connection to the session daemon.
+ *
+ * By default, liblttng-ctl connects to the session daemon for each command
+ * and disconnects once it receives the reply. While a persistent connection
+ * exists, the commands of liblttng-ctl are sent on it instead, which avoids
+ * the cost of setting up a connection for each of them.
+ *
+ * A persistent connection can also pipeline commands: the commands which
+ * don't return any data to the caller (e.g. lttng_enable_event(),
+ * lttng_disable_event(), lttng_enable_channel(), or lttng_start_tracing())
+ * are then sent without waiting for their reply. Their replies are received later, in bulk.
+ *
+ * The session daemon closes a connection after a command fails. The
+ * connection is transparently re-established by the next command. Pipelined
+ * commands sent on a connection which the session daemon already closed fail
+ * without raising the SIGPIPE signal.
+ *
+ * Like the rest of liblttng-ctl, persistent connections must not be used
+ * concurrently by multiple threads.
+ */
+struct lttng_session_daemon_connection;
+
+/*
+ * Negative values indicate errors. Values >= 0 indicate success.
+ */
+enum lttng_session_daemon_connection_status {
+	LTTNG_SESSION_DAEMON_CONNECTION_STATUS_ERROR = -2,
+	LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID = -1,
+	LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK = 0,
+};
+
+/*
+ * Connect to the session daemon and use the connection for the commands of
+ * liblttng-ctl until it is destroyed.
+ *
+ * Only one persistent connection may exist at any given time.
+ *
+ * Returns a new connection on success, NULL if a persistent connection
+ * already exists or on error.
+ */
+LTTNG_EXPORT extern struct lttng_session_daemon_connection *
+lttng_session_daemon_connection_create(void);
+
+/*
+ * Destroy a persistent connection; liblttng-ctl goes back to connecting to
+ * the session daemon for each command.
+ *
+ * The replies to the commands of a pipeline which was not ended are
+ * discarded.
+ */
+LTTNG_EXPORT extern void lttng_session_daemon_connection_destroy(
+		struct lttng_session_daemon_connection *connection);
+
+/*
+ * Start pipelining the commands sent on a persistent connection.
+ *
+ * Until the pipeline is ended, the commands which don't return any data to
+ * the caller return 0 as soon as they are sent: their actual result is
+ * reported by lttng_session_daemon_connection_pipeline_end(). The other
+ * commands wait for the replies of the pipelined commands sent before them,
+ * then for their own.
+ *
+ * Returns LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK on success,
+ * LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID if the connection is NULL or
+ * already pipelining commands.
+ */
+LTTNG_EXPORT extern enum lttng_session_daemon_connection_status
+lttng_session_daemon_connection_pipeline_begin(
+		struct lttng_session_daemon_connection *connection);
+
+/*
+ * Receive the replies to the pipelined commands and stop pipelining
+ * commands.
+ *
+ * `result` is set to LTTNG_OK if all the pipelined commands succeeded.
+ * Otherwise, it is set to the error of the first command which failed; as
+ * the session daemon closes the connection after a failed command, the
+ * pipelined commands which followed it were not executed.
+ *
+ * `completed_count`, if not NULL, is set to the number of pipelined commands
+ * which succeeded.
+ *
+ * Returns LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK on success,
+ * LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID if the connection or result
+ * is NULL, or if the connection is not pipelining commands.
+ */
+LTTNG_EXPORT extern enum lttng_session_daemon_connection_status
+lttng_session_daemon_connection_pipeline_end(
+		struct lttng_session_daemon_connection *connection,
+		enum lttng_error_code *result,
+		unsigned int *completed_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LTTNG_SESSION_DAEMON_CONNECTION_H */
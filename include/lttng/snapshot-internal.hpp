@@ -34,6 +34,15 @@ struct lttng_snapshot_output {
 	char ctrl_url[PATH_MAX];
 	/* Destination of the output. See lttng(1) for URL format. */
 	char data_url[PATH_MAX];
+	/*
+	 * Only record the sub-buffers produced since the previous snapshot.
+	 *
+	 * This structure is part of the client and session daemon messages
+	 * (struct lttcomm_session_msg and the LIST_OUTPUT reply), which this
+	 * field made one byte larger: the lttng-ctl library and the session
+	 * daemon must be of the same version.
+	 */
+	uint8_t incremental;
 } LTTNG_PACKED;
 
 /*
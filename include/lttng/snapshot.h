@@ -49,6 +49,8 @@ LTTNG_EXPORT extern const char *lttng_snapshot_output_get_name(const struct lttn
 LTTNG_EXPORT extern const char *lttng_snapshot_output_get_ctrl_url(const struct lttng_snapshot_output *output);
 /* Return snapshot data URL in a text format. */
 LTTNG_EXPORT extern const char *lttng_snapshot_output_get_data_url(const struct lttng_snapshot_output *output);
+/* Return 1 if the snapshot is incremental, 0 otherwise. */
+LTTNG_EXPORT extern int lttng_snapshot_output_get_incremental(const struct lttng_snapshot_output *output);
 
 /*
  * Snapshot output setter family functions.
@@ -67,6 +69,17 @@ LTTNG_EXPORT extern int lttng_snapshot_output_set_size(uint64_t size,
 LTTNG_EXPORT extern int lttng_snapshot_output_set_name(const char *name,
 		struct lttng_snapshot_output *output);
 
+/*
+ * Make the snapshots recorded with this output incremental.
+ *
+ * An incremental snapshot only records, for each data stream, the packets
+ * produced since the previous snapshot of the recording session, whatever its
+ * output. The metadata is always recorded in full, so that each incremental
+ * snapshot is a trace which can be read on its own.
+ */
+LTTNG_EXPORT extern int lttng_snapshot_output_set_incremental(int incremental,
+		struct lttng_snapshot_output *output);
+
 /*
  * Set the output destination to be a path on the local filesystem.
  *
@@ -43,8 +43,10 @@
 
 /* threads (channel handling, poll, metadata, sessiond) */
 
-static pthread_t channel_thread, data_thread, metadata_thread,
+static pthread_t channel_thread, metadata_thread,
 		sessiond_thread, metadata_timer_thread, health_thread;
+/* Number of data threads launched. */
+static unsigned int nb_data_threads_online;
 static bool metadata_timer_thread_online;
 
 /* to count the number of times the user pressed ctrl+c */
@@ -319,6 +321,7 @@ static void set_ulimit(void)
 int main(int argc, char **argv)
 {
 	int ret = 0, retval = 0;
+	unsigned int i;
 	void *status;
 	struct lttng_consumer_local_data *tmp_ctx;
 
@@ -486,10 +489,10 @@ int main(int argc, char **argv)
 	lttng_consumer_set_error_sock(the_consumer_context, ret);
 
 	/*
-	 * Block RT signals used for UST periodical metadata flush and the live
-	 * timer in main, and create a dedicated thread to handle these signals.
+	 * Create the timerfd driving the channel timers (UST periodical metadata
+	 * flush, live and monitoring timers) before the threads using them.
 	 */
-	if (consumer_signal_init()) {
+	if (consumer_timer_init()) {
 		retval = -1;
 		goto exit_init_data;
 	}
@@ -556,14 +559,20 @@ int main(int argc, char **argv)
 		goto exit_metadata_thread;
 	}
 
-	/* Create thread to manage the polling/writing of trace data */
-	ret = pthread_create(&data_thread, default_pthread_attr(),
-			consumer_thread_data_poll, (void *) the_consumer_context);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_create");
-		retval = -1;
-		goto exit_data_thread;
+	/* Create threads to manage the polling/writing of trace data */
+	for (i = 0; i < the_consumer_context->nb_data_threads; i++) {
+		struct lttng_consumer_data_thread *data_thread =
+				&the_consumer_context->data_threads[i];
+
+		ret = pthread_create(&data_thread->thread, default_pthread_attr(),
+				consumer_thread_data_poll, (void *) data_thread);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create");
+			retval = -1;
+			goto exit_data_thread;
+		}
+		nb_data_threads_online++;
 	}
 
 	/* Create the thread to manage the reception of fds */
@@ -591,13 +600,16 @@ int main(int argc, char **argv)
 	}
 exit_sessiond_thread:
 
-	ret = pthread_join(data_thread, &status);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_join data_thread");
-		retval = -1;
-	}
 exit_data_thread:
+	for (i = 0; i < nb_data_threads_online; i++) {
+		ret = pthread_join(the_consumer_context->data_threads[i].thread,
+				&status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join data_thread");
+			retval = -1;
+		}
+	}
 
 	ret = pthread_join(metadata_thread, &status);
 	if (ret) {
@@ -648,7 +660,7 @@ exit_init_data:
 		 * threads are gone, because it is required to perform timer
 		 * teardown synchronization.
 		 */
-		kill(getpid(), LTTNG_CONSUMER_SIG_EXIT);
+		(void) consumer_timer_thread_quit();
 		ret = pthread_join(metadata_timer_thread, &status);
 		if (ret) {
 			errno = ret;
@@ -664,6 +676,7 @@ exit_init_data:
 		}
 		metadata_timer_thread_online = false;
 	}
+	consumer_timer_fini();
 	tmp_ctx = the_consumer_context;
 	the_consumer_context = NULL;
 	cmm_barrier();	/* Clear ctx for signal handler. */
@@ -3240,6 +3240,48 @@ end_no_reply:
 	return ret;
 }
 
+/*
+ * relay_get_viewer_status: reply whether a live viewer is attached to the
+ * connection's session.
+ */
+static int relay_get_viewer_status(
+		const struct lttcomm_relayd_hdr *recv_hdr __attribute__((unused)),
+		struct relay_connection *conn,
+		const struct lttng_buffer_view *payload __attribute__((unused)))
+{
+	int ret = 0;
+	ssize_t send_ret;
+	struct relay_session *session = conn->session;
+	struct lttcomm_relayd_get_viewer_status_reply reply = {};
+
+	if (!session || !conn->version_check_done) {
+		ERR("Trying to get the viewer status before version check");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (session->major == 2 && session->minor < 14) {
+		ERR("Get viewer status command is unsupported before 2.14");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	pthread_mutex_lock(&session->lock);
+	reply.viewer_attached = session->viewer_attached;
+	pthread_mutex_unlock(&session->lock);
+	reply.generic.ret_code = htobe32((uint32_t) LTTNG_OK);
+
+	send_ret = conn->sock->ops->sendmsg(
+			conn->sock, &reply, sizeof(reply), 0);
+	if (send_ret < (ssize_t) sizeof(reply)) {
+		ERR("Failed to send \"get viewer status\" command reply (ret = %zd)",
+				send_ret);
+		ret = -1;
+	}
+end_no_reply:
+	return ret;
+}
+
 static int relay_process_control_command(struct relay_connection *conn,
 		const struct lttcomm_relayd_hdr *header,
 		const struct lttng_buffer_view *payload)
@@ -3304,6 +3346,9 @@ static int relay_process_control_command(struct relay_connection *conn,
 	case RELAYD_GET_CONFIGURATION:
 		ret = relay_get_configuration(header, conn, payload);
 		break;
+	case RELAYD_GET_VIEWER_STATUS:
+		ret = relay_get_viewer_status(header, conn, payload);
+		break;
 	case RELAYD_UPDATE_SYNC_INFO:
 	default:
 		ERR("Received unknown command (%u)", header->cmd);
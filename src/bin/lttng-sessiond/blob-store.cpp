@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/defaults.hpp>
+#include <common/error.hpp>
+#include <common/hashtable/hashtable.hpp>
+#include <common/hashtable/utils.hpp>
+#include <common/macros.hpp>
+#include <common/urcu.hpp>
+
+#include "blob-store.hpp"
+
+namespace {
+struct blob_store_entry {
+	struct cds_lfht_node node;
+	/* For delayed reclaim. */
+	struct rcu_head rcu_head;
+	/* Protected by blob_store_lock. */
+	unsigned int refcount;
+	size_t len;
+	char data[0];
+};
+
+/*
+ * A blob is looked up in two parts to allow the header of a bytecode to be
+ * overridden without copying the bytecode itself.
+ */
+struct blob_store_key {
+	const void *header;
+	size_t header_len;
+	const void *payload;
+	size_t payload_len;
+};
+} /* namespace */
+
+/*
+ * Serializes the lookups and insertions of blobs with the updates of their
+ * reference count.
+ */
+static pthread_mutex_t blob_store_lock = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * Keyed by the content of the blobs, hence not an lttng_ht. Allocated on
+ * first use, protected by blob_store_lock.
+ */
+static struct cds_lfht *blob_store_ht;
+
+static int match_blob_store_entry(struct cds_lfht_node *node, const void *_key)
+{
+	const struct blob_store_key *key = (const struct blob_store_key *) _key;
+	const struct blob_store_entry *entry =
+			caa_container_of(node, struct blob_store_entry, node);
+
+	if (entry->len != key->header_len + key->payload_len) {
+		return 0;
+	}
+
+	if (memcmp(entry->data, key->header, key->header_len) != 0) {
+		return 0;
+	}
+
+	if (key->payload_len &&
+			memcmp(entry->data + key->header_len, key->payload,
+					key->payload_len) != 0) {
+		return 0;
+	}
+
+	return 1;
+}
+
+static void free_blob_store_entry_rcu(struct rcu_head *head)
+{
+	free(caa_container_of(head, struct blob_store_entry, rcu_head));
+}
+
+/*
+ * Return the shared copy of the blob made of `header` followed by `payload`,
+ * creating it if needed, with a new reference held by the caller.
+ */
+static const void *blob_store_get(const void *header, size_t header_len,
+		const void *payload, size_t payload_len)
+{
+	unsigned long hash;
+	struct cds_lfht_iter iter;
+	struct cds_lfht_node *node;
+	struct blob_store_entry *entry = NULL;
+	const struct blob_store_key key = {
+		.header = header,
+		.header_len = header_len,
+		.payload = payload,
+		.payload_len = payload_len,
+	};
+	lttng::urcu::read_lock_guard read_lock;
+
+	hash = hash_key_buffer(header, header_len, lttng_ht_seed);
+	if (payload_len) {
+		hash = hash_key_buffer(payload, payload_len, hash);
+	}
+
+	pthread_mutex_lock(&blob_store_lock);
+	if (!blob_store_ht) {
+		blob_store_ht = cds_lfht_new(DEFAULT_HT_SIZE, 1, 0,
+				CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, NULL);
+		if (!blob_store_ht) {
+			ERR("Failed to allocate the blob store hash table");
+			goto end;
+		}
+	}
+
+	cds_lfht_lookup(blob_store_ht, hash, match_blob_store_entry, &key,
+			&iter);
+	node = cds_lfht_iter_get_node(&iter);
+	if (node) {
+		entry = caa_container_of(node, struct blob_store_entry, node);
+		entry->refcount++;
+		goto end;
+	}
+
+	entry = zmalloc<blob_store_entry>(
+			sizeof(*entry) + header_len + payload_len);
+	if (!entry) {
+		PERROR("Failed to allocate blob store entry: size = %zu bytes",
+				header_len + payload_len);
+		goto end;
+	}
+
+	cds_lfht_node_init(&entry->node);
+	entry->refcount = 1;
+	entry->len = header_len + payload_len;
+	memcpy(entry->data, header, header_len);
+	if (payload_len) {
+		memcpy(entry->data + header_len, payload, payload_len);
+	}
+
+	cds_lfht_add(blob_store_ht, hash, &entry->node);
+end:
+	pthread_mutex_unlock(&blob_store_lock);
+	return entry ? entry->data : NULL;
+}
+
+const struct lttng_bytecode *blob_store_get_bytecode(
+		const struct lttng_bytecode *bytecode)
+{
+	return (const struct lttng_bytecode *) blob_store_get(bytecode,
+			sizeof(*bytecode), bytecode->data, bytecode->len);
+}
+
+const struct lttng_bytecode *blob_store_get_capture_bytecode(
+		const struct lttng_bytecode *bytecode, uint64_t seqnum)
+{
+	struct lttng_bytecode header;
+
+	memcpy(&header, bytecode, sizeof(header));
+	header.seqnum = seqnum;
+
+	return (const struct lttng_bytecode *) blob_store_get(&header,
+			sizeof(header), bytecode->data, bytecode->len);
+}
+
+const struct lttng_event_exclusion *blob_store_get_exclusion(
+		const struct lttng_event_exclusion *exclusion)
+{
+	return (const struct lttng_event_exclusion *) blob_store_get(exclusion,
+			sizeof(*exclusion) +
+					LTTNG_SYMBOL_NAME_LEN * exclusion->count,
+			NULL, 0);
+}
+
+void blob_store_put(const void *blob)
+{
+	int ret;
+	struct blob_store_entry *entry;
+	lttng::urcu::read_lock_guard read_lock;
+
+	if (!blob) {
+		return;
+	}
+
+	entry = (struct blob_store_entry *) ((const char *) blob -
+			offsetof(struct blob_store_entry, data));
+
+	pthread_mutex_lock(&blob_store_lock);
+	LTTNG_ASSERT(entry->refcount > 0);
+	entry->refcount--;
+	if (entry->refcount == 0) {
+		ret = cds_lfht_del(blob_store_ht, &entry->node);
+		LTTNG_ASSERT(!ret);
+		call_rcu(&entry->rcu_head, free_blob_store_entry_rcu);
+	}
+	pthread_mutex_unlock(&blob_store_lock);
+}
+
+void blob_store_destroy(void)
+{
+	int ret;
+	struct cds_lfht_iter iter;
+	struct blob_store_entry *entry;
+
+	pthread_mutex_lock(&blob_store_lock);
+	if (!blob_store_ht) {
+		goto end;
+	}
+
+	{
+		lttng::urcu::read_lock_guard read_lock;
+
+		/* No reference may be released past this point. */
+		cds_lfht_for_each_entry(blob_store_ht, &iter, entry, node) {
+			DBG("Freeing leaked blob store entry: size = %zu bytes, refcount = %u",
+					entry->len, entry->refcount);
+			ret = cds_lfht_del(blob_store_ht, &entry->node);
+			LTTNG_ASSERT(!ret);
+			call_rcu(&entry->rcu_head, free_blob_store_entry_rcu);
+		}
+	}
+
+	ret = cds_lfht_destroy(blob_store_ht, NULL);
+	LTTNG_ASSERT(!ret);
+	blob_store_ht = NULL;
+end:
+	pthread_mutex_unlock(&blob_store_lock);
+}
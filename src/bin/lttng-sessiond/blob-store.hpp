@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_SESSIOND_BLOB_STORE_H
+#define LTTNG_SESSIOND_BLOB_STORE_H
+
+#include <common/sessiond-comm/sessiond-comm.hpp>
+
+#include <stdint.h>
+
+/*
+ * Content-addressed store of the immutable blobs (filter and capture
+ * bytecodes, event exclusions) which are sent to every application.
+ *
+ * Getting a blob returns the single shared copy of its content and acquires
+ * a reference to it; that reference is released with blob_store_put().
+ * Shared blobs must never be modified.
+ *
+ * All functions return NULL on allocation failure and may be called
+ * concurrently from any thread registered with RCU.
+ */
+const struct lttng_bytecode *blob_store_get_bytecode(
+		const struct lttng_bytecode *bytecode);
+
+/*
+ * Same as blob_store_get_bytecode(), but with the sequence number of the
+ * returned capture bytecode set to `seqnum`.
+ */
+const struct lttng_bytecode *blob_store_get_capture_bytecode(
+		const struct lttng_bytecode *bytecode, uint64_t seqnum);
+
+const struct lttng_event_exclusion *blob_store_get_exclusion(
+		const struct lttng_event_exclusion *exclusion);
+
+/*
+ * Release a reference to a blob returned by one of the functions above. The
+ * blob is freed once its last reference is released. `blob` may be NULL.
+ */
+void blob_store_put(const void *blob);
+
+/*
+ * Destroy the store once no blob is referenced anymore, at the teardown of
+ * the session daemon.
+ */
+void blob_store_destroy(void);
+
+#endif /* LTTNG_SESSIOND_BLOB_STORE_H */
@@ -122,6 +122,7 @@ int buffer_reg_uid_create(uint64_t session_id, uint32_t bits_per_long, uid_t uid
 	reg->bits_per_long = bits_per_long;
 	reg->uid = uid;
 	reg->domain = domain;
+	pthread_mutex_init(&reg->channel_setup_lock, NULL);
 	if (shm_path[0]) {
 		strncpy(reg->root_shm_path, root_shm_path, sizeof(reg->root_shm_path));
 		reg->root_shm_path[sizeof(reg->root_shm_path) - 1] = '\0';
@@ -79,6 +79,11 @@ struct buffer_reg_uid {
 	struct lttng_ht_node_u64 node;
 	/* Node of a linked list used to teardown object at a destroy session. */
 	struct cds_list_head lnode;
+	/*
+	 * Serializes the creation of the channels of this registry by the
+	 * applications of its user, which may be set up concurrently.
+	 */
+	pthread_mutex_t channel_setup_lock;
 
 	char root_shm_path[PATH_MAX];
 	char shm_path[PATH_MAX];
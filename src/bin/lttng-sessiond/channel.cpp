@@ -405,7 +405,12 @@ enum lttng_error_code channel_ust_create(struct ltt_ust_session *usess,
 		goto error;
 	}
 
-	if (attr->attr.output != LTTNG_EVENT_MMAP) {
+	/*
+	 * The tracer only shares its buffers through mmap. The splice output
+	 * makes the consumer daemon vmsplice() the mapped sub-buffers.
+	 */
+	if (attr->attr.output != LTTNG_EVENT_MMAP &&
+			attr->attr.output != LTTNG_EVENT_SPLICE) {
 		ret_code = LTTNG_ERR_NOT_SUPPORTED;
 		goto error;
 	}
@@ -577,7 +582,7 @@ struct lttng_channel *trace_ust_channel_to_lttng_channel(
 	 */
 	switch (uchan->attr.output) {
 	case LTTNG_UST_ABI_MMAP:
-		channel->attr.output = LTTNG_EVENT_MMAP;
+		channel->attr.output = uchan->consumer_output;
 		break;
 	default:
 		/*
@@ -592,6 +597,9 @@ struct lttng_channel *trace_ust_channel_to_lttng_channel(
 			channel, uchan->attr.u.s.blocking_timeout);
 	lttng_channel_set_monitor_timer_interval(
 			channel, uchan->monitor_timer_interval);
+	lttng_channel_set_compression(channel, uchan->compression);
+	lttng_channel_set_empty_packet_suppression(
+			channel, uchan->suppress_empty_packets);
 
 	ret = channel;
 	channel = NULL;
@@ -18,6 +18,7 @@
 #include "lttng/lttng-error.h"
 #include "lttng/tracker.h"
 #include <common/compat/getenv.hpp>
+#include <common/defaults.hpp>
 #include <common/tracker.hpp>
 #include <common/unix.hpp>
 #include <common/utils.hpp>
@@ -32,11 +33,13 @@
 #include <stdint.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <urcu/list.h>
 
 #include "agent-thread.hpp"
 #include "clear.hpp"
 #include "client.hpp"
 #include "cmd.hpp"
+#include "event.hpp"
 #include "health-sessiond.hpp"
 #include "kernel.hpp"
 #include "lttng-sessiond.hpp"
@@ -53,6 +56,53 @@ struct thread_state {
 	bool running;
 	int client_sock;
 } thread_state;
+
+/*
+ * Client connection. A client may send any number of commands on its
+ * connection; the connection is owned by a client worker while it processes
+ * them, and by the client thread while it waits for the next one.
+ */
+struct client_connection {
+	int sock;
+	struct cds_list_head node;
+};
+
+/*
+ * Queues of client connections, shared between the client thread and its
+ * workers.
+ */
+struct client_connection_queue {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	/*
+	 * Connections having a command to process, waiting for a worker.
+	 * Protected by the lock.
+	 */
+	struct cds_list_head list;
+	/*
+	 * Idle connections handed back by the workers, waiting to be polled
+	 * by the client thread. Protected by the lock.
+	 */
+	struct cds_list_head returned_list;
+	/* Wakes up the client thread when connections are handed back. */
+	struct lttng_pipe *returned_pipe;
+	/* Set when the workers must exit; protected by the lock. */
+	bool quit;
+} connection_queue = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	{},
+	{},
+	NULL,
+	false,
+};
+
+/*
+ * Serializes the processing of the client commands which are not read-only
+ * (see is_read_only_command()), as they assume that no other such command
+ * runs concurrently.
+ */
+pthread_mutex_t client_command_lock = PTHREAD_MUTEX_INITIALIZER;
 } /* namespace */
 
 static void set_thread_status(bool running)
@@ -859,6 +909,112 @@ end:
 	return ret_code;
 }
 
+static void destroy_event_enable_specs(struct event_enable_spec *specs,
+		unsigned int count)
+{
+	unsigned int i;
+
+	if (!specs) {
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		lttng_event_destroy(specs[i].event);
+		free(specs[i].filter_expression);
+		free(specs[i].filter);
+		free(specs[i].exclusion);
+	}
+	free(specs);
+}
+
+/*
+ * Receive the batch of events of an ENABLE_EVENTS command. The events are
+ * serialized one after the other, each with its own filter and exclusions.
+ */
+static enum lttng_error_code receive_lttng_events(struct command_ctx *cmd_ctx,
+		int sock,
+		int *sock_error,
+		struct event_enable_spec **out_specs,
+		unsigned int *out_count)
+{
+	int ret;
+	unsigned int i;
+	size_t offset = 0;
+	ssize_t sock_recv_len;
+	enum lttng_error_code ret_code;
+	struct lttng_payload events_payload;
+	struct event_enable_spec *specs = NULL;
+	const size_t events_len = (size_t) cmd_ctx->lsm.u.enable_events.length;
+	const unsigned int count = cmd_ctx->lsm.u.enable_events.count;
+
+	lttng_payload_init(&events_payload);
+
+	ret = lttng_dynamic_buffer_set_size(&events_payload.buffer, events_len);
+	if (ret) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	sock_recv_len = lttcomm_recv_unix_sock(
+			sock, events_payload.buffer.data, events_len);
+	if (sock_recv_len < 0 || sock_recv_len != events_len) {
+		ERR("Failed to receive events in command payload");
+		*sock_error = 1;
+		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+		goto end;
+	}
+
+	/* Userspace probes, which carry an fd, can't be batched. */
+	if (cmd_ctx->lsm.fd_count != 0 || count == 0 || count > events_len) {
+		ERR("Invalid event batch: count = %u, length = %zu, fd count = %u",
+				count, events_len, cmd_ctx->lsm.fd_count);
+		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+		goto end;
+	}
+
+	specs = calloc<event_enable_spec>(count);
+	if (!specs) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		ssize_t len;
+		struct lttng_payload_view event_view =
+				lttng_payload_view_from_payload(
+						&events_payload, offset, -1);
+
+		len = lttng_event_create_from_payload(&event_view,
+				&specs[i].event, &specs[i].exclusion,
+				&specs[i].filter_expression, &specs[i].filter);
+		if (len < 0) {
+			ERR("Failed to create event %u of the batch from the received buffer",
+					i);
+			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+			goto end;
+		}
+
+		offset += len;
+	}
+
+	if (offset != events_len) {
+		ERR("Event batch is not the advertised length: header length = %zu, payload length = %zu",
+				events_len, offset);
+		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+		goto end;
+	}
+
+	*out_specs = specs;
+	*out_count = count;
+	specs = NULL;
+	ret_code = LTTNG_OK;
+
+end:
+	lttng_payload_reset(&events_payload);
+	destroy_event_enable_specs(specs, count);
+	return ret_code;
+}
+
 static enum lttng_error_code receive_lttng_event_context(
 		const struct command_ctx *cmd_ctx,
 		int sock,
@@ -984,6 +1140,34 @@ end:
 	return ret;
 }
 
+/*
+ * Commands that only read the state of a session, of the session list or of
+ * the triggers. They hold neither the client command lock nor the session list
+ * lock, only their session's lock, so that they can run while another command
+ * is being processed (e.g. a rotation waiting on the consumer daemons). They
+ * don't set up the session's domains either.
+ *
+ * Listing the sessions only takes the session list lock while it copies the
+ * list.
+ */
+static bool is_read_only_command(enum lttcomm_sessiond_command cmd_type)
+{
+	switch (cmd_type) {
+	case LTTCOMM_SESSIOND_COMMAND_LIST_DOMAINS:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_CHANNELS:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_EVENTS:
+	case LTTCOMM_SESSIOND_COMMAND_SNAPSHOT_LIST_OUTPUT:
+	case LTTCOMM_SESSIOND_COMMAND_ROTATION_GET_INFO:
+	case LTTCOMM_SESSIOND_COMMAND_SESSION_LIST_ROTATION_SCHEDULES:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_SESSIONS:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /*
  * Process the command requested by the lttng client within the command
  * context structure. This function make sure that the return structure (llm)
@@ -1000,8 +1184,10 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 {
 	int ret = LTTNG_OK;
 	bool need_tracing_session = true;
+	bool session_list_locked = false;
 	bool need_domain;
 	bool need_consumerd;
+	bool read_only;
 
 	if (!lttcomm_sessiond_command_is_valid((lttcomm_sessiond_command) cmd_ctx->lsm.cmd_type)) {
 		ERR("Unknown client command received: command id = %" PRIu32,
@@ -1015,6 +1201,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 		cmd_ctx->lsm.cmd_type);
 
 	*sock_error = 0;
+	read_only = is_read_only_command(
+			(lttcomm_sessiond_command) cmd_ctx->lsm.cmd_type);
 
 	switch (cmd_ctx->lsm.cmd_type) {
 	case LTTCOMM_SESSIOND_COMMAND_CREATE_SESSION_EXT:
@@ -1039,6 +1227,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	case LTTCOMM_SESSIOND_COMMAND_CLEAR_SESSION:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS:
 		need_domain = false;
 		break;
 	default:
@@ -1100,6 +1289,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGER:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS:
 		break;
 	default:
 		/* Setup lttng message with no payload */
@@ -1126,12 +1316,29 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 		break;
 	default:
 		DBG("Getting session %s by name", cmd_ctx->lsm.session.name);
+		if (read_only) {
+			cmd_ctx->session = session_find_by_name_rcu(
+					cmd_ctx->lsm.session.name);
+			if (cmd_ctx->session == NULL) {
+				ret = LTTNG_ERR_SESS_NOT_FOUND;
+				goto error;
+			}
+
+			session_lock(cmd_ctx->session);
+			if (cmd_ctx->session->destroyed) {
+				ret = LTTNG_ERR_SESS_NOT_FOUND;
+				goto error;
+			}
+			break;
+		}
+
 		/*
-		 * We keep the session list lock across _all_ commands
-		 * for now, because the per-session lock does not
+		 * We keep the session list lock across all the other
+		 * commands for now, because the per-session lock does not
 		 * handle teardown properly.
 		 */
 		session_lock_list();
+		session_list_locked = true;
 		cmd_ctx->session = session_find_by_name(cmd_ctx->lsm.session.name);
 		if (cmd_ctx->session == NULL) {
 			ret = LTTNG_ERR_SESS_NOT_FOUND;
@@ -1191,7 +1398,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 		}
 
 		/* Kernel tracer check */
-		if (!kernel_tracer_is_initialized()) {
+		if (!read_only && !kernel_tracer_is_initialized()) {
 			/* Basically, load kernel tracer modules */
 			ret = init_kernel_tracer();
 			if (ret != 0) {
@@ -1207,7 +1414,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 		}
 
 		/* Need a session for kernel command */
-		if (need_tracing_session) {
+		if (need_tracing_session && !read_only) {
 			if (cmd_ctx->session->kernel_session == NULL) {
 				ret = create_kernel_session(cmd_ctx->session);
 				if (ret != LTTNG_OK) {
@@ -1266,7 +1473,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 			goto error;
 		}
 
-		if (need_tracing_session) {
+		if (need_tracing_session && !read_only) {
 			/* Create UST session if none exist. */
 			if (cmd_ctx->session->ust_session == NULL) {
 				lttng_domain domain = cmd_ctx->lsm.domain;
@@ -1298,7 +1505,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 
 			/*
 			 * Setup socket for consumer 64 bit. No need for atomic access
-			 * since it was set above and can ONLY be set in this thread.
+			 * since it was set above and can ONLY be set by a command
+			 * holding the client command lock.
 			 */
 			ret = consumer_create_socket(&the_ustconsumer64_data,
 					cmd_ctx->session->ust_session->consumer);
@@ -1327,7 +1535,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 
 			/*
 			 * Setup socket for consumer 32 bit. No need for atomic access
-			 * since it was set above and can ONLY be set in this thread.
+			 * since it was set above and can ONLY be set by a command
+			 * holding the client command lock.
 			 */
 			ret = consumer_create_socket(&the_ustconsumer32_data,
 					cmd_ctx->session->ust_session->consumer);
@@ -1386,7 +1595,7 @@ skip_domain:
 	 * Send relayd information to consumer as soon as we have a domain and a
 	 * session defined.
 	 */
-	if (cmd_ctx->session && need_domain) {
+	if (cmd_ctx->session && need_domain && !read_only) {
 		/*
 		 * Setup relayd if not done yet. If the relayd information was already
 		 * sent to the consumer, this call will gracefully return.
@@ -1657,6 +1866,27 @@ skip_domain:
 		lttng_event_destroy(event);
 		break;
 	}
+	case LTTCOMM_SESSIOND_COMMAND_ENABLE_EVENTS:
+	{
+		struct event_enable_spec *specs = NULL;
+		unsigned int count = 0;
+		const enum lttng_error_code ret_code = receive_lttng_events(
+				cmd_ctx, *sock, sock_error, &specs, &count);
+
+		if (ret_code != LTTNG_OK) {
+			ret = (int) ret_code;
+			goto error;
+		}
+
+		/*
+		 * Ownership of the filter expressions, exclusions, and
+		 * bytecodes is transferred.
+		 */
+		ret = cmd_enable_events(cmd_ctx, specs, count,
+				the_kernel_poll_pipe[1]);
+		destroy_event_enable_specs(specs, count);
+		break;
+	}
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRACEPOINTS:
 	{
 		enum lttng_error_code ret_code;
@@ -1998,6 +2228,29 @@ skip_domain:
 		ret = LTTNG_OK;
 		break;
 	}
+	case LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS:
+	{
+		enum lttng_error_code ret_code;
+		struct lttng_dynamic_buffer stats;
+
+		lttng_dynamic_buffer_init(&stats);
+		ret_code = cmd_list_stream_stats(cmd_ctx->session, &stats);
+		if (ret_code != LTTNG_OK) {
+			lttng_dynamic_buffer_reset(&stats);
+			ret = (int) ret_code;
+			goto error;
+		}
+
+		ret = setup_lttng_msg_no_cmd_header(cmd_ctx, stats.data,
+				stats.size);
+		lttng_dynamic_buffer_reset(&stats);
+		if (ret < 0) {
+			goto setup_error;
+		}
+
+		ret = LTTNG_OK;
+		break;
+	}
 	case LTTCOMM_SESSIOND_COMMAND_SNAPSHOT_ADD_OUTPUT:
 	{
 		uint32_t snapshot_id;
@@ -2389,10 +2642,14 @@ error:
 setup_error:
 	if (cmd_ctx->session) {
 		session_unlock(cmd_ctx->session);
-		session_put(cmd_ctx->session);
+		if (session_list_locked) {
+			session_put(cmd_ctx->session);
+		} else {
+			session_put_unlocked(cmd_ctx->session);
+		}
 		cmd_ctx->session = NULL;
 	}
-	if (need_tracing_session) {
+	if (session_list_locked) {
 		session_unlock_list();
 	}
 init_setup_error:
@@ -2452,24 +2709,482 @@ static void thread_init_cleanup(void *data __attribute__((unused)))
 }
 
 /*
- * This thread manage all clients request using the unix client socket for
- * communication.
+ * Hand over a client connection having a command to process to the client
+ * workers.
+ */
+static void queue_client_connection(struct client_connection *connection)
+{
+	pthread_mutex_lock(&connection_queue.lock);
+	cds_list_add_tail(&connection->node, &connection_queue.list);
+	pthread_cond_signal(&connection_queue.cond);
+	pthread_mutex_unlock(&connection_queue.lock);
+}
+
+/*
+ * Wait for a client connection to handle.
+ *
+ * Return the connection, or NULL if the workers must exit.
+ */
+static struct client_connection *wait_client_connection(void)
+{
+	struct client_connection *connection = NULL;
+
+	pthread_mutex_lock(&connection_queue.lock);
+	health_poll_entry();
+	while (!connection_queue.quit && cds_list_empty(&connection_queue.list)) {
+		pthread_cond_wait(&connection_queue.cond, &connection_queue.lock);
+	}
+	health_poll_exit();
+
+	if (connection_queue.quit) {
+		goto end;
+	}
+
+	connection = cds_list_first_entry(&connection_queue.list,
+			struct client_connection, node);
+	cds_list_del(&connection->node);
+end:
+	pthread_mutex_unlock(&connection_queue.lock);
+	return connection;
+}
+
+/*
+ * Hand back an idle client connection to the client thread, which waits for
+ * its next command.
+ */
+static void return_client_connection(struct client_connection *connection)
+{
+	bool was_empty;
+
+	pthread_mutex_lock(&connection_queue.lock);
+	was_empty = cds_list_empty(&connection_queue.returned_list);
+	cds_list_add_tail(&connection->node, &connection_queue.returned_list);
+	pthread_mutex_unlock(&connection_queue.lock);
+
+	/*
+	 * The client thread takes all the returned connections on wake-up,
+	 * so it only needs to be woken up when the list becomes non-empty.
+	 */
+	if (was_empty) {
+		const char dummy = 0;
+
+		if (lttng_pipe_write(connection_queue.returned_pipe, &dummy,
+				sizeof(dummy)) != sizeof(dummy)) {
+			PERROR("Failed to wake up the client thread");
+		}
+	}
+}
+
+static void destroy_client_connection(struct client_connection *connection)
+{
+	if (connection->sock >= 0 && close(connection->sock)) {
+		PERROR("close");
+	}
+	free(connection);
+}
+
+/*
+ * Close the connections of a list.
+ */
+static void clear_client_connection_list(struct cds_list_head *list)
+{
+	struct client_connection *connection, *tmp;
+
+	cds_list_for_each_entry_safe(connection, tmp, list, node) {
+		cds_list_del(&connection->node);
+		destroy_client_connection(connection);
+	}
+}
+
+/*
+ * Check whether a client sent data (e.g. its next command) on its connection,
+ * without blocking.
+ *
+ * Return 1 if data is available, 0 if not, or -1 if the connection was closed
+ * by the client or is in error.
+ */
+static int client_connection_has_data(int sock)
+{
+	char c;
+	ssize_t ret;
+
+	do {
+		ret = recv(sock, &c, sizeof(c), MSG_PEEK | MSG_DONTWAIT);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret > 0) {
+		return 1;
+	} else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		return 0;
+	}
+
+	return -1;
+}
+
+/*
+ * Receive a command from a client connection, process it and send the reply
+ * to the client.
+ *
+ * The connection's socket is closed, and set to -1, if it can't be used for
+ * another command.
+ */
+static void handle_client_command(struct command_ctx *cmd_ctx, int *sock)
+{
+	int ret;
+	int sock_error = 0;
+	bool take_command_lock;
+	bool keep_connection = false;
+	const struct cmd_completion_handler *cmd_completion_handler;
+
+	cmd_ctx->creds.uid = UINT32_MAX;
+	cmd_ctx->creds.gid = UINT32_MAX;
+	cmd_ctx->creds.pid = 0;
+	cmd_ctx->session = NULL;
+	lttng_payload_clear(&cmd_ctx->reply_payload);
+	cmd_ctx->lttng_msg_size = 0;
+
+	health_code_update();
+
+	/*
+	 * Data is received from the lttng client. The struct
+	 * lttcomm_session_msg (lsm) contains the command and data request of
+	 * the client.
+	 */
+	DBG("Receiving data from client ...");
+	ret = lttcomm_recv_creds_unix_sock(*sock, &cmd_ctx->lsm,
+			sizeof(struct lttcomm_session_msg), &cmd_ctx->creds);
+	if (ret != sizeof(struct lttcomm_session_msg)) {
+		DBG("Incomplete recv() from client... continuing");
+		goto end;
+	}
+
+	health_code_update();
+
+	// TODO: Validate cmd_ctx including sanity check for
+	// security purpose.
+
+	take_command_lock = !is_read_only_command(
+			(lttcomm_sessiond_command) cmd_ctx->lsm.cmd_type);
+	if (take_command_lock) {
+		pthread_mutex_lock(&client_command_lock);
+	}
+
+	rcu_thread_online();
+	/*
+	 * This function dispatch the work to the kernel or userspace tracer
+	 * libs and fill the lttcomm_lttng_msg data structure of all the needed
+	 * informations for the client. The command context struct contains
+	 * everything this function may needs.
+	 */
+	ret = process_client_msg(cmd_ctx, sock, &sock_error);
+	rcu_thread_offline();
+
+	if (take_command_lock) {
+		pthread_mutex_unlock(&client_command_lock);
+	}
+
+	if (ret < 0) {
+		/*
+		 * TODO: Inform client somehow of the fatal error. At
+		 * this point, ret < 0 means that a zmalloc failed
+		 * (ENOMEM). Error detected but still accept
+		 * command, unless a socket error has been
+		 * detected.
+		 */
+		goto end;
+	}
+
+	if (ret < LTTNG_OK || ret >= LTTNG_ERR_NR) {
+		WARN("Command returned an invalid status code, returning unknown error: "
+				"command type = %s (%d), ret = %d",
+				lttcomm_sessiond_command_str((lttcomm_sessiond_command) cmd_ctx->lsm.cmd_type),
+				cmd_ctx->lsm.cmd_type, ret);
+		ret = LTTNG_ERR_UNK;
+	}
+
+	cmd_completion_handler = cmd_pop_completion_handler();
+	if (cmd_completion_handler) {
+		enum lttng_error_code completion_code;
+
+		completion_code = cmd_completion_handler->run(
+				cmd_completion_handler->data);
+		if (completion_code != LTTNG_OK) {
+			goto end;
+		}
+	}
+
+	health_code_update();
+
+	if (*sock >= 0) {
+		struct lttng_payload_view view =
+				lttng_payload_view_from_payload(
+						&cmd_ctx->reply_payload,
+						0, -1);
+		struct lttcomm_lttng_msg *llm = (typeof(
+				llm)) cmd_ctx->reply_payload.buffer.data;
+		/*
+		 * A failed command may not have received all of its data,
+		 * in which case the next command can't be received: the
+		 * connection is only kept after a successful command.
+		 */
+		const bool reusable = ret == LTTNG_OK && !sock_error;
+
+		LTTNG_ASSERT(cmd_ctx->reply_payload.buffer.size >= sizeof(*llm));
+		LTTNG_ASSERT(cmd_ctx->lttng_msg_size == cmd_ctx->reply_payload.buffer.size);
+
+		llm->fd_count = lttng_payload_view_get_fd_handle_count(&view);
+
+		DBG("Sending response (size: %d, retcode: %s (%d))",
+				cmd_ctx->lttng_msg_size,
+				lttng_strerror(-llm->ret_code),
+				llm->ret_code);
+		ret = send_unix_sock(*sock, &view);
+		if (ret < 0) {
+			ERR("Failed to send data back to client");
+			goto end;
+		}
+
+		keep_connection = reusable;
+	}
+
+end:
+	if (!keep_connection && *sock >= 0) {
+		/* End of transmission */
+		ret = close(*sock);
+		if (ret) {
+			PERROR("close");
+		}
+		*sock = -1;
+	}
+
+	health_code_update();
+}
+
+/*
+ * Process the commands of a client connection until the client has no command
+ * pending.
+ *
+ * The client may send its next command right away, without waiting for the
+ * reply to the previous one, in which case it is processed without going back
+ * to the client thread.
+ */
+static void handle_client_connection(struct command_ctx *cmd_ctx,
+		struct client_connection *connection)
+{
+	do {
+		handle_client_command(cmd_ctx, &connection->sock);
+	} while (connection->sock >= 0 &&
+			client_connection_has_data(connection->sock) == 1);
+}
+
+/*
+ * Client worker thread. Processes the commands of the client connections
+ * accepted by the client thread, concurrently with the other workers.
+ */
+static void *thread_client_worker(void *data __attribute__((unused)))
+{
+	struct client_connection *connection;
+	struct command_ctx cmd_ctx = {};
+
+	DBG("[thread] Client worker started");
+
+	lttng_payload_init(&cmd_ctx.reply_payload);
+
+	rcu_register_thread();
+
+	health_register(the_health_sessiond, HEALTH_SESSIOND_TYPE_CMD);
+
+	health_code_update();
+
+	while ((connection = wait_client_connection())) {
+		handle_client_connection(&cmd_ctx, connection);
+		if (connection->sock >= 0) {
+			return_client_connection(connection);
+		} else {
+			destroy_client_connection(connection);
+		}
+	}
+
+	health_unregister(the_health_sessiond);
+
+	DBG("Client worker dying");
+	lttng_payload_reset(&cmd_ctx.reply_payload);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+/*
+ * Stop the client workers and wait for them to exit.
+ */
+static void stop_client_workers(pthread_t *workers, unsigned int worker_count)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&connection_queue.lock);
+	connection_queue.quit = true;
+	pthread_cond_broadcast(&connection_queue.cond);
+	pthread_mutex_unlock(&connection_queue.lock);
+
+	for (i = 0; i < worker_count; i++) {
+		const int ret = pthread_join(workers[i], NULL);
+
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join client worker");
+		}
+	}
+
+	pthread_mutex_lock(&connection_queue.lock);
+	clear_client_connection_list(&connection_queue.list);
+	clear_client_connection_list(&connection_queue.returned_list);
+	pthread_mutex_unlock(&connection_queue.lock);
+}
+
+/*
+ * Accept a new client connection and hand it over to the client workers.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int accept_client_connection(int client_sock)
+{
+	int ret, sock;
+	struct client_connection *connection;
+
+	sock = lttcomm_accept_unix_sock(client_sock);
+	if (sock < 0) {
+		return -1;
+	}
+
+	/*
+	 * Set the CLOEXEC flag. Return code is useless because either way, the
+	 * show must go on.
+	 */
+	(void) utils_set_fd_cloexec(sock);
+
+	/* Set socket option for credentials retrieval */
+	ret = lttcomm_setsockopt_creds_unix_sock(sock);
+	if (ret < 0) {
+		goto error;
+	}
+
+	connection = zmalloc<client_connection>();
+	if (!connection) {
+		PERROR("zmalloc client connection");
+		goto error;
+	}
+
+	connection->sock = sock;
+	queue_client_connection(connection);
+	return 0;
+
+error:
+	ret = close(sock);
+	if (ret) {
+		PERROR("close");
+	}
+	return -1;
+}
+
+/*
+ * Poll the idle connections handed back by the client workers, waiting for
+ * their next command.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int poll_returned_client_connections(struct lttng_poll_event *events,
+		struct cds_list_head *idle_connections)
+{
+	int ret = 0;
+	char dummy;
+	struct client_connection *connection, *tmp;
+	struct cds_list_head returned;
+
+	if (lttng_pipe_read(connection_queue.returned_pipe, &dummy,
+			sizeof(dummy)) != sizeof(dummy)) {
+		PERROR("Failed to read the client connection return pipe");
+		return -1;
+	}
+
+	CDS_INIT_LIST_HEAD(&returned);
+	pthread_mutex_lock(&connection_queue.lock);
+	cds_list_splice(&connection_queue.returned_list, &returned);
+	CDS_INIT_LIST_HEAD(&connection_queue.returned_list);
+	pthread_mutex_unlock(&connection_queue.lock);
+
+	cds_list_for_each_entry_safe(connection, tmp, &returned, node) {
+		cds_list_del(&connection->node);
+		if (lttng_poll_add(events, connection->sock,
+				LPOLLIN | LPOLLRDHUP) < 0) {
+			destroy_client_connection(connection);
+			ret = -1;
+			continue;
+		}
+
+		cds_list_add_tail(&connection->node, idle_connections);
+	}
+
+	return ret;
+}
+
+/*
+ * Handle activity on an idle client connection: hand it over to the client
+ * workers if the client sent its next command, or close it if the client
+ * disconnected.
+ */
+static void resume_client_connection(struct lttng_poll_event *events,
+		struct cds_list_head *idle_connections, int sock)
+{
+	int ret;
+	struct client_connection *connection;
+
+	cds_list_for_each_entry(connection, idle_connections, node) {
+		if (connection->sock == sock) {
+			goto found;
+		}
+	}
+
+	ERR("Unexpected poll event on unknown client connection (sock = %d)",
+			sock);
+	return;
+
+found:
+	ret = client_connection_has_data(sock);
+	if (ret == 0) {
+		/* Spurious wake-up. */
+		return;
+	}
+
+	(void) lttng_poll_del(events, sock);
+	cds_list_del(&connection->node);
+	if (ret == 1) {
+		queue_client_connection(connection);
+	} else {
+		DBG("Client disconnected (sock = %d)", sock);
+		destroy_client_connection(connection);
+	}
+}
+
+/*
+ * This thread accepts the client connections on the unix client socket and
+ * hands them over to the client workers, which process the commands. Idle
+ * connections are polled by this thread until the client sends its next
+ * command or disconnects.
  */
 static void *thread_manage_clients(void *data)
 {
-	int sock = -1, ret, i, err = -1;
-	int sock_error;
+	int ret, i, err = -1;
 	uint32_t nb_fd;
 	struct lttng_poll_event events;
 	const int client_sock = thread_state.client_sock;
 	struct lttng_pipe *quit_pipe = (lttng_pipe *) data;
 	const int thread_quit_pipe_fd = lttng_pipe_get_readfd(quit_pipe);
-	struct command_ctx cmd_ctx = {};
+	int returned_pipe_fd;
+	pthread_t *workers = NULL;
+	unsigned int worker_count = 0;
+	struct cds_list_head idle_connections;
 
 	DBG("[thread] Manage client started");
 
-	lttng_payload_init(&cmd_ctx.reply_payload);
-
 	is_root = (getuid() == 0);
 
 	pthread_cleanup_push(thread_init_cleanup, NULL);
@@ -2480,16 +3195,22 @@ static void *thread_manage_clients(void *data)
 
 	health_code_update();
 
+	CDS_INIT_LIST_HEAD(&idle_connections);
+	CDS_INIT_LIST_HEAD(&connection_queue.list);
+	CDS_INIT_LIST_HEAD(&connection_queue.returned_list);
+	connection_queue.quit = false;
+
 	ret = lttcomm_listen_unix_sock(client_sock);
 	if (ret < 0) {
 		goto error_listen;
 	}
 
 	/*
-	 * Pass 2 as size here for the thread quit pipe and client_sock. Nothing
-	 * more will be added to this poll set.
+	 * Pass 3 as size here for the thread quit pipe, the return pipe and
+	 * client_sock. The idle client connections are added as they are
+	 * handed back by the workers.
 	 */
-	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	ret = lttng_poll_create(&events, 3, LTTNG_CLOEXEC);
 	if (ret < 0) {
 		goto error_create_poll;
 	}
@@ -2506,6 +3227,35 @@ static void *thread_manage_clients(void *data)
 		goto error;
 	}
 
+	connection_queue.returned_pipe = lttng_pipe_open(FD_CLOEXEC);
+	if (!connection_queue.returned_pipe) {
+		goto error;
+	}
+
+	returned_pipe_fd = lttng_pipe_get_readfd(connection_queue.returned_pipe);
+	ret = lttng_poll_add(&events, returned_pipe_fd, LPOLLIN);
+	if (ret < 0) {
+		goto error;
+	}
+
+	workers = calloc<pthread_t>(the_config.client_workers);
+	if (!workers) {
+		PERROR("Failed to allocate client workers");
+		goto error;
+	}
+
+	for (worker_count = 0; worker_count < the_config.client_workers;
+			worker_count++) {
+		ret = pthread_create(&workers[worker_count],
+				default_pthread_attr(), thread_client_worker, NULL);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create client worker");
+			goto error;
+		}
+	}
+	DBG("Started %u client worker(s)", worker_count);
+
 	/* Set state as running. */
 	set_thread_status(true);
 	pthread_cleanup_pop(0);
@@ -2522,15 +3272,6 @@ static void *thread_manage_clients(void *data)
 	health_code_update();
 
 	while (1) {
-		const struct cmd_completion_handler *cmd_completion_handler;
-
-		cmd_ctx.creds.uid = UINT32_MAX;
-		cmd_ctx.creds.gid = UINT32_MAX;
-		cmd_ctx.creds.pid = 0;
-		cmd_ctx.session = NULL;
-		lttng_payload_clear(&cmd_ctx.reply_payload);
-		cmd_ctx.lttng_msg_size = 0;
-
 		DBG("Accepting client command ...");
 
 		/* Inifinite blocking call, waiting for transmission */
@@ -2564,153 +3305,56 @@ static void *thread_manage_clients(void *data)
 				goto exit;
 			}
 
-			/* Event on the registration socket */
-			if (revents & LPOLLIN) {
-				continue;
-			} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
-				ERR("Client socket poll error");
-				goto error;
-			} else {
-				ERR("Unexpected poll events %u for sock %d", revents, pollfd);
-				goto error;
-			}
-		}
-
-		DBG("Wait for client response");
-
-		health_code_update();
-
-		sock = lttcomm_accept_unix_sock(client_sock);
-		if (sock < 0) {
-			goto error;
-		}
-
-		/*
-		 * Set the CLOEXEC flag. Return code is useless because either way, the
-		 * show must go on.
-		 */
-		(void) utils_set_fd_cloexec(sock);
-
-		/* Set socket option for credentials retrieval */
-		ret = lttcomm_setsockopt_creds_unix_sock(sock);
-		if (ret < 0) {
-			goto error;
-		}
-
-		health_code_update();
-
-		/*
-		 * Data is received from the lttng client. The struct
-		 * lttcomm_session_msg (lsm) contains the command and data request of
-		 * the client.
-		 */
-		DBG("Receiving data from client ...");
-		ret = lttcomm_recv_creds_unix_sock(sock, &cmd_ctx.lsm,
-				sizeof(struct lttcomm_session_msg), &cmd_ctx.creds);
-		if (ret != sizeof(struct lttcomm_session_msg)) {
-			DBG("Incomplete recv() from client... continuing");
-			ret = close(sock);
-			if (ret) {
-				PERROR("close");
-			}
-			sock = -1;
-			continue;
-		}
-
-		health_code_update();
-
-		// TODO: Validate cmd_ctx including sanity check for
-		// security purpose.
+			if (pollfd == returned_pipe_fd) {
+				if (!(revents & LPOLLIN)) {
+					ERR("Client connection return pipe poll error");
+					goto error;
+				}
 
-		rcu_thread_online();
-		/*
-		 * This function dispatch the work to the kernel or userspace tracer
-		 * libs and fill the lttcomm_lttng_msg data structure of all the needed
-		 * informations for the client. The command context struct contains
-		 * everything this function may needs.
-		 */
-		ret = process_client_msg(&cmd_ctx, &sock, &sock_error);
-		rcu_thread_offline();
-		if (ret < 0) {
-			if (sock >= 0) {
-				ret = close(sock);
-				if (ret) {
-					PERROR("close");
+				ret = poll_returned_client_connections(&events,
+						&idle_connections);
+				if (ret < 0) {
+					goto error;
 				}
+				continue;
 			}
-			sock = -1;
-			/*
-			 * TODO: Inform client somehow of the fatal error. At
-			 * this point, ret < 0 means that a zmalloc failed
-			 * (ENOMEM). Error detected but still accept
-			 * command, unless a socket error has been
-			 * detected.
-			 */
-			continue;
-		}
 
-		if (ret < LTTNG_OK || ret >= LTTNG_ERR_NR) {
-			WARN("Command returned an invalid status code, returning unknown error: "
-					"command type = %s (%d), ret = %d",
-					lttcomm_sessiond_command_str((lttcomm_sessiond_command) cmd_ctx.lsm.cmd_type),
-					cmd_ctx.lsm.cmd_type, ret);
-			ret = LTTNG_ERR_UNK;
-		}
-
-		cmd_completion_handler = cmd_pop_completion_handler();
-		if (cmd_completion_handler) {
-			enum lttng_error_code completion_code;
-
-			completion_code = cmd_completion_handler->run(
-					cmd_completion_handler->data);
-			if (completion_code != LTTNG_OK) {
+			if (pollfd != client_sock) {
+				/* Activity on an idle client connection. */
+				resume_client_connection(&events,
+						&idle_connections, pollfd);
 				continue;
 			}
-		}
-
-		health_code_update();
-
-		if (sock >= 0) {
-			struct lttng_payload_view view =
-					lttng_payload_view_from_payload(
-							&cmd_ctx.reply_payload,
-							0, -1);
-			struct lttcomm_lttng_msg *llm = (typeof(
-					llm)) cmd_ctx.reply_payload.buffer.data;
-
-			LTTNG_ASSERT(cmd_ctx.reply_payload.buffer.size >= sizeof(*llm));
-			LTTNG_ASSERT(cmd_ctx.lttng_msg_size == cmd_ctx.reply_payload.buffer.size);
 
-			llm->fd_count = lttng_payload_view_get_fd_handle_count(&view);
+			/* Event on the registration socket */
+			if (revents & LPOLLIN) {
+				DBG("Wait for client response");
 
-			DBG("Sending response (size: %d, retcode: %s (%d))",
-					cmd_ctx.lttng_msg_size,
-					lttng_strerror(-llm->ret_code),
-					llm->ret_code);
-			ret = send_unix_sock(sock, &view);
-			if (ret < 0) {
-				ERR("Failed to send data back to client");
-			}
+				health_code_update();
 
-			/* End of transmission */
-			ret = close(sock);
-			if (ret) {
-				PERROR("close");
+				ret = accept_client_connection(client_sock);
+				if (ret < 0) {
+					goto error;
+				}
+			} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
+				ERR("Client socket poll error");
+				goto error;
+			} else {
+				ERR("Unexpected poll events %u for sock %d", revents, pollfd);
+				goto error;
 			}
 		}
-		sock = -1;
 
 		health_code_update();
 	}
 
 exit:
 error:
-	if (sock >= 0) {
-		ret = close(sock);
-		if (ret) {
-			PERROR("close");
-		}
-	}
+	stop_client_workers(workers, worker_count);
+	free(workers);
+	clear_client_connection_list(&idle_connections);
+	lttng_pipe_destroy(connection_queue.returned_pipe);
+	connection_queue.returned_pipe = NULL;
 
 	lttng_poll_clean(&events);
 
@@ -2730,7 +3374,6 @@ error_create_poll:
 	health_unregister(the_health_sessiond);
 
 	DBG("Client thread dying");
-	lttng_payload_reset(&cmd_ctx.reply_payload);
 	rcu_unregister_thread();
 	return NULL;
 }
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <urcu/list.h>
+#include <urcu/tls-compat.h>
 #include <urcu/uatomic.h>
 
 #include <common/buffer-view.hpp>
@@ -98,14 +99,14 @@ struct cmd_destroy_session_reply_context {
 struct destroy_completion_handler {
 	struct cmd_completion_handler handler;
 	char shm_path[member_sizeof(struct ltt_session, shm_path)];
-} destroy_completion_handler = {
-	.handler = {
-		.run = wait_on_path,
-		.data = destroy_completion_handler.shm_path
-	},
-	.shm_path = { 0 },
 };
 
+/*
+ * Client commands are processed concurrently by the client worker threads,
+ * each of which runs the completion handler of the command it just processed.
+ */
+DEFINE_URCU_TLS(struct destroy_completion_handler, destroy_completion_handler);
+
 /*
  * Used to keep a unique index for each relayd socket created where this value
  * is associated with streams on the consumer so it can match the right relayd
@@ -116,7 +117,7 @@ pthread_mutex_t relayd_net_seq_idx_lock = PTHREAD_MUTEX_INITIALIZER;
 uint64_t relayd_net_seq_idx;
 } /* namespace */
 
-static struct cmd_completion_handler *current_completion_handler;
+static DEFINE_URCU_TLS(struct cmd_completion_handler *, current_completion_handler);
 static int validate_ust_event_name(const char *);
 static int cmd_enable_event_internal(struct ltt_session *session,
 		const struct lttng_domain *domain,
@@ -1285,6 +1286,56 @@ end:
 	return ret;
 }
 
+/*
+ * Packet compression is performed by the consumer daemon on the packets it
+ * copies from mapped sub-buffers to local trace files. Reject any other
+ * configuration.
+ */
+static enum lttng_error_code validate_channel_compression(
+		const struct ltt_session *session,
+		const struct lttng_channel *attr)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	const struct lttng_channel_extended *extended =
+			(const struct lttng_channel_extended *) attr->attr.extended.ptr;
+
+	if (extended->compression == LTTNG_CHANNEL_COMPRESSION_NONE) {
+		goto end;
+	}
+
+	if (extended->compression != LTTNG_CHANNEL_COMPRESSION_ZSTD) {
+		ERR("Unknown packet compression %d requested for channel '%s'",
+				(int) extended->compression, attr->name);
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+#ifndef HAVE_LIBZSTD
+	ERR("Packet compression requested for channel '%s' of session '%s', but the session daemon was built without zstd support",
+			attr->name, session->name);
+	ret_code = LTTNG_ERR_NOT_SUPPORTED;
+	goto end;
+#endif
+
+	if (attr->attr.output != LTTNG_EVENT_MMAP) {
+		ERR("Packet compression of channel '%s' requires the mmap output type",
+				attr->name);
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (session->snapshot_mode || session->snapshot.nb_output > 0 ||
+			!session->consumer ||
+			session->consumer->type != CONSUMER_DST_LOCAL) {
+		ERR("Packet compression of channel '%s' is only supported by sessions writing their trace locally (session '%s')",
+				attr->name, session->name);
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+end:
+	return ret_code;
+}
+
 static enum lttng_error_code cmd_enable_channel_internal(
 		struct ltt_session *session,
 		const struct lttng_domain *domain,
@@ -1360,6 +1411,11 @@ static enum lttng_error_code cmd_enable_channel_internal(
 		goto error;
 	}
 
+	ret_code = validate_channel_compression(session, attr);
+	if (ret_code != LTTNG_OK) {
+		goto error;
+	}
+
 	switch (domain->type) {
 	case LTTNG_DOMAIN_KERNEL:
 	{
@@ -2034,6 +2090,25 @@ end:
 	return ret;
 }
 
+/*
+ * Normalize the name and exclusion names of an event as globbing patterns.
+ */
+static void normalize_event_patterns(struct lttng_event *event,
+		struct lttng_event_exclusion *exclusion)
+{
+	strutils_normalize_star_glob_pattern(event->name);
+
+	if (exclusion) {
+		size_t i;
+
+		for (i = 0; i < exclusion->count; i++) {
+			char *name = LTTNG_EVENT_EXCLUSION_NAME_AT(exclusion, i);
+
+			strutils_normalize_star_glob_pattern(name);
+		}
+	}
+}
+
 /*
  * Internal version of cmd_enable_event() with a supplemental
  * "internal_event" flag which is used to enable internal events which should
@@ -2058,19 +2133,7 @@ static int _cmd_enable_event(struct ltt_session *session,
 	/* If we have a filter, we must have its filter expression */
 	LTTNG_ASSERT(!(!!filter_expression ^ !!filter));
 
-	/* Normalize event name as a globbing pattern */
-	strutils_normalize_star_glob_pattern(event->name);
-
-	/* Normalize exclusion names as globbing patterns */
-	if (exclusion) {
-		size_t i;
-
-		for (i = 0; i < exclusion->count; i++) {
-			char *name = LTTNG_EVENT_EXCLUSION_NAME_AT(exclusion, i);
-
-			strutils_normalize_star_glob_pattern(name);
-		}
-	}
+	normalize_event_patterns(event, exclusion);
 
 	DBG("Enable event command for event \'%s\'", event->name);
 
@@ -2471,6 +2534,219 @@ int cmd_enable_event(struct command_ctx *cmd_ctx,
 	return ret;
 }
 
+/*
+ * Check, for the events of a batch which isn't in the UST domain, what can be
+ * checked before any of them is enabled.
+ */
+static int validate_event_batch(struct ltt_session *session,
+		const struct lttng_domain *domain, const char *channel_name,
+		const struct event_enable_spec *specs, unsigned int count)
+{
+	unsigned int i;
+
+	switch (domain->type) {
+	case LTTNG_DOMAIN_KERNEL:
+		if (session->kernel_session->has_non_default_channel &&
+				channel_name[0] == '\0') {
+			return LTTNG_ERR_NEED_CHANNEL_NAME;
+		}
+
+		for (i = 0; i < count; i++) {
+			switch (specs[i].event->type) {
+			case LTTNG_EVENT_ALL:
+			case LTTNG_EVENT_PROBE:
+			case LTTNG_EVENT_FUNCTION:
+			case LTTNG_EVENT_FUNCTION_ENTRY:
+			case LTTNG_EVENT_TRACEPOINT:
+			case LTTNG_EVENT_SYSCALL:
+				break;
+			default:
+				return LTTNG_ERR_UNK;
+			}
+		}
+		break;
+	case LTTNG_DOMAIN_LOG4J:
+	case LTTNG_DOMAIN_JUL:
+	case LTTNG_DOMAIN_PYTHON:
+		if (!agent_tracing_is_enabled()) {
+			return LTTNG_ERR_AGENT_TRACING_DISABLED;
+		}
+		break;
+	default:
+		return LTTNG_ERR_UND;
+	}
+
+	return LTTNG_OK;
+}
+
+/*
+ * Command LTTNG_ENABLE_EVENTS processed by the client thread.
+ * We own the filters, exclusions, and filter expressions of the specs.
+ *
+ * In the UST domain, all the events of the batch are validated and created
+ * before any of them is enabled, then the batch is applied to the session in
+ * one pass and pushed to each application at once. The kernel tracer and the
+ * agents can't remove an event once created: the other domains check what
+ * can be checked for the whole batch, then enable the events one by one.
+ * Events which are already enabled are not an error.
+ */
+int cmd_enable_events(struct command_ctx *cmd_ctx,
+		struct event_enable_spec *specs, unsigned int count,
+		int wpipe)
+{
+	int ret = LTTNG_OK;
+	unsigned int i;
+	struct ltt_session *session = cmd_ctx->session;
+	struct ltt_ust_session *usess = session->ust_session;
+	struct ltt_ust_channel *uchan;
+	struct ltt_ust_event **uevents = NULL;
+	struct lttng_channel *attr = NULL;
+	char *channel_name = cmd_ctx->lsm.u.enable_events.channel_name;
+	/*
+	 * Copied to ensure proper alignment since 'lsm' is a packed structure.
+	 */
+	const lttng_domain command_domain = cmd_ctx->lsm.domain;
+
+	DBG("Enable events command for %u event(s)", count);
+
+	rcu_read_lock();
+
+	if (command_domain.type != LTTNG_DOMAIN_UST) {
+		ret = validate_event_batch(session, &command_domain,
+				channel_name, specs, count);
+		if (ret != LTTNG_OK) {
+			goto end;
+		}
+
+		for (i = 0; i < count; i++) {
+			/* Ownership is transferred to _cmd_enable_event. */
+			ret = _cmd_enable_event(session, &command_domain,
+					channel_name, specs[i].event,
+					specs[i].filter_expression,
+					specs[i].filter, specs[i].exclusion,
+					wpipe, false);
+			specs[i].filter_expression = NULL;
+			specs[i].filter = NULL;
+			specs[i].exclusion = NULL;
+			if (ret == LTTNG_ERR_UST_EVENT_ENABLED ||
+					ret == LTTNG_ERR_KERN_EVENT_EXIST) {
+				ret = LTTNG_OK;
+			}
+			if (ret != LTTNG_OK) {
+				goto end;
+			}
+		}
+		goto end;
+	}
+
+	LTTNG_ASSERT(usess);
+
+	/*
+	 * If a non-default channel has been created in the session,
+	 * explicitely require that -c chan_name needs to be provided.
+	 */
+	if (usess->has_non_default_channel && channel_name[0] == '\0') {
+		ret = LTTNG_ERR_NEED_CHANNEL_NAME;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct event_enable_spec *spec = &specs[i];
+
+		/* If we have a filter, we must have its filter expression */
+		LTTNG_ASSERT(!(!!spec->filter_expression ^ !!spec->filter));
+
+		normalize_event_patterns(spec->event, spec->exclusion);
+
+		/*
+		 * Ensure the event name is not reserved for internal use.
+		 */
+		if (validate_ust_event_name(spec->event->name)) {
+			WARN("Userspace event name %s failed validation.",
+					spec->event->name);
+			ret = LTTNG_ERR_INVALID_EVENT_NAME;
+			goto end;
+		}
+	}
+
+	uevents = calloc<ltt_ust_event *>(count);
+	if (!uevents) {
+		ret = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	/* Ownership of the specs' filters and exclusions is transferred. */
+	ret = event_ust_create_tracepoints(specs, count, uevents);
+	if (ret != LTTNG_OK) {
+		goto end;
+	}
+
+	/* Get channel from global UST domain */
+	uchan = trace_ust_find_channel_by_name(usess->domain_global.channels,
+			channel_name);
+	if (uchan == NULL) {
+		/* Create default channel */
+		attr = channel_new_default_attr(LTTNG_DOMAIN_UST,
+				usess->buffer_type);
+		if (attr == NULL) {
+			ret = LTTNG_ERR_FATAL;
+			goto end;
+		}
+		if (lttng_strncpy(attr->name, channel_name,
+				sizeof(attr->name))) {
+			ret = LTTNG_ERR_INVALID;
+			goto end;
+		}
+
+		ret = cmd_enable_channel_internal(
+				session, &command_domain, attr, wpipe);
+		if (ret != LTTNG_OK) {
+			goto end;
+		}
+
+		/* Get the newly created channel reference back */
+		uchan = trace_ust_find_channel_by_name(
+				usess->domain_global.channels, channel_name);
+		LTTNG_ASSERT(uchan);
+	}
+
+	if (uchan->domain != LTTNG_DOMAIN_UST) {
+		/*
+		 * Don't allow users to add UST events to channels which
+		 * are assigned to a userspace subdomain (JUL, Log4J,
+		 * Python, etc.).
+		 */
+		ret = LTTNG_ERR_INVALID_CHANNEL_DOMAIN;
+		goto end;
+	}
+
+	/* Ownership of the events is transferred. */
+	ret = event_ust_enable_tracepoints(usess, uchan, uevents, count);
+	free(uevents);
+	uevents = NULL;
+
+end:
+	if (uevents) {
+		for (i = 0; i < count; i++) {
+			if (uevents[i]) {
+				trace_ust_destroy_event(uevents[i]);
+			}
+		}
+		free(uevents);
+	}
+	for (i = 0; i < count; i++) {
+		free(specs[i].filter_expression);
+		free(specs[i].filter);
+		free(specs[i].exclusion);
+		specs[i].filter_expression = NULL;
+		specs[i].filter = NULL;
+		specs[i].exclusion = NULL;
+	}
+	channel_attr_destroy(attr);
+	rcu_read_unlock();
+	return ret;
+}
+
 /*
  * Enable an event which is internal to LTTng. An internal should
  * never be made visible to clients and are immune to checks such as
@@ -3534,11 +3810,15 @@ int cmd_destroy_session(struct ltt_session *session,
 		 * be destroyed properly, except that we can't offer the
 		 * guarantee that the same session can be re-created.
 		 */
-		current_completion_handler = &destroy_completion_handler.handler;
-		ret = lttng_strncpy(destroy_completion_handler.shm_path,
-				session->shm_path,
-				sizeof(destroy_completion_handler.shm_path));
+		struct destroy_completion_handler *handler =
+				&URCU_TLS(destroy_completion_handler);
+
+		handler->handler.run = wait_on_path;
+		handler->handler.data = handler->shm_path;
+		ret = lttng_strncpy(handler->shm_path, session->shm_path,
+				sizeof(handler->shm_path));
 		LTTNG_ASSERT(!ret);
+		URCU_TLS(current_completion_handler) = &handler->handler;
 	}
 
 	/*
@@ -3793,6 +4073,10 @@ enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 		struct lttng_ht_iter iter;
 		struct ltt_ust_channel *uchan;
 
+		if (session->ust_session == NULL) {
+			break;
+		}
+
 		rcu_read_lock();
 		cds_lfht_for_each_entry(session->ust_session->domain_global.channels->ht,
 				&iter.iter, uchan, node.node) {
@@ -4070,6 +4354,55 @@ error:
 	return ret;
 }
 
+/*
+ * Command LTTNG_LIST_STREAM_STATS from the lttng ctl library.
+ *
+ * Fill `stats` with the consumption statistics (struct lttng_stream_stats) of
+ * the streams of every domain of the session. Nothing is reported for a
+ * session that was never started since its streams are not consumed yet.
+ *
+ * Return LTTNG_OK on success or else a LTTNG_ERR code.
+ */
+enum lttng_error_code cmd_list_stream_stats(struct ltt_session *session,
+		struct lttng_dynamic_buffer *stats)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct ltt_kernel_session *ksess = session->kernel_session;
+	struct ltt_ust_session *usess = session->ust_session;
+
+	DBG("Listing stream statistics of session %s", session->name);
+
+	if (!session->has_been_started) {
+		ret_code = LTTNG_OK;
+		goto end;
+	}
+
+	if (ksess && ksess->consumer) {
+		ret = consumer_get_stream_stats(ksess->id, ksess->consumer,
+				LTTNG_DOMAIN_KERNEL, stats);
+		if (ret < 0) {
+			ret_code = ret == -ENOMEM ? LTTNG_ERR_NOMEM :
+					LTTNG_ERR_UNK;
+			goto end;
+		}
+	}
+
+	if (usess && usess->consumer) {
+		ret = consumer_get_stream_stats(usess->id, usess->consumer,
+				LTTNG_DOMAIN_UST, stats);
+		if (ret < 0) {
+			ret_code = ret == -ENOMEM ? LTTNG_ERR_NOMEM :
+					LTTNG_ERR_UNK;
+			goto end;
+		}
+	}
+
+	ret_code = LTTNG_OK;
+end:
+	return ret_code;
+}
+
 /*
  * Command LTTNG_SNAPSHOT_ADD_OUTPUT from the lttng ctl library.
  *
@@ -4123,6 +4456,8 @@ int cmd_snapshot_add_output(struct ltt_session *session,
 		goto free_error;
 	}
 
+	new_output->incremental = output->incremental;
+
 	rcu_read_lock();
 	snapshot_add_output(&session->snapshot, new_output);
 	if (id) {
@@ -4233,6 +4568,7 @@ ssize_t cmd_snapshot_list_outputs(struct ltt_session *session,
 		LTTNG_ASSERT(output->consumer);
 		list[idx].id = output->id;
 		list[idx].max_size = output->max_size;
+		list[idx].incremental = output->incremental;
 		if (lttng_strncpy(list[idx].name, output->name,
 				sizeof(list[idx].name))) {
 			ret = -LTTNG_ERR_INVALID;
@@ -5011,7 +5347,7 @@ static enum lttng_error_code record_kernel_snapshot(
 		struct ltt_kernel_session *ksess,
 		const struct consumer_output *output,
 		const struct ltt_session *session,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream, bool incremental)
 {
 	enum lttng_error_code status;
 
@@ -5020,7 +5356,7 @@ static enum lttng_error_code record_kernel_snapshot(
 	LTTNG_ASSERT(session);
 
 	status = kernel_snapshot_record(
-			ksess, output, nb_packets_per_stream);
+			ksess, output, nb_packets_per_stream, incremental);
 	return status;
 }
 
@@ -5032,7 +5368,7 @@ static enum lttng_error_code record_kernel_snapshot(
 static enum lttng_error_code record_ust_snapshot(struct ltt_ust_session *usess,
 		const struct consumer_output *output,
 		const struct ltt_session *session,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream, bool incremental)
 {
 	enum lttng_error_code status;
 
@@ -5041,7 +5377,7 @@ static enum lttng_error_code record_ust_snapshot(struct ltt_ust_session *usess,
 	LTTNG_ASSERT(session);
 
 	status = ust_app_snapshot_record(
-			usess, output, nb_packets_per_stream);
+			usess, output, nb_packets_per_stream, incremental);
 	return status;
 }
 
@@ -5255,7 +5591,7 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	if (session->kernel_session) {
 		ret_code = record_kernel_snapshot(session->kernel_session,
 				snapshot_kernel_consumer_output, session,
-				nb_packets_per_stream);
+				nb_packets_per_stream, snapshot_output->incremental);
 		if (ret_code != LTTNG_OK) {
 			goto error_close_trace_chunk;
 		}
@@ -5264,7 +5600,7 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	if (session->ust_session) {
 		ret_code = record_ust_snapshot(session->ust_session,
 				snapshot_ust_consumer_output, session,
-				nb_packets_per_stream);
+				nb_packets_per_stream, snapshot_output->incremental);
 		if (ret_code != LTTNG_OK) {
 			goto error_close_trace_chunk;
 		}
@@ -5372,6 +5708,7 @@ int cmd_snapshot_record(struct ltt_session *session,
 		}
 		/* Use the global session count for the temporary snapshot. */
 		tmp_output->nb_snapshot = session->snapshot.nb_snapshot;
+		tmp_output->incremental = output->incremental;
 
 		/* Use the global datetime */
 		memcpy(tmp_output->datetime, datetime, sizeof(datetime));
@@ -5401,6 +5738,8 @@ int cmd_snapshot_record(struct ltt_session *session,
 			}
 
 			output_copy.nb_snapshot = session->snapshot.nb_snapshot;
+			output_copy.incremental = output_copy.incremental ||
+					output->incremental;
 			memcpy(output_copy.datetime, datetime,
 					sizeof(datetime));
 
@@ -5985,9 +6324,10 @@ static enum lttng_error_code wait_on_path(void *path_data)
  */
 const struct cmd_completion_handler *cmd_pop_completion_handler(void)
 {
-	struct cmd_completion_handler *handler = current_completion_handler;
+	struct cmd_completion_handler *handler =
+			URCU_TLS(current_completion_handler);
 
-	current_completion_handler = NULL;
+	URCU_TLS(current_completion_handler) = NULL;
 	return handler;
 }
 
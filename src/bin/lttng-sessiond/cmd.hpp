@@ -16,6 +16,7 @@
 
 struct notification_thread_handle;
 struct lttng_dynamic_buffer;
+struct event_enable_spec;
 
 /*
  * A callback (and associated user data) that should be run after a command
@@ -94,6 +95,9 @@ int cmd_enable_event(struct command_ctx *cmd_ctx,
 		struct lttng_event_exclusion *exclusion,
 		struct lttng_bytecode *bytecode,
 		int wpipe);
+int cmd_enable_events(struct command_ctx *cmd_ctx,
+		struct event_enable_spec *specs, unsigned int count,
+		int wpipe);
 
 /* Trace session action commands */
 int cmd_start_trace(struct ltt_session *session);
@@ -129,6 +133,8 @@ enum lttng_error_code cmd_list_syscalls(
 		struct lttng_payload *reply_payload);
 
 int cmd_data_pending(struct ltt_session *session);
+enum lttng_error_code cmd_list_stream_stats(struct ltt_session *session,
+		struct lttng_dynamic_buffer *stats);
 
 /* Snapshot */
 int cmd_snapshot_add_output(struct ltt_session *session,
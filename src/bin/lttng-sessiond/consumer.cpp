@@ -918,6 +918,8 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		bool is_in_live_session,
 		unsigned int monitor_timer_interval,
 		int output,
+		enum lttng_channel_compression compression,
+		bool suppress_empty_packets,
 		int type,
 		uint64_t session_id,
 		const char *pathname,
@@ -967,6 +969,8 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.ask_channel.is_live = is_in_live_session;
 	msg->u.ask_channel.monitor_timer_interval = monitor_timer_interval;
 	msg->u.ask_channel.output = output;
+	msg->u.ask_channel.compression = (uint8_t) compression;
+	msg->u.ask_channel.suppress_empty_packets = suppress_empty_packets;
 	msg->u.ask_channel.type = type;
 	msg->u.ask_channel.session_id = session_id;
 	msg->u.ask_channel.session_id_per_pid = session_id_per_pid;
@@ -1013,6 +1017,8 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		const char *name,
 		unsigned int nb_init_streams,
 		enum lttng_event_output output,
+		enum lttng_channel_compression compression,
+		bool suppress_empty_packets,
 		int type,
 		uint64_t tracefile_size,
 		uint64_t tracefile_count,
@@ -1043,6 +1049,8 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.channel.relayd_id = relayd_id;
 	msg->u.channel.nb_init_streams = nb_init_streams;
 	msg->u.channel.output = output;
+	msg->u.channel.compression = (uint8_t) compression;
+	msg->u.channel.suppress_empty_packets = suppress_empty_packets;
 	msg->u.channel.type = type;
 	msg->u.channel.tracefile_size = tracefile_size;
 	msg->u.channel.tracefile_count = tracefile_count;
@@ -1506,7 +1514,8 @@ end:
 enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 		uint64_t key, const struct consumer_output *output, int metadata,
 		const char *channel_path,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream,
+		bool incremental)
 {
 	int ret;
 	enum lttng_error_code status = LTTNG_OK;
@@ -1522,6 +1531,7 @@ enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 	msg.u.snapshot_channel.key = key;
 	msg.u.snapshot_channel.nb_packets_per_stream = nb_packets_per_stream;
 	msg.u.snapshot_channel.metadata = metadata;
+	msg.u.snapshot_channel.incremental = incremental;
 
 	if (output->type == CONSUMER_DST_NET) {
 		msg.u.snapshot_channel.relayd_id =
@@ -1677,6 +1687,109 @@ end:
 	return ret;
 }
 
+/*
+ * Ask every consumer of an output for the consumption statistics of the
+ * streams of a session and append them, as struct lttng_stream_stats
+ * entries tagged with `domain`, to `stats`.
+ *
+ * Return 0 on success else a negative value.
+ */
+int consumer_get_stream_stats(uint64_t session_id,
+		struct consumer_output *consumer, enum lttng_domain_type domain,
+		struct lttng_dynamic_buffer *stats)
+{
+	int ret = 0;
+	struct consumer_socket *socket;
+	struct lttng_ht_iter iter;
+	struct lttcomm_consumer_msg msg;
+
+	LTTNG_ASSERT(consumer);
+	LTTNG_ASSERT(stats);
+
+	DBG3("Consumer stream statistics for session id %" PRIu64, session_id);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_GET_STREAM_STATS;
+	msg.u.get_stream_stats.session_id = session_id;
+
+	/* Send command for each consumer */
+	rcu_read_lock();
+	cds_lfht_for_each_entry(consumer->socks->ht, &iter.iter, socket,
+			node.node) {
+		uint64_t count = 0, i;
+		bool append_failed = false;
+
+		pthread_mutex_lock(socket->lock);
+		ret = consumer_socket_send(socket, &msg, sizeof(msg));
+		if (ret < 0) {
+			pthread_mutex_unlock(socket->lock);
+			goto end;
+		}
+
+		/*
+		 * No need for a recv reply status because the answer to the
+		 * command is the reply status message.
+		 */
+		ret = consumer_socket_recv(socket, &count, sizeof(count));
+		if (ret < 0) {
+			ERR("get stream statistics count");
+			pthread_mutex_unlock(socket->lock);
+			goto end;
+		}
+
+		for (i = 0; i < count; i++) {
+			struct lttcomm_consumer_stream_stats entry;
+			struct lttng_stream_stats user_entry;
+
+			ret = consumer_socket_recv(socket, &entry, sizeof(entry));
+			if (ret < 0) {
+				ERR("get stream statistics");
+				pthread_mutex_unlock(socket->lock);
+				goto end;
+			}
+
+			memset(&user_entry, 0, sizeof(user_entry));
+			user_entry.domain = domain;
+			memcpy(user_entry.channel_name, entry.channel_name,
+					sizeof(user_entry.channel_name));
+			user_entry.channel_name[sizeof(user_entry.channel_name) - 1] = '\0';
+			memcpy(user_entry.stream_name, entry.stream_name,
+					sizeof(user_entry.stream_name));
+			user_entry.stream_name[sizeof(user_entry.stream_name) - 1] = '\0';
+			user_entry.metadata = entry.metadata;
+			user_entry.subbuffers_consumed = entry.subbuffers_consumed;
+			user_entry.bytes_written = entry.bytes_written;
+			user_entry.write_syscalls = entry.write_syscalls;
+			user_entry.write_time_ns = entry.write_time_ns;
+			user_entry.relayd_sends = entry.relayd_sends;
+			user_entry.relayd_send_time_ns = entry.relayd_send_time_ns;
+			user_entry.relayd_send_max_ns = entry.relayd_send_max_ns;
+			user_entry.last_lag_ns = entry.last_lag_ns;
+			user_entry.max_lag_ns = entry.max_lag_ns;
+
+			/*
+			 * Keep draining the reply on allocation failure so the
+			 * socket remains usable.
+			 */
+			if (!append_failed && lttng_dynamic_buffer_append(stats,
+					&user_entry, sizeof(user_entry))) {
+				append_failed = true;
+			}
+		}
+		pthread_mutex_unlock(socket->lock);
+		if (append_failed) {
+			ERR("Failed to allocate stream statistics");
+			ret = -ENOMEM;
+			goto end;
+		}
+	}
+	ret = 0;
+
+end:
+	rcu_read_unlock();
+	return ret;
+}
+
 /*
  * Ask the consumer to rotate a channel.
  *
@@ -9,6 +9,7 @@
 #define _CONSUMER_H
 
 #include <common/consumer/consumer.hpp>
+#include <common/dynamic-buffer.hpp>
 #include <common/hashtable/hashtable.hpp>
 #include <lttng/lttng.h>
 #include <urcu/ref.h>
@@ -255,6 +256,8 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		bool is_in_live_session,
 		unsigned int monitor_timer_interval,
 		int output,
+		enum lttng_channel_compression compression,
+		bool suppress_empty_packets,
 		int type,
 		uint64_t session_id,
 		const char *pathname,
@@ -288,6 +291,8 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		const char *name,
 		unsigned int nb_init_streams,
 		enum lttng_event_output output,
+		enum lttng_channel_compression compression,
+		bool suppress_empty_packets,
 		int type,
 		uint64_t tracefile_size,
 		uint64_t tracefile_count,
@@ -311,11 +316,15 @@ int consumer_get_discarded_events(uint64_t session_id, uint64_t channel_key,
 		struct consumer_output *consumer, uint64_t *discarded);
 int consumer_get_lost_packets(uint64_t session_id, uint64_t channel_key,
 		struct consumer_output *consumer, uint64_t *lost);
+int consumer_get_stream_stats(uint64_t session_id,
+		struct consumer_output *consumer, enum lttng_domain_type domain,
+		struct lttng_dynamic_buffer *stats);
 
 /* Snapshot command. */
 enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 		uint64_t key, const struct consumer_output *output, int metadata,
-		const char *channel_path, uint64_t nb_packets_per_stream);
+		const char *channel_path, uint64_t nb_packets_per_stream,
+		bool incremental);
 
 /* Rotation commands. */
 int consumer_rotate_channel(struct consumer_socket *socket, uint64_t key,
@@ -7,9 +7,11 @@
  *
  */
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <urcu.h>
+#include <common/dynamic-array.hpp>
 #include <common/futex.hpp>
 #include <common/macros.hpp>
 
@@ -28,60 +30,184 @@ struct thread_notifiers {
 	int apps_cmd_notify_pipe_write_fd;
 	int dispatch_thread_exit;
 };
+
+/*
+ * Step of the setup of a batch of newly registered applications, applied to
+ * each application of the batch.
+ */
+typedef void (*app_setup_step_function)(struct ust_app *app, void *data);
+
+/*
+ * Pool of threads applying the setup steps to the applications of a batch
+ * concurrently. The dispatch thread posts the steps one at a time and applies
+ * them along with the workers, so the steps of an application remain in
+ * order.
+ */
+struct app_setup_pool {
+	pthread_mutex_t lock;
+	/* Signaled when a step is posted and when the workers must exit. */
+	pthread_cond_t step_cond;
+	/* Signaled when the last application of a step is set up. */
+	pthread_cond_t done_cond;
+	/* The following fields are protected by the lock. */
+	app_setup_step_function step;
+	void *step_data;
+	const struct lttng_dynamic_pointer_array *apps;
+	size_t app_count;
+	/* Index of the next application to which the step is applied. */
+	size_t next_app;
+	/* Number of applications to which the step is still being applied. */
+	size_t pending_apps;
+	bool quit;
+} app_setup_pool = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	NULL,
+	NULL,
+	NULL,
+	0,
+	0,
+	0,
+	false,
+};
+
+struct app_setup_status {
+	const struct thread_notifiers *notifiers;
+	/* Set when a socket can't be sent to its management thread. */
+	int error;
+};
 } /* namespace */
 
 /*
- * For each tracing session, update newly registered apps. The session list
- * lock MUST be acquired before calling this.
+ * Apply the current step of the application setup pool to one application.
+ * Called with the pool lock held, which is released while the step runs.
  */
-static void update_ust_app(int app_sock)
+static void apply_app_setup_step(void)
 {
-	struct ltt_session *sess, *stmp;
-	const struct ltt_session_list *session_list = session_get_list();
-	struct ust_app *app;
+	const size_t index = app_setup_pool.next_app++;
+	const app_setup_step_function step = app_setup_pool.step;
+	void *data = app_setup_pool.step_data;
+	struct ust_app *app = (struct ust_app *) lttng_dynamic_pointer_array_get_pointer(
+			app_setup_pool.apps, index);
 
-	/* Consumer is in an ERROR state. Stop any application update. */
-	if (uatomic_read(&the_ust_consumerd_state) == CONSUMER_ERROR) {
-		/* Stop the update process since the consumer is dead. */
-		return;
+	pthread_mutex_unlock(&app_setup_pool.lock);
+	rcu_read_lock();
+	step(app, data);
+	rcu_read_unlock();
+	health_code_update();
+	pthread_mutex_lock(&app_setup_pool.lock);
+
+	app_setup_pool.pending_apps--;
+	if (app_setup_pool.pending_apps == 0) {
+		pthread_cond_signal(&app_setup_pool.done_cond);
 	}
+}
 
-	rcu_read_lock();
-	LTTNG_ASSERT(app_sock >= 0);
-	app = ust_app_find_by_sock(app_sock);
-	if (app == NULL) {
-		/*
-		 * Application can be unregistered before so
-		 * this is possible hence simply stopping the
-		 * update.
-		 */
-		DBG3("UST app update failed to find app sock %d",
-			app_sock);
-		goto unlock_rcu;
+/*
+ * Apply a setup step to every application of a batch using the application
+ * setup workers, and wait for it to complete.
+ */
+static void run_app_setup_step(app_setup_step_function step, void *data,
+		const struct lttng_dynamic_pointer_array *apps)
+{
+	pthread_mutex_lock(&app_setup_pool.lock);
+	app_setup_pool.step = step;
+	app_setup_pool.step_data = data;
+	app_setup_pool.apps = apps;
+	app_setup_pool.app_count = lttng_dynamic_pointer_array_get_count(apps);
+	app_setup_pool.next_app = 0;
+	app_setup_pool.pending_apps = app_setup_pool.app_count;
+	pthread_cond_broadcast(&app_setup_pool.step_cond);
+
+	/* Lend a hand rather than waiting idle. */
+	while (app_setup_pool.next_app < app_setup_pool.app_count) {
+		apply_app_setup_step();
 	}
 
-	/* Update all event notifiers for the app. */
-	ust_app_global_update_event_notifier_rules(app);
+	while (app_setup_pool.pending_apps > 0) {
+		pthread_cond_wait(&app_setup_pool.done_cond, &app_setup_pool.lock);
+	}
 
-	/* For all tracing session(s) */
-	cds_list_for_each_entry_safe(sess, stmp, &session_list->head, list) {
-		if (!session_get(sess)) {
-			continue;
+	app_setup_pool.step = NULL;
+	app_setup_pool.step_data = NULL;
+	app_setup_pool.apps = NULL;
+	app_setup_pool.app_count = 0;
+	app_setup_pool.next_app = 0;
+	pthread_mutex_unlock(&app_setup_pool.lock);
+}
+
+/*
+ * Application setup worker thread.
+ *
+ * The workers run the setup steps on behalf of the dispatch thread, which
+ * holds the locks the steps require for their whole duration: the session
+ * list lock and, during update_ust_app_step(), the lock of the session being
+ * updated. The workers never take or release these locks themselves. The
+ * lock ownership checks of the steps (ASSERT_LOCKED(),
+ * ASSERT_SESSION_LIST_LOCKED()) only verify that the mutex is held, not by
+ * whom, and hold true since run_app_setup_step() doesn't return before every
+ * worker is done with the step.
+ *
+ * Likewise, the session references a step takes (session_find_by_id()) are
+ * released by the worker with session_put() while the dispatch thread holds
+ * its own reference, so a worker never releases the last reference of a
+ * session.
+ */
+static void *thread_app_setup_worker(void *data __attribute__((unused)))
+{
+	DBG("[thread] Application setup worker started");
+
+	rcu_register_thread();
+
+	health_register(the_health_sessiond,
+			HEALTH_SESSIOND_TYPE_APP_REG_DISPATCH);
+
+	pthread_mutex_lock(&app_setup_pool.lock);
+	for (;;) {
+		health_poll_entry();
+		while (!app_setup_pool.quit &&
+				app_setup_pool.next_app >= app_setup_pool.app_count) {
+			pthread_cond_wait(&app_setup_pool.step_cond,
+					&app_setup_pool.lock);
 		}
-		session_lock(sess);
-		if (!sess->active || !sess->ust_session ||
-				!sess->ust_session->active) {
-			goto unlock_session;
+		health_poll_exit();
+
+		if (app_setup_pool.quit) {
+			break;
 		}
 
-		ust_app_global_update(sess->ust_session, app);
-	unlock_session:
-		session_unlock(sess);
-		session_put(sess);
+		apply_app_setup_step();
 	}
+	pthread_mutex_unlock(&app_setup_pool.lock);
 
-unlock_rcu:
-	rcu_read_unlock();
+	health_unregister(the_health_sessiond);
+
+	DBG("Application setup worker dying");
+	rcu_unregister_thread();
+	return NULL;
+}
+
+/*
+ * Stop the application setup workers and wait for them to exit.
+ */
+static void stop_app_setup_workers(pthread_t *workers, unsigned int worker_count)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&app_setup_pool.lock);
+	app_setup_pool.quit = true;
+	pthread_cond_broadcast(&app_setup_pool.step_cond);
+	pthread_mutex_unlock(&app_setup_pool.lock);
+
+	for (i = 0; i < worker_count; i++) {
+		const int ret = pthread_join(workers[i], NULL);
+
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join application setup worker");
+		}
+	}
 }
 
 /*
@@ -215,6 +341,179 @@ error:
 	return (int) ret;
 }
 
+/*
+ * First setup step: make the application visible to the rest of the session
+ * daemon, hand its notify socket over to the notify thread and add the
+ * event notifiers to it.
+ */
+static void add_ust_app_step(struct ust_app *app, void *data)
+{
+	int ret;
+	struct app_setup_status *status = (struct app_setup_status *) data;
+
+	/*
+	 * Add application to the global hash table. This needs to be
+	 * done before the update to the UST registry can locate the
+	 * application.
+	 */
+	ust_app_add(app);
+
+	/* Set app version. This call will print an error if needed. */
+	(void) ust_app_version(app);
+
+	(void) ust_app_setup_event_notifier_group(app);
+
+	/* Send notify socket through the notify pipe. */
+	ret = send_socket_to_thread(
+			status->notifiers->apps_cmd_notify_pipe_write_fd,
+			app->notify_sock);
+	if (ret < 0) {
+		uatomic_set(&status->error, 1);
+		return;
+	}
+
+	/* Consumer is in an ERROR state. Stop any application update. */
+	if (uatomic_read(&the_ust_consumerd_state) == CONSUMER_ERROR) {
+		return;
+	}
+
+	/* Update all event notifiers for the app. */
+	ust_app_global_update_event_notifier_rules(app);
+}
+
+/*
+ * Second setup step, applied for each active tracing session: update the
+ * application with the channels and events of the session.
+ *
+ * The session list lock and the session's lock are held by the dispatch
+ * thread for the duration of the step.
+ */
+static void update_ust_app_step(struct ust_app *app, void *data)
+{
+	struct ltt_ust_session *usess = (struct ltt_ust_session *) data;
+
+	/*
+	 * Application can be unregistered before so this is possible hence
+	 * simply stopping the update.
+	 */
+	if (ust_app_find_by_sock(app->sock) != app) {
+		DBG3("UST app update failed to find app sock %d", app->sock);
+		return;
+	}
+
+	ust_app_global_update(usess, app);
+}
+
+/*
+ * Last setup step: let the application run and hand its command socket over
+ * to the application management thread.
+ */
+static void register_done_ust_app_step(struct ust_app *app, void *data)
+{
+	int ret;
+	struct app_setup_status *status = (struct app_setup_status *) data;
+
+	/*
+	 * Don't care about return value. Let the manage apps threads
+	 * handle app unregistration upon socket close.
+	 */
+	(void) ust_app_register_done(app);
+
+	/*
+	 * Even if the application socket has been closed, send the app
+	 * to the thread and unregistration will take place at that
+	 * place.
+	 */
+	ret = send_socket_to_thread(status->notifiers->apps_cmd_pipe_write_fd,
+			app->sock);
+	if (ret < 0) {
+		uatomic_set(&status->error, 1);
+	}
+}
+
+/*
+ * Set up a batch of newly registered applications which received their notify
+ * socket: the applications are set up concurrently by the application setup
+ * workers.
+ *
+ * Return 0 on success, -1 if the sockets can't be sent to the application
+ * management threads.
+ */
+static int setup_ust_apps(const struct thread_notifiers *notifiers,
+		const struct lttng_dynamic_pointer_array *apps)
+{
+	int ret = 0;
+	struct ltt_session *sess, *stmp;
+	const struct ltt_session_list *session_list = session_get_list();
+	struct app_setup_status status = {
+		.notifiers = notifiers,
+		.error = 0,
+	};
+
+	DBG("Setting up %zu UST application(s)",
+			lttng_dynamic_pointer_array_get_count(apps));
+
+	/*
+	 * @session_lock_list
+	 *
+	 * Lock the global session list so from the register up to the
+	 * registration done message, no thread can see the applications and
+	 * change their state.
+	 */
+	session_lock_list();
+	rcu_read_lock();
+
+	run_app_setup_step(add_ust_app_step, &status, apps);
+	if (status.error) {
+		/*
+		 * No notify thread, stop the UST tracing. However, this is
+		 * not an internal error of the this thread.
+		 */
+		ret = -1;
+		goto end;
+	}
+
+	/* Consumer is in an ERROR state. Stop any application update. */
+	if (uatomic_read(&the_ust_consumerd_state) == CONSUMER_ERROR) {
+		goto register_done;
+	}
+
+	/*
+	 * For all tracing session(s). The applications of the batch are
+	 * updated concurrently for a given session, which remains locked.
+	 */
+	cds_list_for_each_entry_safe(sess, stmp, &session_list->head, list) {
+		if (!session_get(sess)) {
+			continue;
+		}
+		session_lock(sess);
+		if (!sess->active || !sess->ust_session ||
+				!sess->ust_session->active) {
+			goto unlock_session;
+		}
+
+		run_app_setup_step(update_ust_app_step, sess->ust_session, apps);
+	unlock_session:
+		session_unlock(sess);
+		session_put(sess);
+	}
+
+register_done:
+	run_app_setup_step(register_done_ust_app_step, &status, apps);
+	if (status.error) {
+		/*
+		 * No apps. thread, stop the UST tracing. However, this is
+		 * not an internal error of the this thread.
+		 */
+		ret = -1;
+	}
+
+end:
+	rcu_read_unlock();
+	session_unlock_list();
+	return ret;
+}
+
 static void cleanup_ust_dispatch_thread(void *data)
 {
 	free(data);
@@ -235,6 +534,11 @@ static void *thread_dispatch_ust_registration(void *data)
 		.head = {},
 	};
 	struct thread_notifiers *notifiers = (thread_notifiers *) data;
+	struct lttng_dynamic_pointer_array ready_apps;
+	pthread_t *workers = NULL;
+	unsigned int worker_count = 0;
+
+	lttng_dynamic_pointer_array_init(&ready_apps, NULL);
 
 	rcu_register_thread();
 
@@ -249,6 +553,24 @@ static void *thread_dispatch_ust_registration(void *data)
 
 	CDS_INIT_LIST_HEAD(&wait_queue.head);
 
+	workers = calloc<pthread_t>(the_config.app_setup_workers);
+	if (!workers) {
+		PERROR("Failed to allocate application setup workers");
+		goto error;
+	}
+
+	for (worker_count = 0; worker_count < the_config.app_setup_workers;
+			worker_count++) {
+		ret = pthread_create(&workers[worker_count], NULL,
+				thread_app_setup_worker, NULL);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create application setup worker");
+			goto error;
+		}
+	}
+	DBG("Started %u application setup worker(s)", worker_count);
+
 	DBG("[thread] Dispatch UST command started");
 
 	for (;;) {
@@ -375,79 +697,34 @@ static void *thread_dispatch_ust_registration(void *data)
 
 			if (app) {
 				/*
-				 * @session_lock_list
-				 *
-				 * Lock the global session list so from the register up to the
-				 * registration done message, no thread can see the application
-				 * and change its state.
-				 */
-				session_lock_list();
-				rcu_read_lock();
-
-				/*
-				 * Add application to the global hash table. This needs to be
-				 * done before the update to the UST registry can locate the
-				 * application.
+				 * Set up the applications which are ready once the
+				 * queue is drained, so the ones registering at the
+				 * same time are set up concurrently.
 				 */
-				ust_app_add(app);
-
-				/* Set app version. This call will print an error if needed. */
-				(void) ust_app_version(app);
-
-				(void) ust_app_setup_event_notifier_group(app);
-
-				/* Send notify socket through the notify pipe. */
-				ret = send_socket_to_thread(
-						notifiers->apps_cmd_notify_pipe_write_fd,
-						app->notify_sock);
-				if (ret < 0) {
-					rcu_read_unlock();
-					session_unlock_list();
-					/*
-					 * No notify thread, stop the UST tracing. However, this is
-					 * not an internal error of the this thread thus setting
-					 * the health error code to a normal exit.
-					 */
-					err = 0;
-					goto error;
+				ret = lttng_dynamic_pointer_array_add_pointer(
+						&ready_apps, app);
+				if (ret) {
+					ERR("Failed to queue UST application for setup: pid = %d",
+							app->pid);
+					ust_app_destroy(app);
 				}
+			}
+		} while (node != NULL);
 
+		if (lttng_dynamic_pointer_array_get_count(&ready_apps) > 0) {
+			ret = setup_ust_apps(notifiers, &ready_apps);
+			lttng_dynamic_pointer_array_clear(&ready_apps);
+			if (ret < 0) {
 				/*
-				 * Update newly registered application with the tracing
-				 * registry info already enabled information.
-				 */
-				update_ust_app(app->sock);
-
-				/*
-				 * Don't care about return value. Let the manage apps threads
-				 * handle app unregistration upon socket close.
-				 */
-				(void) ust_app_register_done(app);
-
-				/*
-				 * Even if the application socket has been closed, send the app
-				 * to the thread and unregistration will take place at that
-				 * place.
+				 * No application management thread, stop the UST
+				 * tracing. However, this is not an internal error
+				 * of the this thread thus setting the health error
+				 * code to a normal exit.
 				 */
-				ret = send_socket_to_thread(
-						notifiers->apps_cmd_pipe_write_fd,
-						app->sock);
-				if (ret < 0) {
-					rcu_read_unlock();
-					session_unlock_list();
-					/*
-					 * No apps. thread, stop the UST tracing. However, this is
-					 * not an internal error of the this thread thus setting
-					 * the health error code to a normal exit.
-					 */
-					err = 0;
-					goto error;
-				}
-
-				rcu_read_unlock();
-				session_unlock_list();
+				err = 0;
+				goto error;
 			}
-		} while (node != NULL);
+		}
 
 		health_poll_entry();
 		/* Futex wait on queue. Blocking call on futex() */
@@ -458,6 +735,10 @@ static void *thread_dispatch_ust_registration(void *data)
 	err = 0;
 
 error:
+	stop_app_setup_workers(workers, worker_count);
+	free(workers);
+	lttng_dynamic_pointer_array_reset(&ready_apps);
+
 	/* Clean up wait queue. */
 	cds_list_for_each_entry_safe(wait_node, tmp_wait_node,
 			&wait_queue.head, head) {
@@ -233,6 +233,143 @@ end:
 	return ret;
 }
 
+/*
+ * Create the UST events of a batch, without adding them to any channel.
+ *
+ * Either all the events are created or none is: on error, the events created
+ * so far are destroyed.
+ *
+ * The filter expressions, filters and exclusions of the specs are owned by
+ * this function; they are set to NULL on return.
+ */
+int event_ust_create_tracepoints(struct event_enable_spec *specs,
+		unsigned int count, struct ltt_ust_event **uevents)
+{
+	int ret = LTTNG_OK;
+	unsigned int i, created_count = 0;
+
+	LTTNG_ASSERT(specs);
+	LTTNG_ASSERT(uevents);
+
+	for (i = 0; i < count; i++) {
+		struct event_enable_spec *spec = &specs[i];
+
+		ret = trace_ust_create_event(spec->event,
+				spec->filter_expression, spec->filter,
+				spec->exclusion, false, &uevents[i]);
+		/* We have passed ownership */
+		spec->filter_expression = NULL;
+		spec->filter = NULL;
+		spec->exclusion = NULL;
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		created_count++;
+	}
+
+	return LTTNG_OK;
+
+error:
+	for (i = 0; i < created_count; i++) {
+		trace_ust_destroy_event(uevents[i]);
+		uevents[i] = NULL;
+	}
+	for (i = created_count; i < count; i++) {
+		free(specs[i].filter_expression);
+		free(specs[i].filter);
+		free(specs[i].exclusion);
+		specs[i].filter_expression = NULL;
+		specs[i].filter = NULL;
+		specs[i].exclusion = NULL;
+	}
+	return ret;
+}
+
+/*
+ * Enable a batch of UST events, created by event_ust_create_tracepoints(), in
+ * a channel of a UST session.
+ *
+ * The events are added to or enabled in the session's shadow state first,
+ * which can't fail, then the events that changed are pushed to the
+ * applications at once. Events of the batch which are already enabled are
+ * skipped.
+ *
+ * The events are owned by this function; those which are not added to the
+ * channel are destroyed.
+ */
+int event_ust_enable_tracepoints(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count)
+{
+	int ret = LTTNG_OK, sync_ret;
+	unsigned int i, changed_count = 0;
+	struct ltt_ust_event **changed = NULL;
+
+	LTTNG_ASSERT(usess);
+	LTTNG_ASSERT(uchan);
+	LTTNG_ASSERT(uevents);
+
+	changed = calloc<ltt_ust_event *>(count);
+	if (!changed) {
+		ret = LTTNG_ERR_NOMEM;
+		goto free_events;
+	}
+
+	rcu_read_lock();
+
+	for (i = 0; i < count; i++) {
+		struct ltt_ust_event *uevent;
+
+		uevent = trace_ust_find_event(uchan->events,
+				uevents[i]->attr.name, uevents[i]->filter,
+				(enum lttng_ust_abi_loglevel_type) uevents[i]->attr.loglevel_type,
+				uevents[i]->attr.loglevel, uevents[i]->exclusion);
+		if (!uevent) {
+			/* Add ltt ust event to channel */
+			uevent = uevents[i];
+			uevents[i] = NULL;
+			add_unique_ust_event(uchan->events, uevent);
+		}
+
+		if (uevent->enabled) {
+			/* Already enabled, possibly earlier in this batch. */
+			continue;
+		}
+
+		uevent->enabled = 1;
+		changed[changed_count++] = uevent;
+	}
+
+	if (!usess->active || changed_count == 0) {
+		goto end;
+	}
+
+	sync_ret = ust_app_synchronize_events_glb(usess, uchan, changed,
+			changed_count);
+	if (sync_ret < 0) {
+		if (sync_ret == -LTTNG_UST_ERR_EXIST) {
+			ret = LTTNG_ERR_UST_EVENT_EXIST;
+		} else {
+			ret = LTTNG_ERR_UST_ENABLE_FAIL;
+		}
+	}
+
+	DBG("%u UST event(s) enabled in channel %s", changed_count, uchan->name);
+
+end:
+	rcu_read_unlock();
+free_events:
+	for (i = 0; i < count; i++) {
+		if (uevents[i]) {
+			trace_ust_destroy_event(uevents[i]);
+			uevents[i] = NULL;
+		}
+	}
+	free(changed);
+	return ret;
+}
+
 /*
  * Disable UST tracepoint of a channel from a UST session.
  */
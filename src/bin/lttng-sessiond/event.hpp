@@ -12,6 +12,16 @@
 
 struct agent;
 
+/*
+ * Event to enable as part of a batch, along with its filter and exclusions.
+ */
+struct event_enable_spec {
+	struct lttng_event *event;
+	char *filter_expression;
+	struct lttng_bytecode *filter;
+	struct lttng_event_exclusion *exclusion;
+};
+
 int event_kernel_disable_event(struct ltt_kernel_channel *kchan,
 		const char *event_name, enum lttng_event_type event_type);
 
@@ -25,6 +35,11 @@ int event_ust_enable_tracepoint(struct ltt_ust_session *usess,
 		struct lttng_bytecode *filter,
 		struct lttng_event_exclusion *exclusion,
 		bool internal_event);
+int event_ust_create_tracepoints(struct event_enable_spec *specs,
+		unsigned int count, struct ltt_ust_event **uevents);
+int event_ust_enable_tracepoints(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count);
 int event_ust_disable_tracepoint(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan, const char *event_name);
 
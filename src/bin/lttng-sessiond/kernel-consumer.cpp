@@ -149,6 +149,9 @@ int kernel_consumer_add_channel(struct consumer_socket *sock,
 			channel->channel->name,
 			channel->stream_count,
 			channel->channel->attr.output,
+			(enum lttng_channel_compression)
+					channel_attr_extended->compression,
+			!!channel_attr_extended->suppress_empty_packets,
 			CONSUMER_CHANNEL_TYPE_DATA,
 			channel->channel->attr.tracefile_size,
 			channel->channel->attr.tracefile_count,
@@ -225,6 +228,8 @@ int kernel_consumer_add_metadata(struct consumer_socket *sock,
 			ksession->metadata->conf->name,
 			1,
 			ksession->metadata->conf->attr.output,
+			LTTNG_CHANNEL_COMPRESSION_NONE,
+			false,
 			CONSUMER_CHANNEL_TYPE_METADATA,
 			ksession->metadata->conf->attr.tracefile_size,
 			ksession->metadata->conf->attr.tracefile_count,
@@ -1664,7 +1664,7 @@ void kernel_destroy_channel(struct ltt_kernel_channel *kchan)
 enum lttng_error_code kernel_snapshot_record(
 		struct ltt_kernel_session *ksess,
 		const struct consumer_output *output,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream, bool incremental)
 {
 	int err, ret, saved_metadata_fd;
 	enum lttng_error_code status = LTTNG_OK;
@@ -1722,7 +1722,7 @@ enum lttng_error_code kernel_snapshot_record(
 		cds_list_for_each_entry(chan, &ksess->channel_list.head, list) {
 			status = consumer_snapshot_channel(socket, chan->key, output, 0,
 					&trace_path[consumer_path_offset],
-					nb_packets_per_stream);
+					nb_packets_per_stream, incremental);
 			if (status != LTTNG_OK) {
 				(void) kernel_consumer_destroy_metadata(socket,
 						ksess->metadata);
@@ -1732,7 +1732,7 @@ enum lttng_error_code kernel_snapshot_record(
 
 		/* Snapshot metadata, */
 		status = consumer_snapshot_channel(socket, ksess->metadata->key, output,
-				1, &trace_path[consumer_path_offset], 0);
+				1, &trace_path[consumer_path_offset], 0, false);
 		if (status != LTTNG_OK) {
 			goto error_consumer;
 		}
@@ -44,6 +44,7 @@
 #include <common/dynamic-buffer.hpp>
 #include <lttng/event-internal.hpp>
 #include "lttng-sessiond.hpp"
+#include "blob-store.hpp"
 #include "buffer-registry.hpp"
 #include "channel.hpp"
 #include "cmd.hpp"
@@ -1869,8 +1870,9 @@ int main(int argc, char **argv)
 		goto stop_threads;
 	}
 
-	/* Create thread to manage application notify socket */
-	if (!launch_application_notification_thread(apps_cmd_notify_pipe[0])) {
+	/* Create threads to manage application notify sockets */
+	if (!launch_application_notification_threads(apps_cmd_notify_pipe[0],
+			the_config.app_notify_threads)) {
 		retval = -1;
 		goto stop_threads;
 	}
@@ -1967,6 +1969,9 @@ stop_threads:
 	 */
 	rcu_barrier();
 
+	/* The UST apps released the blobs they shared. */
+	blob_store_destroy();
+
 	if (notification_thread) {
 		lttng_thread_shutdown(notification_thread);
 		lttng_thread_put(notification_thread);
@@ -21,12 +21,75 @@
 namespace {
 struct thread_notifiers {
 	struct lttng_pipe *quit_pipe;
+	/* Receives the notify sockets assigned to this thread. */
+	struct lttng_pipe *sock_pipe;
+	/* Number of notify sockets managed by this thread; accessed atomically. */
+	unsigned long sock_count;
+	/*
+	 * Read side of the pipe on which the dispatch thread sends the notify
+	 * sockets, -1 for all the threads but the one which distributes them.
+	 */
 	int apps_cmd_notify_pipe_read_fd;
 };
+
+/*
+ * Application notification threads. The notify sockets are spread across
+ * them so the registrations of the events, channels and enumerations of
+ * different applications are handled concurrently; the registry updates
+ * remain serialized by the lock of each registry session.
+ */
+struct notification_threads {
+	struct thread_notifiers *threads;
+	unsigned int count;
+	/* Number of threads not cleaned up yet; accessed atomically. */
+	int refcount;
+} notification_threads;
 } /* namespace */
 
 /*
- * This thread manage application notify communication.
+ * Assign a notify socket received from the dispatch thread to the notification
+ * thread managing the fewest sockets.
+ *
+ * Return 0 on success, -1 if the socket can't be handed over, in which case it
+ * is closed.
+ */
+static int distribute_notify_sock(int sock)
+{
+	int ret;
+	ssize_t size_ret;
+	unsigned int i;
+	struct thread_notifiers *target = &notification_threads.threads[0];
+
+	for (i = 1; i < notification_threads.count; i++) {
+		struct thread_notifiers *candidate =
+				&notification_threads.threads[i];
+
+		if (uatomic_read(&candidate->sock_count) <
+				uatomic_read(&target->sock_count)) {
+			target = candidate;
+		}
+	}
+
+	uatomic_inc(&target->sock_count);
+	size_ret = lttng_pipe_write(target->sock_pipe, &sock, sizeof(sock));
+	if (size_ret < sizeof(sock)) {
+		PERROR("Failed to hand over notify socket %d", sock);
+		uatomic_dec(&target->sock_count);
+		ret = close(sock);
+		if (ret) {
+			PERROR("close notify socket %d", sock);
+		}
+		lttng_fd_put(LTTNG_FD_APPS, 1);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * This thread manage application notify communication. Each notification
+ * thread manages its share of the notify sockets; the first one also
+ * distributes the sockets received from the dispatch thread.
  */
 static void *thread_application_notification(void *data)
 {
@@ -36,6 +99,7 @@ static void *thread_application_notification(void *data)
 	struct lttng_poll_event events;
 	struct thread_notifiers *notifiers = (thread_notifiers *) data;
 	const auto thread_quit_pipe_fd = lttng_pipe_get_readfd(notifiers->quit_pipe);
+	const auto sock_pipe_fd = lttng_pipe_get_readfd(notifiers->sock_pipe);
 
 	DBG("[ust-thread] Manage application notify command");
 
@@ -51,14 +115,22 @@ static void *thread_application_notification(void *data)
 
 	health_code_update();
 
-	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	ret = lttng_poll_create(&events, 3, LTTNG_CLOEXEC);
 	if (ret < 0) {
 		goto error_poll_create;
 	}
 
 	/* Add notify pipe to the pollset. */
-	ret = lttng_poll_add(&events, notifiers->apps_cmd_notify_pipe_read_fd,
-			LPOLLIN | LPOLLRDHUP);
+	if (notifiers->apps_cmd_notify_pipe_read_fd >= 0) {
+		ret = lttng_poll_add(&events,
+				notifiers->apps_cmd_notify_pipe_read_fd,
+				LPOLLIN | LPOLLRDHUP);
+		if (ret < 0) {
+			goto error;
+		}
+	}
+
+	ret = lttng_poll_add(&events, sock_pipe_fd, LPOLLIN | LPOLLRDHUP);
 	if (ret < 0) {
 		goto error;
 	}
@@ -120,6 +192,27 @@ restart:
 					}
 					health_code_update();
 
+					(void) distribute_notify_sock(sock);
+				} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
+					ERR("Apps notify command pipe error");
+					goto error;
+				} else {
+					ERR("Unexpected poll events %u for sock %d", revents, pollfd);
+					goto error;
+				}
+			} else if (pollfd == sock_pipe_fd) {
+				/* Inspect the pipe of the sockets assigned to this thread. */
+				int sock;
+
+				if (revents & LPOLLIN) {
+					size_ret = lttng_pipe_read(notifiers->sock_pipe,
+							&sock, sizeof(sock));
+					if (size_ret < sizeof(sock)) {
+						PERROR("read notify socket pipe");
+						goto error;
+					}
+					health_code_update();
+
 					ret = lttng_poll_add(&events, sock, LPOLLIN | LPOLLRDHUP);
 					if (ret < 0) {
 						/*
@@ -131,11 +224,12 @@ restart:
 							PERROR("close notify socket %d", sock);
 						}
 						lttng_fd_put(LTTNG_FD_APPS, 1);
+						uatomic_dec(&notifiers->sock_count);
 						continue;
 					}
 					DBG3("UST thread notify added sock %d to pollset", sock);
 				} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
-					ERR("Apps notify command pipe error");
+					ERR("Notify socket pipe error");
 					goto error;
 				} else {
 					ERR("Unexpected poll events %u for sock %d", revents, pollfd);
@@ -157,6 +251,7 @@ restart:
 
 						/* The socket is closed after a grace period here. */
 						ust_app_notify_sock_unregister(pollfd);
+						uatomic_dec(&notifiers->sock_count);
 					}
 				} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
 					/* Removing from the poll set */
@@ -167,6 +262,7 @@ restart:
 
 					/* The socket is closed after a grace period here. */
 					ust_app_notify_sock_unregister(pollfd);
+					uatomic_dec(&notifiers->sock_count);
 				} else {
 					ERR("Unexpected poll events %u for sock %d", revents, pollfd);
 					goto error;
@@ -201,44 +297,81 @@ static bool shutdown_application_notification_thread(void *data)
 	return notify_thread_pipe(write_fd) == 1;
 }
 
-static void cleanup_application_notification_thread(void *data)
+/*
+ * The threads share their notifiers, which are released along with the last
+ * thread.
+ */
+static void cleanup_application_notification_thread(
+		void *data __attribute__((unused)))
 {
-	struct thread_notifiers *notifiers = (thread_notifiers *) data;
+	unsigned int i;
+
+	if (uatomic_sub_return(&notification_threads.refcount, 1) > 0) {
+		return;
+	}
 
-	lttng_pipe_destroy(notifiers->quit_pipe);
-	free(notifiers);
+	for (i = 0; i < notification_threads.count; i++) {
+		lttng_pipe_destroy(notification_threads.threads[i].quit_pipe);
+		lttng_pipe_destroy(notification_threads.threads[i].sock_pipe);
+	}
+	free(notification_threads.threads);
+	notification_threads.threads = NULL;
+	notification_threads.count = 0;
 }
 
-bool launch_application_notification_thread(int apps_cmd_notify_pipe_read_fd)
+bool launch_application_notification_threads(int apps_cmd_notify_pipe_read_fd,
+		unsigned int thread_count)
 {
+	unsigned int i;
 	struct lttng_thread *thread;
-	struct thread_notifiers *notifiers;
-	struct lttng_pipe *quit_pipe;
 
-	notifiers = zmalloc<thread_notifiers>();
-	if (!notifiers) {
-		goto error_alloc;
+	LTTNG_ASSERT(thread_count > 0);
+
+	notification_threads.threads = calloc<thread_notifiers>(thread_count);
+	if (!notification_threads.threads) {
+		PERROR("Failed to allocate application notification threads");
+		return false;
 	}
-	notifiers->apps_cmd_notify_pipe_read_fd = apps_cmd_notify_pipe_read_fd;
+	notification_threads.count = thread_count;
 
-	quit_pipe = lttng_pipe_open(FD_CLOEXEC);
-	if (!quit_pipe) {
-		goto error;
+	for (i = 0; i < thread_count; i++) {
+		struct thread_notifiers *notifiers = &notification_threads.threads[i];
+
+		notifiers->apps_cmd_notify_pipe_read_fd =
+				i == 0 ? apps_cmd_notify_pipe_read_fd : -1;
+		notifiers->quit_pipe = lttng_pipe_open(FD_CLOEXEC);
+		notifiers->sock_pipe = lttng_pipe_open(FD_CLOEXEC);
+		if (!notifiers->quit_pipe || !notifiers->sock_pipe) {
+			goto error;
+		}
 	}
-	notifiers->quit_pipe = quit_pipe;
-
-	thread = lttng_thread_create("Application notification",
-			thread_application_notification,
-			shutdown_application_notification_thread,
-			cleanup_application_notification_thread,
-			notifiers);
-	if (!thread) {
-		goto error;
+
+	/* Hold a reference until all the threads are launched. */
+	notification_threads.refcount = 1;
+	for (i = 0; i < thread_count; i++) {
+		uatomic_inc(&notification_threads.refcount);
+		thread = lttng_thread_create("Application notification",
+				thread_application_notification,
+				shutdown_application_notification_thread,
+				cleanup_application_notification_thread,
+				&notification_threads.threads[i]);
+		if (!thread) {
+			/*
+			 * The reference of the thread was released by its
+			 * cleanup if it was created; drop the launch reference.
+			 */
+			cleanup_application_notification_thread(NULL);
+			return false;
+		}
+		lttng_thread_put(thread);
 	}
-	lttng_thread_put(thread);
+
+	DBG("Launched %u application notification thread(s)", thread_count);
+	cleanup_application_notification_thread(NULL);
 	return true;
+
 error:
-	cleanup_application_notification_thread(notifiers);
-error_alloc:
+	notification_threads.refcount = 1;
+	cleanup_application_notification_thread(NULL);
 	return false;
 }
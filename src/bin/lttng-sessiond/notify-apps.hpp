@@ -10,13 +10,15 @@
 
 #ifdef HAVE_LIBLTTNG_UST_CTL
 
-bool launch_application_notification_thread(int apps_cmd_notify_pipe_read_fd);
+bool launch_application_notification_threads(int apps_cmd_notify_pipe_read_fd,
+		unsigned int thread_count);
 
 #else /* HAVE_LIBLTTNG_UST_CTL */
 
 static
-bool launch_application_notification_thread(
-		int apps_cmd_notify_pipe_read_fd __attribute__((unused)))
+bool launch_application_notification_threads(
+		int apps_cmd_notify_pipe_read_fd __attribute__((unused)),
+		unsigned int thread_count __attribute__((unused)))
 {
 	return true;
 }
@@ -123,6 +123,26 @@ int save_kernel_channel_attributes(struct config_writer *writer,
 			ret = LTTNG_ERR_SAVE_IO_FAIL;
 			goto end;
 		}
+
+		if (ext->compression != LTTNG_CHANNEL_COMPRESSION_NONE) {
+			ret = config_writer_write_element_string(writer,
+					config_element_compression,
+					config_compression_zstd);
+			if (ret) {
+				ret = LTTNG_ERR_SAVE_IO_FAIL;
+				goto end;
+			}
+		}
+
+		if (ext->suppress_empty_packets) {
+			ret = config_writer_write_element_bool(writer,
+					config_element_suppress_empty_packets,
+					1);
+			if (ret) {
+				ret = LTTNG_ERR_SAVE_IO_FAIL;
+				goto end;
+			}
+		}
 	}
 
 	ret = LTTNG_OK;
@@ -178,9 +198,14 @@ int save_ust_channel_attributes(struct config_writer *writer,
 		goto end;
 	}
 
+	/*
+	 * Fetch the monitor timer and consumer output which are located in the
+	 * parent of lttng_ust_channel_attr
+	 */
+	channel = lttng::utils::container_of(attr, &ltt_ust_channel::attr);
 	ret = config_writer_write_element_string(writer,
 		config_element_output_type,
-		attr->output == LTTNG_UST_ABI_MMAP ?
+		channel->consumer_output == LTTNG_EVENT_MMAP ?
 		config_output_type_mmap : config_output_type_splice);
 	if (ret) {
 		ret = LTTNG_ERR_SAVE_IO_FAIL;
@@ -195,11 +220,6 @@ int save_ust_channel_attributes(struct config_writer *writer,
 		goto end;
 	}
 
-	/*
-	 * Fetch the monitor timer which is located in the parent of
-	 * lttng_ust_channel_attr
-	 */
-	channel = lttng::utils::container_of(attr, &ltt_ust_channel::attr);
 	ret = config_writer_write_element_unsigned_int(writer,
 		config_element_monitor_timer_interval,
 		channel->monitor_timer_interval);
@@ -208,6 +228,25 @@ int save_ust_channel_attributes(struct config_writer *writer,
 		goto end;
 	}
 
+	if (channel->compression != LTTNG_CHANNEL_COMPRESSION_NONE) {
+		ret = config_writer_write_element_string(writer,
+				config_element_compression,
+				config_compression_zstd);
+		if (ret) {
+			ret = LTTNG_ERR_SAVE_IO_FAIL;
+			goto end;
+		}
+	}
+
+	if (channel->suppress_empty_packets) {
+		ret = config_writer_write_element_bool(writer,
+				config_element_suppress_empty_packets, 1);
+		if (ret) {
+			ret = LTTNG_ERR_SAVE_IO_FAIL;
+			goto end;
+		}
+	}
+
 	ret = LTTNG_OK;
 end:
 	return ret;
@@ -2449,6 +2488,15 @@ int save_snapshot_outputs(struct config_writer *writer,
 			goto end_unlock;
 		}
 
+		if (output->incremental) {
+			ret = config_writer_write_element_bool(writer,
+				config_element_incremental, 1);
+			if (ret) {
+				ret = LTTNG_ERR_SAVE_IO_FAIL;
+				goto end_unlock;
+			}
+		}
+
 		ret = save_consumer_output(writer, output->consumer);
 		if (ret != LTTNG_OK) {
 			goto end_unlock;
@@ -303,50 +303,43 @@ end:
 /*
  * Allocate the ltt_sessions_ht_by_id and ltt_sessions_ht_by_name HT.
  *
+ * The hash tables are kept for the lifetime of the session daemon since
+ * ltt_sessions_ht_by_name is looked up without the session list lock (see
+ * session_find_by_name_rcu()).
+ *
  * The session list lock must be held.
  */
 static int ltt_sessions_ht_alloc(void)
 {
 	int ret = 0;
+	struct lttng_ht *ht_by_id = NULL, *ht_by_name = NULL;
 
 	DBG("Allocating ltt_sessions_ht_by_id");
-	ltt_sessions_ht_by_id = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
-	if (!ltt_sessions_ht_by_id) {
+	ht_by_id = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
+	if (!ht_by_id) {
 		ret = -1;
 		ERR("Failed to allocate ltt_sessions_ht_by_id");
-		goto end;
+		goto error;
 	}
 
 	DBG("Allocating ltt_sessions_ht_by_name");
-	ltt_sessions_ht_by_name = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
-	if (!ltt_sessions_ht_by_name) {
+	ht_by_name = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
+	if (!ht_by_name) {
 		ret = -1;
 		ERR("Failed to allocate ltt_sessions_ht_by_name");
-		goto end;
+		goto error;
 	}
 
-end:
-	return ret;
-}
-
-/*
- * Destroy the ltt_sessions_ht_by_id HT.
- *
- * The session list lock must be held.
- */
-static void ltt_sessions_ht_destroy(void)
-{
-	if (ltt_sessions_ht_by_id) {
-		lttng_ht_destroy(ltt_sessions_ht_by_id);
-		ltt_sessions_ht_by_id = NULL;
-	}
+	rcu_assign_pointer(ltt_sessions_ht_by_id, ht_by_id);
+	rcu_assign_pointer(ltt_sessions_ht_by_name, ht_by_name);
+	goto end;
 
-	if (ltt_sessions_ht_by_name) {
-		lttng_ht_destroy(ltt_sessions_ht_by_name);
-		ltt_sessions_ht_by_name = NULL;
+error:
+	if (ht_by_id) {
+		lttng_ht_destroy(ht_by_id);
 	}
-
-	return;
+end:
+	return ret;
 }
 
 /*
@@ -381,52 +374,8 @@ end:
 	return;
 }
 
-/*
- * Test if ltt_sessions_ht_by_id/name are empty.
- * Return `false` if hash table objects are null.
- * The session list lock must be held.
- */
-static bool ltt_sessions_ht_empty(void)
-{
-	bool empty = false;
-
-	if (!ltt_sessions_ht_by_id) {
-		/* The hash tables do not exist yet. */
-		goto end;
-	}
-
-	LTTNG_ASSERT(ltt_sessions_ht_by_name);
-
-	if (lttng_ht_get_count(ltt_sessions_ht_by_id) != 0) {
-		/* Not empty.*/
-		goto end;
-	}
-
-	/*
-	 * At this point it is expected that the `ltt_sessions_ht_by_name` ht is
-	 * empty.
-	 *
-	 * The removal from both hash tables is done in two different
-	 * places:
-	 *   - removal from `ltt_sessions_ht_by_name` is done during
-	 *     `session_destroy()`
-	 *   - removal from `ltt_sessions_ht_by_id` is done later
-	 *     in `session_release()` on the last reference put.
-	 *
-	 * This means that it is possible for `ltt_sessions_ht_by_name` to be
-	 * empty but for `ltt_sessions_ht_by_id` to still contain objects when
-	 * multiple sessions exists. The reverse is false, hence this sanity
-	 * check.
-	 */
-	LTTNG_ASSERT(lttng_ht_get_count(ltt_sessions_ht_by_name) == 0);
-	empty = true;
-end:
-	return empty;
-}
-
 /*
  * Remove a ltt_session from the ltt_sessions_ht_by_id.
- * If empty, the ltt_sessions_ht_by_id/name HTs are freed.
  * The session list lock must be held.
  */
 static void del_session_ht(struct ltt_session *ls)
@@ -441,11 +390,6 @@ static void del_session_ht(struct ltt_session *ls)
 	iter.iter.node = &ls->node.node;
 	ret = lttng_ht_del(ltt_sessions_ht_by_id, &iter);
 	LTTNG_ASSERT(!ret);
-
-	if (ltt_sessions_ht_empty()) {
-		DBG("Empty ltt_sessions_ht_by_id/name, destroying hast tables");
-		ltt_sessions_ht_destroy();
-	}
 }
 
 /*
@@ -973,6 +917,23 @@ void session_notify_clear(struct ltt_session *session)
 	lttng_dynamic_array_clear(&session->clear_notifiers);
 }
 
+/*
+ * RCU protected session free.
+ *
+ * Sessions can be looked up by name under the RCU read-side lock only (see
+ * session_find_by_name_rcu()), so their memory must outlive the readers that
+ * may still see them in the session hash tables.
+ */
+static void free_session_rcu(struct rcu_head *head)
+{
+	struct lttng_ht_node_u64 *node =
+		lttng::utils::container_of(head, &lttng_ht_node_u64::head);
+	struct ltt_session *session =
+		lttng::utils::container_of(node, &ltt_session::node);
+
+	free(session);
+}
+
 static
 void session_release(struct urcu_ref *ref)
 {
@@ -1039,11 +1000,11 @@ void session_release(struct urcu_ref *ref)
 	free(session->last_archived_chunk_name);
 	free(session->base_path);
 	lttng_trigger_put(session->rotate_trigger);
-	free(session);
+	call_rcu(&session->node.head, free_session_rcu);
 	if (session_published) {
 		/*
-		 * Broadcast after free-ing to ensure the memory is
-		 * reclaimed before the main thread exits.
+		 * Broadcast after queuing the free; the main thread waits
+		 * for pending RCU callbacks (rcu_barrier()) before exiting.
 		 */
 		ASSERT_LOCKED(the_session_list.lock);
 		pthread_cond_broadcast(&the_session_list.removal_cond);
@@ -1076,6 +1037,36 @@ void session_put(struct ltt_session *session)
 	urcu_ref_put(&session->ref, session_release);
 }
 
+/*
+ * Release a reference to a session without holding the session list lock.
+ *
+ * The session list lock is only acquired when this may be the last reference
+ * to the session, since its release removes it from the session list.
+ */
+void session_put_unlocked(struct ltt_session *session)
+{
+	long refcount;
+
+	if (!session) {
+		return;
+	}
+
+	refcount = uatomic_read(&session->ref.refcount);
+	while (refcount > 1) {
+		const long old = uatomic_cmpxchg(&session->ref.refcount,
+				refcount, refcount - 1);
+
+		if (old == refcount) {
+			return;
+		}
+		refcount = old;
+	}
+
+	session_lock_list();
+	session_put(session);
+	session_unlock_list();
+}
+
 /*
  * Destroy a session.
  *
@@ -1160,6 +1151,49 @@ found:
 	return session_get(iter) ? iter : NULL;
 }
 
+/*
+ * Return a ltt_session structure ptr that matches name without requiring the
+ * session list lock. If no session found, NULL is returned.
+ *
+ * A reference to the session is implicitly acquired by this function. Since
+ * the session may be destroyed concurrently, the caller must check its
+ * "destroyed" flag once it holds the session's lock. The reference can be
+ * released without the session list lock using session_put_unlocked().
+ */
+struct ltt_session *session_find_by_name_rcu(const char *name)
+{
+	struct lttng_ht *ht;
+	struct lttng_ht_node_str *node;
+	struct lttng_ht_iter iter;
+	struct ltt_session *ls = NULL;
+
+	LTTNG_ASSERT(name);
+
+	DBG2("Trying to find session by name %s without the session list lock",
+			name);
+
+	rcu_read_lock();
+	ht = rcu_dereference(ltt_sessions_ht_by_name);
+	if (!ht) {
+		goto end;
+	}
+
+	lttng_ht_lookup(ht, name, &iter);
+	node = lttng_ht_iter_get_node_str(&iter);
+	if (node == NULL) {
+		goto end;
+	}
+
+	ls = lttng::utils::container_of(node, &ltt_session::node_by_name);
+	if (!session_get(ls)) {
+		/* The session is being released. */
+		ls = NULL;
+	}
+end:
+	rcu_read_unlock();
+	return ls;
+}
+
 /*
  * Return an ltt_session that matches the id. If no session is found,
  * NULL is returned. This must be called with rcu_read_lock and
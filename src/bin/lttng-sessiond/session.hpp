@@ -245,6 +245,7 @@ void session_notify_clear(struct ltt_session *session);
 
 bool session_get(struct ltt_session *session);
 void session_put(struct ltt_session *session);
+void session_put_unlocked(struct ltt_session *session);
 
 enum consumer_dst_type session_get_consumer_destination_type(
 		const struct ltt_session *session);
@@ -257,6 +258,7 @@ struct lttng_trace_archive_location *session_get_trace_archive_location(
 		const struct ltt_session *session);
 
 struct ltt_session *session_find_by_name(const char *name);
+struct ltt_session *session_find_by_name_rcu(const char *name);
 struct ltt_session *session_find_by_id(ltt_session::id_t id);
 
 struct ltt_session_list *session_get_list(void);
@@ -26,6 +26,9 @@ struct sessiond_config sessiond_config_build_defaults = {
 	.event_notifier_buffer_size_kernel =	DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE,
 	.event_notifier_buffer_size_userspace =	DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE,
 	.app_socket_timeout = 			DEFAULT_APP_SOCKET_RW_TIMEOUT,
+	.app_notify_threads =			DEFAULT_SESSIOND_APP_NOTIFY_THREADS,
+	.app_setup_workers =			DEFAULT_SESSIOND_APP_SETUP_WORKERS,
+	.client_workers =			DEFAULT_SESSIOND_CLIENT_WORKERS,
 
 	.quiet =		        	false,
 
@@ -119,6 +122,60 @@ int sessiond_config_apply_env_config(struct sessiond_config *config)
 		config->app_socket_timeout = int_val;
 	}
 
+	env_value = getenv(DEFAULT_SESSIOND_APP_NOTIFY_THREADS_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || int_val == 0 ||
+				int_val > UINT_MAX) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable",
+					env_value, DEFAULT_SESSIOND_APP_NOTIFY_THREADS_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->app_notify_threads = (unsigned int) int_val;
+	}
+
+	env_value = getenv(DEFAULT_SESSIOND_APP_SETUP_WORKERS_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || int_val == 0 ||
+				int_val > UINT_MAX) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable",
+					env_value, DEFAULT_SESSIOND_APP_SETUP_WORKERS_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->app_setup_workers = (unsigned int) int_val;
+	}
+
+	env_value = getenv(DEFAULT_SESSIOND_CLIENT_WORKERS_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || int_val == 0 ||
+				int_val > UINT_MAX) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable",
+					env_value, DEFAULT_SESSIOND_CLIENT_WORKERS_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->client_workers = (unsigned int) int_val;
+	}
+
 	env_value = lttng_secure_getenv("LTTNG_CONSUMERD32_BIN");
 	if (env_value) {
 		config_string_set_static(&config->consumerd32_bin_path,
@@ -511,6 +568,9 @@ void sessiond_config_log(struct sessiond_config *config)
 				config->agent_tcp_port.end);
 	}
 	DBG_NO_LOC("\tapplication socket timeout:    %i", config->app_socket_timeout);
+	DBG_NO_LOC("\tapplication notify threads:    %u", config->app_notify_threads);
+	DBG_NO_LOC("\tapplication setup workers:     %u", config->app_setup_workers);
+	DBG_NO_LOC("\tclient workers:                %u", config->client_workers);
 	DBG_NO_LOC("\tno-kernel:                     %s", config->no_kernel ? "True" : "False");
 	DBG_NO_LOC("\tbackground:                    %s", config->background ? "True" : "False");
 	DBG_NO_LOC("\tdaemonize:                     %s", config->daemonize ? "True" : "False");
@@ -33,6 +33,12 @@ struct sessiond_config {
 	int event_notifier_buffer_size_userspace;
 	/* Socket timeout for receiving and sending (in seconds). */
 	int app_socket_timeout;
+	/* Number of threads handling the notify sockets of the applications. */
+	unsigned int app_notify_threads;
+	/* Number of threads setting up newly registered applications. */
+	unsigned int app_setup_workers;
+	/* Number of threads processing the client commands. */
+	unsigned int client_workers;
 
 	bool quiet;
 	bool no_kernel;
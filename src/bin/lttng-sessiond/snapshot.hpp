@@ -25,6 +25,8 @@ struct snapshot_output {
 	uint64_t max_size;
 	/* Number of snapshot taken with that output. */
 	uint64_t nb_snapshot;
+	/* Only record the sub-buffers produced since the previous snapshot. */
+	bool incremental;
 	char name[NAME_MAX];
 	struct consumer_output *consumer;
 	int kernel_sockets_copied;
@@ -302,6 +302,7 @@ struct ltt_ust_session *trace_ust_create_session(uint64_t session_id)
 	lus->buffer_type_changed = 0;
 	/* Init it in case it get used after allocation. */
 	CDS_INIT_LIST_HEAD(&lus->buffer_reg_uid_list);
+	pthread_mutex_init(&lus->buffer_reg_uid_setup_lock, NULL);
 
 	/* Alloc UST global domain channels' HT */
 	lus->domain_global.channels = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
@@ -371,6 +372,11 @@ struct ltt_ust_channel *trace_ust_create_channel(struct lttng_channel *chan,
 			chan->attr.extended.ptr)->monitor_timer_interval;
 	luc->attr.u.s.blocking_timeout = ((struct lttng_channel_extended *)
 			chan->attr.extended.ptr)->blocking_timeout;
+	luc->compression = (enum lttng_channel_compression)
+			((struct lttng_channel_extended *)
+					chan->attr.extended.ptr)->compression;
+	luc->suppress_empty_packets = !!((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->suppress_empty_packets;
 
 	/* Translate to UST output enum */
 	switch (luc->attr.output) {
@@ -379,6 +385,10 @@ struct ltt_ust_channel *trace_ust_create_channel(struct lttng_channel *chan,
 		break;
 	}
 
+	/* The consumer daemon may splice the buffers the tracer maps. */
+	luc->consumer_output = chan->attr.output == LTTNG_EVENT_SPLICE ?
+			LTTNG_EVENT_SPLICE : LTTNG_EVENT_MMAP;
+
 	/*
 	 * If we receive an empty string for channel name, it means the
 	 * default channel name is requested.
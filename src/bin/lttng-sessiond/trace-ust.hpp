@@ -74,6 +74,16 @@ struct ltt_ust_channel {
 	uint64_t per_pid_closed_app_discarded;
 	uint64_t per_pid_closed_app_lost;
 	uint64_t monitor_timer_interval;
+	/*
+	 * Output type used by the consumer daemon to extract the content of the
+	 * ring buffers. The tracer always shares its buffers through mmap
+	 * (see attr.output).
+	 */
+	enum lttng_event_output consumer_output;
+	/* Compression of the packets written by the consumer daemon. */
+	enum lttng_channel_compression compression;
+	/* Don't write the packets holding no event (see the consumer daemon). */
+	bool suppress_empty_packets;
 };
 
 /* UST domain global (LTTNG_DOMAIN_UST) */
@@ -110,6 +120,12 @@ struct ltt_ust_session {
 	int buffer_type_changed;
 	/* For per UID buffer, every buffer reg object is kept of this session */
 	struct cds_list_head buffer_reg_uid_list;
+	/*
+	 * Serializes the lookup and creation of the per UID buffer registries
+	 * of this session, and protects buffer_reg_uid_list while applications
+	 * are set up concurrently.
+	 */
+	pthread_mutex_t buffer_reg_uid_setup_lock;
 	/* Next channel ID available for a newly registered channel. */
 	uint64_t next_channel_id;
 	/* Once this value reaches UINT32_MAX, no more id can be allocated. */
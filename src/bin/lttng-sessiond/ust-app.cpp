@@ -8,6 +8,7 @@
 
 #define _LGPL_SOURCE
 
+#include "blob-store.hpp"
 #include "buffer-registry.hpp"
 #include "condition-internal.hpp"
 #include "event-notifier-error-accounting.hpp"
@@ -349,9 +350,8 @@ void delete_ust_app_event(int sock, struct ust_app_event *ua_event,
 	LTTNG_ASSERT(ua_event);
 	ASSERT_RCU_READ_LOCKED();
 
-	free(ua_event->filter);
-	if (ua_event->exclusion != NULL)
-		free(ua_event->exclusion);
+	blob_store_put(ua_event->filter);
+	blob_store_put(ua_event->exclusion);
 	if (ua_event->obj != NULL) {
 		pthread_mutex_lock(&app->sock_lock);
 		ret = lttng_ust_ctl_release_object(sock, ua_event->obj);
@@ -394,12 +394,15 @@ static void delete_ust_app_event_notifier_rule(int sock,
 		struct ust_app *app)
 {
 	int ret;
+	unsigned int i;
 
 	LTTNG_ASSERT(ua_event_notifier_rule);
 
-	if (ua_event_notifier_rule->exclusion != NULL) {
-		free(ua_event_notifier_rule->exclusion);
+	blob_store_put(ua_event_notifier_rule->exclusion);
+	for (i = 0; i < ua_event_notifier_rule->capture_bytecode_count; i++) {
+		blob_store_put(ua_event_notifier_rule->capture_bytecodes[i]);
 	}
+	free(ua_event_notifier_rule->capture_bytecodes);
 
 	if (ua_event_notifier_rule->obj != NULL) {
 		pthread_mutex_lock(&app->sock_lock);
@@ -1234,6 +1237,9 @@ struct ust_app_channel *alloc_ust_app_channel(const char *name,
 	}
 	/* By default, the channel is a per cpu channel. */
 	ua_chan->attr.type = LTTNG_UST_ABI_CHAN_PER_CPU;
+	ua_chan->consumer_output = LTTNG_EVENT_MMAP;
+	ua_chan->compression = LTTNG_CHANNEL_COMPRESSION_NONE;
+	ua_chan->suppress_empty_packets = false;
 
 	DBG3("UST app channel %s allocated", ua_chan->name);
 
@@ -1311,6 +1317,8 @@ static struct ust_app_event_notifier_rule *alloc_ust_app_event_notifier_rule(
 	struct ust_app_event_notifier_rule *ua_event_notifier_rule;
 	struct lttng_condition *condition = NULL;
 	const struct lttng_event_rule *event_rule = NULL;
+	struct lttng_event_exclusion *exclusion = NULL;
+	unsigned int capture_bytecode_count, i;
 
 	ua_event_notifier_rule = zmalloc<ust_app_event_notifier_rule>();
 	if (ua_event_notifier_rule == NULL) {
@@ -1341,9 +1349,16 @@ static struct ust_app_event_notifier_rule *alloc_ust_app_event_notifier_rule(
 	ua_event_notifier_rule->trigger = trigger;
 	ua_event_notifier_rule->filter = lttng_event_rule_get_filter_bytecode(event_rule);
 	generate_exclusion_status = lttng_event_rule_generate_exclusions(
-			event_rule, &ua_event_notifier_rule->exclusion);
+			event_rule, &exclusion);
 	switch (generate_exclusion_status) {
 	case LTTNG_EVENT_RULE_GENERATE_EXCLUSIONS_STATUS_OK:
+		ua_event_notifier_rule->exclusion = blob_store_get_exclusion(exclusion);
+		free(exclusion);
+		if (!ua_event_notifier_rule->exclusion) {
+			ERR("Failed to share exclusions while allocating an event notifier rule");
+			goto error_put_trigger;
+		}
+		break;
 	case LTTNG_EVENT_RULE_GENERATE_EXCLUSIONS_STATUS_NONE:
 		break;
 	default:
@@ -1352,11 +1367,50 @@ static struct ust_app_event_notifier_rule *alloc_ust_app_event_notifier_rule(
 		goto error_put_trigger;
 	}
 
+	cond_status = lttng_condition_event_rule_matches_get_capture_descriptor_count(
+			condition, &capture_bytecode_count);
+	LTTNG_ASSERT(cond_status == LTTNG_CONDITION_STATUS_OK);
+
+	if (capture_bytecode_count) {
+		ua_event_notifier_rule->capture_bytecodes =
+				calloc<const lttng_bytecode *>(capture_bytecode_count);
+		if (!ua_event_notifier_rule->capture_bytecodes) {
+			PERROR("Failed to allocate capture bytecode array of event notifier rule");
+			goto error_put_blobs;
+		}
+	}
+
+	/*
+	 * The sequence number of a capture bytecode is its index, which
+	 * orders the captured fields at runtime and on reception of the
+	 * captured payloads.
+	 */
+	for (i = 0; i < capture_bytecode_count; i++) {
+		const struct lttng_bytecode *capture_bytecode =
+				lttng_condition_event_rule_matches_get_capture_bytecode_at_index(
+						condition, i);
+
+		ua_event_notifier_rule->capture_bytecodes[i] =
+				blob_store_get_capture_bytecode(capture_bytecode, i);
+		if (!ua_event_notifier_rule->capture_bytecodes[i]) {
+			ERR("Failed to share capture bytecode while allocating an event notifier rule");
+			goto error_put_blobs;
+		}
+
+		ua_event_notifier_rule->capture_bytecode_count++;
+	}
+
 	DBG3("UST app event notifier rule allocated: token = %" PRIu64,
 			ua_event_notifier_rule->token);
 
 	return ua_event_notifier_rule;
 
+error_put_blobs:
+	for (i = 0; i < ua_event_notifier_rule->capture_bytecode_count; i++) {
+		blob_store_put(ua_event_notifier_rule->capture_bytecodes[i]);
+	}
+	free(ua_event_notifier_rule->capture_bytecodes);
+	blob_store_put(ua_event_notifier_rule->exclusion);
 error_put_trigger:
 	lttng_trigger_put(trigger);
 error:
@@ -1404,54 +1458,6 @@ error:
 	return NULL;
 }
 
-/*
- * Create a liblttng-ust filter bytecode from given bytecode.
- *
- * Return allocated filter or NULL on error.
- */
-static struct lttng_ust_abi_filter_bytecode *create_ust_filter_bytecode_from_bytecode(
-		const struct lttng_bytecode *orig_f)
-{
-	struct lttng_ust_abi_filter_bytecode *filter = NULL;
-
-	/* Copy filter bytecode. */
-	filter = zmalloc<lttng_ust_abi_filter_bytecode>(sizeof(*filter) + orig_f->len);
-	if (!filter) {
-		PERROR("Failed to allocate lttng_ust_filter_bytecode: bytecode len = %" PRIu32 " bytes", orig_f->len);
-		goto error;
-	}
-
-	LTTNG_ASSERT(sizeof(struct lttng_bytecode) ==
-			sizeof(struct lttng_ust_abi_filter_bytecode));
-	memcpy(filter, orig_f, sizeof(*filter) + orig_f->len);
-error:
-	return filter;
-}
-
-/*
- * Create a liblttng-ust capture bytecode from given bytecode.
- *
- * Return allocated filter or NULL on error.
- */
-static struct lttng_ust_abi_capture_bytecode *
-create_ust_capture_bytecode_from_bytecode(const struct lttng_bytecode *orig_f)
-{
-	struct lttng_ust_abi_capture_bytecode *capture = NULL;
-
-	/* Copy capture bytecode. */
-	capture = zmalloc<lttng_ust_abi_capture_bytecode>(sizeof(*capture) + orig_f->len);
-	if (!capture) {
-		PERROR("Failed to allocate lttng_ust_abi_capture_bytecode: bytecode len = %" PRIu32 " bytes", orig_f->len);
-		goto error;
-	}
-
-	LTTNG_ASSERT(sizeof(struct lttng_bytecode) ==
-			sizeof(struct lttng_ust_abi_capture_bytecode));
-	memcpy(capture, orig_f, sizeof(*capture) + orig_f->len);
-error:
-	return capture;
-}
-
 /*
  * Find an ust_app using the sock and return it. RCU read side lock must be
  * held before calling this helper function.
@@ -1614,6 +1620,47 @@ error:
 	return ret;
 }
 
+/*
+ * Filters, capture bytecodes and exclusions are sent to the tracer as-is,
+ * without being converted to their liblttng-ust counterparts, which must
+ * therefore share their layout.
+ */
+#define ASSERT_SAME_FIELD(type, field, ust_type, ust_field)			\
+	static_assert(offsetof(struct type, field) ==				\
+			offsetof(struct ust_type, ust_field) &&			\
+			sizeof(((struct type *) NULL)->field) ==		\
+			sizeof(((struct ust_type *) NULL)->ust_field),		\
+			#type "." #field " matches " #ust_type "." #ust_field)
+
+static_assert(sizeof(struct lttng_bytecode) ==
+		sizeof(struct lttng_ust_abi_filter_bytecode),
+		"lttng_bytecode matches lttng_ust_abi_filter_bytecode");
+ASSERT_SAME_FIELD(lttng_bytecode, len, lttng_ust_abi_filter_bytecode, len);
+ASSERT_SAME_FIELD(lttng_bytecode, reloc_table_offset,
+		lttng_ust_abi_filter_bytecode, reloc_offset);
+ASSERT_SAME_FIELD(lttng_bytecode, seqnum, lttng_ust_abi_filter_bytecode, seqnum);
+ASSERT_SAME_FIELD(lttng_bytecode, data, lttng_ust_abi_filter_bytecode, data);
+
+static_assert(sizeof(struct lttng_bytecode) ==
+		sizeof(struct lttng_ust_abi_capture_bytecode),
+		"lttng_bytecode matches lttng_ust_abi_capture_bytecode");
+ASSERT_SAME_FIELD(lttng_bytecode, len, lttng_ust_abi_capture_bytecode, len);
+ASSERT_SAME_FIELD(lttng_bytecode, reloc_table_offset,
+		lttng_ust_abi_capture_bytecode, reloc_offset);
+ASSERT_SAME_FIELD(lttng_bytecode, seqnum, lttng_ust_abi_capture_bytecode, seqnum);
+ASSERT_SAME_FIELD(lttng_bytecode, data, lttng_ust_abi_capture_bytecode, data);
+
+static_assert(sizeof(struct lttng_event_exclusion) ==
+		sizeof(struct lttng_ust_abi_event_exclusion),
+		"lttng_event_exclusion matches lttng_ust_abi_event_exclusion");
+ASSERT_SAME_FIELD(lttng_event_exclusion, count,
+		lttng_ust_abi_event_exclusion, count);
+static_assert(offsetof(struct lttng_event_exclusion, names) ==
+		offsetof(struct lttng_ust_abi_event_exclusion, names),
+		"lttng_event_exclusion.names matches lttng_ust_abi_event_exclusion.names");
+static_assert(LTTNG_SYMBOL_NAME_LEN == LTTNG_UST_ABI_SYM_NAME_LEN,
+		"Exclusion names have the same length as in liblttng-ust");
+
 /*
  * Set the filter on the tracer.
  */
@@ -1622,17 +1669,12 @@ static int set_ust_object_filter(struct ust_app *app,
 		struct lttng_ust_abi_object_data *ust_object)
 {
 	int ret;
-	struct lttng_ust_abi_filter_bytecode *ust_bytecode = NULL;
 
 	health_code_update();
 
-	ust_bytecode = create_ust_filter_bytecode_from_bytecode(bytecode);
-	if (!ust_bytecode) {
-		ret = -LTTNG_ERR_NOMEM;
-		goto error;
-	}
 	pthread_mutex_lock(&app->sock_lock);
-	ret = lttng_ust_ctl_set_filter(app->sock, ust_bytecode,
+	ret = lttng_ust_ctl_set_filter(app->sock,
+			(struct lttng_ust_abi_filter_bytecode *) bytecode,
 			ust_object);
 	pthread_mutex_unlock(&app->sock_lock);
 	if (ret < 0) {
@@ -1655,38 +1697,25 @@ static int set_ust_object_filter(struct ust_app *app,
 
 error:
 	health_code_update();
-	free(ust_bytecode);
 	return ret;
 }
 
 /*
  * Set a capture bytecode for the passed object.
- * The sequence number enforces the ordering at runtime and on reception of
- * the captured payloads.
+ * The sequence number of the bytecode, which must already be set, enforces
+ * the ordering at runtime and on reception of the captured payloads.
  */
 static int set_ust_capture(struct ust_app *app,
 		const struct lttng_bytecode *bytecode,
-		unsigned int capture_seqnum,
 		struct lttng_ust_abi_object_data *ust_object)
 {
 	int ret;
-	struct lttng_ust_abi_capture_bytecode *ust_bytecode = NULL;
 
 	health_code_update();
 
-	ust_bytecode = create_ust_capture_bytecode_from_bytecode(bytecode);
-	if (!ust_bytecode) {
-		ret = -LTTNG_ERR_NOMEM;
-		goto error;
-	}
-
-	/*
-	 * Set the sequence number to ensure the capture of fields is ordered.
-	 */
-	ust_bytecode->seqnum = capture_seqnum;
-
 	pthread_mutex_lock(&app->sock_lock);
-	ret = lttng_ust_ctl_set_capture(app->sock, ust_bytecode,
+	ret = lttng_ust_ctl_set_capture(app->sock,
+			(struct lttng_ust_abi_capture_bytecode *) bytecode,
 			ust_object);
 	pthread_mutex_unlock(&app->sock_lock);
 	if (ret < 0) {
@@ -1711,31 +1740,9 @@ static int set_ust_capture(struct ust_app *app,
 
 error:
 	health_code_update();
-	free(ust_bytecode);
 	return ret;
 }
 
-static
-struct lttng_ust_abi_event_exclusion *create_ust_exclusion_from_exclusion(
-		const struct lttng_event_exclusion *exclusion)
-{
-	struct lttng_ust_abi_event_exclusion *ust_exclusion = NULL;
-	size_t exclusion_alloc_size = sizeof(struct lttng_ust_abi_event_exclusion) +
-		LTTNG_UST_ABI_SYM_NAME_LEN * exclusion->count;
-
-	ust_exclusion = zmalloc<lttng_ust_abi_event_exclusion>(exclusion_alloc_size);
-	if (!ust_exclusion) {
-		PERROR("malloc");
-		goto end;
-	}
-
-	LTTNG_ASSERT(sizeof(struct lttng_event_exclusion) ==
-			sizeof(struct lttng_ust_abi_event_exclusion));
-	memcpy(ust_exclusion, exclusion, exclusion_alloc_size);
-end:
-	return ust_exclusion;
-}
-
 /*
  * Set event exclusions on the tracer.
  */
@@ -1744,20 +1751,15 @@ static int set_ust_object_exclusions(struct ust_app *app,
 		struct lttng_ust_abi_object_data *ust_object)
 {
 	int ret;
-	struct lttng_ust_abi_event_exclusion *ust_exclusions = NULL;
 
 	LTTNG_ASSERT(exclusions && exclusions->count > 0);
 
 	health_code_update();
 
-	ust_exclusions = create_ust_exclusion_from_exclusion(
-			exclusions);
-	if (!ust_exclusions) {
-		ret = -LTTNG_ERR_NOMEM;
-		goto error;
-	}
 	pthread_mutex_lock(&app->sock_lock);
-	ret = lttng_ust_ctl_set_exclusion(app->sock, ust_exclusions, ust_object);
+	ret = lttng_ust_ctl_set_exclusion(app->sock,
+			(struct lttng_ust_abi_event_exclusion *) exclusions,
+			ust_object);
 	pthread_mutex_unlock(&app->sock_lock);
 	if (ret < 0) {
 		if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
@@ -1779,7 +1781,6 @@ static int set_ust_object_exclusions(struct ust_app *app,
 
 error:
 	health_code_update();
-	free(ust_exclusions);
 	return ret;
 }
 
@@ -2184,8 +2185,7 @@ static int create_ust_event_notifier(struct ust_app *app,
 	const struct lttng_condition *condition = NULL;
 	struct lttng_ust_abi_event_notifier event_notifier;
 	const struct lttng_event_rule *event_rule = NULL;
-	unsigned int capture_bytecode_count = 0, i;
-	enum lttng_condition_status cond_status;
+	unsigned int i;
 	enum lttng_event_rule_type event_rule_type;
 
 	health_code_update();
@@ -2266,16 +2266,9 @@ static int create_ust_event_notifier(struct ust_app *app,
 	}
 
 	/* Set the capture bytecodes. */
-	cond_status = lttng_condition_event_rule_matches_get_capture_descriptor_count(
-			condition, &capture_bytecode_count);
-	LTTNG_ASSERT(cond_status == LTTNG_CONDITION_STATUS_OK);
-
-	for (i = 0; i < capture_bytecode_count; i++) {
-		const struct lttng_bytecode *capture_bytecode =
-				lttng_condition_event_rule_matches_get_capture_bytecode_at_index(
-						condition, i);
-
-		ret = set_ust_capture(app, capture_bytecode, i,
+	for (i = 0; i < ua_event_notifier_rule->capture_bytecode_count; i++) {
+		ret = set_ust_capture(app,
+				ua_event_notifier_rule->capture_bytecodes[i],
 				ua_event_notifier_rule->obj);
 		if (ret < 0) {
 			goto error;
@@ -2321,8 +2314,6 @@ error:
 static void shadow_copy_event(struct ust_app_event *ua_event,
 		struct ltt_ust_event *uevent)
 {
-	size_t exclusion_alloc_size;
-
 	strncpy(ua_event->name, uevent->attr.name, sizeof(ua_event->name));
 	ua_event->name[sizeof(ua_event->name) - 1] = '\0';
 
@@ -2331,23 +2322,18 @@ static void shadow_copy_event(struct ust_app_event *ua_event,
 	/* Copy event attributes */
 	memcpy(&ua_event->attr, &uevent->attr, sizeof(ua_event->attr));
 
-	/* Copy filter bytecode */
+	/*
+	 * Share the filter bytecode and exclusion data with the other
+	 * applications.
+	 */
 	if (uevent->filter) {
-		ua_event->filter = lttng_bytecode_copy(uevent->filter);
+		ua_event->filter = blob_store_get_bytecode(uevent->filter);
 		/* Filter might be NULL here in case of ENONEM. */
 	}
 
-	/* Copy exclusion data */
 	if (uevent->exclusion) {
-		exclusion_alloc_size = sizeof(struct lttng_event_exclusion) +
-				LTTNG_UST_ABI_SYM_NAME_LEN * uevent->exclusion->count;
-		ua_event->exclusion = zmalloc<lttng_event_exclusion>(exclusion_alloc_size);
-		if (ua_event->exclusion == NULL) {
-			PERROR("malloc");
-		} else {
-			memcpy(ua_event->exclusion, uevent->exclusion,
-					exclusion_alloc_size);
-		}
+		ua_event->exclusion = blob_store_get_exclusion(uevent->exclusion);
+		/* Exclusion might be NULL here in case of ENONEM. */
 	}
 }
 
@@ -2374,6 +2360,9 @@ static void shadow_copy_channel(struct ust_app_channel *ua_chan,
 	ua_chan->monitor_timer_interval = uchan->monitor_timer_interval;
 	ua_chan->attr.output = (lttng_ust_abi_output) uchan->attr.output;
 	ua_chan->attr.blocking_timeout = uchan->attr.u.s.blocking_timeout;
+	ua_chan->consumer_output = uchan->consumer_output;
+	ua_chan->compression = uchan->compression;
+	ua_chan->suppress_empty_packets = uchan->suppress_empty_packets;
 
 	/*
 	 * Note that the attribute channel type is not set since the channel on the
@@ -2594,6 +2583,7 @@ static int setup_buffer_reg_uid(struct ltt_ust_session *usess,
 	LTTNG_ASSERT(app);
 
 	rcu_read_lock();
+	pthread_mutex_lock(&usess->buffer_reg_uid_setup_lock);
 
 	reg_uid = buffer_reg_uid_find(usess->id, app->abi.bits_per_long, app->uid);
 	if (!reg_uid) {
@@ -2637,6 +2627,7 @@ end:
 		*regp = reg_uid;
 	}
 error:
+	pthread_mutex_unlock(&usess->buffer_reg_uid_setup_lock);
 	rcu_read_unlock();
 	return ret;
 }
@@ -3377,6 +3368,7 @@ static int create_channel_per_uid(struct ust_app *app,
 		struct ust_app_channel *ua_chan)
 {
 	int ret;
+	bool setup_locked = false;
 	struct buffer_reg_uid *reg_uid;
 	struct buffer_reg_channel *buf_reg_chan;
 	struct ltt_session *session = NULL;
@@ -3398,6 +3390,14 @@ static int create_channel_per_uid(struct ust_app *app,
 	 */
 	LTTNG_ASSERT(reg_uid);
 
+	/*
+	 * Only the first application of the user creates the buffers; the
+	 * others wait for them to be ready. Applications of other users don't
+	 * share this registry and proceed concurrently.
+	 */
+	pthread_mutex_lock(&reg_uid->channel_setup_lock);
+	setup_locked = true;
+
 	buf_reg_chan = buffer_reg_channel_find(ua_chan->tracing_channel_id,
 			reg_uid);
 	if (buf_reg_chan) {
@@ -3471,6 +3471,9 @@ static int create_channel_per_uid(struct ust_app *app,
 	}
 
 send_channel:
+	pthread_mutex_unlock(&reg_uid->channel_setup_lock);
+	setup_locked = false;
+
 	/* Send buffers to the application. */
 	ret = send_channel_uid_to_ust(buf_reg_chan, app, ua_sess, ua_chan);
 	if (ret < 0) {
@@ -3481,6 +3484,9 @@ send_channel:
 	}
 
 error:
+	if (setup_locked) {
+		pthread_mutex_unlock(&reg_uid->channel_setup_lock);
+	}
 	if (session) {
 		session_put(session);
 	}
@@ -5815,6 +5821,84 @@ end:
 	return ret;
 }
 
+/*
+ * For a specific existing UST session and UST channel, create or enable a set
+ * of events for all registered apps.
+ *
+ * Each application session is looked up and locked once for the whole set,
+ * rather than once per event.
+ */
+int ust_app_synchronize_events_glb(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count)
+{
+	int ret = 0;
+	unsigned int i;
+	struct lttng_ht_iter iter, uiter;
+	struct lttng_ht_node_str *ua_chan_node;
+	struct ust_app *app;
+	struct ust_app_session *ua_sess;
+	struct ust_app_channel *ua_chan;
+
+	LTTNG_ASSERT(usess->active);
+	DBG("UST app synchronizing %u event(s) of channel %s for all apps for session id %" PRIu64,
+			count, uchan->name, usess->id);
+
+	rcu_read_lock();
+
+	/* For all registered applications */
+	cds_lfht_for_each_entry(ust_app_ht->ht, &iter.iter, app, pid_n.node) {
+		if (!app->compatible) {
+			continue;
+		}
+		ua_sess = lookup_session_by_app(usess, app);
+		if (!ua_sess) {
+			/* The application has problem or is probably dead. */
+			continue;
+		}
+
+		pthread_mutex_lock(&ua_sess->lock);
+
+		if (ua_sess->deleted) {
+			pthread_mutex_unlock(&ua_sess->lock);
+			continue;
+		}
+
+		/*
+		 * The channel may not be found if the application exits
+		 * concurrently.
+		 */
+		lttng_ht_lookup(ua_sess->channels, (void *) uchan->name, &uiter);
+		ua_chan_node = lttng_ht_iter_get_node_str(&uiter);
+		if (!ua_chan_node) {
+			pthread_mutex_unlock(&ua_sess->lock);
+			continue;
+		}
+
+		ua_chan = lttng::utils::container_of(ua_chan_node, &ust_app_channel::node);
+
+		for (i = 0; i < count; i++) {
+			ret = ust_app_channel_synchronize_event(ua_chan,
+					uevents[i], app);
+			if (ret == -LTTNG_UST_ERR_EXIST) {
+				DBG2("UST app event %s already exist on app PID %d",
+						uevents[i]->attr.name, app->pid);
+				ret = 0;
+			} else if (ret < 0) {
+				break;
+			}
+		}
+		pthread_mutex_unlock(&ua_sess->lock);
+		if (ret < 0) {
+			/* Possible value at this point: -ENOMEM. If so, we stop! */
+			break;
+		}
+	}
+
+	rcu_read_unlock();
+	return ret;
+}
+
 /* Called with RCU read-side lock held. */
 static
 void ust_app_synchronize_event_notifier_rules(struct ust_app *app)
@@ -6105,6 +6189,10 @@ void ust_app_global_destroy(struct ltt_ust_session *usess, struct ust_app *app)
  *
  * Called with session lock held.
  * Called with RCU read-side lock held.
+ *
+ * When newly registered applications are set up, this is called concurrently
+ * for the applications of the same session; the session list lock and the
+ * session's lock are then held by the thread dispatching the updates.
  */
 void ust_app_global_update(struct ltt_ust_session *usess, struct ust_app *app)
 {
@@ -6936,7 +7024,7 @@ void ust_app_destroy(struct ust_app *app)
 enum lttng_error_code ust_app_snapshot_record(
 		const struct ltt_ust_session *usess,
 		const struct consumer_output *output,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream, bool incremental)
 {
 	int ret = 0;
 	enum lttng_error_code status = LTTNG_OK;
@@ -6996,14 +7084,14 @@ enum lttng_error_code ust_app_snapshot_record(
 				status = consumer_snapshot_channel(socket,
 						buf_reg_chan->consumer_key,
 						output, 0, &trace_path[consumer_path_offset],
-						nb_packets_per_stream);
+						nb_packets_per_stream, incremental);
 				if (status != LTTNG_OK) {
 					goto error;
 				}
 			}
 			status = consumer_snapshot_channel(socket,
 					reg->registry->reg.ust->_metadata_key, output, 1,
-					&trace_path[consumer_path_offset], 0);
+					&trace_path[consumer_path_offset], 0, false);
 			if (status != LTTNG_OK) {
 				goto error;
 			}
@@ -7057,7 +7145,7 @@ enum lttng_error_code ust_app_snapshot_record(
 				status = consumer_snapshot_channel(socket,
 						ua_chan->key, output, 0,
 						&trace_path[consumer_path_offset],
-						nb_packets_per_stream);
+						nb_packets_per_stream, incremental);
 				switch (status) {
 				case LTTNG_OK:
 					break;
@@ -7075,7 +7163,7 @@ enum lttng_error_code ust_app_snapshot_record(
 			}
 			status = consumer_snapshot_channel(socket,
 					registry->_metadata_key, output, 1,
-					&trace_path[consumer_path_offset], 0);
+					&trace_path[consumer_path_offset], 0, false);
 			switch (status) {
 			case LTTNG_OK:
 				break;
@@ -111,8 +111,9 @@ struct ust_app_event {
 	struct lttng_ust_abi_event attr;
 	char name[LTTNG_UST_ABI_SYM_NAME_LEN];
 	struct lttng_ht_node_str node;
-	struct lttng_bytecode *filter;
-	struct lttng_event_exclusion *exclusion;
+	/* Shared through the blob store; a reference is held. */
+	const struct lttng_bytecode *filter;
+	const struct lttng_event_exclusion *exclusion;
 };
 
 struct ust_app_event_notifier_rule {
@@ -127,8 +128,14 @@ struct ust_app_event_notifier_rule {
 	struct lttng_ht_node_u64 node;
 	/* The trigger object owns the filter. */
 	const struct lttng_bytecode *filter;
-	/* Owned by this. */
-	struct lttng_event_exclusion *exclusion;
+	/* Shared through the blob store; a reference is held. */
+	const struct lttng_event_exclusion *exclusion;
+	/*
+	 * Capture bytecodes with their sequence number set, shared through the
+	 * blob store; a reference to each of them is held.
+	 */
+	const struct lttng_bytecode **capture_bytecodes;
+	unsigned int capture_bytecode_count;
 	/* For delayed reclaim. */
 	struct rcu_head rcu_head;
 };
@@ -174,6 +181,10 @@ struct ust_app_channel {
 	uint64_t tracefile_size;
 	uint64_t tracefile_count;
 	uint64_t monitor_timer_interval;
+	/* Output type used by the consumer daemon (see ltt_ust_channel). */
+	enum lttng_event_output consumer_output;
+	enum lttng_channel_compression compression;
+	bool suppress_empty_packets;
 	/*
 	 * Node indexed by channel name in the channels' hash table of a session.
 	 */
@@ -358,6 +369,9 @@ int ust_app_list_events(struct lttng_event **events);
 int ust_app_list_event_fields(struct lttng_event_field **fields);
 int ust_app_create_event_glb(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan, struct ltt_ust_event *uevent);
+int ust_app_synchronize_events_glb(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count);
 int ust_app_disable_channel_glb(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan);
 int ust_app_enable_channel_glb(struct ltt_ust_session *usess,
@@ -389,7 +403,7 @@ void ust_app_destroy(struct ust_app *app);
 enum lttng_error_code ust_app_snapshot_record(
 		const struct ltt_ust_session *usess,
 		const struct consumer_output *output,
-		uint64_t nb_packets_per_stream);
+		uint64_t nb_packets_per_stream, bool incremental);
 uint64_t ust_app_get_size_one_more_packet_per_stream(
 		const struct ltt_ust_session *usess, uint64_t cur_nr_packets);
 struct ust_app *ust_app_find_by_sock(int sock);
@@ -561,6 +575,16 @@ int ust_app_create_event_glb(
 	return 0;
 }
 
+static inline
+int ust_app_synchronize_events_glb(
+		struct ltt_ust_session *usess __attribute__((unused)),
+		struct ltt_ust_channel *uchan __attribute__((unused)),
+		struct ltt_ust_event **uevents __attribute__((unused)),
+		unsigned int count __attribute__((unused)))
+{
+	return 0;
+}
+
 static inline
 int ust_app_disable_event_glb(
 		struct ltt_ust_session *usess __attribute__((unused)),
@@ -649,7 +673,8 @@ static inline
 enum lttng_error_code ust_app_snapshot_record(
 		struct ltt_ust_session *usess __attribute__((unused)),
 		const struct consumer_output *output __attribute__((unused)),
-		uint64_t max_stream_size __attribute__((unused)))
+		uint64_t max_stream_size __attribute__((unused)),
+		bool incremental __attribute__((unused)))
 {
 	return LTTNG_ERR_UNK;
 }
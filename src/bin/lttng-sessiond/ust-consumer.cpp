@@ -130,7 +130,8 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 	switch (ua_chan->attr.output) {
 	case LTTNG_UST_ABI_MMAP:
 	default:
-		output = LTTNG_EVENT_MMAP;
+		/* The tracer maps its buffers, the consumer may splice them. */
+		output = ua_chan->consumer_output;
 		break;
 	}
 
@@ -144,6 +145,8 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 			ua_sess->live_timer_interval != 0,
 			ua_chan->monitor_timer_interval,
 			output,
+			ua_chan->compression,
+			ua_chan->suppress_empty_packets,
 			(int) ua_chan->attr.type,
 			ua_sess->tracing_id,
 			&pathname[consumer_path_offset],
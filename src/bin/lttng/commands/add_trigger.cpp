@@ -62,6 +62,7 @@ enum {
 	OPT_CTRL_URL,
 	OPT_URL,
 	OPT_PATH,
+	OPT_INCREMENTAL,
 
 	OPT_CAPTURE,
 };
@@ -1800,6 +1801,7 @@ static const struct argpar_opt_descr snapshot_action_opt_descrs[] = {
 	{ OPT_DATA_URL, '\0', "data-url", true },
 	{ OPT_URL, '\0', "url", true },
 	{ OPT_PATH, '\0', "path", true },
+	{ OPT_INCREMENTAL, '\0', "incremental", false },
 	{ OPT_RATE_POLICY, '\0', "rate-policy", true },
 	ARGPAR_OPT_DESCR_SENTINEL
 };
@@ -1818,6 +1820,7 @@ struct lttng_action *handle_action_snapshot_session(int *argc,
 	char *max_size_arg = NULL;
 	char *url_arg = NULL;
 	char *path_arg = NULL;
+	bool incremental = false;
 	char *error = NULL;
 	enum lttng_action_status action_status;
 	struct lttng_snapshot_output *snapshot_output = NULL;
@@ -1862,6 +1865,9 @@ struct lttng_action *handle_action_snapshot_session(int *argc,
 					goto error;
 				}
 
+				break;
+			case OPT_INCREMENTAL:
+				incremental = true;
 				break;
 			case OPT_CTRL_URL:
 				if (!assign_string(&ctrl_url_arg, arg, "--ctrl-url")) {
@@ -2004,6 +2010,19 @@ struct lttng_action *handle_action_snapshot_session(int *argc,
 		}
 	}
 
+	if (incremental) {
+		if (!snapshot_output) {
+			ERR("Can't record incremental snapshots without a snapshot output destination.");
+			goto error;
+		}
+
+		ret = lttng_snapshot_output_set_incremental(1, snapshot_output);
+		if (ret != 0) {
+			ERR("Failed to make the snapshot output incremental.");
+			goto error;
+		}
+	}
+
 	if (url_arg) {
 		int num_uris;
 		struct lttng_uri *uris;
@@ -32,9 +32,13 @@ static int opt_kernel;
 static char *opt_session_name;
 static int opt_userspace;
 static char *opt_output;
+static char *opt_compression;
+static enum lttng_channel_compression compression =
+		LTTNG_CHANNEL_COMPRESSION_NONE;
 static int opt_buffer_uid;
 static int opt_buffer_pid;
 static int opt_buffer_global;
+static int opt_suppress_empty_packets;
 static struct {
 	bool set;
 	uint64_t interval;
@@ -72,6 +76,8 @@ static struct lttng_handle *handle;
 
 const char *output_mmap = "mmap";
 const char *output_splice = "splice";
+const char *compression_none = "none";
+const char *compression_zstd = "zstd";
 
 static struct poptOption long_options[] = {
 	/* longName, shortName, argInfo, argPtr, value, descrip, argDesc */
@@ -88,9 +94,11 @@ static struct poptOption long_options[] = {
 	{"read-timer",     0,   POPT_ARG_INT, 0, OPT_READ_TIMER, 0, 0},
 	{"list-options",   0, POPT_ARG_NONE, NULL, OPT_LIST_OPTIONS, NULL, NULL},
 	{"output",         0,   POPT_ARG_STRING, &opt_output, 0, 0, 0},
+	{"compression",    0,   POPT_ARG_STRING, &opt_compression, 0, 0, 0},
 	{"buffers-uid",    0,	POPT_ARG_VAL, &opt_buffer_uid, 1, 0, 0},
 	{"buffers-pid",    0,	POPT_ARG_VAL, &opt_buffer_pid, 1, 0, 0},
 	{"buffers-global", 0,	POPT_ARG_VAL, &opt_buffer_global, 1, 0, 0},
+	{"suppress-empty-packets", 0, POPT_ARG_VAL, &opt_suppress_empty_packets, 1, 0, 0},
 	{"tracefile-size", 'C',   POPT_ARG_INT, 0, OPT_TRACEFILE_SIZE, 0, 0},
 	{"tracefile-count", 'W',   POPT_ARG_INT, 0, OPT_TRACEFILE_COUNT, 0, 0},
 	{"blocking-timeout",     0,   POPT_ARG_INT, 0, OPT_BLOCKING_TIMEOUT, 0, 0},
@@ -213,6 +221,33 @@ static int enable_channel(char *session_name)
 		}
 	}
 
+	/* Setting packet compression */
+	if (opt_compression) {
+		if (!strcmp(compression_zstd, opt_compression)) {
+			compression = LTTNG_CHANNEL_COMPRESSION_ZSTD;
+		} else if (!strcmp(compression_none, opt_compression)) {
+			compression = LTTNG_CHANNEL_COMPRESSION_NONE;
+		} else {
+			ERR("Unknown compression %s. Possible values are: %s, %s\n",
+					opt_compression, compression_none,
+					compression_zstd);
+			ret = CMD_ERROR;
+			goto error;
+		}
+
+		/* Packets are compressed from mapped sub-buffers. */
+		if (compression != LTTNG_CHANNEL_COMPRESSION_NONE) {
+			if (!opt_output) {
+				chan_opts.attr.output = LTTNG_EVENT_MMAP;
+			} else if (chan_opts.attr.output != LTTNG_EVENT_MMAP) {
+				ERR("Packet compression requires the %s output type",
+						output_mmap);
+				ret = CMD_ERROR;
+				goto error;
+			}
+		}
+	}
+
 	handle = lttng_create_handle(session_name, &dom);
 	if (handle == NULL) {
 		ret = -1;
@@ -277,6 +312,22 @@ static int enable_channel(char *session_name)
 				goto error;
 			}
 		}
+		if (compression != LTTNG_CHANNEL_COMPRESSION_NONE) {
+			ret = lttng_channel_set_compression(channel, compression);
+			if (ret) {
+				ERR("Failed to set the channel's packet compression");
+				error = 1;
+				goto error;
+			}
+		}
+		if (opt_suppress_empty_packets) {
+			ret = lttng_channel_set_empty_packet_suppression(channel, 1);
+			if (ret) {
+				ERR("Failed to set the channel's empty packet suppression");
+				error = 1;
+				goto error;
+			}
+		}
 
 		DBG("Enabling channel %s", channel_name);
 
@@ -1277,6 +1277,8 @@ static void print_channel(struct lttng_channel *channel)
 	int ret;
 	uint64_t discarded_events, lost_packets, monitor_timer_interval;
 	int64_t blocking_timeout;
+	enum lttng_channel_compression compression;
+	int suppress_empty_packets;
 
 	ret = lttng_channel_get_discarded_event_count(channel,
 			&discarded_events);
@@ -1306,6 +1308,19 @@ static void print_channel(struct lttng_channel *channel)
 		return;
 	}
 
+	ret = lttng_channel_get_compression(channel, &compression);
+	if (ret) {
+		ERR("Failed to retrieve packet compression of channel");
+		return;
+	}
+
+	ret = lttng_channel_get_empty_packet_suppression(channel,
+			&suppress_empty_packets);
+	if (ret) {
+		ERR("Failed to retrieve empty packet suppression of channel");
+		return;
+	}
+
 	MSG("- %s:%s\n", channel->name, enabled_string(channel->enabled));
 	MSG("%sAttributes:", indent4);
 	MSG("%sEvent-loss mode:  %s", indent6, channel->attr.overwrite ? "overwrite" : "discard");
@@ -1342,6 +1357,12 @@ static void print_channel(struct lttng_channel *channel)
 			MSG("%sOutput mode:      mmap", indent6);
 			break;
 	}
+	if (compression == LTTNG_CHANNEL_COMPRESSION_ZSTD) {
+		MSG("%sCompression:      zstd", indent6);
+	}
+	if (suppress_empty_packets) {
+		MSG("%sEmpty packets:    suppressed", indent6);
+	}
 
 	MSG("\n%sStatistics:", indent4);
 	if (the_listed_session.snapshot_mode) {
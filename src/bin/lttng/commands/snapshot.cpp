@@ -27,6 +27,7 @@ static const char *opt_data_url;
 static const char *opt_ctrl_url;
 static const char *current_session_name;
 static uint64_t opt_max_size;
+static int opt_incremental;
 
 /* Stub for the cmd struct actions. */
 static int cmd_add_output(int argc, const char **argv);
@@ -59,6 +60,7 @@ static struct poptOption snapshot_opts[] = {
 	{"data-url",     'D', POPT_ARG_STRING, &opt_data_url, 0, 0, 0},
 	{"name",         'n', POPT_ARG_STRING, &opt_output_name, 0, 0, 0},
 	{"max-size",     'm', POPT_ARG_STRING, 0, OPT_MAX_SIZE, 0, 0},
+	{"incremental",    0, POPT_ARG_VAL, &opt_incremental, 1, 0, 0},
 	{"list-options",   0, POPT_ARG_NONE, NULL, OPT_LIST_OPTIONS, NULL, NULL},
 	{"list-commands",  0, POPT_ARG_NONE, NULL, OPT_LIST_COMMANDS, NULL, NULL},
 	{0, 0, 0, 0, 0, 0, 0}
@@ -136,6 +138,13 @@ static struct lttng_snapshot_output *create_output_from_args(const char *url)
 		}
 	}
 
+	if (opt_incremental) {
+		ret = lttng_snapshot_output_set_incremental(1, output);
+		if (ret < 0) {
+			goto error;
+		}
+	}
+
 	return output;
 
 error:
@@ -167,17 +176,23 @@ static int list_output(void)
 	}
 
 	while ((s_iter = lttng_snapshot_output_list_get_next(list)) != NULL) {
+		const char *incremental =
+				lttng_snapshot_output_get_incremental(s_iter) ?
+						" [incremental]" : "";
+
 		if (lttng_snapshot_output_get_maxsize(s_iter)) {
-			MSG("%s[%" PRIu32 "] %s: %s (max size: %" PRIu64 " bytes)", indent4,
+			MSG("%s[%" PRIu32 "] %s: %s (max size: %" PRIu64 " bytes)%s", indent4,
 					lttng_snapshot_output_get_id(s_iter),
 					lttng_snapshot_output_get_name(s_iter),
 					lttng_snapshot_output_get_ctrl_url(s_iter),
-					lttng_snapshot_output_get_maxsize(s_iter));
+					lttng_snapshot_output_get_maxsize(s_iter),
+					incremental);
 		} else {
-			MSG("%s[%" PRIu32 "] %s: %s", indent4,
+			MSG("%s[%" PRIu32 "] %s: %s%s", indent4,
 					lttng_snapshot_output_get_id(s_iter),
 					lttng_snapshot_output_get_name(s_iter),
-					lttng_snapshot_output_get_ctrl_url(s_iter));
+					lttng_snapshot_output_get_ctrl_url(s_iter),
+					incremental);
 		}
 		output_seen = 1;
 		if (lttng_opt_mi) {
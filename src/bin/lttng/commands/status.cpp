@@ -6,6 +6,7 @@
  */
 
 #define _LGPL_SOURCE
+#include <inttypes.h>
 #include <popt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,6 +17,7 @@
 
 #include "../command.hpp"
 #include "../utils.hpp"
+#include <common/time.hpp>
 #include <config.h>
 
 #ifdef LTTNG_EMBED_HELP
@@ -29,13 +31,91 @@ enum {
 	OPT_LIST_OPTIONS,
 };
 
+static int opt_stream_stats;
+
 static struct poptOption long_options[] = {
 	/* longName, shortName, argInfo, argPtr, value, descrip, argDesc */
 	{"help",        'h', POPT_ARG_NONE, NULL, OPT_HELP, NULL, NULL},
 	{"list-options", 0,  POPT_ARG_NONE, NULL, OPT_LIST_OPTIONS, NULL, NULL},
+	{"stream-stats", 0,  POPT_ARG_VAL, &opt_stream_stats, 1, NULL, NULL},
 	{0, 0, 0, 0, 0, 0, 0}
 };
 
+/*
+ * Order stream statistics from the worst to the best producer to disk lag.
+ */
+static int compare_stream_stats_max_lag(const void *a, const void *b)
+{
+	const struct lttng_stream_stats *stats_a =
+			(const struct lttng_stream_stats *) a;
+	const struct lttng_stream_stats *stats_b =
+			(const struct lttng_stream_stats *) b;
+
+	if (stats_a->max_lag_ns == stats_b->max_lag_ns) {
+		return 0;
+	}
+
+	return stats_a->max_lag_ns < stats_b->max_lag_ns ? 1 : -1;
+}
+
+/*
+ * Print the consumption statistics of the streams of a session, the streams
+ * that are the slowest to drain first. Times are shown in microseconds.
+ *
+ * The statistics are an addition to the session's status: failing to get
+ * them, for instance from a session daemon which predates them, is not an
+ * error.
+ */
+static void print_stream_stats(const char *session_name)
+{
+	int count, i;
+	struct lttng_stream_stats *stats = NULL;
+
+	count = lttng_list_stream_stats(session_name, &stats);
+	if (count < 0) {
+		WARN("Failed to list the stream statistics of session `%s`: %s",
+				session_name, lttng_strerror(count));
+		goto end;
+	}
+
+	if (count == 0) {
+		goto end;
+	}
+
+	qsort(stats, count, sizeof(*stats), compare_stream_stats_max_lag);
+
+	MSG("Stream consumption statistics (times in %s):", USEC_UNIT);
+	MSG("%-24s %-32s %-7s %11s %14s %10s %12s %10s %10s %10s %10s",
+			"Channel", "Stream", "Domain", "Sub-buffers", "Bytes",
+			"Syscalls", "Write time", "Send avg", "Send max",
+			"Lag", "Max lag");
+	for (i = 0; i < count; i++) {
+		const struct lttng_stream_stats *entry = &stats[i];
+		const uint64_t send_avg_ns = entry->relayd_sends ?
+				entry->relayd_send_time_ns / entry->relayd_sends : 0;
+
+		MSG("%-24s %-32s %-7s %11" PRIu64 " %14" PRIu64 " %10" PRIu64
+				" %12" PRIu64 " %10" PRIu64 " %10" PRIu64
+				" %10" PRIu64 " %10" PRIu64,
+				entry->channel_name,
+				entry->stream_name,
+				entry->domain == LTTNG_DOMAIN_KERNEL ?
+						"kernel" : "user",
+				entry->subbuffers_consumed,
+				entry->bytes_written,
+				entry->write_syscalls,
+				entry->write_time_ns / NSEC_PER_USEC,
+				send_avg_ns / NSEC_PER_USEC,
+				entry->relayd_send_max_ns / NSEC_PER_USEC,
+				entry->last_lag_ns / NSEC_PER_USEC,
+				entry->max_lag_ns / NSEC_PER_USEC);
+	}
+	MSG("");
+
+end:
+	free(stats);
+}
+
 static int status(void)
 {
 	const char *argv[2];
@@ -51,6 +131,11 @@ static int status(void)
 	argv[0] = "list";
 	argv[1] = session_name;
 	ret = cmd_list(2, argv);
+	if (ret != CMD_SUCCESS || lttng_opt_mi || !opt_stream_stats) {
+		goto end;
+	}
+
+	print_stream_stats(session_name);
 end:
 	free(session_name);
 	return ret;
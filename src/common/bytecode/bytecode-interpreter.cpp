@@ -0,0 +1,1108 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include "bytecode-interpreter.hpp"
+#include "bytecode.hpp"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <common/error.hpp>
+#include <common/macros.hpp>
+
+/* Same depth as the stack of the tracers' interpreters. */
+#define INTERPRETER_STACK_LEN	10
+
+/* Value of a field reference which wasn't relocated. */
+#define FIELD_REF_UNRESOLVED	((uint16_t) -1U)
+
+#define CONTEXT_PREFIX		"$ctx."
+#define APP_CONTEXT_PREFIX	"$app."
+
+struct bytecode_interpreter_program {
+	/* Private copy of the bytecode, in which field references are linked. */
+	struct lttng_bytecode *bytecode;
+	/* Number of fields of the layout against which it was linked. */
+	unsigned int field_count;
+};
+
+enum reg_type {
+	REG_S64,
+	REG_U64,
+	REG_DOUBLE,
+	REG_STRING,
+	REG_STAR_GLOB_STRING,
+	/* Objects, pushed while walking towards a field. */
+	REG_ROOT,
+	REG_FIELD,
+	REG_ELEMENT,
+};
+
+struct reg {
+	enum reg_type type;
+	union {
+		int64_t s64;
+		uint64_t u64;
+		double d;
+		struct {
+			const char *str;
+			/*
+			 * Literal strings of the bytecode, unlike the strings
+			 * of the event, may end with a `*` wildcard and
+			 * escape `*` and `\` with a `\`.
+			 */
+			bool literal;
+		} s;
+		struct {
+			unsigned int field;
+			uint64_t index;
+		} object;
+	} u;
+};
+
+/*
+ * Length of an instruction, excluding its literal string if any, or -1 if
+ * its opcode is not supported.
+ */
+static
+int get_insn_len(enum bytecode_op op)
+{
+	switch (op) {
+	case BYTECODE_OP_RETURN:
+	case BYTECODE_OP_RETURN_S64:
+		return sizeof(struct return_op);
+
+	case BYTECODE_OP_MUL:
+	case BYTECODE_OP_DIV:
+	case BYTECODE_OP_MOD:
+	case BYTECODE_OP_PLUS:
+	case BYTECODE_OP_MINUS:
+	case BYTECODE_OP_BIT_RSHIFT:
+	case BYTECODE_OP_BIT_LSHIFT:
+	case BYTECODE_OP_BIT_AND:
+	case BYTECODE_OP_BIT_OR:
+	case BYTECODE_OP_BIT_XOR:
+	case BYTECODE_OP_EQ:
+	case BYTECODE_OP_NE:
+	case BYTECODE_OP_GT:
+	case BYTECODE_OP_LT:
+	case BYTECODE_OP_GE:
+	case BYTECODE_OP_LE:
+		return sizeof(struct binary_op);
+
+	case BYTECODE_OP_UNARY_PLUS:
+	case BYTECODE_OP_UNARY_MINUS:
+	case BYTECODE_OP_UNARY_NOT:
+	case BYTECODE_OP_UNARY_BIT_NOT:
+		return sizeof(struct unary_op);
+
+	case BYTECODE_OP_AND:
+	case BYTECODE_OP_OR:
+		return sizeof(struct logical_op);
+
+	case BYTECODE_OP_LOAD_FIELD_REF:
+	case BYTECODE_OP_GET_CONTEXT_REF:
+		return sizeof(struct load_op) + sizeof(struct field_ref);
+
+	case BYTECODE_OP_LOAD_STRING:
+	case BYTECODE_OP_LOAD_STAR_GLOB_STRING:
+		return sizeof(struct load_op);
+	case BYTECODE_OP_LOAD_S64:
+		return sizeof(struct load_op) + sizeof(struct literal_numeric);
+	case BYTECODE_OP_LOAD_DOUBLE:
+		return sizeof(struct load_op) + sizeof(struct literal_double);
+
+	case BYTECODE_OP_CAST_TO_S64:
+	case BYTECODE_OP_CAST_DOUBLE_TO_S64:
+	case BYTECODE_OP_CAST_NOP:
+		return sizeof(struct cast_op);
+
+	case BYTECODE_OP_GET_CONTEXT_ROOT:
+	case BYTECODE_OP_GET_APP_CONTEXT_ROOT:
+	case BYTECODE_OP_GET_PAYLOAD_ROOT:
+	case BYTECODE_OP_LOAD_FIELD:
+		return sizeof(struct load_op);
+	case BYTECODE_OP_GET_SYMBOL:
+		return sizeof(struct load_op) + sizeof(struct get_symbol);
+	case BYTECODE_OP_GET_INDEX_U16:
+		return sizeof(struct load_op) + sizeof(struct get_index_u16);
+	case BYTECODE_OP_GET_INDEX_U64:
+		return sizeof(struct load_op) + sizeof(struct get_index_u64);
+
+	default:
+		/*
+		 * The typed instructions are only generated by the
+		 * specialization pass of the tracers.
+		 */
+		return -1;
+	}
+}
+
+static
+int find_field(const struct bytecode_interpreter_event *layout,
+		enum bytecode_interpreter_scope scope, const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < layout->field_count; i++) {
+		const struct bytecode_interpreter_field *field =
+				&layout->fields[i];
+
+		if (field->scope == scope && !strcmp(field->name, name)) {
+			return i;
+		}
+	}
+
+	DBG("Failed to link bytecode: no such field: name = `%s`", name);
+	return -ENOENT;
+}
+
+/*
+ * Resolve the legacy field references listed in the relocation table.
+ * `GET_SYMBOL` instructions, which also have a relocation, are resolved
+ * while validating the instructions.
+ */
+static
+int link_relocations(struct lttng_bytecode *bytecode,
+		const struct bytecode_interpreter_event *layout)
+{
+	uint32_t pos = bytecode->reloc_table_offset;
+
+	while (pos < bytecode->len) {
+		uint16_t insn_offset;
+		const char *name, *end;
+		enum bytecode_interpreter_scope scope;
+		struct field_ref ref;
+		int index;
+
+		if (bytecode->len - pos < sizeof(insn_offset) + 1) {
+			ERR("Truncated bytecode relocation table entry");
+			return -EINVAL;
+		}
+
+		memcpy(&insn_offset, &bytecode->data[pos], sizeof(insn_offset));
+		name = &bytecode->data[pos + sizeof(insn_offset)];
+		end = (const char *) memchr(name, '\0',
+				bytecode->len - pos - sizeof(insn_offset));
+		if (!end) {
+			ERR("Unterminated bytecode relocation symbol");
+			return -EINVAL;
+		}
+		pos = end - bytecode->data + 1;
+
+		if (insn_offset >= bytecode->reloc_table_offset) {
+			ERR("Bytecode relocation out of bounds: offset = %" PRIu16,
+					insn_offset);
+			return -EINVAL;
+		}
+
+		switch ((enum bytecode_op) bytecode->data[insn_offset]) {
+		case BYTECODE_OP_GET_SYMBOL:
+			continue;
+		case BYTECODE_OP_LOAD_FIELD_REF:
+			scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+			break;
+		case BYTECODE_OP_GET_CONTEXT_REF:
+			if (!strncmp(name, CONTEXT_PREFIX, strlen(CONTEXT_PREFIX))) {
+				scope = BYTECODE_INTERPRETER_SCOPE_CONTEXT;
+				name += strlen(CONTEXT_PREFIX);
+			} else if (!strncmp(name, APP_CONTEXT_PREFIX,
+					strlen(APP_CONTEXT_PREFIX))) {
+				scope = BYTECODE_INTERPRETER_SCOPE_APP_CONTEXT;
+				name += strlen(APP_CONTEXT_PREFIX);
+			} else {
+				ERR("Invalid context field reference: name = `%s`",
+						name);
+				return -EINVAL;
+			}
+			break;
+		default:
+			ERR("Bytecode relocation doesn't apply to a field reference: offset = %" PRIu16,
+					insn_offset);
+			return -EINVAL;
+		}
+
+		if (insn_offset + sizeof(struct load_op) + sizeof(struct field_ref) >
+				bytecode->reloc_table_offset) {
+			ERR("Truncated bytecode instruction: offset = %" PRIu16,
+					insn_offset);
+			return -EINVAL;
+		}
+
+		index = find_field(layout, scope, name);
+		if (index < 0) {
+			return index;
+		}
+
+		ref.offset = (uint16_t) index;
+		memcpy(&bytecode->data[insn_offset + sizeof(struct load_op)],
+				&ref, sizeof(ref));
+	}
+
+	return 0;
+}
+
+/*
+ * Validate the instructions of the bytecode and resolve the `GET_SYMBOL`
+ * instructions, which are turned into `GET_SYMBOL_FIELD` instructions
+ * operating on the index of the field.
+ *
+ * Only the symbols of the roots are resolved: synthetic events don't have
+ * structures.
+ */
+static
+int link_instructions(struct lttng_bytecode *bytecode,
+		const struct bytecode_interpreter_event *layout)
+{
+	int ret = 0;
+	const uint32_t code_len = bytecode->reloc_table_offset;
+	bool *insn_starts = NULL;
+	int root_scope = -1;
+	uint32_t pc;
+
+	insn_starts = calloc<bool>(code_len + 1);
+	if (!insn_starts) {
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	for (pc = 0; pc < code_len;) {
+		const enum bytecode_op op = (enum bytecode_op) bytecode->data[pc];
+		int insn_len = get_insn_len(op);
+		int scope = -1;
+
+		if (insn_len < 0) {
+			ERR("Unsupported bytecode instruction: opcode = %d, offset = %" PRIu32,
+					(int) op, pc);
+			ret = -EINVAL;
+			goto end;
+		}
+
+		if (op == BYTECODE_OP_LOAD_STRING ||
+				op == BYTECODE_OP_LOAD_STAR_GLOB_STRING) {
+			const char *str = &bytecode->data[pc + insn_len];
+			const char *str_end = (const char *) memchr(str, '\0',
+					code_len - pc - insn_len);
+
+			if (!str_end) {
+				ERR("Unterminated bytecode string literal: offset = %" PRIu32,
+						pc);
+				ret = -EINVAL;
+				goto end;
+			}
+			insn_len += str_end - str + 1;
+		}
+
+		if ((uint32_t) insn_len > code_len - pc) {
+			ERR("Truncated bytecode instruction: offset = %" PRIu32,
+					pc);
+			ret = -EINVAL;
+			goto end;
+		}
+
+		switch (op) {
+		case BYTECODE_OP_LOAD_FIELD_REF:
+		case BYTECODE_OP_GET_CONTEXT_REF:
+		{
+			struct field_ref ref;
+
+			memcpy(&ref, &bytecode->data[pc + sizeof(struct load_op)],
+					sizeof(ref));
+			if (ref.offset == FIELD_REF_UNRESOLVED ||
+					ref.offset >= layout->field_count) {
+				ERR("Unresolved bytecode field reference: offset = %" PRIu32,
+						pc);
+				ret = -EINVAL;
+				goto end;
+			}
+			break;
+		}
+		case BYTECODE_OP_GET_PAYLOAD_ROOT:
+			scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+			break;
+		case BYTECODE_OP_GET_CONTEXT_ROOT:
+			scope = BYTECODE_INTERPRETER_SCOPE_CONTEXT;
+			break;
+		case BYTECODE_OP_GET_APP_CONTEXT_ROOT:
+			scope = BYTECODE_INTERPRETER_SCOPE_APP_CONTEXT;
+			break;
+		case BYTECODE_OP_GET_SYMBOL:
+		{
+			struct get_symbol symbol;
+			uint32_t symbol_pos;
+			int index;
+
+			if (root_scope < 0) {
+				ERR("Unsupported access to a structure member: offset = %" PRIu32,
+						pc);
+				ret = -EINVAL;
+				goto end;
+			}
+
+			memcpy(&symbol, &bytecode->data[pc + sizeof(struct load_op)],
+					sizeof(symbol));
+			symbol_pos = bytecode->reloc_table_offset + symbol.offset;
+			if (symbol_pos >= bytecode->len ||
+					!memchr(&bytecode->data[symbol_pos], '\0',
+						bytecode->len - symbol_pos)) {
+				ERR("Invalid bytecode symbol: offset = %" PRIu32, pc);
+				ret = -EINVAL;
+				goto end;
+			}
+
+			index = find_field(layout,
+					(enum bytecode_interpreter_scope) root_scope,
+					&bytecode->data[symbol_pos]);
+			if (index < 0) {
+				ret = index;
+				goto end;
+			}
+
+			bytecode->data[pc] = BYTECODE_OP_GET_SYMBOL_FIELD;
+			symbol.offset = (uint16_t) index;
+			memcpy(&bytecode->data[pc + sizeof(struct load_op)],
+					&symbol, sizeof(symbol));
+			break;
+		}
+		default:
+			break;
+		}
+
+		insn_starts[pc] = true;
+		root_scope = scope;
+		pc += insn_len;
+	}
+
+	/* The logical operators must skip to the start of an instruction. */
+	for (pc = 0; pc < code_len;) {
+		const enum bytecode_op op = (enum bytecode_op) bytecode->data[pc];
+
+		if (op == BYTECODE_OP_AND || op == BYTECODE_OP_OR) {
+			struct logical_op insn;
+
+			memcpy(&insn, &bytecode->data[pc], sizeof(insn));
+			if (insn.skip_offset <= pc ||
+					insn.skip_offset >= code_len ||
+					!insn_starts[insn.skip_offset]) {
+				ERR("Invalid bytecode skip offset: offset = %" PRIu32,
+						pc);
+				ret = -EINVAL;
+				goto end;
+			}
+		}
+
+		/* Move to the next instruction. */
+		do {
+			pc++;
+		} while (pc < code_len && !insn_starts[pc]);
+	}
+
+end:
+	free(insn_starts);
+	return ret;
+}
+
+int bytecode_interpreter_link(const struct lttng_bytecode *bytecode,
+		const struct bytecode_interpreter_event *layout,
+		struct bytecode_interpreter_program **program)
+{
+	int ret;
+	struct bytecode_interpreter_program *new_program = NULL;
+
+	if (bytecode->reloc_table_offset > bytecode->len ||
+			layout->field_count >= FIELD_REF_UNRESOLVED) {
+		ret = -EINVAL;
+		goto error;
+	}
+
+	new_program = zmalloc<bytecode_interpreter_program>();
+	if (!new_program) {
+		ret = -ENOMEM;
+		goto error;
+	}
+
+	new_program->bytecode = lttng_bytecode_copy(bytecode);
+	if (!new_program->bytecode) {
+		ret = -ENOMEM;
+		goto error;
+	}
+
+	new_program->field_count = layout->field_count;
+
+	ret = link_relocations(new_program->bytecode, layout);
+	if (ret) {
+		goto error;
+	}
+
+	ret = link_instructions(new_program->bytecode, layout);
+	if (ret) {
+		goto error;
+	}
+
+	*program = new_program;
+	return 0;
+
+error:
+	bytecode_interpreter_program_destroy(new_program);
+	return ret;
+}
+
+void bytecode_interpreter_program_destroy(
+		struct bytecode_interpreter_program *program)
+{
+	if (!program) {
+		return;
+	}
+
+	free(program->bytecode);
+	free(program);
+}
+
+/*
+ * Get the next character of a string.
+ *
+ * Returns -1 when reaching the `*` wildcard of a literal, otherwise the
+ * character, `\0` at the end of the string.
+ */
+static
+int next_char(const char **p, bool literal)
+{
+	const char *c = *p;
+
+	if (literal) {
+		if (*c == '*') {
+			return -1;
+		}
+
+		if (*c == '\\' && (c[1] == '*' || c[1] == '\\')) {
+			c++;
+		}
+	}
+
+	if (*c != '\0') {
+		*p = c + 1;
+	}
+
+	return (unsigned char) *c;
+}
+
+static
+int compare_strings(const struct reg *left, const struct reg *right)
+{
+	const char *p = left->u.s.str, *q = right->u.s.str;
+
+	for (;;) {
+		const int cp = next_char(&p, left->u.s.literal);
+		const int cq = next_char(&q, right->u.s.literal);
+
+		if (cp < 0 || cq < 0) {
+			/* A wildcard matches the rest of the other string. */
+			return 0;
+		}
+
+		if (cp != cq) {
+			return cp - cq;
+		}
+
+		if (cp == '\0') {
+			return 0;
+		}
+	}
+}
+
+/*
+ * Match a string against a globbing pattern in which `*` matches any
+ * sequence of characters, anywhere, and `\` escapes `*` and `\`.
+ */
+static
+bool star_glob_match(const char *pattern, const char *candidate)
+{
+	const char *retry_pattern = NULL, *retry_candidate = NULL;
+
+	for (;;) {
+		const char *next;
+		char c;
+
+		if (*pattern == '*') {
+			while (*pattern == '*') {
+				pattern++;
+			}
+
+			if (*pattern == '\0') {
+				return true;
+			}
+
+			retry_pattern = pattern;
+			retry_candidate = candidate;
+			continue;
+		}
+
+		if (*candidate == '\0') {
+			return *pattern == '\0';
+		}
+
+		c = *pattern;
+		next = pattern + 1;
+		if (c == '\\' && (pattern[1] == '*' || pattern[1] == '\\')) {
+			c = pattern[1];
+			next = pattern + 2;
+		}
+
+		if (c != '\0' && c == *candidate) {
+			pattern = next;
+			candidate++;
+			continue;
+		}
+
+		if (!retry_pattern) {
+			return false;
+		}
+
+		/* Let the last star match one more character. */
+		pattern = retry_pattern;
+		candidate = ++retry_candidate;
+	}
+}
+
+static
+bool is_integer(const struct reg *reg)
+{
+	return reg->type == REG_S64 || reg->type == REG_U64;
+}
+
+static
+bool is_number(const struct reg *reg)
+{
+	return is_integer(reg) || reg->type == REG_DOUBLE;
+}
+
+static
+double to_double(const struct reg *reg)
+{
+	switch (reg->type) {
+	case REG_S64:
+		return (double) reg->u.s64;
+	case REG_U64:
+		return (double) reg->u.u64;
+	default:
+		return reg->u.d;
+	}
+}
+
+static
+bool apply_comparison(enum bytecode_op op, int diff)
+{
+	switch (op) {
+	case BYTECODE_OP_EQ:
+		return diff == 0;
+	case BYTECODE_OP_NE:
+		return diff != 0;
+	case BYTECODE_OP_GT:
+		return diff > 0;
+	case BYTECODE_OP_LT:
+		return diff < 0;
+	case BYTECODE_OP_GE:
+		return diff >= 0;
+	case BYTECODE_OP_LE:
+	default:
+		return diff <= 0;
+	}
+}
+
+static
+bool compare_doubles(enum bytecode_op op, double left, double right)
+{
+	switch (op) {
+	case BYTECODE_OP_EQ:
+		return left == right;
+	case BYTECODE_OP_NE:
+		return left != right;
+	case BYTECODE_OP_GT:
+		return left > right;
+	case BYTECODE_OP_LT:
+		return left < right;
+	case BYTECODE_OP_GE:
+		return left >= right;
+	case BYTECODE_OP_LE:
+	default:
+		return left <= right;
+	}
+}
+
+/*
+ * Integers are compared as signed 64-bit integers, like the tracers do.
+ */
+static
+int compare(enum bytecode_op op, const struct reg *left,
+		const struct reg *right, bool *result)
+{
+	if (is_number(left) && is_number(right)) {
+		if (left->type == REG_DOUBLE || right->type == REG_DOUBLE) {
+			*result = compare_doubles(op, to_double(left),
+					to_double(right));
+		} else {
+			*result = apply_comparison(op,
+					(left->u.s64 > right->u.s64) -
+					(left->u.s64 < right->u.s64));
+		}
+		return 0;
+	}
+
+	if (left->type == REG_STRING && right->type == REG_STRING) {
+		*result = apply_comparison(op, compare_strings(left, right));
+		return 0;
+	}
+
+	if ((op == BYTECODE_OP_EQ || op == BYTECODE_OP_NE) &&
+			((left->type == REG_STRING &&
+				right->type == REG_STAR_GLOB_STRING) ||
+			(left->type == REG_STAR_GLOB_STRING &&
+				right->type == REG_STRING))) {
+		const bool match = left->type == REG_STAR_GLOB_STRING ?
+				star_glob_match(left->u.s.str, right->u.s.str) :
+				star_glob_match(right->u.s.str, left->u.s.str);
+
+		*result = op == BYTECODE_OP_EQ ? match : !match;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+/* Load the value of a field in a register. */
+static
+int load_value(const struct bytecode_interpreter_value *value,
+		struct reg *reg)
+{
+	switch (value->type) {
+	case BYTECODE_INTERPRETER_VALUE_TYPE_S64:
+		reg->type = REG_S64;
+		reg->u.s64 = value->u.s64;
+		return 0;
+	case BYTECODE_INTERPRETER_VALUE_TYPE_U64:
+		reg->type = REG_U64;
+		reg->u.u64 = value->u.u64;
+		return 0;
+	case BYTECODE_INTERPRETER_VALUE_TYPE_DOUBLE:
+		reg->type = REG_DOUBLE;
+		reg->u.d = value->u.d;
+		return 0;
+	case BYTECODE_INTERPRETER_VALUE_TYPE_STRING:
+		if (!value->u.string) {
+			return -EINVAL;
+		}
+		reg->type = REG_STRING;
+		reg->u.s.str = value->u.string;
+		reg->u.s.literal = false;
+		return 0;
+	default:
+		/* Arrays can only be accessed by index. */
+		return -EINVAL;
+	}
+}
+
+/* Load the field or array element designated by an object register. */
+static
+int load_object(const struct bytecode_interpreter_event *event,
+		struct reg *reg)
+{
+	switch (reg->type) {
+	case REG_FIELD:
+		return load_value(&event->fields[reg->u.object.field].value, reg);
+	case REG_ELEMENT:
+	{
+		const struct bytecode_interpreter_value *array =
+				&event->fields[reg->u.object.field].value;
+
+		reg->type = REG_S64;
+		reg->u.s64 = array->u.array.elements[reg->u.object.index];
+		return 0;
+	}
+	default:
+		return -EINVAL;
+	}
+}
+
+static
+int get_index(const struct bytecode_interpreter_event *event,
+		struct reg *reg, uint64_t index)
+{
+	const struct bytecode_interpreter_value *value;
+
+	if (reg->type != REG_FIELD) {
+		return -EINVAL;
+	}
+
+	value = &event->fields[reg->u.object.field].value;
+	if (value->type != BYTECODE_INTERPRETER_VALUE_TYPE_ARRAY ||
+			index >= value->u.array.count) {
+		return -EINVAL;
+	}
+
+	reg->type = REG_ELEMENT;
+	reg->u.object.index = index;
+	return 0;
+}
+
+static
+int reg_to_value(const struct bytecode_interpreter_event *event,
+		const struct reg *reg, struct bytecode_interpreter_value *value)
+{
+	switch (reg->type) {
+	case REG_S64:
+		value->type = BYTECODE_INTERPRETER_VALUE_TYPE_S64;
+		value->u.s64 = reg->u.s64;
+		return 0;
+	case REG_U64:
+		value->type = BYTECODE_INTERPRETER_VALUE_TYPE_U64;
+		value->u.u64 = reg->u.u64;
+		return 0;
+	case REG_DOUBLE:
+		value->type = BYTECODE_INTERPRETER_VALUE_TYPE_DOUBLE;
+		value->u.d = reg->u.d;
+		return 0;
+	case REG_STRING:
+	case REG_STAR_GLOB_STRING:
+		value->type = BYTECODE_INTERPRETER_VALUE_TYPE_STRING;
+		value->u.string = reg->u.s.str;
+		return 0;
+	case REG_FIELD:
+		/* Captured field, which may be an array. */
+		*value = event->fields[reg->u.object.field].value;
+		return 0;
+	case REG_ELEMENT:
+	{
+		struct reg element = *reg;
+		int ret;
+
+		ret = load_object(event, &element);
+		if (ret) {
+			return ret;
+		}
+
+		return reg_to_value(event, &element, value);
+	}
+	default:
+		return -EINVAL;
+	}
+}
+
+int bytecode_interpreter_run(const struct bytecode_interpreter_program *program,
+		const struct bytecode_interpreter_event *event,
+		struct bytecode_interpreter_value *result)
+{
+	const char *code = program->bytecode->data;
+	const uint32_t code_len = program->bytecode->reloc_table_offset;
+	struct reg stack[INTERPRETER_STACK_LEN];
+	unsigned int depth = 0;
+	uint32_t pc = 0;
+
+	if (event->field_count != program->field_count) {
+		return -EINVAL;
+	}
+
+	while (pc < code_len) {
+		const enum bytecode_op op = (enum bytecode_op) code[pc];
+		struct reg *ax = depth > 0 ? &stack[depth - 1] : NULL;
+		struct reg *bx = depth > 1 ? &stack[depth - 2] : NULL;
+
+		switch (op) {
+		case BYTECODE_OP_RETURN:
+		case BYTECODE_OP_RETURN_S64:
+			if (!ax) {
+				return -EINVAL;
+			}
+			return reg_to_value(event, ax, result);
+
+		case BYTECODE_OP_EQ:
+		case BYTECODE_OP_NE:
+		case BYTECODE_OP_GT:
+		case BYTECODE_OP_LT:
+		case BYTECODE_OP_GE:
+		case BYTECODE_OP_LE:
+		{
+			bool value;
+
+			if (!bx || compare(op, bx, ax, &value)) {
+				return -EINVAL;
+			}
+			bx->type = REG_S64;
+			bx->u.s64 = value;
+			depth--;
+			pc += sizeof(struct binary_op);
+			break;
+		}
+
+		case BYTECODE_OP_BIT_RSHIFT:
+		case BYTECODE_OP_BIT_LSHIFT:
+		case BYTECODE_OP_BIT_AND:
+		case BYTECODE_OP_BIT_OR:
+		case BYTECODE_OP_BIT_XOR:
+			if (!bx || !is_integer(bx) || !is_integer(ax)) {
+				return -EINVAL;
+			}
+			switch (op) {
+			case BYTECODE_OP_BIT_RSHIFT:
+			case BYTECODE_OP_BIT_LSHIFT:
+				/* Undefined shifts are runtime errors. */
+				if (ax->u.u64 >= 64) {
+					return -EINVAL;
+				}
+				bx->u.u64 = op == BYTECODE_OP_BIT_RSHIFT ?
+						bx->u.u64 >> ax->u.u64 :
+						bx->u.u64 << ax->u.u64;
+				break;
+			case BYTECODE_OP_BIT_AND:
+				bx->u.u64 &= ax->u.u64;
+				break;
+			case BYTECODE_OP_BIT_OR:
+				bx->u.u64 |= ax->u.u64;
+				break;
+			default:
+				bx->u.u64 ^= ax->u.u64;
+				break;
+			}
+			bx->type = REG_U64;
+			depth--;
+			pc += sizeof(struct binary_op);
+			break;
+
+		case BYTECODE_OP_UNARY_PLUS:
+			if (!ax || !is_number(ax)) {
+				return -EINVAL;
+			}
+			pc += sizeof(struct unary_op);
+			break;
+		case BYTECODE_OP_UNARY_MINUS:
+			if (!ax || !is_number(ax)) {
+				return -EINVAL;
+			}
+			if (ax->type == REG_DOUBLE) {
+				ax->u.d = -ax->u.d;
+			} else {
+				ax->type = REG_S64;
+				ax->u.u64 = -ax->u.u64;
+			}
+			pc += sizeof(struct unary_op);
+			break;
+		case BYTECODE_OP_UNARY_NOT:
+			if (!ax || !is_number(ax)) {
+				return -EINVAL;
+			}
+			ax->u.s64 = ax->type == REG_DOUBLE ? !ax->u.d : !ax->u.u64;
+			ax->type = REG_S64;
+			pc += sizeof(struct unary_op);
+			break;
+		case BYTECODE_OP_UNARY_BIT_NOT:
+			if (!ax || !is_integer(ax)) {
+				return -EINVAL;
+			}
+			ax->type = REG_U64;
+			ax->u.u64 = ~ax->u.u64;
+			pc += sizeof(struct unary_op);
+			break;
+
+		case BYTECODE_OP_AND:
+		case BYTECODE_OP_OR:
+		{
+			struct logical_op insn;
+
+			if (!ax || !is_integer(ax)) {
+				return -EINVAL;
+			}
+
+			memcpy(&insn, &code[pc], sizeof(insn));
+			if (op == BYTECODE_OP_AND && ax->u.u64 == 0) {
+				/* Short-circuit: the result is 0. */
+				pc = insn.skip_offset;
+			} else if (op == BYTECODE_OP_OR && ax->u.u64 != 0) {
+				/* Short-circuit: the result is 1. */
+				ax->type = REG_S64;
+				ax->u.s64 = 1;
+				pc = insn.skip_offset;
+			} else {
+				/* The result is the one of the right operand. */
+				depth--;
+				pc += sizeof(insn);
+			}
+			break;
+		}
+
+		case BYTECODE_OP_LOAD_FIELD_REF:
+		case BYTECODE_OP_GET_CONTEXT_REF:
+		{
+			struct field_ref ref;
+
+			if (depth == INTERPRETER_STACK_LEN) {
+				return -EINVAL;
+			}
+
+			memcpy(&ref, &code[pc + sizeof(struct load_op)],
+					sizeof(ref));
+			if (load_value(&event->fields[ref.offset].value,
+					&stack[depth])) {
+				return -EINVAL;
+			}
+			depth++;
+			pc += sizeof(struct load_op) + sizeof(ref);
+			break;
+		}
+
+		case BYTECODE_OP_LOAD_STRING:
+		case BYTECODE_OP_LOAD_STAR_GLOB_STRING:
+		{
+			const char *str = &code[pc + sizeof(struct load_op)];
+
+			if (depth == INTERPRETER_STACK_LEN) {
+				return -EINVAL;
+			}
+
+			stack[depth].type = op == BYTECODE_OP_LOAD_STRING ?
+					REG_STRING : REG_STAR_GLOB_STRING;
+			stack[depth].u.s.str = str;
+			stack[depth].u.s.literal = true;
+			depth++;
+			pc += sizeof(struct load_op) + strlen(str) + 1;
+			break;
+		}
+		case BYTECODE_OP_LOAD_S64:
+			if (depth == INTERPRETER_STACK_LEN) {
+				return -EINVAL;
+			}
+
+			stack[depth].type = REG_S64;
+			memcpy(&stack[depth].u.s64, &code[pc + sizeof(struct load_op)],
+					sizeof(stack[depth].u.s64));
+			depth++;
+			pc += sizeof(struct load_op) + sizeof(struct literal_numeric);
+			break;
+		case BYTECODE_OP_LOAD_DOUBLE:
+			if (depth == INTERPRETER_STACK_LEN) {
+				return -EINVAL;
+			}
+
+			stack[depth].type = REG_DOUBLE;
+			memcpy(&stack[depth].u.d, &code[pc + sizeof(struct load_op)],
+					sizeof(stack[depth].u.d));
+			depth++;
+			pc += sizeof(struct load_op) + sizeof(struct literal_double);
+			break;
+
+		case BYTECODE_OP_CAST_TO_S64:
+			if (!ax || !is_number(ax)) {
+				return -EINVAL;
+			}
+			if (ax->type == REG_DOUBLE) {
+				ax->u.s64 = (int64_t) ax->u.d;
+			}
+			ax->type = REG_S64;
+			pc += sizeof(struct cast_op);
+			break;
+		case BYTECODE_OP_CAST_DOUBLE_TO_S64:
+			if (!ax || ax->type != REG_DOUBLE) {
+				return -EINVAL;
+			}
+			ax->type = REG_S64;
+			ax->u.s64 = (int64_t) ax->u.d;
+			pc += sizeof(struct cast_op);
+			break;
+		case BYTECODE_OP_CAST_NOP:
+			pc += sizeof(struct cast_op);
+			break;
+
+		case BYTECODE_OP_GET_CONTEXT_ROOT:
+		case BYTECODE_OP_GET_APP_CONTEXT_ROOT:
+		case BYTECODE_OP_GET_PAYLOAD_ROOT:
+			if (depth == INTERPRETER_STACK_LEN) {
+				return -EINVAL;
+			}
+
+			stack[depth].type = REG_ROOT;
+			depth++;
+			pc += sizeof(struct load_op);
+			break;
+		case BYTECODE_OP_GET_SYMBOL_FIELD:
+		{
+			struct get_symbol symbol;
+
+			if (!ax || ax->type != REG_ROOT) {
+				return -EINVAL;
+			}
+
+			memcpy(&symbol, &code[pc + sizeof(struct load_op)],
+					sizeof(symbol));
+			ax->type = REG_FIELD;
+			ax->u.object.field = symbol.offset;
+			pc += sizeof(struct load_op) + sizeof(symbol);
+			break;
+		}
+		case BYTECODE_OP_GET_INDEX_U16:
+		{
+			struct get_index_u16 index;
+
+			memcpy(&index, &code[pc + sizeof(struct load_op)],
+					sizeof(index));
+			if (!ax || get_index(event, ax, index.index)) {
+				return -EINVAL;
+			}
+			pc += sizeof(struct load_op) + sizeof(index);
+			break;
+		}
+		case BYTECODE_OP_GET_INDEX_U64:
+		{
+			struct get_index_u64 index;
+
+			memcpy(&index, &code[pc + sizeof(struct load_op)],
+					sizeof(index));
+			if (!ax || get_index(event, ax, index.index)) {
+				return -EINVAL;
+			}
+			pc += sizeof(struct load_op) + sizeof(index);
+			break;
+		}
+		case BYTECODE_OP_LOAD_FIELD:
+			if (!ax || load_object(event, ax)) {
+				return -EINVAL;
+			}
+			pc += sizeof(struct load_op);
+			break;
+
+		default:
+			/*
+			 * Arithmetic operators are parsed but, like in the
+			 * tracers, not supported.
+			 */
+			return -EINVAL;
+		}
+	}
+
+	/* The bytecode doesn't end with a return instruction. */
+	return -EINVAL;
+}
+
+int bytecode_interpreter_filter(
+		const struct bytecode_interpreter_program *program,
+		const struct bytecode_interpreter_event *event)
+{
+	int ret;
+	struct bytecode_interpreter_value result;
+
+	ret = bytecode_interpreter_run(program, event, &result);
+	if (ret) {
+		return ret;
+	}
+
+	switch (result.type) {
+	case BYTECODE_INTERPRETER_VALUE_TYPE_S64:
+		return result.u.s64 != 0;
+	case BYTECODE_INTERPRETER_VALUE_TYPE_U64:
+		return result.u.u64 != 0;
+	default:
+		return -EINVAL;
+	}
+}
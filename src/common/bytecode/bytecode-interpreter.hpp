@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_COMMON_BYTECODE_INTERPRETER_H
+#define LTTNG_COMMON_BYTECODE_INTERPRETER_H
+
+#include <stdint.h>
+
+struct lttng_bytecode;
+
+/*
+ * Offline interpreter of the filter and capture bytecode generated by the
+ * tools.
+ *
+ * It evaluates bytecode against synthetic events, following the semantics
+ * of the tracers' interpreters, so that the cost and the result of a filter
+ * can be measured without deploying it in a traced application.
+ *
+ * Like the tracers, a bytecode is first linked against the layout of an
+ * event (the names of its fields), which resolves its field references.
+ * The resulting program can then be run against any event having that
+ * layout.
+ */
+
+enum bytecode_interpreter_scope {
+	BYTECODE_INTERPRETER_SCOPE_PAYLOAD,
+	/* Referenced as `$ctx.name`. */
+	BYTECODE_INTERPRETER_SCOPE_CONTEXT,
+	/* Referenced as `$app.provider:name`; named `provider:name`. */
+	BYTECODE_INTERPRETER_SCOPE_APP_CONTEXT,
+};
+
+enum bytecode_interpreter_value_type {
+	BYTECODE_INTERPRETER_VALUE_TYPE_S64,
+	BYTECODE_INTERPRETER_VALUE_TYPE_U64,
+	BYTECODE_INTERPRETER_VALUE_TYPE_DOUBLE,
+	BYTECODE_INTERPRETER_VALUE_TYPE_STRING,
+	/* Array of signed integers, only accessed by index. */
+	BYTECODE_INTERPRETER_VALUE_TYPE_ARRAY,
+};
+
+struct bytecode_interpreter_value {
+	enum bytecode_interpreter_value_type type;
+	union {
+		int64_t s64;
+		uint64_t u64;
+		double d;
+		const char *string;
+		struct {
+			const int64_t *elements;
+			uint64_t count;
+		} array;
+	} u;
+};
+
+struct bytecode_interpreter_field {
+	enum bytecode_interpreter_scope scope;
+	const char *name;
+	struct bytecode_interpreter_value value;
+};
+
+struct bytecode_interpreter_event {
+	const struct bytecode_interpreter_field *fields;
+	unsigned int field_count;
+};
+
+struct bytecode_interpreter_program;
+
+/*
+ * Validate a bytecode and link it against the layout of an event: the
+ * scopes and names of its fields. Their values are not used.
+ *
+ * Returns 0 on success, -ENOENT if the bytecode references a field which
+ * the event doesn't have (the tracers then never record the event),
+ * -EINVAL if the bytecode is invalid or uses unsupported instructions, or
+ * -ENOMEM.
+ */
+int bytecode_interpreter_link(const struct lttng_bytecode *bytecode,
+		const struct bytecode_interpreter_event *layout,
+		struct bytecode_interpreter_program **program);
+
+void bytecode_interpreter_program_destroy(
+		struct bytecode_interpreter_program *program);
+
+/*
+ * Run a program against an event having the layout against which it was
+ * linked.
+ *
+ * On success, returns 0 and sets `result` to the value returned by the
+ * program: the value of a filter expression or the captured field. The
+ * strings and arrays of the result belong to the event.
+ *
+ * Returns -EINVAL on runtime error (e.g. an unsupported operation or an out
+ * of bound index), on which the tracers discard the event.
+ */
+int bytecode_interpreter_run(const struct bytecode_interpreter_program *program,
+		const struct bytecode_interpreter_event *event,
+		struct bytecode_interpreter_value *result);
+
+/*
+ * Run a filter program against an event.
+ *
+ * Returns 1 if the event is recorded, 0 if it is discarded, or -EINVAL if it
+ * is discarded because of a runtime error.
+ */
+int bytecode_interpreter_filter(
+		const struct bytecode_interpreter_program *program,
+		const struct bytecode_interpreter_event *event);
+
+#endif /* LTTNG_COMMON_BYTECODE_INTERPRETER_H */
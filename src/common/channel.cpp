@@ -178,6 +178,8 @@ ssize_t lttng_channel_create_from_buffer(const struct lttng_buffer_view *view,
 	extended->lost_packets = channel_comm->lost_packets;
 	extended->monitor_timer_interval = channel_comm->monitor_timer_interval;
 	extended->blocking_timeout = channel_comm->blocking_timeout;
+	extended->compression = channel_comm->compression;
+	extended->suppress_empty_packets = channel_comm->suppress_empty_packets;
 
 	*channel = local_channel;
 	local_channel = nullptr;
@@ -232,6 +234,8 @@ int lttng_channel_serialize(
 	channel_comm.lost_packets = extended->lost_packets;
 	channel_comm.monitor_timer_interval = extended->monitor_timer_interval;
 	channel_comm.blocking_timeout = extended->blocking_timeout;
+	channel_comm.compression = extended->compression;
+	channel_comm.suppress_empty_packets = extended->suppress_empty_packets;
 
 	/* Header */
 	ret = lttng_dynamic_buffer_append(
@@ -66,6 +66,17 @@ static inline ssize_t splice(
 {
 	return -ENOSYS;
 }
+
+struct iovec;
+
+static inline ssize_t vmsplice(
+		int fd __attribute__((unused)),
+		const struct iovec *iov __attribute__((unused)),
+		unsigned long nr_segs __attribute__((unused)),
+		unsigned int flags __attribute__((unused)))
+{
+	return -ENOSYS;
+}
 #endif
 
 #if !(defined(__linux__) || defined(__FreeBSD__) || defined(__CYGWIN__) || defined(__sun__) || defined(__APPLE__))
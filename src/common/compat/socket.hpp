@@ -26,13 +26,19 @@ ssize_t lttng_recvmsg_nosigpipe(int sockfd, struct msghdr *msg)
 {
 	return recvmsg(sockfd, msg, MSG_NOSIGNAL);
 }
+
+static inline
+ssize_t lttng_sendmsg_nosigpipe(int sockfd, const struct msghdr *msg)
+{
+	return sendmsg(sockfd, msg, MSG_NOSIGNAL);
+}
 #else
 
 #include <signal.h>
 #include <common/compat/errno.hpp>
 
 static inline
-ssize_t lttng_recvmsg_nosigpipe(int sockfd, struct msghdr *msg)
+ssize_t lttng_msg_nosigpipe(int sockfd, struct msghdr *msg, bool send)
 {
 	ssize_t received;
 	int saved_err;
@@ -74,7 +80,7 @@ ssize_t lttng_recvmsg_nosigpipe(int sockfd, struct msghdr *msg)
 	}
 
 	/* Send and save errno. */
-	received = recvmsg(sockfd, msg, 0);
+	received = send ? sendmsg(sockfd, msg, 0) : recvmsg(sockfd, msg, 0);
 	saved_err = errno;
 
 	if (received == -1 && errno == EPIPE && !sigpipe_was_pending) {
@@ -96,6 +102,18 @@ ssize_t lttng_recvmsg_nosigpipe(int sockfd, struct msghdr *msg)
 
 	return received;
 }
+
+static inline
+ssize_t lttng_recvmsg_nosigpipe(int sockfd, struct msghdr *msg)
+{
+	return lttng_msg_nosigpipe(sockfd, msg, false);
+}
+
+static inline
+ssize_t lttng_sendmsg_nosigpipe(int sockfd, const struct msghdr *msg)
+{
+	return lttng_msg_nosigpipe(sockfd, (struct msghdr *) msg, true);
+}
 #endif
 
 #ifdef __sun__
@@ -46,6 +46,8 @@ LTTNG_EXPORT extern const char * const config_element_switch_timer_interval;
 LTTNG_EXPORT extern const char * const config_element_read_timer_interval;
 extern const char * const config_element_monitor_timer_interval;
 extern const char * const config_element_blocking_timeout;
+extern const char * const config_element_compression;
+extern const char * const config_element_suppress_empty_packets;
 LTTNG_EXPORT extern const char * const config_element_output;
 LTTNG_EXPORT extern const char * const config_element_output_type;
 LTTNG_EXPORT extern const char * const config_element_tracefile_size;
@@ -76,6 +78,7 @@ LTTNG_EXPORT extern const char * const config_element_net_output;
 LTTNG_EXPORT extern const char * const config_element_control_uri;
 LTTNG_EXPORT extern const char * const config_element_data_uri;
 LTTNG_EXPORT extern const char * const config_element_max_size;
+extern const char * const config_element_incremental;
 LTTNG_EXPORT extern const char * const config_element_pid;
 extern const char * const config_element_process_attr_id;
 LTTNG_EXPORT extern const char * const config_element_pids;
@@ -117,6 +120,9 @@ LTTNG_EXPORT extern const char * const config_overwrite_mode_overwrite;
 LTTNG_EXPORT extern const char * const config_output_type_splice;
 LTTNG_EXPORT extern const char * const config_output_type_mmap;
 
+extern const char * const config_compression_none;
+extern const char * const config_compression_zstd;
+
 LTTNG_EXPORT extern const char * const config_loglevel_type_all;
 LTTNG_EXPORT extern const char * const config_loglevel_type_range;
 LTTNG_EXPORT extern const char * const config_loglevel_type_single;
@@ -91,6 +91,8 @@ const char * const config_element_switch_timer_interval = "switch_timer_interval
 const char * const config_element_read_timer_interval = "read_timer_interval";
 const char * const config_element_monitor_timer_interval = "monitor_timer_interval";
 const char * const config_element_blocking_timeout = "blocking_timeout";
+const char * const config_element_compression = "compression";
+const char * const config_element_suppress_empty_packets = "suppress_empty_packets";
 const char * const config_element_output = "output";
 const char * const config_element_output_type = "output_type";
 const char * const config_element_tracefile_size = "tracefile_size";
@@ -121,6 +123,7 @@ const char * const config_element_net_output = "net_output";
 const char * const config_element_control_uri = "control_uri";
 const char * const config_element_data_uri = "data_uri";
 const char * const config_element_max_size = "max_size";
+const char * const config_element_incremental = "incremental";
 const char * const config_element_pid = "pid";
 const char * const config_element_pids = "pids";
 const char * const config_element_shared_memory_path = "shared_memory_path";
@@ -171,6 +174,9 @@ const char * const config_overwrite_mode_overwrite = "OVERWRITE";
 const char * const config_output_type_splice = "SPLICE";
 const char * const config_output_type_mmap = "MMAP";
 
+const char * const config_compression_none = "NONE";
+const char * const config_compression_zstd = "ZSTD";
+
 const char * const config_loglevel_type_all = "ALL";
 const char * const config_loglevel_type_range = "RANGE";
 const char * const config_loglevel_type_single = "SINGLE";
@@ -814,6 +820,28 @@ error:
 	return -1;
 }
 
+static
+int get_compression(xmlChar *compression)
+{
+	int ret;
+
+	if (!compression) {
+		goto error;
+	}
+
+	if (!strcmp((char *) compression, config_compression_none)) {
+		ret = LTTNG_CHANNEL_COMPRESSION_NONE;
+	} else if (!strcmp((char *) compression, config_compression_zstd)) {
+		ret = LTTNG_CHANNEL_COMPRESSION_ZSTD;
+	} else {
+		goto error;
+	}
+
+	return ret;
+error:
+	return -1;
+}
+
 static
 int get_event_type(xmlChar *event_type)
 {
@@ -1207,6 +1235,7 @@ int create_snapshot_session(const char *session_name, xmlNodePtr output_node,
 			xmlNextElementSibling(snapshot_output_node)) {
 		char *name = NULL;
 		uint64_t max_size = UINT64_MAX;
+		int incremental = 0;
 		struct consumer_output output = {};
 		struct lttng_snapshot_output *snapshot_output = NULL;
 		const char *control_uri = NULL;
@@ -1238,6 +1267,21 @@ int create_snapshot_session(const char *session_name, xmlNodePtr output_node,
 					ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
 					goto error_snapshot_output;
 				}
+			} else if (!strcmp((const char *) node->name,
+				config_element_incremental)) {
+				xmlChar *content = xmlNodeGetContent(node);
+
+				/* incremental */
+				if (!content) {
+					ret = -LTTNG_ERR_NOMEM;
+					goto error_snapshot_output;
+				}
+				ret = parse_bool(content, &incremental);
+				free(content);
+				if (ret) {
+					ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+					goto error_snapshot_output;
+				}
 			} else {
 				/* consumer_output */
 				ret = process_consumer_output(node, &output);
@@ -1287,6 +1331,12 @@ int create_snapshot_session(const char *session_name, xmlNodePtr output_node,
 			goto error_snapshot_output;
 		}
 
+		ret = lttng_snapshot_output_set_incremental(incremental,
+				snapshot_output);
+		if (ret) {
+			goto error_snapshot_output;
+		}
+
 		if (path) {
 			ret = lttng_snapshot_output_set_ctrl_url(path,
 					snapshot_output);
@@ -2350,6 +2400,55 @@ int process_channel_attr_node(xmlNodePtr attr_node,
 			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
 			goto end;
 		}
+	} else if (!strcmp((const char *) attr_node->name,
+			config_element_compression)) {
+		xmlChar *content;
+
+		/* compression */
+		content = xmlNodeGetContent(attr_node);
+		if (!content) {
+			ret = -LTTNG_ERR_NOMEM;
+			goto end;
+		}
+
+		ret = get_compression(content);
+		free(content);
+		if (ret < 0) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
+
+		ret = lttng_channel_set_compression(channel,
+			(enum lttng_channel_compression) ret);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
+	} else if (!strcmp((const char *) attr_node->name,
+			config_element_suppress_empty_packets)) {
+		xmlChar *content;
+		int suppress_empty_packets;
+
+		/* suppress_empty_packets */
+		content = xmlNodeGetContent(attr_node);
+		if (!content) {
+			ret = -LTTNG_ERR_NOMEM;
+			goto end;
+		}
+
+		ret = parse_bool(content, &suppress_empty_packets);
+		free(content);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
+
+		ret = lttng_channel_set_empty_packet_suppression(channel,
+			suppress_empty_packets);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
 	} else if (!strcmp((const char *) attr_node->name,
 			config_element_events)) {
 		/* events */
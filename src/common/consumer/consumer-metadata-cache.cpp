@@ -14,6 +14,8 @@
 #include <unistd.h>
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <common/common.hpp>
 #include <common/utils.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
@@ -22,53 +24,144 @@
 
 #include "consumer-metadata-cache.hpp"
 
-enum metadata_cache_update_version_status {
-	METADATA_CACHE_UPDATE_STATUS_VERSION_UPDATED,
-	METADATA_CACHE_UPDATE_STATUS_VERSION_NOT_UPDATED,
-};
-
 extern struct lttng_consumer_global_data the_consumer_data;
 
 /*
- * Reset the metadata cache.
+ * Offset, within the cache, of the first byte of a chunk.
  */
-static
-void metadata_cache_reset(struct consumer_metadata_cache *cache)
+static uint64_t metadata_cache_chunk_offset(unsigned int chunk_index)
 {
-	const int ret = lttng_dynamic_buffer_set_size(&cache->contents, 0);
+	return (uint64_t) DEFAULT_METADATA_CACHE_SIZE *
+			((UINT64_C(1) << chunk_index) - 1);
+}
 
-	LTTNG_ASSERT(ret == 0);
+static uint64_t metadata_cache_chunk_size(unsigned int chunk_index)
+{
+	return (uint64_t) DEFAULT_METADATA_CACHE_SIZE << chunk_index;
 }
 
 /*
- * Check if the metadata cache version changed.
- * If it did, reset the metadata cache.
- * The metadata cache lock MUST be held.
+ * Index of the chunk containing the byte at `offset`. Chunk `n` starts at
+ * DEFAULT_METADATA_CACHE_SIZE * (2^n - 1).
  */
-static enum metadata_cache_update_version_status metadata_cache_update_version(
-		struct consumer_metadata_cache *cache, uint64_t version)
+static unsigned int metadata_cache_chunk_index(uint64_t offset)
+{
+	return utils_get_count_order_u64(
+			offset / DEFAULT_METADATA_CACHE_SIZE + 2) - 1;
+}
+
+static void metadata_cache_contents_destroy(
+		struct consumer_metadata_cache_contents *contents)
 {
-	enum metadata_cache_update_version_status status;
+	unsigned int i;
 
-	if (cache->version == version) {
-		status = METADATA_CACHE_UPDATE_STATUS_VERSION_NOT_UPDATED;
-		goto end;
+	if (!contents) {
+		return;
+	}
+
+	for (i = 0; i < METADATA_CACHE_MAX_CHUNKS; i++) {
+		free(contents->chunks[i]);
+	}
+
+	free(contents);
+}
+
+static void metadata_cache_contents_destroy_rcu(struct rcu_head *head)
+{
+	struct consumer_metadata_cache_contents *contents =
+			lttng::utils::container_of(head,
+					&consumer_metadata_cache_contents::rcu_head);
+
+	metadata_cache_contents_destroy(contents);
+}
+
+static struct consumer_metadata_cache_contents *metadata_cache_contents_create(
+		uint64_t version)
+{
+	struct consumer_metadata_cache_contents *contents;
+
+	contents = zmalloc<consumer_metadata_cache_contents>();
+	if (!contents) {
+		PERROR("Failed to allocate metadata cache contents");
+		goto error;
+	}
+
+	contents->version = version;
+	contents->chunks[0] = calloc<char>(metadata_cache_chunk_size(0));
+	if (!contents->chunks[0]) {
+		PERROR("Failed to pre-allocate metadata cache storage of %d bytes",
+				DEFAULT_METADATA_CACHE_SIZE);
+		goto error;
 	}
 
-	DBG("Metadata cache version update to %" PRIu64, version);
-	cache->version = version;
-	status = METADATA_CACHE_UPDATE_STATUS_VERSION_UPDATED;
+	return contents;
+error:
+	metadata_cache_contents_destroy(contents);
+	return NULL;
+}
+
+/*
+ * Copy `len` bytes at `offset` in the contents, allocating the chunks as
+ * needed. The bytes are not published to the readers.
+ *
+ * Newly allocated chunks are zeroed: gaps left by non-contiguous writes read
+ * as zeroes.
+ */
+static int metadata_cache_contents_copy(
+		struct consumer_metadata_cache_contents *contents,
+		uint64_t offset, uint64_t len, const char *data)
+{
+	int ret = 0;
+
+	while (len > 0) {
+		const unsigned int chunk_index =
+				metadata_cache_chunk_index(offset);
+		uint64_t offset_in_chunk, copy_len;
+
+		if (chunk_index >= METADATA_CACHE_MAX_CHUNKS) {
+			ERR("Metadata cache size limit reached");
+			ret = -1;
+			goto end;
+		}
+
+		if (!contents->chunks[chunk_index]) {
+			contents->chunks[chunk_index] = calloc<char>(
+					metadata_cache_chunk_size(chunk_index));
+			if (!contents->chunks[chunk_index]) {
+				PERROR("Failed to allocate metadata cache chunk of %" PRIu64 " bytes",
+						metadata_cache_chunk_size(chunk_index));
+				ret = -1;
+				goto end;
+			}
+		}
+
+		offset_in_chunk = offset - metadata_cache_chunk_offset(chunk_index);
+		copy_len = std::min(len,
+				metadata_cache_chunk_size(chunk_index) -
+						offset_in_chunk);
+		if (data) {
+			memcpy(contents->chunks[chunk_index] + offset_in_chunk,
+					data, copy_len);
+			data += copy_len;
+		}
 
+		offset += copy_len;
+		len -= copy_len;
+	}
 end:
-	return status;
+	return ret;
 }
 
 /*
  * Write metadata to the cache, extend the cache if necessary. We support
- * overlapping updates, but they need to be contiguous. Send the
- * contiguous metadata in cache to the ring buffer. The metadata cache
+ * overlapping updates, but they need to be contiguous. The metadata cache
  * lock MUST be acquired to write in the cache.
  *
+ * Previously written bytes are never modified: the overlapping part of a
+ * write is expected to be identical to the cached data and is skipped. When
+ * the version changes, new contents replace the current ones and the latter
+ * are reclaimed once no reader can access them anymore.
+ *
  * See `enum consumer_metadata_cache_write_status` for the meaning of the
  * various returned status codes.
  */
@@ -77,47 +170,130 @@ consumer_metadata_cache_write(struct consumer_metadata_cache *cache,
 		unsigned int offset, unsigned int len, uint64_t version,
 		const char *data)
 {
-	int ret = 0;
+	int ret;
 	enum consumer_metadata_cache_write_status status;
 	bool cache_is_invalidated = false;
+	struct consumer_metadata_cache_contents *contents;
 	uint64_t original_size;
+	const uint64_t end_offset = (uint64_t) offset + len;
 
 	LTTNG_ASSERT(cache);
 	ASSERT_LOCKED(cache->lock);
-	original_size = cache->contents.size;
+	contents = cache->contents;
+
+	if (contents->version != version) {
+		struct consumer_metadata_cache_contents *new_contents;
 
-	if (metadata_cache_update_version(cache, version) ==
-			METADATA_CACHE_UPDATE_STATUS_VERSION_UPDATED) {
-		metadata_cache_reset(cache);
+		DBG("Metadata cache version update to %" PRIu64, version);
+		new_contents = metadata_cache_contents_create(version);
+		if (!new_contents) {
+			status = CONSUMER_METADATA_CACHE_WRITE_STATUS_ERROR;
+			goto end;
+		}
+
+		rcu_assign_pointer(cache->contents, new_contents);
+		call_rcu(&contents->rcu_head,
+				metadata_cache_contents_destroy_rcu);
+		contents = new_contents;
 		cache_is_invalidated = true;
 	}
 
+	/* Only the writer modifies the size; no need for an atomic read. */
+	original_size = contents->size;
+
 	DBG("Writing %u bytes from offset %u in metadata cache", len, offset);
-	if (offset + len > cache->contents.size) {
-		ret = lttng_dynamic_buffer_set_size(
-				&cache->contents, offset + len);
+	if (end_offset > original_size) {
+		uint64_t copy_offset = offset;
+
+		if (copy_offset < original_size) {
+			/* Skip the already cached (identical) bytes. */
+			data += original_size - copy_offset;
+			copy_offset = original_size;
+		} else if (copy_offset > original_size) {
+			/* Allocate the (zeroed) gap. */
+			ret = metadata_cache_contents_copy(contents,
+					original_size,
+					copy_offset - original_size, NULL);
+			if (ret) {
+				ERR("Extending metadata cache");
+				status = CONSUMER_METADATA_CACHE_WRITE_STATUS_ERROR;
+				goto end;
+			}
+		}
+
+		ret = metadata_cache_contents_copy(contents, copy_offset,
+				end_offset - copy_offset, data);
 		if (ret) {
 			ERR("Extending metadata cache");
 			status = CONSUMER_METADATA_CACHE_WRITE_STATUS_ERROR;
 			goto end;
 		}
-	}
 
-	memcpy(cache->contents.data + offset, data, len);
+		/* Publish the new bytes after they are written. */
+		cmm_smp_wmb();
+		uatomic_set(&contents->size, (unsigned long) end_offset);
+	}
 
 	if (cache_is_invalidated) {
 		status = CONSUMER_METADATA_CACHE_WRITE_STATUS_INVALIDATED;
-	} else if (cache->contents.size > original_size) {
+	} else if (contents->size > original_size) {
 		status = CONSUMER_METADATA_CACHE_WRITE_STATUS_APPENDED_CONTENT;
 	} else {
 		status = CONSUMER_METADATA_CACHE_WRITE_STATUS_NO_CHANGE;
-		LTTNG_ASSERT(cache->contents.size == original_size);
+		LTTNG_ASSERT(contents->size == original_size);
 	}
 
 end:
 	return status;
 }
 
+const struct consumer_metadata_cache_contents *
+consumer_metadata_cache_get_contents(struct consumer_metadata_cache *cache)
+{
+	ASSERT_RCU_READ_LOCKED();
+
+	return rcu_dereference(cache->contents);
+}
+
+uint64_t consumer_metadata_cache_contents_get_size(
+		const struct consumer_metadata_cache_contents *contents)
+{
+	const uint64_t size = uatomic_read(&contents->size);
+
+	/* Read the published size before the bytes it covers. */
+	cmm_smp_rmb();
+	return size;
+}
+
+struct lttng_buffer_view consumer_metadata_cache_contents_get_view(
+		const struct consumer_metadata_cache_contents *contents,
+		uint64_t offset, uint64_t size)
+{
+	unsigned int chunk_index;
+	uint64_t offset_in_chunk, len;
+
+	LTTNG_ASSERT(offset < size);
+	chunk_index = metadata_cache_chunk_index(offset);
+	offset_in_chunk = offset - metadata_cache_chunk_offset(chunk_index);
+	len = std::min(size - offset,
+			metadata_cache_chunk_size(chunk_index) - offset_in_chunk);
+
+	return lttng_buffer_view_init(contents->chunks[chunk_index],
+			offset_in_chunk, len);
+}
+
+uint64_t consumer_metadata_cache_get_size(struct consumer_metadata_cache *cache)
+{
+	uint64_t size;
+
+	rcu_read_lock();
+	size = consumer_metadata_cache_contents_get_size(
+			consumer_metadata_cache_get_contents(cache));
+	rcu_read_unlock();
+
+	return size;
+}
+
 /*
  * Create the metadata cache, original allocated size: max_sb_size
  *
@@ -141,20 +317,14 @@ int consumer_metadata_cache_allocate(struct lttng_consumer_channel *channel)
 		goto end_free_cache;
 	}
 
-	lttng_dynamic_buffer_init(&channel->metadata_cache->contents);
-	ret = lttng_dynamic_buffer_set_capacity(
-			&channel->metadata_cache->contents,
-			DEFAULT_METADATA_CACHE_SIZE);
-	if (ret) {
-		PERROR("Failed to pre-allocate metadata cache storage of %d bytes on creation",
-				DEFAULT_METADATA_CACHE_SIZE);
+	channel->metadata_cache->contents = metadata_cache_contents_create(0);
+	if (!channel->metadata_cache->contents) {
 		ret = -1;
 		goto end_free_mutex;
 	}
 
-	DBG("Allocated metadata cache: current capacity = %zu",
-			lttng_dynamic_buffer_get_capacity_left(
-					&channel->metadata_cache->contents));
+	DBG("Allocated metadata cache: first chunk size = %d",
+			DEFAULT_METADATA_CACHE_SIZE);
 
 	ret = 0;
 	goto end;
@@ -179,7 +349,7 @@ void consumer_metadata_cache_destroy(struct lttng_consumer_channel *channel)
 	DBG("Destroying metadata cache");
 
 	pthread_mutex_destroy(&channel->metadata_cache->lock);
-	lttng_dynamic_buffer_reset(&channel->metadata_cache->contents);
+	metadata_cache_contents_destroy(channel->metadata_cache->contents);
 	free(channel->metadata_cache);
 }
 
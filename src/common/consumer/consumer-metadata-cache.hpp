@@ -10,7 +10,10 @@
 #define CONSUMER_METADATA_CACHE_H
 
 #include <common/consumer/consumer.hpp>
-#include <common/dynamic-buffer.hpp>
+#include <common/buffer-view.hpp>
+
+#include <pthread.h>
+#include <urcu.h>
 
 enum consumer_metadata_cache_write_status {
 	CONSUMER_METADATA_CACHE_WRITE_STATUS_ERROR = -1,
@@ -33,17 +36,45 @@ enum consumer_metadata_cache_write_status {
 	CONSUMER_METADATA_CACHE_WRITE_STATUS_NO_CHANGE,
 };
 
-struct consumer_metadata_cache {
-	/* Current version of the metadata cache. */
+/*
+ * Maximal number of chunks of a metadata cache. Chunk `n` holds
+ * DEFAULT_METADATA_CACHE_SIZE * 2^n bytes; the cache can hold up to
+ * DEFAULT_METADATA_CACHE_SIZE * (2^METADATA_CACHE_MAX_CHUNKS - 1) bytes.
+ */
+#define METADATA_CACHE_MAX_CHUNKS	32
+
+/*
+ * Contents of a given version of the metadata cache.
+ *
+ * The contents are append-only: chunks are never moved nor modified once
+ * their bytes are published through `size`. This allows readers to consume
+ * the cache without holding the cache's lock (see
+ * consumer_metadata_cache_get_contents()).
+ */
+struct consumer_metadata_cache_contents {
+	/* Metadata version of the contents; immutable. */
 	uint64_t version;
 	/*
-	 * Size is the upper-limit of data written inside the buffer.
-	 * All cached data is contiguous.
+	 * Number of bytes available to readers. Updated by the writer after
+	 * the corresponding bytes are written; use
+	 * consumer_metadata_cache_contents_get_size() to read it.
+	 */
+	unsigned long size;
+	/* Chunks of increasing size, allocated on demand. */
+	char *chunks[METADATA_CACHE_MAX_CHUNKS];
+	struct rcu_head rcu_head;
+};
+
+struct consumer_metadata_cache {
+	/*
+	 * Current contents of the cache (RCU). Replaced, rather than reset, when
+	 * the metadata version changes so that concurrent readers never observe
+	 * partially overwritten contents.
 	 */
-	struct lttng_dynamic_buffer contents;
+	struct consumer_metadata_cache_contents *contents;
 	/*
-	 * Lock to update the metadata cache and push into the ring_buffer
-	 * (lttng_ust_ctl_write_metadata_to_channel).
+	 * Lock serializing the writers of the metadata cache. Readers don't
+	 * need to acquire it.
 	 *
 	 * This is nested INSIDE the consumer_data lock.
 	 */
@@ -59,4 +90,31 @@ void consumer_metadata_cache_destroy(struct lttng_consumer_channel *channel);
 int consumer_metadata_cache_flushed(struct lttng_consumer_channel *channel,
 		uint64_t offset, int timer);
 
+/*
+ * Get the current contents of the cache. The RCU read-side lock must be held
+ * for as long as the contents are used.
+ */
+const struct consumer_metadata_cache_contents *
+consumer_metadata_cache_get_contents(struct consumer_metadata_cache *cache);
+
+/*
+ * Get the number of bytes of `contents` that can be read.
+ */
+uint64_t consumer_metadata_cache_contents_get_size(
+		const struct consumer_metadata_cache_contents *contents);
+
+/*
+ * Get a view of the contiguous bytes available from `offset`. The view ends
+ * at `size` (as returned by consumer_metadata_cache_contents_get_size()) or
+ * at the end of the chunk containing `offset`, whichever comes first.
+ */
+struct lttng_buffer_view consumer_metadata_cache_contents_get_view(
+		const struct consumer_metadata_cache_contents *contents,
+		uint64_t offset, uint64_t size);
+
+/*
+ * Get the number of bytes available in the current contents of the cache.
+ */
+uint64_t consumer_metadata_cache_get_size(struct consumer_metadata_cache *cache);
+
 #endif /* CONSUMER_METADATA_CACHE_H */
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <algorithm>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/common.hpp>
+#include <common/macros.hpp>
+
+#include "consumer-numa.hpp"
+
+#ifdef __linux__
+
+#define NUMA_SYSFS_NODE_PATH	"/sys/devices/system/node"
+
+namespace {
+struct numa_node {
+	/* System id of the node. */
+	unsigned long id;
+	/* CPUs of the node on which the consumer daemon may run. */
+	cpu_set_t cpus;
+};
+} /* namespace */
+
+static struct numa_node *nodes;
+static unsigned int node_count;
+
+/*
+ * Parse a sysfs CPU list (e.g. "0-3,8,10-11") into a CPU set. CPUs which
+ * don't fit in a cpu_set_t are ignored.
+ *
+ * Returns 0 on success, -1 if the list is malformed.
+ */
+static int parse_cpu_list(const char *list, cpu_set_t *cpus)
+{
+	const char *p = list;
+
+	CPU_ZERO(cpus);
+	while (*p != '\0' && *p != '\n') {
+		char *end;
+		unsigned long first, last, cpu;
+
+		errno = 0;
+		first = strtoul(p, &end, 10);
+		if (errno || end == p) {
+			return -1;
+		}
+
+		last = first;
+		p = end;
+		if (*p == '-') {
+			p++;
+			last = strtoul(p, &end, 10);
+			if (errno || end == p || last < first) {
+				return -1;
+			}
+			p = end;
+		}
+
+		for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, cpus);
+		}
+
+		if (*p == ',') {
+			p++;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Read the CPUs of a node, restricted to the CPUs in `allowed`.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int read_node_cpus(unsigned long id, const cpu_set_t *allowed,
+		cpu_set_t *cpus)
+{
+	int ret;
+	char path[PATH_MAX];
+	char list[4096];
+	FILE *file;
+
+	ret = snprintf(path, sizeof(path), NUMA_SYSFS_NODE_PATH "/node%lu/cpulist",
+			id);
+	if (ret < 0 || (size_t) ret >= sizeof(path)) {
+		return -1;
+	}
+
+	file = fopen(path, "r");
+	if (!file) {
+		PERROR("Failed to open %s", path);
+		return -1;
+	}
+
+	if (!fgets(list, sizeof(list), file)) {
+		ERR("Failed to read the CPU list of NUMA node %lu", id);
+		ret = -1;
+		goto end;
+	}
+
+	ret = parse_cpu_list(list, cpus);
+	if (ret) {
+		ERR("Invalid CPU list of NUMA node %lu: %s", id, list);
+		goto end;
+	}
+
+	CPU_AND(cpus, cpus, allowed);
+end:
+	if (fclose(file)) {
+		PERROR("fclose");
+	}
+	return ret;
+}
+
+static int compare_node_id(const void *a, const void *b)
+{
+	const struct numa_node *node_a = (const struct numa_node *) a;
+	const struct numa_node *node_b = (const struct numa_node *) b;
+
+	if (node_a->id == node_b->id) {
+		return 0;
+	}
+	return node_a->id < node_b->id ? -1 : 1;
+}
+
+int consumer_numa_init(void)
+{
+	int ret = 0;
+	DIR *dir;
+	struct dirent *entry;
+	cpu_set_t allowed;
+
+	if (sched_getaffinity(0, sizeof(allowed), &allowed)) {
+		PERROR("sched_getaffinity");
+		return -1;
+	}
+
+	dir = opendir(NUMA_SYSFS_NODE_PATH);
+	if (!dir) {
+		DBG("No NUMA topology information available, assuming a single node");
+		return 0;
+	}
+
+	while ((entry = readdir(dir))) {
+		char *end;
+		unsigned long id;
+		struct numa_node node;
+		struct numa_node *new_nodes;
+
+		if (strncmp(entry->d_name, "node", 4) != 0) {
+			continue;
+		}
+
+		errno = 0;
+		id = strtoul(entry->d_name + 4, &end, 10);
+		if (errno || end == entry->d_name + 4 || *end != '\0') {
+			continue;
+		}
+
+		node.id = id;
+		ret = read_node_cpus(id, &allowed, &node.cpus);
+		if (ret) {
+			goto error;
+		}
+
+		if (CPU_COUNT(&node.cpus) == 0) {
+			/* Memory-only node, or not usable by this process. */
+			continue;
+		}
+
+		new_nodes = (struct numa_node *) realloc(nodes,
+				(node_count + 1) * sizeof(*nodes));
+		if (!new_nodes) {
+			PERROR("Failed to allocate NUMA node");
+			ret = -1;
+			goto error;
+		}
+		nodes = new_nodes;
+		nodes[node_count++] = node;
+	}
+
+	qsort(nodes, node_count, sizeof(*nodes), compare_node_id);
+	DBG("Found %u usable NUMA node(s)", node_count);
+	goto end;
+
+error:
+	consumer_numa_fini();
+end:
+	if (closedir(dir)) {
+		PERROR("closedir");
+	}
+	return ret;
+}
+
+void consumer_numa_fini(void)
+{
+	free(nodes);
+	nodes = NULL;
+	node_count = 0;
+}
+
+unsigned int consumer_numa_get_node_count(void)
+{
+	return std::max(node_count, 1U);
+}
+
+int consumer_numa_get_node_of_cpu(int cpu)
+{
+	unsigned int i;
+
+	if (cpu < 0 || cpu >= CPU_SETSIZE) {
+		return -1;
+	}
+
+	for (i = 0; i < node_count; i++) {
+		if (CPU_ISSET(cpu, &nodes[i].cpus)) {
+			return (int) i;
+		}
+	}
+
+	return -1;
+}
+
+int consumer_numa_bind_current_thread(unsigned int node)
+{
+	int ret;
+
+	if (node >= node_count) {
+		return -1;
+	}
+
+	ret = pthread_setaffinity_np(pthread_self(), sizeof(nodes[node].cpus),
+			&nodes[node].cpus);
+	if (ret) {
+		errno = ret;
+		PERROR("Failed to bind thread to the CPUs of NUMA node %lu",
+				nodes[node].id);
+		return -1;
+	}
+
+	DBG("Thread bound to the CPUs of NUMA node %lu", nodes[node].id);
+	return 0;
+}
+
+#else /* __linux__ */
+
+int consumer_numa_init(void)
+{
+	return 0;
+}
+
+void consumer_numa_fini(void)
+{
+}
+
+unsigned int consumer_numa_get_node_count(void)
+{
+	return 1;
+}
+
+int consumer_numa_get_node_of_cpu(int cpu __attribute__((unused)))
+{
+	return -1;
+}
+
+int consumer_numa_bind_current_thread(
+		unsigned int node __attribute__((unused)))
+{
+	return -1;
+}
+
+#endif /* __linux__ */
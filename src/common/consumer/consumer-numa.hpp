@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef CONSUMER_NUMA_H
+#define CONSUMER_NUMA_H
+
+/*
+ * NUMA topology of the host, as seen by the consumer daemon.
+ *
+ * Only the NUMA nodes having at least one CPU on which the consumer daemon is
+ * allowed to run are considered. They are numbered from 0 to
+ * consumer_numa_get_node_count() - 1, in the order of their system node id.
+ */
+
+/*
+ * Discover the NUMA nodes of the host from sysfs.
+ *
+ * Not finding any topology information is not an error: the host is then
+ * considered to have a single node.
+ *
+ * Returns 0 on success, a negative value on error.
+ */
+int consumer_numa_init(void);
+
+/*
+ * Release the topology information.
+ */
+void consumer_numa_fini(void);
+
+/*
+ * Number of NUMA nodes; always at least 1.
+ */
+unsigned int consumer_numa_get_node_count(void);
+
+/*
+ * Get the NUMA node of a CPU.
+ *
+ * Returns the node's index, or -1 if it is unknown.
+ */
+int consumer_numa_get_node_of_cpu(int cpu);
+
+/*
+ * Bind the calling thread to the CPUs of a NUMA node.
+ *
+ * Memory first touched by the thread afterwards is then allocated on that
+ * node by the kernel's default memory policy.
+ *
+ * Returns 0 on success, a negative value on error.
+ */
+int consumer_numa_bind_current_thread(unsigned int node);
+
+#endif /* CONSUMER_NUMA_H */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <algorithm>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include <urcu.h>
+#include <urcu/uatomic.h>
+
+#include <bin/lttng-consumerd/health-consumerd.hpp>
+#include <common/common.hpp>
+#include <common/defaults.hpp>
+#include <common/macros.hpp>
+
+#include "consumer-snapshot.hpp"
+
+namespace {
+struct snapshot_work {
+	struct consumer_snapshot_stream *snapshot_streams;
+	size_t count;
+	consumer_snapshot_record_stream_cb record;
+	/* Index of the next stream to record. */
+	unsigned long next;
+};
+} /* namespace */
+
+static void record_streams(struct snapshot_work *work)
+{
+	while (true) {
+		const unsigned long i = uatomic_add_return(&work->next, 1) - 1;
+
+		if (i >= work->count) {
+			break;
+		}
+
+		work->snapshot_streams[i].ret =
+				work->record(&work->snapshot_streams[i]);
+	}
+}
+
+static void *snapshot_worker(void *data)
+{
+	rcu_register_thread();
+	record_streams((struct snapshot_work *) data);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+unsigned long consumer_snapshot_get_start_pos(
+		const struct lttng_consumer_stream *stream,
+		unsigned long consumed_pos, unsigned long produced_pos,
+		uint64_t nb_packets_per_stream, bool incremental)
+{
+	unsigned long last_pos;
+	unsigned long start_pos = consumer_get_consume_start_pos(consumed_pos,
+			produced_pos, nb_packets_per_stream,
+			stream->max_sb_size);
+
+	if (!incremental || !stream->last_snapshot_produced_pos.is_set) {
+		goto end;
+	}
+
+	/*
+	 * Start after the previous snapshot unless the sub-buffers it left off
+	 * at were overwritten since.
+	 */
+	last_pos = stream->last_snapshot_produced_pos.value;
+	if ((long) (last_pos - start_pos) > 0 &&
+			(long) (produced_pos - last_pos) >= 0) {
+		DBG("Incremental snapshot of stream %" PRIu64 " skips %lu bytes",
+				stream->key, last_pos - start_pos);
+		start_pos = last_pos;
+	}
+end:
+	return start_pos;
+}
+
+int consumer_snapshot_record_streams(
+		struct consumer_snapshot_stream *snapshot_streams, size_t count,
+		consumer_snapshot_record_stream_cb record)
+{
+	int ret = 0;
+	size_t i;
+	unsigned int worker_count, started = 0;
+	pthread_t *workers = NULL;
+	struct snapshot_work work = {
+		.snapshot_streams = snapshot_streams,
+		.count = count,
+		.record = record,
+		.next = 0,
+	};
+
+	worker_count = std::min<size_t>(
+			consumer_get_snapshot_worker_count(), count);
+	for (i = 0; i < count; i++) {
+		if (snapshot_streams[i].relayd_id != (uint64_t) -1ULL) {
+			worker_count = 1;
+			break;
+		}
+	}
+
+	/* The calling thread is one of the workers. */
+	if (worker_count > 1) {
+		workers = calloc<pthread_t>(worker_count - 1);
+		if (!workers) {
+			PERROR("Failed to allocate snapshot workers");
+		}
+	}
+
+	for (; workers && started < worker_count - 1; started++) {
+		const int create_ret = pthread_create(&workers[started],
+				default_pthread_attr(), snapshot_worker, &work);
+
+		if (create_ret) {
+			errno = create_ret;
+			PERROR("Failed to create snapshot worker thread");
+			break;
+		}
+	}
+
+	DBG("Recording snapshot of %zu streams with %u workers", count,
+			started + 1);
+	record_streams(&work);
+
+	health_poll_entry();
+	for (i = 0; i < started; i++) {
+		const int join_ret = pthread_join(workers[i], NULL);
+
+		if (join_ret) {
+			errno = join_ret;
+			PERROR("Failed to join snapshot worker thread");
+		}
+	}
+	health_poll_exit();
+
+	for (i = 0; i < count; i++) {
+		struct lttng_consumer_stream *stream =
+				snapshot_streams[i].stream;
+
+		stream->chan->lost_packets += snapshot_streams[i].lost_packets;
+		if (snapshot_streams[i].ret) {
+			if (!ret) {
+				ret = snapshot_streams[i].ret;
+			}
+			continue;
+		}
+
+		pthread_mutex_lock(&stream->lock);
+		LTTNG_OPTIONAL_SET(&stream->last_snapshot_produced_pos,
+				snapshot_streams[i].produced_pos);
+		pthread_mutex_unlock(&stream->lock);
+	}
+
+	free(workers);
+	return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef CONSUMER_SNAPSHOT_H
+#define CONSUMER_SNAPSHOT_H
+
+#include <common/consumer/consumer.hpp>
+
+/*
+ * Sub-buffers of a stream to record in a snapshot.
+ *
+ * The positions of all the streams of a channel are sampled before any of
+ * them is recorded so that the snapshot is consistent.
+ */
+struct consumer_snapshot_stream {
+	struct lttng_consumer_stream *stream;
+	/* Output of the snapshot. */
+	char *path;
+	uint64_t relayd_id;
+	/* Sampled positions; the range to record is [consumed, produced). */
+	unsigned long consumed_pos;
+	unsigned long produced_pos;
+	/* Sub-buffers which could not be recorded. */
+	uint64_t lost_packets;
+	int ret;
+};
+
+/*
+ * Record the sampled sub-buffers of a stream to its output. Acquires the
+ * stream lock; may run concurrently with the recording of the channel's other
+ * streams.
+ */
+typedef int (*consumer_snapshot_record_stream_cb)(
+		struct consumer_snapshot_stream *snapshot_stream);
+
+/*
+ * Get the position from which a stream is recorded by a snapshot, given its
+ * sampled positions.
+ *
+ * An incremental snapshot skips the sub-buffers which the stream's previous
+ * snapshot recorded, if they are still in the buffer.
+ */
+unsigned long consumer_snapshot_get_start_pos(
+		const struct lttng_consumer_stream *stream,
+		unsigned long consumed_pos, unsigned long produced_pos,
+		uint64_t nb_packets_per_stream, bool incremental);
+
+/*
+ * Record the snapshot of the streams of a channel using the consumer's
+ * snapshot worker pool (see LTTNG_CONSUMERD_SNAPSHOT_WORKERS). The streams
+ * sent to a relay daemon are recorded one at a time since they share the
+ * relay daemon's data socket.
+ *
+ * The lost packets of the streams are accounted to their channel, and the
+ * produced position of each successfully recorded stream is kept for the next
+ * incremental snapshot.
+ *
+ * Returns 0 on success, or the first error reported by `record`.
+ */
+int consumer_snapshot_record_streams(
+		struct consumer_snapshot_stream *snapshot_streams, size_t count,
+		consumer_snapshot_record_stream_cb record);
+
+#endif /* CONSUMER_SNAPSHOT_H */
@@ -20,6 +20,7 @@
 #include <common/consumer/metadata-bucket.hpp>
 #include <common/consumer/metadata-bucket.hpp>
 #include <common/index/index.hpp>
+#include <common/index/packet-header.hpp>
 #include <common/kernel-consumer/kernel-consumer.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
 #include <common/macros.hpp>
@@ -228,6 +229,170 @@ static ssize_t consumer_stream_consume_splice(
 	return written_bytes;
 }
 
+/*
+ * Consume a sub-buffer mapped in memory (UST) of a channel using the splice
+ * output.
+ *
+ * Sub-buffers that are streamed to a relay daemon go through the mmap path:
+ * pages spliced to a socket may still be referenced by the network stack
+ * after the sub-buffer is handed back to the tracer.
+ */
+static ssize_t consumer_stream_consume_vmsplice(
+		struct lttng_consumer_local_data *ctx,
+		struct lttng_consumer_stream *stream,
+		const struct stream_subbuffer *subbuffer)
+{
+	ssize_t written_bytes;
+
+	if (stream->net_seq_idx != -1ULL) {
+		return consumer_stream_consume_mmap(ctx, stream, subbuffer);
+	}
+
+	written_bytes = lttng_consumer_on_read_subbuffer_vmsplice(
+			ctx, stream, &subbuffer->buffer.buffer);
+	if (written_bytes != subbuffer->info.data.padded_subbuf_size) {
+		DBG("Failed to write the entire padded subbuffer (written_bytes: %zd, padded subbuffer size %lu)",
+				written_bytes,
+				subbuffer->info.data.padded_subbuf_size);
+	}
+
+	if (written_bytes < 0) {
+		ERR("Error reading vmsplice subbuffer: %zd", written_bytes);
+	}
+
+	return written_bytes;
+}
+
+/*
+ * Consume a mapped sub-buffer of a compressed channel.
+ *
+ * Each packet (padding included) is compressed independently and written
+ * as-is to the local trace file; its index entry records the compressed
+ * size (see consumer_stream_send_index()). Sub-buffers streamed to a relay
+ * daemon are sent uncompressed.
+ */
+static ssize_t consumer_stream_consume_compressed(
+		struct lttng_consumer_local_data *ctx,
+		struct lttng_consumer_stream *stream,
+		const struct stream_subbuffer *subbuffer)
+{
+	int ret;
+	ssize_t written_bytes;
+	struct lttng_buffer_view compressed;
+
+	if (stream->net_seq_idx != -1ULL) {
+		return consumer_stream_consume_mmap(ctx, stream, subbuffer);
+	}
+
+	if (!stream->compressor) {
+		stream->compressor = lttng_packet_compressor_create(
+				stream->chan->compression);
+		if (!stream->compressor) {
+			ERR("Failed to create packet compressor of stream %" PRIu64,
+					stream->key);
+			return -1;
+		}
+	}
+
+	ret = lttng_packet_compress(stream->compressor,
+			&subbuffer->buffer.buffer, &compressed);
+	if (ret) {
+		ERR("Failed to compress packet of stream %" PRIu64,
+				stream->key);
+		return -1;
+	}
+
+	written_bytes = lttng_consumer_on_read_subbuffer_mmap(
+			stream, &compressed, 0);
+	if (written_bytes < 0) {
+		ERR("Error writing compressed subbuffer: %zd", written_bytes);
+		return written_bytes;
+	}
+
+	if (written_bytes != compressed.size) {
+		DBG("Failed to write the entire compressed subbuffer (written_bytes: %zd, compressed size %zu)",
+				written_bytes, compressed.size);
+	}
+
+	stream->compressed_packet_size = compressed.size;
+	return written_bytes;
+}
+
+/*
+ * Suppress the data packets which contain no event record, typically produced
+ * by the switch and live timers flushing idle streams.
+ *
+ * A packet is empty when its content ends with its packet context (see
+ * struct lttng_packet_header). The content and packet sizes read from the
+ * header must match the ones reported by the tracer; otherwise, the layout is
+ * not the expected one and the packet is consumed. A 32-bit kernel consumer
+ * daemon tracing a 64-bit kernel expects a smaller packet context than the
+ * tracer's and never finds an empty packet.
+ *
+ * The first packet of a stream in a trace chunk is never suppressed, and the
+ * last suppressed packet is written out, trimmed to its packet header and
+ * context, when the stream's output is closed or rotated unless a packet was
+ * written out after it. Hence, the stream's output still spans the time range
+ * during which it was recorded.
+ */
+static int consumer_stream_suppress_empty_packet(
+		struct lttng_consumer_stream *stream,
+		const struct stream_subbuffer *subbuffer)
+{
+	int ret = 0;
+	struct lttng_packet_header header;
+	struct stream_subbuffer *pending = &stream->empty_packets.pending;
+
+	stream->empty_packets.suppressing = false;
+	if (lttng_packet_header_read(&subbuffer->buffer.buffer, &header) ||
+			header.ctx.content_size != subbuffer->info.data.content_size ||
+			header.ctx.packet_size != subbuffer->info.data.packet_size) {
+		DBG("Unexpected packet header layout, consuming packet: stream key = %" PRIu64,
+				stream->key);
+		goto consume;
+	}
+
+	if (!lttng_packet_header_is_empty(&header)) {
+		goto consume;
+	}
+
+	if (!stream->empty_packets.wrote_packet_in_current_trace_chunk) {
+		/* Keep the beginning of the stream. */
+		goto consume;
+	}
+
+	ret = lttng_packet_header_trim(&subbuffer->buffer.buffer,
+			&stream->empty_packets.content);
+	if (ret) {
+		ERR("Failed to copy the empty packet of stream %" PRIu64,
+				stream->key);
+		goto end;
+	}
+
+	*pending = *subbuffer;
+	pending->buffer.buffer = {};
+	pending->info.data.subbuf_size = stream->empty_packets.content.size;
+	pending->info.data.padded_subbuf_size =
+			stream->empty_packets.content.size;
+	pending->info.data.packet_size =
+			(uint64_t) stream->empty_packets.content.size * CHAR_BIT;
+	stream->empty_packets.has_pending = true;
+	stream->empty_packets.suppressing = true;
+	DBG3("Suppressed empty packet of stream %" PRIu64 ", packet_seq_num = %" PRIu64,
+			stream->key,
+			subbuffer->info.data.sequence_number.is_set ?
+					subbuffer->info.data.sequence_number.value :
+					-1ULL);
+	ret = 1;
+	goto end;
+
+consume:
+	stream->empty_packets.has_pending = false;
+	stream->empty_packets.wrote_packet_in_current_trace_chunk = true;
+end:
+	return ret;
+}
+
 static int consumer_stream_send_index(
 		struct lttng_consumer_stream *stream,
 		const struct stream_subbuffer *subbuffer,
@@ -235,17 +400,41 @@ static int consumer_stream_send_index(
 {
 	off_t packet_offset = 0;
 	struct ctf_packet_index index = {};
+	const bool compressed = stream->net_seq_idx == (uint64_t) -1ULL &&
+			stream->chan->compression != LTTNG_CHANNEL_COMPRESSION_NONE;
+
+	if (stream->empty_packets.suppressing) {
+		if (stream->net_seq_idx == (uint64_t) -1ULL ||
+				!stream->chan->is_live) {
+			return 0;
+		}
+
+		/*
+		 * Send a beacon in place of the index to let live viewers
+		 * know that the stream is inactive up to the packet's end.
+		 */
+		index.stream_id = htobe64(subbuffer->info.data.stream_id);
+		index.timestamp_end = htobe64(subbuffer->info.data.timestamp_end);
+		return consumer_stream_write_index(stream, &index);
+	}
 
 	/*
 	 * This is called after consuming the sub-buffer; substract the
 	 * effect this sub-buffer from the offset.
 	 */
-	if (stream->net_seq_idx == (uint64_t) -1ULL) {
+	if (compressed) {
+		packet_offset = stream->out_fd_offset -
+				stream->compressed_packet_size;
+	} else if (stream->net_seq_idx == (uint64_t) -1ULL) {
 		packet_offset = stream->out_fd_offset -
 				subbuffer->info.data.padded_subbuf_size;
 	}
 
 	ctf_packet_index_populate(&index, packet_offset, subbuffer);
+	if (compressed) {
+		index.compressed_size = htobe64(stream->compressed_packet_size);
+	}
+
 	return consumer_stream_write_index(stream, &index);
 }
 
@@ -680,6 +869,7 @@ struct lttng_consumer_stream *consumer_stream_create(
 	stream->session_id = session_id;
 	stream->monitor = monitor;
 	stream->endpoint_status = CONSUMER_ENDPOINT_ACTIVE;
+	stream->cpu = cpu;
 	stream->index_file = NULL;
 	stream->last_sequence_number = -1ULL;
 	stream->rotate_position = -1ULL;
@@ -779,14 +969,34 @@ struct lttng_consumer_stream *consumer_stream_create(
 				consumer_stream_data_assert_locked_all;
 		stream->read_subbuffer_ops.pre_consume_subbuffer =
 				consumer_stream_update_stats;
+
+		/*
+		 * The header of the last suppressed packet is copied from the
+		 * mapped sub-buffer; spliced kernel sub-buffers are not mapped.
+		 */
+		if (channel->suppress_empty_packets &&
+				(channel->output == CONSUMER_CHANNEL_MMAP ||
+						the_consumer_data.type != LTTNG_CONSUMER_KERNEL)) {
+			stream->read_subbuffer_ops.suppress_subbuffer =
+					consumer_stream_suppress_empty_packet;
+		}
 	}
 
-	if (channel->output == CONSUMER_CHANNEL_MMAP) {
+	if (channel->output == CONSUMER_CHANNEL_MMAP &&
+			channel->compression != LTTNG_CHANNEL_COMPRESSION_NONE &&
+			!stream->metadata_flag) {
+		stream->read_subbuffer_ops.consume_subbuffer =
+				consumer_stream_consume_compressed;
+	} else if (channel->output == CONSUMER_CHANNEL_MMAP) {
 		stream->read_subbuffer_ops.consume_subbuffer =
 				consumer_stream_consume_mmap;
-	} else {
+	} else if (the_consumer_data.type == LTTNG_CONSUMER_KERNEL) {
 		stream->read_subbuffer_ops.consume_subbuffer =
 				consumer_stream_consume_splice;
+	} else {
+		/* UST buffers are always mapped; vmsplice them. */
+		stream->read_subbuffer_ops.consume_subbuffer =
+				consumer_stream_consume_vmsplice;
 	}
 
 	return stream;
@@ -824,11 +1034,11 @@ void consumer_stream_relayd_close(struct lttng_consumer_stream *stream,
 	}
 
 	/* Closing streams requires to lock the control socket. */
-	pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+	consumer_relayd_ctrl_lock(relayd);
 	ret = relayd_send_close_stream(&relayd->control_sock,
 			stream->relayd_stream_id,
 			stream->next_net_seq_num - 1);
-	pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+	consumer_relayd_ctrl_unlock(relayd);
 	if (ret < 0) {
 		ERR("Relayd send close stream failed. Cleaning up relayd %" PRIu64 ".", relayd->net_seq_idx);
 		lttng_consumer_cleanup_relayd(relayd);
@@ -847,7 +1057,6 @@ void consumer_stream_relayd_close(struct lttng_consumer_stream *stream,
  * Close stream's file descriptors and, if needed, close stream also on the
  * relayd side.
  *
- * The consumer data lock MUST be acquired.
  * The stream lock MUST be acquired.
  */
 void consumer_stream_close_output(struct lttng_consumer_stream *stream)
@@ -856,6 +1065,11 @@ void consumer_stream_close_output(struct lttng_consumer_stream *stream)
 
 	LTTNG_ASSERT(stream);
 
+	if (consumer_stream_write_suppressed_packet(stream)) {
+		ERR("Failed to write the last suppressed packet of stream %" PRIu64,
+				stream->key);
+	}
+
 	/* Close output fd. Could be a socket or local file at this point. */
 	if (stream->out_fd >= 0) {
 		const auto ret = close(stream->out_fd);
@@ -888,7 +1102,7 @@ void consumer_stream_close_output(struct lttng_consumer_stream *stream)
 /*
  * Delete the stream from all possible hash tables.
  *
- * The consumer data lock MUST be acquired.
+ * The channel lock MUST be acquired.
  * The stream lock MUST be acquired.
  */
 void consumer_stream_delete(struct lttng_consumer_stream *stream,
@@ -904,9 +1118,25 @@ void consumer_stream_delete(struct lttng_consumer_stream *stream,
 	rcu_read_lock();
 
 	if (ht) {
+		/*
+		 * A data stream is removed under the lock of its data thread,
+		 * along with the thread's stream count.
+		 */
+		if (!stream->metadata_flag) {
+			LTTNG_ASSERT(stream->data_thread);
+			pthread_mutex_lock(&stream->data_thread->lock);
+		}
+
 		iter.iter.node = &stream->node.node;
 		ret = lttng_ht_del(ht, &iter);
 		LTTNG_ASSERT(!ret);
+
+		if (!stream->metadata_flag) {
+			LTTNG_ASSERT(stream->data_thread->stream_count > 0);
+			stream->data_thread->stream_count--;
+			stream->data_thread->streams_generation++;
+			pthread_mutex_unlock(&stream->data_thread->lock);
+		}
 	}
 
 	/* Delete from stream per channel ID hash table. */
@@ -925,12 +1155,6 @@ void consumer_stream_delete(struct lttng_consumer_stream *stream,
 	(void) lttng_ht_del(the_consumer_data.stream_list_ht, &iter);
 
 	rcu_read_unlock();
-
-	if (!stream->metadata_flag) {
-		/* Decrement the stream count of the global consumer data. */
-		LTTNG_ASSERT(the_consumer_data.stream_count > 0);
-		the_consumer_data.stream_count--;
-	}
 }
 
 /*
@@ -941,6 +1165,9 @@ void consumer_stream_free(struct lttng_consumer_stream *stream)
 	LTTNG_ASSERT(stream);
 
 	metadata_bucket_destroy(stream->metadata_bucket);
+	lttng_packet_compressor_destroy(stream->compressor);
+	stream->compressor = NULL;
+	lttng_dynamic_buffer_reset(&stream->empty_packets.content);
 	call_rcu(&stream->node.head, free_stream_rcu);
 }
 
@@ -1001,6 +1228,10 @@ void consumer_stream_destroy_buffers(struct lttng_consumer_stream *stream)
 			}
 		}
 
+		if (stream->chan->output == CONSUMER_CHANNEL_SPLICE) {
+			utils_close_pipe(stream->splice_pipe);
+		}
+
 		lttng_ustconsumer_del_stream(stream);
 		break;
 	default:
@@ -1050,8 +1281,8 @@ static struct lttng_consumer_channel *unref_channel(
  * Once return, the stream is NO longer usable. Its channel may get destroyed
  * if conditions are met for a monitored stream.
  *
- * This MUST be called WITHOUT the consumer data and stream lock acquired if
- * the stream is in _monitor_ mode else it does not matter.
+ * This MUST be called WITHOUT the channel and stream lock acquired if the
+ * stream is in _monitor_ mode else it does not matter.
  */
 void consumer_stream_destroy(struct lttng_consumer_stream *stream,
 		struct lttng_ht *ht)
@@ -1070,7 +1301,6 @@ void consumer_stream_destroy(struct lttng_consumer_stream *stream,
 		 * stream thus being globally visible.
 		 */
 		if (stream->globally_visible) {
-			pthread_mutex_lock(&the_consumer_data.lock);
 			pthread_mutex_lock(&stream->chan->lock);
 
 			pthread_mutex_lock(&stream->lock);
@@ -1083,16 +1313,12 @@ void consumer_stream_destroy(struct lttng_consumer_stream *stream,
 			/* Update channel's refcount of the stream. */
 			free_chan = unref_channel(stream);
 
-			/* Indicates that the consumer data state MUST be updated after this. */
-			the_consumer_data.need_update = 1;
-
 			pthread_mutex_unlock(&stream->lock);
 			pthread_mutex_unlock(&stream->chan->lock);
-			pthread_mutex_unlock(&the_consumer_data.lock);
 		} else {
 			/*
 			 * If the stream is not visible globally, this needs to be done
-			 * outside of the consumer data lock section.
+			 * outside of the channel lock section.
 			 */
 			destroy_close_stream(stream);
 			free_chan = unref_channel(stream);
@@ -1112,6 +1338,41 @@ void consumer_stream_destroy(struct lttng_consumer_stream *stream,
 	consumer_stream_free(stream);
 }
 
+int consumer_stream_write_suppressed_packet(
+		struct lttng_consumer_stream *stream)
+{
+	int ret = 0;
+	ssize_t written_bytes;
+	struct stream_subbuffer subbuffer;
+
+	if (!stream->empty_packets.has_pending) {
+		goto end;
+	}
+
+	stream->empty_packets.has_pending = false;
+	stream->empty_packets.suppressing = false;
+	if (stream->out_fd < 0 && stream->net_seq_idx == (uint64_t) -1ULL) {
+		/* The stream has no output. */
+		goto end;
+	}
+
+	subbuffer = stream->empty_packets.pending;
+	subbuffer.buffer.buffer = lttng_buffer_view_from_dynamic_buffer(
+			&stream->empty_packets.content, 0, -1);
+	written_bytes = stream->read_subbuffer_ops.consume_subbuffer(
+			NULL, stream, &subbuffer);
+	if (written_bytes <= 0) {
+		ret = -1;
+		goto end;
+	}
+
+	DBG("Wrote the last suppressed packet of stream %" PRIu64,
+			stream->key);
+	ret = consumer_stream_send_index(stream, &subbuffer, NULL);
+end:
+	return ret;
+}
+
 /*
  * Write index of a specific stream either on the relayd or local disk.
  *
@@ -1130,19 +1391,13 @@ int consumer_stream_write_index(struct lttng_consumer_stream *stream,
 		struct consumer_relayd_sock_pair *relayd;
 		relayd = consumer_find_relayd(stream->net_seq_idx);
 		if (relayd) {
-			pthread_mutex_lock(&relayd->ctrl_sock_mutex);
-			ret = relayd_send_index(&relayd->control_sock, element,
+			/*
+			 * Don't wait for the control socket, which may be busy
+			 * sending metadata or a command; a send failure
+			 * cleans up the relayd.
+			 */
+			ret = consumer_relayd_queue_index(relayd, element,
 				stream->relayd_stream_id, stream->next_net_seq_num - 1);
-			if (ret < 0) {
-				/*
-				 * Communication error with lttng-relayd,
-				 * perform cleanup now
-				 */
-				ERR("Relayd send index failed. Cleaning up relayd %" PRIu64 ".", relayd->net_seq_idx);
-				lttng_consumer_cleanup_relayd(relayd);
-				ret = -1;
-			}
-			pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
 		} else {
 			ERR("Stream %" PRIu64 " relayd ID %" PRIu64 " unknown. Can't write index.",
 					stream->key, stream->net_seq_idx);
@@ -1213,7 +1468,11 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream,
 				stream->name,
 				stream->chan->tracefile_size,
 				stream->tracefile_count_current,
-				CTF_INDEX_MAJOR, CTF_INDEX_MINOR,
+				CTF_INDEX_MAJOR,
+				stream->chan->compression !=
+						LTTNG_CHANNEL_COMPRESSION_NONE ?
+						CTF_INDEX_COMPRESSED_MINOR :
+						CTF_INDEX_MINOR,
 				false, &stream->index_file);
 		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
 			ret = -1;
@@ -39,7 +39,6 @@ struct lttng_consumer_stream *consumer_stream_create(
  * relayd side.
  *
  * The stream lock MUST be acquired.
- * The consumer data lock MUST be acquired.
  */
 void consumer_stream_close_output(struct lttng_consumer_stream *stream);
 
@@ -56,7 +55,8 @@ void consumer_stream_relayd_close(struct lttng_consumer_stream *stream,
 /*
  * Delete the stream from all possible hash tables.
  *
- * The consumer data lock MUST be acquired.
+ * The channel lock MUST be acquired.
+ * The stream lock MUST be acquired.
  */
 void consumer_stream_delete(struct lttng_consumer_stream *stream,
 		struct lttng_ht *ht);
@@ -82,6 +82,16 @@ void consumer_stream_destroy(struct lttng_consumer_stream *stream,
  */
 void consumer_stream_destroy_buffers(struct lttng_consumer_stream *stream);
 
+/*
+ * Write out the last suppressed empty packet of a data stream, if no packet
+ * was written out after it, so that the stream's output ends on its last
+ * packet. Called before the stream's output is closed or rotated.
+ *
+ * The stream lock MUST be acquired.
+ */
+int consumer_stream_write_suppressed_packet(
+		struct lttng_consumer_stream *stream);
+
 /*
  * Write index of a specific stream either on the relayd or local disk.
  */
@@ -7,19 +7,30 @@
  */
 
 #define _LGPL_SOURCE
+#include <algorithm>
 #include <inttypes.h>
-#include <signal.h>
+#include <sys/timerfd.h>
 
 #include <bin/lttng-consumerd/health-consumerd.hpp>
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/compat/poll.hpp>
+#include <common/compat/time.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
 #include <common/kernel-consumer/kernel-consumer.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/consumer/consumer-testpoint.hpp>
+#include <common/pipe.hpp>
+#include <common/readwrite.hpp>
+#include <common/relayd/relayd.hpp>
+#include <common/time.hpp>
+#include <common/timer-wheel.hpp>
 #include <common/ust-consumer/ust-consumer.hpp>
 
+/* Granularity of the channel timers. */
+#define CONSUMER_TIMER_TICK_NS	NSEC_PER_MSEC
+
 typedef int (*sample_positions_cb)(struct lttng_consumer_stream *stream);
 typedef int (*get_consumed_cb)(struct lttng_consumer_stream *stream,
 		unsigned long *consumed);
@@ -27,47 +38,55 @@ typedef int (*get_produced_cb)(struct lttng_consumer_stream *stream,
 		unsigned long *produced);
 typedef int (*flush_index_cb)(struct lttng_consumer_stream *stream);
 
-static struct timer_signal_data timer_signal = {
-	.tid = 0,
-	.setup_done = 0,
-	.qs_done = 0,
+/*
+ * The timers of all channels are kept in a single timer wheel. The timer
+ * thread waits on a timerfd armed on the wheel's next expiry and invokes the
+ * callbacks of the expired timers, one at a time, without holding the lock.
+ *
+ * A timer being stopped while its callback executes is waited for so that
+ * its channel can be freed as soon as the stop function returns.
+ */
+static struct {
+	/* Protects all the fields below. */
+	pthread_mutex_t lock;
+	/* Signaled when the timer thread completes a timer callback. */
+	pthread_cond_t callback_done_cond;
+	struct timer_wheel wheel;
+	/* Timer whose callback is being executed by the timer thread. */
+	struct timer_wheel_entry *running;
+	/* Absolute CLOCK_MONOTONIC time on which timer_fd is armed, 0 if disarmed. */
+	uint64_t armed_expiry_ns;
+	pthread_t tid;
+	int timer_fd;
+	struct lttng_pipe *quit_pipe;
+} timer_state = {
 	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.callback_done_cond = PTHREAD_COND_INITIALIZER,
+	.wheel = {},
+	.running = NULL,
+	.armed_expiry_ns = 0,
+	.tid = 0,
+	.timer_fd = -1,
+	.quit_pipe = NULL,
 };
 
-/*
- * Set custom signal mask to current thread.
- */
-static void setmask(sigset_t *mask)
+static int the_channel_monitor_pipe = -1;
+
+static int get_monotonic_time_ns(uint64_t *now_ns)
 {
 	int ret;
+	struct timespec ts;
 
-	ret = sigemptyset(mask);
-	if (ret) {
-		PERROR("sigemptyset");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_SWITCH);
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &ts);
 	if (ret) {
-		PERROR("sigaddset switch");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_TEARDOWN);
-	if (ret) {
-		PERROR("sigaddset teardown");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_LIVE);
-	if (ret) {
-		PERROR("sigaddset live");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_MONITOR);
-	if (ret) {
-		PERROR("sigaddset monitor");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_EXIT);
-	if (ret) {
-		PERROR("sigaddset exit");
+		PERROR("clock_gettime");
+		goto end;
 	}
-}
 
-static int the_channel_monitor_pipe = -1;
+	*now_ns = (uint64_t) ts.tv_sec * NSEC_PER_SEC + (uint64_t) ts.tv_nsec;
+end:
+	return ret;
+}
 
 /*
  * Execute action on a timer switch.
@@ -77,12 +96,10 @@ static int the_channel_monitor_pipe = -1;
  * deadlocks.
  */
 static void metadata_switch_timer(struct lttng_consumer_local_data *ctx,
-		siginfo_t *si)
+		struct lttng_consumer_channel *channel)
 {
 	int ret;
-	struct lttng_consumer_channel *channel;
 
-	channel = (lttng_consumer_channel *) si->si_value.sival_ptr;
 	LTTNG_ASSERT(channel);
 
 	if (channel->switch_timer_error) {
@@ -102,10 +119,9 @@ static void metadata_switch_timer(struct lttng_consumer_local_data *ctx,
 		 *       - channel->timer_lock
 		 *         - channel->metadata_cache->lock
 		 *
-		 * Ensure that neither consumer_data.lock nor
-		 * channel->lock are taken within this function, since
-		 * they are held while consumer_timer_switch_stop() is
-		 * called.
+		 * Ensure that channel->lock is not taken within this
+		 * function, since it is held while
+		 * consumer_timer_switch_stop() is called.
 		 */
 		ret = lttng_ustconsumer_request_metadata(ctx, channel, 1, 1);
 		if (ret < 0) {
@@ -265,13 +281,71 @@ end:
 }
 
 /*
- * Execute action on a live timer
+ * Check whether a live viewer is attached to the channel's session on the
+ * relay daemon.
+ *
+ * The relay daemon is queried at most once per live timer period for all the
+ * channels of a session since their live timers expire on the same tick. A
+ * viewer is assumed to be attached whenever the status can't be obtained.
+ */
+static bool live_viewer_attached(struct lttng_consumer_channel *channel)
+{
+	int ret;
+	bool viewer_attached = true;
+	uint64_t now_ns;
+	struct consumer_relayd_sock_pair *relayd;
+
+	if (channel->relayd_id == (uint64_t) -1ULL) {
+		goto end;
+	}
+
+	ret = get_monotonic_time_ns(&now_ns);
+	if (ret) {
+		goto end;
+	}
+
+	rcu_read_lock();
+	relayd = consumer_find_relayd(channel->relayd_id);
+	if (!relayd) {
+		goto end_rcu_unlock;
+	}
+
+	consumer_relayd_ctrl_lock(relayd);
+	if (relayd->viewer_status.timestamp_ns == 0 ||
+			now_ns - relayd->viewer_status.timestamp_ns >=
+					(uint64_t) channel->live_timer_interval *
+							NSEC_PER_USEC / 2) {
+		ret = relayd_get_viewer_status(&relayd->control_sock,
+				&relayd->viewer_status.viewer_attached);
+		if (ret < 0) {
+			ERR("Relayd get viewer status failed. Cleaning up relayd %" PRIu64 ".",
+					relayd->net_seq_idx);
+			lttng_consumer_cleanup_relayd(relayd);
+			consumer_relayd_ctrl_unlock(relayd);
+			goto end_rcu_unlock;
+		}
+		relayd->viewer_status.timestamp_ns = now_ns;
+	}
+	viewer_attached = relayd->viewer_status.viewer_attached;
+	consumer_relayd_ctrl_unlock(relayd);
+
+end_rcu_unlock:
+	rcu_read_unlock();
+end:
+	return viewer_attached;
+}
+
+/*
+ * Execute action on a live timer.
+ *
+ * The streams are only flushed while a viewer is attached to the session:
+ * the empty indexes and partial packets are of no use to anyone otherwise.
+ * Flushing resumes on the first tick following the attachment of a viewer.
  */
 static void live_timer(struct lttng_consumer_local_data *ctx,
-		siginfo_t *si)
+		struct lttng_consumer_channel *channel)
 {
 	int ret;
-	struct lttng_consumer_channel *channel;
 	struct lttng_consumer_stream *stream;
 	struct lttng_ht_iter iter;
 	const struct lttng_ht *ht = the_consumer_data.stream_per_chan_id_ht;
@@ -280,13 +354,18 @@ static void live_timer(struct lttng_consumer_local_data *ctx,
 					consumer_flush_kernel_index :
 					consumer_flush_ust_index;
 
-	channel = (lttng_consumer_channel *) si->si_value.sival_ptr;
 	LTTNG_ASSERT(channel);
 
 	if (channel->switch_timer_error) {
 		goto error;
 	}
 
+	if (!live_viewer_attached(channel)) {
+		DBG("Live timer for channel %" PRIu64 ": no viewer attached, skipping flush",
+				channel->key);
+		goto error;
+	}
+
 	DBG("Live timer for channel %" PRIu64, channel->key);
 
 	rcu_read_lock();
@@ -307,72 +386,79 @@ error:
 	return;
 }
 
-static
-void consumer_timer_signal_thread_qs(unsigned int signr)
+static void switch_timer_cb(struct timer_wheel_entry *timer, void *data)
 {
-	sigset_t pending_set;
-	int ret;
+	metadata_switch_timer((lttng_consumer_local_data *) data,
+			lttng::utils::container_of(timer,
+					&lttng_consumer_channel::switch_timer));
+}
 
-	/*
-	 * We need to be the only thread interacting with the thread
-	 * that manages signals for teardown synchronization.
-	 */
-	pthread_mutex_lock(&timer_signal.lock);
+static void live_timer_cb(struct timer_wheel_entry *timer, void *data)
+{
+	live_timer((lttng_consumer_local_data *) data,
+			lttng::utils::container_of(timer,
+					&lttng_consumer_channel::live_timer));
+}
 
-	/* Ensure we don't have any signal queued for this channel. */
-	for (;;) {
-		ret = sigemptyset(&pending_set);
-		if (ret == -1) {
-			PERROR("sigemptyset");
-		}
-		ret = sigpending(&pending_set);
-		if (ret == -1) {
-			PERROR("sigpending");
-		}
-		if (!sigismember(&pending_set, signr)) {
-			break;
-		}
-		caa_cpu_relax();
-	}
+static void monitor_timer_cb(struct timer_wheel_entry *timer,
+		void *data __attribute__((unused)))
+{
+	sample_and_send_channel_buffer_stats(lttng::utils::container_of(timer,
+			&lttng_consumer_channel::monitor_timer));
+}
 
-	/*
-	 * From this point, no new signal handler will be fired that would try to
-	 * access "chan". However, we still need to wait for any currently
-	 * executing handler to complete.
-	 */
-	cmm_smp_mb();
-	CMM_STORE_SHARED(timer_signal.qs_done, 0);
-	cmm_smp_mb();
+/*
+ * Arm the timerfd on the wheel's next expiry, or disarm it if the wheel is
+ * empty.
+ *
+ * Called with the timer state lock held.
+ */
+static int rearm_timer_fd(void)
+{
+	int ret = 0;
+	uint64_t next_expiry_ns = 0;
+	struct itimerspec its = {};
 
-	/*
-	 * Kill with LTTNG_CONSUMER_SIG_TEARDOWN, so signal management thread wakes
-	 * up.
-	 */
-	kill(getpid(), LTTNG_CONSUMER_SIG_TEARDOWN);
+	if (timer_wheel_get_next_expiry(&timer_state.wheel, &next_expiry_ns)) {
+		/* A zero it_value would disarm the timer. */
+		next_expiry_ns = std::max<uint64_t>(next_expiry_ns, 1);
+	}
+
+	if (next_expiry_ns == timer_state.armed_expiry_ns) {
+		goto end;
+	}
 
-	while (!CMM_LOAD_SHARED(timer_signal.qs_done)) {
-		caa_cpu_relax();
+	its.it_value.tv_sec = next_expiry_ns / NSEC_PER_SEC;
+	its.it_value.tv_nsec = next_expiry_ns % NSEC_PER_SEC;
+	ret = timerfd_settime(timer_state.timer_fd, TFD_TIMER_ABSTIME, &its,
+			NULL);
+	if (ret == -1) {
+		PERROR("timerfd_settime");
+		timer_state.armed_expiry_ns = 0;
+		goto end;
 	}
-	cmm_smp_mb();
 
-	pthread_mutex_unlock(&timer_signal.lock);
+	timer_state.armed_expiry_ns = next_expiry_ns;
+end:
+	return ret;
 }
 
 /*
- * Start a timer channel timer which will fire at a given interval
- * (timer_interval_us)and fire a given signal (signal).
+ * Start a channel timer which will invoke `callback` every
+ * `timer_interval_us` from the timer thread.
+ *
+ * Timers sharing an interval expire on the same tick of the timer wheel.
  *
  * Returns a negative value on error, 0 if a timer was created, and
  * a positive value if no timer was created (not an error).
  */
 static
-int consumer_channel_timer_start(timer_t *timer_id,
+int consumer_channel_timer_start(struct timer_wheel_entry *timer,
 		struct lttng_consumer_channel *channel,
-		unsigned int timer_interval_us, int signal)
+		unsigned int timer_interval_us, timer_wheel_cb callback)
 {
-	int ret = 0, delete_ret;
-	struct sigevent sev = {};
-	struct itimerspec its;
+	int ret = 0;
+	uint64_t now_ns;
 
 	LTTNG_ASSERT(channel);
 	LTTNG_ASSERT(channel->key);
@@ -383,50 +469,39 @@ int consumer_channel_timer_start(timer_t *timer_id,
 		goto end;
 	}
 
-	sev.sigev_notify = SIGEV_SIGNAL;
-	sev.sigev_signo = signal;
-	sev.sigev_value.sival_ptr = channel;
-	ret = timer_create(CLOCKID, &sev, timer_id);
-	if (ret == -1) {
-		PERROR("timer_create");
+	ret = get_monotonic_time_ns(&now_ns);
+	if (ret) {
 		goto end;
 	}
 
-	its.it_value.tv_sec = timer_interval_us / 1000000;
-	its.it_value.tv_nsec = (timer_interval_us % 1000000) * 1000;
-	its.it_interval.tv_sec = its.it_value.tv_sec;
-	its.it_interval.tv_nsec = its.it_value.tv_nsec;
-
-	ret = timer_settime(*timer_id, 0, &its, NULL);
-	if (ret == -1) {
-		PERROR("timer_settime");
-		goto error_destroy_timer;
+	pthread_mutex_lock(&timer_state.lock);
+	timer_wheel_add(&timer_state.wheel, timer,
+			(uint64_t) timer_interval_us * NSEC_PER_USEC, callback,
+			now_ns);
+	ret = rearm_timer_fd();
+	if (ret) {
+		timer_wheel_remove(&timer_state.wheel, timer);
 	}
+	pthread_mutex_unlock(&timer_state.lock);
 end:
 	return ret;
-error_destroy_timer:
-	delete_ret = timer_delete(*timer_id);
-	if (delete_ret == -1) {
-		PERROR("timer_delete");
-	}
-	goto end;
 }
 
+/*
+ * Stop a channel timer. On return, the timer's callback is guaranteed not to
+ * be executing, unless called from that callback.
+ */
 static
-int consumer_channel_timer_stop(timer_t *timer_id, int signal)
+void consumer_channel_timer_stop(struct timer_wheel_entry *timer)
 {
-	int ret = 0;
-
-	ret = timer_delete(*timer_id);
-	if (ret == -1) {
-		PERROR("timer_delete");
-		goto end;
-	}
-
-	consumer_timer_signal_thread_qs(signal);
-	*timer_id = 0;
-end:
-	return ret;
+	pthread_mutex_lock(&timer_state.lock);
+	timer_wheel_remove(&timer_state.wheel, timer);
+	while (timer_state.running == timer &&
+			!pthread_equal(timer_state.tid, pthread_self())) {
+		pthread_cond_wait(&timer_state.callback_done_cond,
+				&timer_state.lock);
+	}
+	pthread_mutex_unlock(&timer_state.lock);
 }
 
 /*
@@ -441,7 +516,7 @@ void consumer_timer_switch_start(struct lttng_consumer_channel *channel,
 	LTTNG_ASSERT(channel->key);
 
 	ret = consumer_channel_timer_start(&channel->switch_timer, channel,
-			switch_timer_interval_us, LTTNG_CONSUMER_SIG_SWITCH);
+			switch_timer_interval_us, switch_timer_cb);
 
 	channel->switch_timer_enabled = !!(ret == 0);
 }
@@ -451,16 +526,9 @@ void consumer_timer_switch_start(struct lttng_consumer_channel *channel,
  */
 void consumer_timer_switch_stop(struct lttng_consumer_channel *channel)
 {
-	int ret;
-
 	LTTNG_ASSERT(channel);
 
-	ret = consumer_channel_timer_stop(&channel->switch_timer,
-			LTTNG_CONSUMER_SIG_SWITCH);
-	if (ret == -1) {
-		ERR("Failed to stop switch timer");
-	}
-
+	consumer_channel_timer_stop(&channel->switch_timer);
 	channel->switch_timer_enabled = 0;
 }
 
@@ -476,7 +544,7 @@ void consumer_timer_live_start(struct lttng_consumer_channel *channel,
 	LTTNG_ASSERT(channel->key);
 
 	ret = consumer_channel_timer_start(&channel->live_timer, channel,
-			live_timer_interval_us, LTTNG_CONSUMER_SIG_LIVE);
+			live_timer_interval_us, live_timer_cb);
 
 	channel->live_timer_enabled = !!(ret == 0);
 }
@@ -486,16 +554,9 @@ void consumer_timer_live_start(struct lttng_consumer_channel *channel,
  */
 void consumer_timer_live_stop(struct lttng_consumer_channel *channel)
 {
-	int ret;
-
 	LTTNG_ASSERT(channel);
 
-	ret = consumer_channel_timer_stop(&channel->live_timer,
-			LTTNG_CONSUMER_SIG_LIVE);
-	if (ret == -1) {
-		ERR("Failed to stop live timer");
-	}
-
+	consumer_channel_timer_stop(&channel->live_timer);
 	channel->live_timer_enabled = 0;
 }
 
@@ -515,7 +576,7 @@ int consumer_timer_monitor_start(struct lttng_consumer_channel *channel,
 	LTTNG_ASSERT(!channel->monitor_timer_enabled);
 
 	ret = consumer_channel_timer_start(&channel->monitor_timer, channel,
-			monitor_timer_interval_us, LTTNG_CONSUMER_SIG_MONITOR);
+			monitor_timer_interval_us, monitor_timer_cb);
 	channel->monitor_timer_enabled = !!(ret == 0);
 	return ret;
 }
@@ -525,40 +586,79 @@ int consumer_timer_monitor_start(struct lttng_consumer_channel *channel,
  */
 int consumer_timer_monitor_stop(struct lttng_consumer_channel *channel)
 {
-	int ret;
-
 	LTTNG_ASSERT(channel);
 	LTTNG_ASSERT(channel->monitor_timer_enabled);
 
-	ret = consumer_channel_timer_stop(&channel->monitor_timer,
-			LTTNG_CONSUMER_SIG_MONITOR);
-	if (ret == -1) {
-		ERR("Failed to stop live timer");
-		goto end;
-	}
-
+	consumer_channel_timer_stop(&channel->monitor_timer);
 	channel->monitor_timer_enabled = 0;
-end:
-	return ret;
+	return 0;
 }
 
 /*
- * Block the RT signals for the entire process. It must be called from the
- * consumer main before creating the threads
+ * Create the timerfd and quit pipe of the timer thread. It must be called
+ * from the consumer main before creating the threads.
  */
-int consumer_signal_init(void)
+int consumer_timer_init(void)
 {
 	int ret;
-	sigset_t mask;
+	uint64_t now_ns;
 
-	/* Block signal for entire process, so only our thread processes it. */
-	setmask(&mask);
-	ret = pthread_sigmask(SIG_BLOCK, &mask, NULL);
+	ret = get_monotonic_time_ns(&now_ns);
 	if (ret) {
-		errno = ret;
-		PERROR("pthread_sigmask");
+		goto error;
+	}
+
+	timer_wheel_init(&timer_state.wheel, CONSUMER_TIMER_TICK_NS, now_ns);
+
+	timer_state.timer_fd = timerfd_create(CLOCK_MONOTONIC,
+			TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer_state.timer_fd < 0) {
+		PERROR("timerfd_create");
+		goto error;
+	}
+
+	timer_state.quit_pipe = lttng_pipe_open(FD_CLOEXEC);
+	if (!timer_state.quit_pipe) {
+		ERR("Failed to create timer thread quit pipe");
+		goto error;
+	}
+
+	return 0;
+error:
+	consumer_timer_fini();
+	return -1;
+}
+
+/*
+ * Release the resources of the timer thread once it has exited.
+ */
+void consumer_timer_fini(void)
+{
+	if (timer_state.timer_fd >= 0) {
+		if (close(timer_state.timer_fd)) {
+			PERROR("close timerfd");
+		}
+		timer_state.timer_fd = -1;
+	}
+
+	lttng_pipe_destroy(timer_state.quit_pipe);
+	timer_state.quit_pipe = NULL;
+}
+
+/*
+ * Ask the timer thread to exit.
+ */
+int consumer_timer_thread_quit(void)
+{
+	const char dummy = 'q';
+	ssize_t ret;
+
+	ret = lttng_pipe_write(timer_state.quit_pipe, &dummy, sizeof(dummy));
+	if (ret != sizeof(dummy)) {
+		PERROR("Failed to write to timer thread quit pipe");
 		return -1;
 	}
+
 	return 0;
 }
 
@@ -732,16 +832,65 @@ end:
 }
 
 /*
- * This thread is the sighandler for signals LTTNG_CONSUMER_SIG_SWITCH,
- * LTTNG_CONSUMER_SIG_TEARDOWN, LTTNG_CONSUMER_SIG_LIVE, and
- * LTTNG_CONSUMER_SIG_MONITOR, LTTNG_CONSUMER_SIG_EXIT.
+ * Advance the timer wheel to the current time and invoke the callbacks of the
+ * expired timers.
+ */
+static int run_expired_timers(struct lttng_consumer_local_data *ctx)
+{
+	int ret;
+	ssize_t read_len;
+	uint64_t expirations, now_ns;
+	struct timer_wheel_entry *timer;
+
+	/*
+	 * Acknowledge the expiration. The read fails with EAGAIN if the timerfd
+	 * was re-armed in the meantime, which is harmless.
+	 */
+	read_len = lttng_read(timer_state.timer_fd, &expirations,
+			sizeof(expirations));
+	if (read_len < 0 && errno != EAGAIN) {
+		PERROR("read timerfd");
+		ret = -1;
+		goto end;
+	}
+
+	ret = get_monotonic_time_ns(&now_ns);
+	if (ret) {
+		goto end;
+	}
+
+	pthread_mutex_lock(&timer_state.lock);
+	/* The timerfd is disarmed once it expired. */
+	timer_state.armed_expiry_ns = 0;
+	timer_wheel_advance(&timer_state.wheel, now_ns);
+	while ((timer = timer_wheel_pop_expired(&timer_state.wheel))) {
+		const timer_wheel_cb callback = timer->callback;
+
+		health_code_update();
+
+		timer_state.running = timer;
+		pthread_mutex_unlock(&timer_state.lock);
+		callback(timer, ctx);
+		pthread_mutex_lock(&timer_state.lock);
+		timer_state.running = NULL;
+		pthread_cond_broadcast(&timer_state.callback_done_cond);
+	}
+	ret = rearm_timer_fd();
+	pthread_mutex_unlock(&timer_state.lock);
+end:
+	return ret;
+}
+
+/*
+ * This thread executes the switch, live and monitoring timers of the
+ * channels.
  */
 void *consumer_timer_thread(void *data)
 {
-	int signr;
-	sigset_t mask;
-	siginfo_t info;
+	int ret, i, nb_fd, err = -1;
+	struct lttng_poll_event events;
 	struct lttng_consumer_local_data *ctx = (lttng_consumer_local_data *) data;
+	const int quit_fd = lttng_pipe_get_readfd(timer_state.quit_pipe);
 
 	rcu_register_thread();
 
@@ -753,53 +902,66 @@ void *consumer_timer_thread(void *data)
 
 	health_code_update();
 
-	/* Only self thread will receive signal mask. */
-	setmask(&mask);
-	CMM_STORE_SHARED(timer_signal.tid, pthread_self());
+	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	if (ret < 0) {
+		ERR("Failed to create timer thread poll set");
+		goto error_poll;
+	}
+
+	ret = lttng_poll_add(&events, timer_state.timer_fd, LPOLLIN);
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = lttng_poll_add(&events, quit_fd, LPOLLIN);
+	if (ret < 0) {
+		goto error;
+	}
+
+	pthread_mutex_lock(&timer_state.lock);
+	timer_state.tid = pthread_self();
+	pthread_mutex_unlock(&timer_state.lock);
 
 	while (1) {
 		health_code_update();
 
 		health_poll_entry();
-		signr = sigwaitinfo(&mask, &info);
+		ret = lttng_poll_wait(&events, -1);
 		health_poll_exit();
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			PERROR("Timer thread poll wait");
+			goto error;
+		}
 
-		/*
-		 * NOTE: cascading conditions are used instead of a switch case
-		 * since the use of SIGRTMIN in the definition of the signals'
-		 * values prevents the reduction to an integer constant.
-		 */
-		if (signr == -1) {
-			if (errno != EINTR) {
-				PERROR("sigwaitinfo");
+		nb_fd = ret;
+		for (i = 0; i < nb_fd; i++) {
+			const int pollfd = LTTNG_POLL_GETFD(&events, i);
+
+			if (pollfd == quit_fd) {
+				LTTNG_ASSERT(CMM_LOAD_SHARED(consumer_quit));
+				DBG("Timer thread quit pipe activity");
+				err = 0;
+				goto exit;
+			} else if (pollfd == timer_state.timer_fd) {
+				ret = run_expired_timers(ctx);
+				if (ret) {
+					goto error;
+				}
 			}
-			continue;
-		} else if (signr == LTTNG_CONSUMER_SIG_SWITCH) {
-			metadata_switch_timer(ctx, &info);
-		} else if (signr == LTTNG_CONSUMER_SIG_TEARDOWN) {
-			cmm_smp_mb();
-			CMM_STORE_SHARED(timer_signal.qs_done, 1);
-			cmm_smp_mb();
-			DBG("Signal timer metadata thread teardown");
-		} else if (signr == LTTNG_CONSUMER_SIG_LIVE) {
-			live_timer(ctx, &info);
-		} else if (signr == LTTNG_CONSUMER_SIG_MONITOR) {
-			struct lttng_consumer_channel *channel;
-
-			channel = (lttng_consumer_channel *) info.si_value.sival_ptr;
-			sample_and_send_channel_buffer_stats(channel);
-		} else if (signr == LTTNG_CONSUMER_SIG_EXIT) {
-			LTTNG_ASSERT(CMM_LOAD_SHARED(consumer_quit));
-			goto end;
-		} else {
-			ERR("Unexpected signal %d\n", info.si_signo);
 		}
 	}
 
+exit:
+error:
+	lttng_poll_clean(&events);
+error_poll:
 error_testpoint:
-	/* Only reached in testpoint error */
-	health_error();
-end:
+	if (err) {
+		health_error();
+	}
 	health_unregister(health_consumerd);
 	rcu_unregister_thread();
 	return NULL;
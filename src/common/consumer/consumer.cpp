@@ -17,14 +17,17 @@
 #include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <bin/lttng-consumerd/health-consumerd.hpp>
 #include <common/align.hpp>
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/compat/getenv.hpp>
 #include <common/compat/poll.hpp>
 #include <common/consumer/consumer-metadata-cache.hpp>
+#include <common/consumer/consumer-numa.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-testpoint.hpp>
 #include <common/consumer/consumer-timer.hpp>
@@ -32,9 +35,11 @@
 #include <common/dynamic-array.hpp>
 #include <common/index/ctf-index.hpp>
 #include <common/index/index.hpp>
+#include <common/ini-config/ini-config.hpp>
 #include <common/kernel-consumer/kernel-consumer.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
 #include <common/relayd/relayd.hpp>
+#include <common/sessiond-comm/inet.hpp>
 #include <common/sessiond-comm/relayd.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/string-utils/format.hpp>
@@ -46,6 +51,12 @@
 
 lttng_consumer_global_data the_consumer_data;
 
+/*
+ * Maximal number of index commands sent to a relayd before their replies are
+ * received.
+ */
+#define CONSUMER_RELAYD_INDEX_BATCH_SIZE	64
+
 enum consumer_channel_action {
 	CONSUMER_CHANNEL_ADD,
 	CONSUMER_CHANNEL_DEL,
@@ -66,6 +77,19 @@ struct consumer_channel_msg {
  */
 struct lttng_ht *metadata_ht;
 struct lttng_ht *data_ht;
+
+/*
+ * Use MSG_ZEROCOPY to send sub-buffers mapped in memory on relayd data
+ * sockets. Set from the LTTNG_CONSUMERD_NETWORK_ZEROCOPY environment variable.
+ */
+bool network_zerocopy;
+static unsigned int snapshot_worker_count = DEFAULT_CONSUMERD_SNAPSHOT_WORKERS;
+
+/*
+ * Run one data thread per NUMA node. Set from the
+ * LTTNG_CONSUMERD_NUMA_AFFINITY environment variable.
+ */
+static bool numa_affinity = true;
 } /* namespace */
 
 /* Flag used to temporarily pause data consumption from testpoints. */
@@ -93,6 +117,46 @@ static const char *get_consumer_domain(void)
 	}
 }
 
+/*
+ * Add `value` to a consumption statistic of a stream.
+ *
+ * Only the thread consuming the stream updates its statistics; the store is
+ * published so that concurrent readers (see lttng_consumer_send_stream_stats())
+ * can sample the counter without taking the stream lock.
+ */
+static void consumer_stream_stats_add(uint64_t *counter, uint64_t value)
+{
+	CMM_STORE_SHARED(*counter, *counter + value);
+}
+
+/*
+ * Raise a "worst value" statistic of a stream to `value` if it is larger.
+ */
+static void consumer_stream_stats_max(uint64_t *counter, uint64_t value)
+{
+	if (value > *counter) {
+		CMM_STORE_SHARED(*counter, value);
+	}
+}
+
+/*
+ * Return the current CLOCK_MONOTONIC time in nanoseconds, or 0 on error.
+ */
+static uint64_t consumer_get_monotonic_ns(void)
+{
+	struct timespec ts;
+	uint64_t now_ns = 0;
+
+	if (lttng_clock_gettime(CLOCK_MONOTONIC, &ts)) {
+		PERROR("clock_gettime");
+		goto end;
+	}
+
+	now_ns = (uint64_t) ts.tv_sec * NSEC_PER_SEC + (uint64_t) ts.tv_nsec;
+end:
+	return now_ns;
+}
+
 /*
  * Notify a thread lttng pipe to poll back again. This usually means that some
  * global state has changed so we just send back the thread in a poll wait
@@ -107,6 +171,18 @@ static void notify_thread_lttng_pipe(struct lttng_pipe *pipe)
 	(void) lttng_pipe_write(pipe, &null_stream, sizeof(null_stream));
 }
 
+/*
+ * Notify all the data threads to poll back again.
+ */
+static void notify_data_threads(struct lttng_consumer_local_data *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->nb_data_threads; i++) {
+		notify_thread_lttng_pipe(ctx->data_threads[i].data_pipe);
+	}
+}
+
 static void notify_health_quit_pipe(int *pipe)
 {
 	ssize_t ret;
@@ -187,8 +263,8 @@ static void clean_channel_stream_list(struct lttng_consumer_channel *channel)
 }
 
 /*
- * Find a stream. The consumer_data.lock must be locked during this
- * call.
+ * Find a stream. RCU read side lock MUST be acquired before calling this
+ * function and while using the returned object.
  */
 static struct lttng_consumer_stream *find_stream(uint64_t key,
 		struct lttng_ht *ht)
@@ -319,6 +395,7 @@ static void free_relayd_rcu(struct rcu_head *head)
 		lttng::utils::container_of(head, &lttng_ht_node_u64::head);
 	struct consumer_relayd_sock_pair *relayd =
 		lttng::utils::container_of(node, &consumer_relayd_sock_pair::node);
+	struct cds_wfcq_node *queue_node;
 
 	/*
 	 * Close all sockets. This is done in the call RCU since we don't want the
@@ -331,6 +408,14 @@ static void free_relayd_rcu(struct rcu_head *head)
 	(void) relayd_close(&relayd->control_sock);
 	(void) relayd_close(&relayd->data_sock);
 
+	/* Drop the index commands that could not be sent. */
+	while ((queue_node = cds_wfcq_dequeue_blocking(&relayd->index_queue_head,
+			&relayd->index_queue_tail))) {
+		free(lttng::utils::container_of(queue_node,
+				&consumer_relayd_index_msg::node));
+	}
+	cds_wfcq_destroy(&relayd->index_queue_head, &relayd->index_queue_tail);
+
 	pthread_mutex_destroy(&relayd->ctrl_sock_mutex);
 	free(relayd);
 }
@@ -361,8 +446,11 @@ void consumer_destroy_relayd(struct consumer_relayd_sock_pair *relayd)
 }
 
 /*
- * Remove a channel from the global list protected by a mutex. This function is
- * also responsible for freeing its data structures.
+ * Remove a channel from the channel hash tables. This function is also
+ * responsible for freeing its data structures.
+ *
+ * The channel lock is sufficient: lookups are RCU-protected and check whether
+ * the channel was unpublished under its lock.
  */
 void consumer_del_channel(struct lttng_consumer_channel *channel)
 {
@@ -370,7 +458,6 @@ void consumer_del_channel(struct lttng_consumer_channel *channel)
 
 	DBG("Consumer delete channel key %" PRIu64, channel->key);
 
-	pthread_mutex_lock(&the_consumer_data.lock);
 	pthread_mutex_lock(&channel->lock);
 
 	/* Destroy streams that might have been left in the stream list. */
@@ -424,7 +511,6 @@ void consumer_del_channel(struct lttng_consumer_channel *channel)
 	call_rcu(&channel->node.head, free_channel_rcu);
 end:
 	pthread_mutex_unlock(&channel->lock);
-	pthread_mutex_unlock(&the_consumer_data.lock);
 }
 
 /*
@@ -517,10 +603,189 @@ void lttng_consumer_cleanup_relayd(struct consumer_relayd_sock_pair *relayd)
 	 * memory barrier ordering the updates of the end point status from the
 	 * read of this status which happens AFTER receiving this notify.
 	 */
-	notify_thread_lttng_pipe(relayd->ctx->consumer_data_pipe);
+	notify_data_threads(relayd->ctx);
 	notify_thread_lttng_pipe(relayd->ctx->consumer_metadata_pipe);
 }
 
+/*
+ * Receive the replies to `count` index commands.
+ *
+ * Returns 0 on success, a negative value on error.
+ */
+static int relayd_recv_index_replies(struct consumer_relayd_sock_pair *relayd,
+		unsigned int count)
+{
+	int ret = 0;
+
+	for (; count > 0; count--) {
+		ret = relayd_recv_index_reply(&relayd->control_sock);
+		if (ret < 0) {
+			break;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Send the index commands queued on a relayd control socket.
+ *
+ * The commands are pipelined: up to CONSUMER_RELAYD_INDEX_BATCH_SIZE of them
+ * are sent before their replies are received. Bounding the number of unread
+ * replies ensures that neither side ends up blocked on a full socket buffer.
+ * On a communication error, the relayd is cleaned up and the remaining
+ * commands are dropped.
+ *
+ * The control socket mutex MUST be held.
+ */
+static void relayd_send_queued_indexes(struct consumer_relayd_sock_pair *relayd)
+{
+	int ret;
+	bool failed = false;
+	unsigned int in_flight = 0;
+	struct cds_wfcq_node *node;
+
+	while ((node = cds_wfcq_dequeue_blocking(&relayd->index_queue_head,
+			&relayd->index_queue_tail))) {
+		struct consumer_relayd_index_msg *msg =
+			lttng::utils::container_of(node,
+					&consumer_relayd_index_msg::node);
+
+		if (!failed) {
+			ret = relayd_send_index_command(&relayd->control_sock,
+					&msg->index, msg->relay_stream_id,
+					msg->net_seq_num);
+			if (ret < 0) {
+				failed = true;
+			} else {
+				in_flight++;
+			}
+		}
+		free(msg);
+
+		if (!failed && in_flight == CONSUMER_RELAYD_INDEX_BATCH_SIZE) {
+			ret = relayd_recv_index_replies(relayd, in_flight);
+			in_flight = 0;
+			if (ret < 0) {
+				failed = true;
+			}
+		}
+	}
+
+	if (!failed && in_flight > 0) {
+		ret = relayd_recv_index_replies(relayd, in_flight);
+		if (ret < 0) {
+			failed = true;
+		}
+	}
+
+	if (failed) {
+		/*
+		 * Communication error with lttng-relayd, perform cleanup now.
+		 */
+		ERR("Relayd send index failed. Cleaning up relayd %" PRIu64 ".",
+				relayd->net_seq_idx);
+		lttng_consumer_cleanup_relayd(relayd);
+	}
+}
+
+/*
+ * Check whether index commands are waiting to be sent on a relayd control
+ * socket.
+ */
+static bool relayd_has_queued_indexes(struct consumer_relayd_sock_pair *relayd)
+{
+	cds_wfcq_head_ptr_t head;
+
+	head.h = &relayd->index_queue_head;
+	return !cds_wfcq_empty(head, &relayd->index_queue_tail);
+}
+
+/*
+ * Acquire exclusive use of a relayd control socket.
+ *
+ * The index commands queued on the socket are sent first so that the relayd's
+ * replies keep arriving in the order in which the commands were queued.
+ */
+void consumer_relayd_ctrl_lock(struct consumer_relayd_sock_pair *relayd)
+{
+	pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+	relayd_send_queued_indexes(relayd);
+}
+
+/*
+ * Release a relayd control socket acquired with consumer_relayd_ctrl_lock().
+ *
+ * An index command queued while the socket was held could not be sent by its
+ * producer. Once the mutex is released, check for such commands and send them
+ * unless another thread took the socket, in which case it sends them.
+ */
+void consumer_relayd_ctrl_unlock(struct consumer_relayd_sock_pair *relayd)
+{
+	for (;;) {
+		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+
+		/* Order the unlock before the queue check. */
+		cmm_smp_mb();
+		if (!relayd_has_queued_indexes(relayd)) {
+			break;
+		}
+
+		if (pthread_mutex_trylock(&relayd->ctrl_sock_mutex)) {
+			/* The current owner sends the queued commands. */
+			break;
+		}
+
+		relayd_send_queued_indexes(relayd);
+	}
+}
+
+/*
+ * Queue an index command on a relayd control socket without waiting for the
+ * socket to be available. The command is sent right away if the socket is
+ * free, otherwise by the thread holding it.
+ *
+ * A failure to send the command is handled by cleaning up the relayd, which
+ * deactivates the streams using it, rather than being reported to the caller.
+ *
+ * Returns 0 on success, a negative value if the command could not be queued.
+ */
+int consumer_relayd_queue_index(struct consumer_relayd_sock_pair *relayd,
+		const struct ctf_packet_index *index, uint64_t relay_stream_id,
+		uint64_t net_seq_num)
+{
+	cds_wfcq_head_ptr_t head;
+	struct consumer_relayd_index_msg *msg;
+
+	msg = zmalloc<consumer_relayd_index_msg>();
+	if (!msg) {
+		PERROR("zmalloc relayd index message");
+		return -1;
+	}
+
+	msg->index = *index;
+	msg->relay_stream_id = relay_stream_id;
+	msg->net_seq_num = net_seq_num;
+	cds_wfcq_node_init(&msg->node);
+
+	head.h = &relayd->index_queue_head;
+	cds_wfcq_enqueue(head, &relayd->index_queue_tail, &msg->node);
+
+	/*
+	 * Order the enqueue before the lock attempt; pairs with the barrier of
+	 * consumer_relayd_ctrl_unlock().
+	 */
+	cmm_smp_mb();
+	if (pthread_mutex_trylock(&relayd->ctrl_sock_mutex)) {
+		/* The current owner sends the command. */
+		return 0;
+	}
+
+	relayd_send_queued_indexes(relayd);
+	consumer_relayd_ctrl_unlock(relayd);
+	return 0;
+}
+
 /*
  * Flag a relayd socket pair for destruction. Destroy it if the refcount
  * reaches zero.
@@ -575,18 +840,56 @@ void consumer_stream_update_channel_attributes(
 }
 
 /*
- * Add a stream to the global list protected by a mutex.
+ * Select the data thread which consumes a stream: the one bound to the NUMA
+ * node of the stream's CPU, if known.
+ *
+ * Streams sent to a relay daemon are all consumed by the first data thread
+ * since they share the relay daemon's data socket.
+ */
+static struct lttng_consumer_data_thread *select_data_thread(
+		struct lttng_consumer_local_data *ctx,
+		const struct lttng_consumer_stream *stream)
+{
+	unsigned int i;
+	int node;
+
+	if (ctx->nb_data_threads == 1 ||
+			stream->net_seq_idx != (uint64_t) -1ULL) {
+		goto default_thread;
+	}
+
+	node = consumer_numa_get_node_of_cpu(stream->cpu);
+	if (node < 0) {
+		goto default_thread;
+	}
+
+	for (i = 0; i < ctx->nb_data_threads; i++) {
+		if (ctx->data_threads[i].numa_node == node) {
+			return &ctx->data_threads[i];
+		}
+	}
+
+default_thread:
+	return &ctx->data_threads[0];
+}
+
+/*
+ * Add a stream to the global list protected by a mutex and assign it to the
+ * data thread which will consume it.
  */
-void consumer_add_data_stream(struct lttng_consumer_stream *stream)
+void consumer_add_data_stream(struct lttng_consumer_stream *stream,
+		struct lttng_consumer_local_data *ctx)
 {
 	struct lttng_ht *ht = data_ht;
 
 	LTTNG_ASSERT(stream);
+	LTTNG_ASSERT(ctx);
 	LTTNG_ASSERT(ht);
 
 	DBG3("Adding consumer stream %" PRIu64, stream->key);
 
-	pthread_mutex_lock(&the_consumer_data.lock);
+	stream->data_thread = select_data_thread(ctx, stream);
+
 	pthread_mutex_lock(&stream->chan->lock);
 	pthread_mutex_lock(&stream->chan->timer_lock);
 	pthread_mutex_lock(&stream->lock);
@@ -595,7 +898,15 @@ void consumer_add_data_stream(struct lttng_consumer_stream *stream)
 	/* Steal stream identifier to avoid having streams with the same key */
 	steal_stream_key(stream->key, ht);
 
+	/*
+	 * Publish the stream to its data thread, which only needs a coherent
+	 * view of its own streams.
+	 */
+	pthread_mutex_lock(&stream->data_thread->lock);
 	lttng_ht_add_unique_u64(ht, &stream->node);
+	stream->data_thread->stream_count++;
+	stream->data_thread->streams_generation++;
+	pthread_mutex_unlock(&stream->data_thread->lock);
 
 	lttng_ht_add_u64(the_consumer_data.stream_per_chan_id_ht,
 			&stream->node_channel_id);
@@ -621,15 +932,10 @@ void consumer_add_data_stream(struct lttng_consumer_stream *stream)
 		uatomic_dec(&stream->chan->nb_init_stream_left);
 	}
 
-	/* Update consumer data once the node is inserted. */
-	the_consumer_data.stream_count++;
-	the_consumer_data.need_update = 1;
-
 	rcu_read_unlock();
 	pthread_mutex_unlock(&stream->lock);
 	pthread_mutex_unlock(&stream->chan->timer_lock);
 	pthread_mutex_unlock(&stream->chan->lock);
-	pthread_mutex_unlock(&the_consumer_data.lock);
 }
 
 /*
@@ -683,6 +989,7 @@ static struct consumer_relayd_sock_pair *consumer_allocate_relayd_sock_pair(
 	obj->data_sock.sock.fd = -1;
 	lttng_ht_node_init_u64(&obj->node, obj->net_seq_idx);
 	pthread_mutex_init(&obj->ctrl_sock_mutex, NULL);
+	cds_wfcq_init(&obj->index_queue_head, &obj->index_queue_tail);
 
 error:
 	return obj;
@@ -738,13 +1045,13 @@ int consumer_send_relayd_stream(struct lttng_consumer_stream *stream,
 	relayd = consumer_find_relayd(stream->net_seq_idx);
 	if (relayd != NULL) {
 		/* Add stream on the relayd */
-		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_lock(relayd);
 		ret = relayd_add_stream(&relayd->control_sock, stream->name,
 				get_consumer_domain(), path, &stream->relayd_stream_id,
 				stream->chan->tracefile_size,
 				stream->chan->tracefile_count,
 				stream->trace_chunk);
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_unlock(relayd);
 		if (ret < 0) {
 			ERR("Relayd add stream failed. Cleaning up relayd %" PRIu64".", relayd->net_seq_idx);
 			lttng_consumer_cleanup_relayd(relayd);
@@ -785,9 +1092,9 @@ int consumer_send_relayd_streams_sent(uint64_t net_seq_idx)
 	relayd = consumer_find_relayd(net_seq_idx);
 	if (relayd != NULL) {
 		/* Add stream on the relayd */
-		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_lock(relayd);
 		ret = relayd_streams_sent(&relayd->control_sock);
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_unlock(relayd);
 		if (ret < 0) {
 			ERR("Relayd streams sent failed. Cleaning up relayd %" PRIu64".", relayd->net_seq_idx);
 			lttng_consumer_cleanup_relayd(relayd);
@@ -1162,13 +1469,14 @@ int consumer_add_channel(struct lttng_consumer_channel *channel,
 }
 
 /*
- * Allocate the pollfd structure and the local view of the out fds to avoid
- * doing a lookup in the linked list and concurrency issues when writing is
- * needed. Called with consumer_data.lock held.
+ * Allocate the pollfd structure and the local view of the out fds of the
+ * streams consumed by a data thread to avoid doing a lookup in the linked list
+ * and concurrency issues when writing is needed. Called with the data thread's
+ * lock held.
  *
  * Returns the number of fds in the structures.
  */
-static int update_poll_array(struct lttng_consumer_local_data *ctx,
+static int update_poll_array(struct lttng_consumer_data_thread *data_thread,
 		struct pollfd **pollfd, struct lttng_consumer_stream **local_stream,
 		struct lttng_ht *ht, int *nb_inactive_fd)
 {
@@ -1176,7 +1484,7 @@ static int update_poll_array(struct lttng_consumer_local_data *ctx,
 	struct lttng_ht_iter iter;
 	struct lttng_consumer_stream *stream;
 
-	LTTNG_ASSERT(ctx);
+	LTTNG_ASSERT(data_thread);
 	LTTNG_ASSERT(ht);
 	LTTNG_ASSERT(pollfd);
 	LTTNG_ASSERT(local_stream);
@@ -1185,6 +1493,10 @@ static int update_poll_array(struct lttng_consumer_local_data *ctx,
 	*nb_inactive_fd = 0;
 	rcu_read_lock();
 	cds_lfht_for_each_entry(ht->ht, &iter.iter, stream, node.node) {
+		if (stream->data_thread != data_thread) {
+			continue;
+		}
+
 		/*
 		 * Only active streams with an active end point can be added to the
 		 * poll set and local stream storage of the thread.
@@ -1214,13 +1526,13 @@ static int update_poll_array(struct lttng_consumer_local_data *ctx,
 	rcu_read_unlock();
 
 	/*
-	 * Insert the consumer_data_pipe at the end of the array and don't
+	 * Insert the data pipe at the end of the array and don't
 	 * increment i so nb_fd is the number of real FD.
 	 */
-	(*pollfd)[i].fd = lttng_pipe_get_readfd(ctx->consumer_data_pipe);
+	(*pollfd)[i].fd = lttng_pipe_get_readfd(data_thread->data_pipe);
 	(*pollfd)[i].events = POLLIN | POLLPRI;
 
-	(*pollfd)[i + 1].fd = lttng_pipe_get_readfd(ctx->consumer_wakeup_pipe);
+	(*pollfd)[i + 1].fd = lttng_pipe_get_readfd(data_thread->wakeup_pipe);
 	(*pollfd)[i + 1].events = POLLIN | POLLPRI;
 	return i;
 }
@@ -1317,6 +1629,8 @@ void lttng_consumer_cleanup(void)
 	 */
 	lttng_ht_destroy(the_consumer_data.stream_list_ht);
 
+	consumer_numa_fini();
+
 	/*
 	 * Trace chunks in the registry may still exist if the session
 	 * daemon has encountered an internal error and could not
@@ -1404,10 +1718,76 @@ void lttng_consumer_sync_trace_file(struct lttng_consumer_stream *stream,
 	}
 }
 
+/*
+ * Release the data threads of a context and their pipes.
+ */
+static void fini_data_threads(struct lttng_consumer_local_data *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->nb_data_threads; i++) {
+		lttng_pipe_destroy(ctx->data_threads[i].data_pipe);
+		lttng_pipe_destroy(ctx->data_threads[i].wakeup_pipe);
+		pthread_mutex_destroy(&ctx->data_threads[i].lock);
+	}
+
+	free(ctx->data_threads);
+	ctx->data_threads = NULL;
+	ctx->nb_data_threads = 0;
+}
+
+/*
+ * Allocate the data threads of a context and their pipes: one per NUMA node
+ * when NUMA affinity is enabled, a single unbound one otherwise. The threads
+ * are launched by the consumer daemon.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int init_data_threads(struct lttng_consumer_local_data *ctx)
+{
+	unsigned int i;
+	const unsigned int count = numa_affinity ?
+			consumer_numa_get_node_count() : 1;
+
+	ctx->data_threads = calloc<lttng_consumer_data_thread>(count);
+	if (!ctx->data_threads) {
+		PERROR("allocating data threads");
+		return -1;
+	}
+
+	ctx->nb_data_threads = count;
+	ctx->nb_running_data_threads = count;
+	for (i = 0; i < count; i++) {
+		struct lttng_consumer_data_thread *data_thread =
+				&ctx->data_threads[i];
+
+		data_thread->ctx = ctx;
+		data_thread->numa_node = count > 1 ? (int) i : -1;
+		pthread_mutex_init(&data_thread->lock, NULL);
+
+		data_thread->data_pipe = lttng_pipe_open(0);
+		if (!data_thread->data_pipe) {
+			goto error;
+		}
+
+		data_thread->wakeup_pipe = lttng_pipe_open(0);
+		if (!data_thread->wakeup_pipe) {
+			goto error;
+		}
+	}
+
+	DBG("Consuming data streams with %u thread(s)", count);
+	return 0;
+
+error:
+	fini_data_threads(ctx);
+	return -1;
+}
+
 /*
  * Initialise the necessary environnement :
  * - create a new context
- * - create the poll_pipe
+ * - create the data threads' poll and wakeup pipes
  * - create the should_quit pipe (for signal handler)
  * - create the thread pipe (for splice)
  *
@@ -1448,14 +1828,9 @@ struct lttng_consumer_local_data *lttng_consumer_create(
 	ctx->on_recv_stream = recv_stream;
 	ctx->on_update_stream = update_stream;
 
-	ctx->consumer_data_pipe = lttng_pipe_open(0);
-	if (!ctx->consumer_data_pipe) {
-		goto error_poll_pipe;
-	}
-
-	ctx->consumer_wakeup_pipe = lttng_pipe_open(0);
-	if (!ctx->consumer_wakeup_pipe) {
-		goto error_wakeup_pipe;
+	ret = init_data_threads(ctx);
+	if (ret) {
+		goto error_data_threads;
 	}
 
 	ret = pipe(ctx->consumer_should_quit);
@@ -1484,10 +1859,8 @@ error_metadata_pipe:
 error_channel_pipe:
 	utils_close_pipe(ctx->consumer_should_quit);
 error_quit_pipe:
-	lttng_pipe_destroy(ctx->consumer_wakeup_pipe);
-error_wakeup_pipe:
-	lttng_pipe_destroy(ctx->consumer_data_pipe);
-error_poll_pipe:
+	fini_data_threads(ctx);
+error_data_threads:
 	free(ctx);
 error:
 	return NULL;
@@ -1569,9 +1942,8 @@ void lttng_consumer_destroy(struct lttng_consumer_local_data *ctx)
 		PERROR("close");
 	}
 	utils_close_pipe(ctx->consumer_channel_pipe);
-	lttng_pipe_destroy(ctx->consumer_data_pipe);
+	fini_data_threads(ctx);
 	lttng_pipe_destroy(ctx->consumer_metadata_pipe);
-	lttng_pipe_destroy(ctx->consumer_wakeup_pipe);
 	utils_close_pipe(ctx->consumer_should_quit);
 
 	unlink(ctx->consumer_command_sock_path);
@@ -1616,6 +1988,49 @@ end:
 	return (int) ret;
 }
 
+/*
+ * Send the payload of a mapped sub-buffer on the relayd data socket using
+ * MSG_ZEROCOPY.
+ *
+ * When the caller allows it (`zerocopy.can_defer`), the sub-buffer is left in
+ * flight: the function returns without waiting for the kernel to release its
+ * pages, and lttng_consumer_release_zerocopy_subbuffer() hands it back to
+ * the tracer once it has. Otherwise, the function only returns once the pages
+ * are released so that the caller can put the sub-buffer right away.
+ *
+ * Returns the number of bytes sent or a negative value on error.
+ */
+static ssize_t relayd_send_subbuffer_zerocopy(
+		struct lttng_consumer_stream *stream,
+		struct consumer_relayd_sock_pair *relayd,
+		const char *data, size_t len)
+{
+	ssize_t ret;
+
+	ret = lttcomm_sendmsg_zerocopy_inet_sock(&relayd->data_sock.sock, data,
+			len, &relayd->data_sock_zerocopy.sent);
+	if (ret < 0) {
+		goto end;
+	}
+
+	if (stream->zerocopy.can_defer) {
+		stream->zerocopy.in_flight = true;
+		stream->zerocopy.release_at = relayd->data_sock_zerocopy.sent;
+		goto end;
+	}
+
+	if (lttcomm_wait_zerocopy_inet_sock(&relayd->data_sock.sock,
+			relayd->data_sock_zerocopy.sent,
+			&relayd->data_sock_zerocopy.completed)) {
+		/* The relayd can no longer be trusted with this socket. */
+		errno = EPIPE;
+		ret = -1;
+	}
+
+end:
+	return ret;
+}
+
 /*
  * Mmap the ring buffer, read it and write the data to the tracefile. This is a
  * core function for writing trace buffers to either the local filesystem or
@@ -1665,7 +2080,7 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 		 */
 		if (stream->metadata_flag) {
 			/* Metadata requires the control socket. */
-			pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_lock(relayd);
 			if (stream->reset_metadata_flag) {
 				ret = relayd_reset_metadata(&relayd->control_sock,
 						stream->relayd_stream_id,
@@ -1729,7 +2144,13 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 	 * This call guarantee that len or less is returned. It's impossible to
 	 * receive a ret value that is bigger than len.
 	 */
-	ret = lttng_write(outfd, buffer->data, write_len);
+	if (relayd && !stream->metadata_flag && relayd->data_sock_zerocopy.enabled) {
+		ret = relayd_send_subbuffer_zerocopy(stream, relayd,
+				buffer->data, write_len);
+	} else {
+		ret = lttng_write(outfd, buffer->data, write_len);
+	}
+	consumer_stream_stats_add(&stream->stats.write_syscalls, 1);
 	DBG("Consumer mmap write() ret %zd (len %zu)", ret, write_len);
 	if (ret < 0 || ((size_t) ret != write_len)) {
 		/*
@@ -1781,7 +2202,7 @@ write_error:
 end:
 	/* Unlock only if ctrl socket used */
 	if (relayd && stream->metadata_flag) {
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_unlock(relayd);
 	}
 
 	rcu_read_unlock();
@@ -1844,7 +2265,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 			 * Lock the control socket for the complete duration of the function
 			 * since from this point on we will use the socket.
 			 */
-			pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_lock(relayd);
 
 			if (stream->reset_metadata_flag) {
 				ret = relayd_reset_metadata(&relayd->control_sock,
@@ -1909,6 +2330,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 				(unsigned long)offset, len, fd, splice_pipe[1]);
 		ret_splice = splice(fd, &offset, splice_pipe[1], NULL, len,
 				SPLICE_F_MOVE | SPLICE_F_MORE);
+		consumer_stream_stats_add(&stream->stats.write_syscalls, 1);
 		DBG("splice chan to pipe, ret %zd", ret_splice);
 		if (ret_splice < 0) {
 			ret = errno;
@@ -1935,6 +2357,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 		/* Splice data out */
 		ret_splice = splice(splice_pipe[0], NULL, outfd, NULL,
 				ret_splice, SPLICE_F_MOVE | SPLICE_F_MORE);
+		consumer_stream_stats_add(&stream->stats.write_syscalls, 1);
 		DBG("Consumer splice pipe to file (out_fd: %d), ret %zd",
 				outfd, ret_splice);
 		if (ret_splice < 0) {
@@ -1999,11 +2422,130 @@ splice_error:
 	}
 
 end:
-	if (relayd && stream->metadata_flag) {
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
-	}
-
-	rcu_read_unlock();
+	if (relayd && stream->metadata_flag) {
+		consumer_relayd_ctrl_unlock(relayd);
+	}
+
+	rcu_read_unlock();
+	return written;
+}
+
+/*
+ * Move a sub-buffer mapped in memory to the tracefile without copying it
+ * through user space: the pages are vmsplice'd in the stream's splice pipe
+ * and spliced from the pipe to the output file.
+ *
+ * Only used for local (non-streaming) data streams of UST channels using the
+ * splice output. The pages are not gifted to the pipe; the splice to the
+ * output file completes the copy to the page cache before returning, so the
+ * sub-buffer can be handed back to the tracer afterwards.
+ *
+ * It must be called with the stream lock held.
+ *
+ * Returns the number of bytes spliced.
+ */
+ssize_t lttng_consumer_on_read_subbuffer_vmsplice(
+		struct lttng_consumer_local_data *ctx,
+		struct lttng_consumer_stream *stream,
+		const struct lttng_buffer_view *buffer)
+{
+	ssize_t ret = 0, written = 0;
+	off_t orig_offset = stream->out_fd_offset;
+	int outfd = stream->out_fd;
+	const int *splice_pipe = stream->splice_pipe;
+	const char *data = buffer->data;
+	size_t len = buffer->size;
+
+	LTTNG_ASSERT(stream->net_seq_idx == (uint64_t) -1ULL);
+	LTTNG_ASSERT(!stream->metadata_flag);
+
+	/*
+	 * Check if we need to change the tracefile before writing the packet.
+	 */
+	if (stream->chan->tracefile_size > 0 &&
+			(stream->tracefile_size_current + len) >
+			stream->chan->tracefile_size) {
+		ret = consumer_stream_rotate_output_files(stream);
+		if (ret < 0) {
+			written = ret;
+			goto end;
+		}
+		outfd = stream->out_fd;
+		orig_offset = 0;
+	}
+	stream->tracefile_size_current += len;
+
+	while (len > 0) {
+		struct iovec iov;
+		ssize_t in_pipe;
+
+		iov.iov_base = (void *) data;
+		iov.iov_len = len;
+		in_pipe = vmsplice(splice_pipe[1], &iov, 1, 0);
+		consumer_stream_stats_add(&stream->stats.write_syscalls, 1);
+		DBG("vmsplice sub-buffer to pipe (len: %zu, pipe: %d), ret %zd",
+				len, splice_pipe[1], in_pipe);
+		if (in_pipe < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			ret = errno;
+			written = -ret;
+			PERROR("Error in vmsplice");
+			goto splice_error;
+		}
+
+		data += in_pipe;
+		len -= in_pipe;
+
+		/* Drain the pipe to the output file. */
+		while (in_pipe > 0) {
+			const ssize_t ret_splice = splice(splice_pipe[0], NULL,
+					outfd, NULL, in_pipe,
+					SPLICE_F_MOVE | SPLICE_F_MORE);
+
+			consumer_stream_stats_add(&stream->stats.write_syscalls, 1);
+			DBG("Consumer splice pipe to file (out_fd: %d), ret %zd",
+					outfd, ret_splice);
+			if (ret_splice < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+
+				ret = errno;
+				written = -ret;
+				PERROR("Error in splice of vmsplice'd sub-buffer");
+				goto splice_error;
+			}
+
+			/* This won't block, but will start writeout asynchronously */
+			lttng_sync_file_range(outfd, stream->out_fd_offset,
+					ret_splice, SYNC_FILE_RANGE_WRITE);
+			stream->out_fd_offset += ret_splice;
+			stream->output_written += ret_splice;
+			written += ret_splice;
+			in_pipe -= ret_splice;
+		}
+	}
+	lttng_consumer_sync_trace_file(stream, orig_offset);
+	goto end;
+
+splice_error:
+	/* send the appropriate error description to sessiond */
+	switch (ret) {
+	case EINVAL:
+		lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_SPLICE_EINVAL);
+		break;
+	case ENOMEM:
+		lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_SPLICE_ENOMEM);
+		break;
+	case ESPIPE:
+		lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_SPLICE_ESPIPE);
+		break;
+	}
+
+end:
 	return written;
 }
 
@@ -2149,7 +2691,6 @@ void consumer_del_metadata_stream(struct lttng_consumer_stream *stream,
 
 	DBG3("Consumer delete metadata stream %d", stream->wait_fd);
 
-	pthread_mutex_lock(&the_consumer_data.lock);
 	/*
 	 * Note that this assumes that a stream's channel is never changed and
 	 * that the stream's lock doesn't need to be taken to sample its
@@ -2191,7 +2732,6 @@ void consumer_del_metadata_stream(struct lttng_consumer_stream *stream,
 	}
 	pthread_mutex_unlock(&stream->lock);
 	pthread_mutex_unlock(&channel->lock);
-	pthread_mutex_unlock(&the_consumer_data.lock);
 
 	if (free_channel) {
 		consumer_del_channel(channel);
@@ -2217,7 +2757,6 @@ void consumer_add_metadata_stream(struct lttng_consumer_stream *stream)
 
 	DBG3("Adding metadata stream %" PRIu64 " to hash table", stream->key);
 
-	pthread_mutex_lock(&the_consumer_data.lock);
 	pthread_mutex_lock(&stream->chan->lock);
 	pthread_mutex_lock(&stream->chan->timer_lock);
 	pthread_mutex_lock(&stream->lock);
@@ -2268,13 +2807,14 @@ void consumer_add_metadata_stream(struct lttng_consumer_stream *stream)
 	pthread_mutex_unlock(&stream->lock);
 	pthread_mutex_unlock(&stream->chan->lock);
 	pthread_mutex_unlock(&stream->chan->timer_lock);
-	pthread_mutex_unlock(&the_consumer_data.lock);
 }
 
 /*
- * Delete data stream that are flagged for deletion (endpoint_status).
+ * Delete the data streams of a data thread that are flagged for deletion
+ * (endpoint_status).
  */
-static void validate_endpoint_status_data_stream(void)
+static void validate_endpoint_status_data_stream(
+		const struct lttng_consumer_data_thread *data_thread)
 {
 	struct lttng_ht_iter iter;
 	struct lttng_consumer_stream *stream;
@@ -2283,6 +2823,10 @@ static void validate_endpoint_status_data_stream(void)
 
 	rcu_read_lock();
 	cds_lfht_for_each_entry(data_ht->ht, &iter.iter, stream, node.node) {
+		if (stream->data_thread != data_thread) {
+			continue;
+		}
+
 		/* Validate delete flag of the stream */
 		if (stream->endpoint_status == CONSUMER_ENDPOINT_ACTIVE) {
 			continue;
@@ -2539,6 +3083,35 @@ error_testpoint:
 	return NULL;
 }
 
+/*
+ * Release the sub-buffers that the streams of the local view left in flight
+ * while sending them with MSG_ZEROCOPY during the last pass.
+ *
+ * The completions of a relayd data socket are reported in order: waiting for
+ * the first stream's sub-buffer leaves most of the others already completed.
+ */
+static void release_zerocopy_subbuffers(
+		struct lttng_consumer_stream **local_stream, int nb_fd,
+		struct lttng_consumer_local_data *ctx)
+{
+	int i;
+
+	for (i = 0; i < nb_fd; i++) {
+		struct lttng_consumer_stream *stream = local_stream[i];
+
+		/* Only this thread puts sub-buffers in flight. */
+		if (!stream || !stream->zerocopy.in_flight) {
+			continue;
+		}
+
+		if (lttng_consumer_release_zerocopy_subbuffer(stream, ctx) < 0) {
+			/* Clean the stream and free it. */
+			consumer_del_stream(stream, data_ht);
+			local_stream[i] = NULL;
+		}
+	}
+}
+
 /*
  * This thread polls the fds in the set to consume the data and write
  * it to tracefile if necessary.
@@ -2551,11 +3124,16 @@ void *consumer_thread_data_poll(void *data)
 	struct lttng_consumer_stream **local_stream = NULL, *new_stream = NULL;
 	/* local view of consumer_data.fds_count */
 	int nb_fd = 0;
-	/* 2 for the consumer_data_pipe and wake up pipe */
+	/* 2 for the data pipe and wake up pipe */
 	const int nb_pipes_fd = 2;
 	/* Number of FDs with CONSUMER_ENDPOINT_INACTIVE but still open. */
 	int nb_inactive_fd = 0;
-	struct lttng_consumer_local_data *ctx = (lttng_consumer_local_data *) data;
+	struct lttng_consumer_data_thread *data_thread =
+			(lttng_consumer_data_thread *) data;
+	struct lttng_consumer_local_data *ctx = data_thread->ctx;
+	/* Generation of the data streams in the local view. */
+	unsigned long generation = 0;
+	bool local_view_valid = false;
 	ssize_t len;
 
 	rcu_register_thread();
@@ -2568,6 +3146,14 @@ void *consumer_thread_data_poll(void *data)
 
 	health_code_update();
 
+	/*
+	 * Binding to the node's CPUs is best effort: the streams are still
+	 * consumed if it fails.
+	 */
+	if (data_thread->numa_node >= 0) {
+		(void) consumer_numa_bind_current_thread(data_thread->numa_node);
+	}
+
 	local_stream = zmalloc<lttng_consumer_stream *>();
 	if (local_stream == NULL) {
 		PERROR("local_stream malloc");
@@ -2584,8 +3170,9 @@ void *consumer_thread_data_poll(void *data)
 		 * the fds set has been updated, we need to update our
 		 * local array as well
 		 */
-		pthread_mutex_lock(&the_consumer_data.lock);
-		if (the_consumer_data.need_update) {
+		pthread_mutex_lock(&data_thread->lock);
+		if (!local_view_valid ||
+				generation != data_thread->streams_generation) {
 			free(pollfd);
 			pollfd = NULL;
 
@@ -2593,31 +3180,32 @@ void *consumer_thread_data_poll(void *data)
 			local_stream = NULL;
 
 			/* Allocate for all fds */
-			pollfd = calloc<struct pollfd>(the_consumer_data.stream_count + nb_pipes_fd);
+			pollfd = calloc<struct pollfd>(data_thread->stream_count + nb_pipes_fd);
 			if (pollfd == NULL) {
 				PERROR("pollfd malloc");
-				pthread_mutex_unlock(&the_consumer_data.lock);
+				pthread_mutex_unlock(&data_thread->lock);
 				goto end;
 			}
 
-			local_stream = calloc<lttng_consumer_stream *>(the_consumer_data.stream_count + nb_pipes_fd);
+			local_stream = calloc<lttng_consumer_stream *>(data_thread->stream_count + nb_pipes_fd);
 			if (local_stream == NULL) {
 				PERROR("local_stream malloc");
-				pthread_mutex_unlock(&the_consumer_data.lock);
+				pthread_mutex_unlock(&data_thread->lock);
 				goto end;
 			}
-			ret = update_poll_array(ctx, &pollfd, local_stream,
+			ret = update_poll_array(data_thread, &pollfd, local_stream,
 					data_ht, &nb_inactive_fd);
 			if (ret < 0) {
 				ERR("Error in allocating pollfd or local_outfds");
 				lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_POLL_ERROR);
-				pthread_mutex_unlock(&the_consumer_data.lock);
+				pthread_mutex_unlock(&data_thread->lock);
 				goto end;
 			}
 			nb_fd = ret;
-			the_consumer_data.need_update = 0;
+			generation = data_thread->streams_generation;
+			local_view_valid = true;
 		}
-		pthread_mutex_unlock(&the_consumer_data.lock);
+		pthread_mutex_unlock(&data_thread->lock);
 
 		/* No FDs and consumer_quit, consumer_cleanup the thread */
 		if (nb_fd == 0 && nb_inactive_fd == 0 &&
@@ -2657,15 +3245,15 @@ void *consumer_thread_data_poll(void *data)
 		}
 
 		/*
-		 * If the consumer_data_pipe triggered poll go directly to the
+		 * If the data pipe triggered poll go directly to the
 		 * beginning of the loop to update the array. We want to prioritize
 		 * array update over low-priority reads.
 		 */
 		if (pollfd[nb_fd].revents & (POLLIN | POLLPRI)) {
 			ssize_t pipe_readlen;
 
-			DBG("consumer_data_pipe wake up");
-			pipe_readlen = lttng_pipe_read(ctx->consumer_data_pipe,
+			DBG("Data pipe wake up");
+			pipe_readlen = lttng_pipe_read(data_thread->data_pipe,
 					&new_stream, sizeof(new_stream));
 			if (pipe_readlen < sizeof(new_stream)) {
 				PERROR("Consumer data pipe");
@@ -2679,7 +3267,7 @@ void *consumer_thread_data_poll(void *data)
 			 * waking us up to test it.
 			 */
 			if (new_stream == NULL) {
-				validate_endpoint_status_data_stream();
+				validate_endpoint_status_data_stream(data_thread);
 				continue;
 			}
 
@@ -2692,13 +3280,13 @@ void *consumer_thread_data_poll(void *data)
 			char dummy;
 			ssize_t pipe_readlen;
 
-			pipe_readlen = lttng_pipe_read(ctx->consumer_wakeup_pipe, &dummy,
+			pipe_readlen = lttng_pipe_read(data_thread->wakeup_pipe, &dummy,
 					sizeof(dummy));
 			if (pipe_readlen < 0) {
 				PERROR("Consumer data wakeup pipe");
 			}
 			/* We've been awakened to handle stream(s). */
-			ctx->has_wakeup = 0;
+			data_thread->has_wakeup = 0;
 		}
 
 		/* Take care of high priority channels first. */
@@ -2723,6 +3311,8 @@ void *consumer_thread_data_poll(void *data)
 			}
 		}
 
+		release_zerocopy_subbuffers(local_stream, nb_fd, ctx);
+
 		/*
 		 * If we read high prio channel in this loop, try again
 		 * for more high prio data.
@@ -2754,6 +3344,8 @@ void *consumer_thread_data_poll(void *data)
 			}
 		}
 
+		release_zerocopy_subbuffers(local_stream, nb_fd, ctx);
+
 		/* Handle hangup and errors */
 		for (i = 0; i < nb_fd; i++) {
 			health_code_update();
@@ -2819,14 +3411,16 @@ end:
 	free(local_stream);
 
 	/*
-	 * Close the write side of the pipe so epoll_wait() in
-	 * consumer_thread_metadata_poll can catch it. The thread is monitoring the
-	 * read side of the pipe. If we close them both, epoll_wait strangely does
-	 * not return and could create a endless wait period if the pipe is the
-	 * only tracked fd in the poll set. The thread will take care of closing
-	 * the read side.
+	 * Once the last data thread exits, close the write side of the pipe so
+	 * epoll_wait() in consumer_thread_metadata_poll can catch it. The thread
+	 * is monitoring the read side of the pipe. If we close them both,
+	 * epoll_wait strangely does not return and could create a endless wait
+	 * period if the pipe is the only tracked fd in the poll set. The thread
+	 * will take care of closing the read side.
 	 */
-	(void) lttng_pipe_write_close(ctx->consumer_metadata_pipe);
+	if (uatomic_sub_return(&ctx->nb_running_data_threads, 1) == 0) {
+		(void) lttng_pipe_write_close(ctx->consumer_metadata_pipe);
+	}
 
 error_testpoint:
 	if (err) {
@@ -3329,10 +3923,10 @@ end:
 	CMM_STORE_SHARED(consumer_quit, 1);
 
 	/*
-	 * Notify the data poll thread to poll back again and test the
+	 * Notify the data poll threads to poll back again and test the
 	 * consumer_quit state that we just set so to quit gracefully.
 	 */
-	notify_thread_lttng_pipe(ctx->consumer_data_pipe);
+	notify_data_threads(ctx);
 
 	notify_channel_pipe(ctx, NULL, -1, CONSUMER_CHANNEL_QUIT);
 
@@ -3386,14 +3980,145 @@ end:
 	return ret;
 }
 
+/*
+ * Account for a sub-buffer that was just written out by the consumption
+ * callback of a stream.
+ *
+ * The producer to disk lag is derived from the packet's end timestamp. It is
+ * only meaningful with the default tracer clock (CLOCK_MONOTONIC, in ns); a
+ * timestamp in the future of the consumer's clock is ignored.
+ */
+static void update_stream_consumption_stats(struct lttng_consumer_stream *stream,
+		const struct stream_subbuffer *subbuffer, ssize_t written_bytes,
+		uint64_t consume_start_ns)
+{
+	struct lttng_consumer_stream_stats *stats = &stream->stats;
+	const uint64_t now_ns = consumer_get_monotonic_ns();
+	const uint64_t elapsed_ns = now_ns >= consume_start_ns ?
+			now_ns - consume_start_ns : 0;
+
+	consumer_stream_stats_add(&stats->subbuffers_consumed, 1);
+	consumer_stream_stats_add(&stats->bytes_written, written_bytes);
+
+	if (stream->net_seq_idx != (uint64_t) -1ULL) {
+		consumer_stream_stats_add(&stats->relayd_sends, 1);
+		consumer_stream_stats_add(&stats->relayd_send_time_ns, elapsed_ns);
+		consumer_stream_stats_max(&stats->relayd_send_max_ns, elapsed_ns);
+	} else {
+		consumer_stream_stats_add(&stats->write_time_ns, elapsed_ns);
+	}
+
+	if (!stream->metadata_flag && now_ns &&
+			subbuffer->info.data.timestamp_end <= now_ns) {
+		const uint64_t lag_ns =
+				now_ns - subbuffer->info.data.timestamp_end;
+
+		CMM_STORE_SHARED(stats->last_lag_ns, lag_ns);
+		consumer_stream_stats_max(&stats->max_lag_ns, lag_ns);
+	}
+}
+
+/*
+ * Hand a consumed sub-buffer back to the tracer, then run the post-consumption
+ * callbacks and the rotation of the stream, if it is ready.
+ *
+ * Returns 0 on success or a negative value on error.
+ */
+static int release_subbuffer(struct lttng_consumer_stream *stream,
+		struct stream_subbuffer *subbuffer,
+		struct lttng_consumer_local_data *ctx)
+{
+	int ret;
+
+	ret = stream->read_subbuffer_ops.put_next_subbuffer(stream, subbuffer);
+	if (ret) {
+		goto end;
+	}
+
+	ret = post_consume(stream, subbuffer, ctx);
+	if (ret) {
+		goto end;
+	}
+
+	/*
+	 * After extracting the packet, we check if the stream is now ready to
+	 * be rotated and perform the action immediately.
+	 */
+	ret = lttng_consumer_stream_is_rotate_ready(stream);
+	if (ret == 1) {
+		ret = lttng_consumer_rotate_stream(stream);
+		if (ret < 0) {
+			ERR("Stream rotation error after consuming data");
+			goto end;
+		}
+	} else if (ret < 0) {
+		ERR("Failed to check if stream was ready to rotate after consuming data");
+		goto end;
+	}
+
+	ret = 0;
+end:
+	return ret;
+}
+
+/*
+ * Release the sub-buffer of a stream left in flight by a zero-copy send once
+ * the kernel no longer uses its pages.
+ *
+ * If the relay daemon is gone or its data socket failed, nothing more will be
+ * sent from the sub-buffer and it is released right away.
+ *
+ * Must be called with the stream lock held.
+ */
+static int release_in_flight_subbuffer(struct lttng_consumer_stream *stream,
+		struct lttng_consumer_local_data *ctx)
+{
+	struct consumer_relayd_sock_pair *relayd;
+
+	if (!stream->zerocopy.in_flight) {
+		return 0;
+	}
+
+	rcu_read_lock();
+	relayd = consumer_find_relayd(stream->net_seq_idx);
+	if (relayd && lttcomm_wait_zerocopy_inet_sock(&relayd->data_sock.sock,
+			stream->zerocopy.release_at,
+			&relayd->data_sock_zerocopy.completed)) {
+		ERR("Relayd hangup. Cleaning up relayd %" PRIu64".",
+				relayd->net_seq_idx);
+		lttng_consumer_cleanup_relayd(relayd);
+	}
+	rcu_read_unlock();
+
+	stream->zerocopy.in_flight = false;
+	return release_subbuffer(stream, &stream->zerocopy.subbuffer, ctx);
+}
+
+int lttng_consumer_release_zerocopy_subbuffer(
+		struct lttng_consumer_stream *stream,
+		struct lttng_consumer_local_data *ctx)
+{
+	int ret;
+
+	stream->read_subbuffer_ops.lock(stream);
+	ret = release_in_flight_subbuffer(stream, ctx);
+	if (ret == 0 && stream->read_subbuffer_ops.on_sleep) {
+		stream->read_subbuffer_ops.on_sleep(stream, ctx);
+	}
+	stream->read_subbuffer_ops.unlock(stream);
+
+	return ret;
+}
+
 ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		struct lttng_consumer_local_data *ctx,
 		bool locked_by_caller)
 {
 	ssize_t ret, written_bytes = 0;
-	int rotation_ret;
 	struct stream_subbuffer subbuffer = {};
 	enum get_next_subbuffer_status get_next_status;
+	uint64_t consume_start_ns;
+	bool suppressed = false;
 
 	if (!locked_by_caller) {
 		stream->read_subbuffer_ops.lock(stream);
@@ -3401,6 +4126,12 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		stream->read_subbuffer_ops.assert_locked(stream);
 	}
 
+	/* A stream only holds one sub-buffer at a time. */
+	ret = release_in_flight_subbuffer(stream, ctx);
+	if (ret) {
+		goto end;
+	}
+
 	if (stream->read_subbuffer_ops.on_wake_up) {
 		ret = stream->read_subbuffer_ops.on_wake_up(stream);
 		if (ret) {
@@ -3443,43 +4174,52 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		goto error_put_subbuf;
 	}
 
-	written_bytes = stream->read_subbuffer_ops.consume_subbuffer(
-			ctx, stream, &subbuffer);
-	if (written_bytes <= 0) {
-		ERR("Error consuming subbuffer: (%zd)", written_bytes);
-		ret = (int) written_bytes;
-		goto error_put_subbuf;
+	if (stream->read_subbuffer_ops.suppress_subbuffer) {
+		ret = stream->read_subbuffer_ops.suppress_subbuffer(
+				stream, &subbuffer);
+		if (ret < 0) {
+			goto error_put_subbuf;
+		}
+
+		suppressed = ret == 1;
 	}
 
-	ret = stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
-	if (ret) {
-		goto end;
+	if (suppressed) {
+		/* Callers expect a positive value when a sub-buffer was read. */
+		written_bytes = subbuffer.info.data.padded_subbuf_size;
+	} else {
+		/*
+		 * The data thread releases the sub-buffers left in flight by
+		 * its streams (see release_zerocopy_subbuffers()).
+		 */
+		stream->zerocopy.can_defer = !stream->metadata_flag;
+		consume_start_ns = consumer_get_monotonic_ns();
+		written_bytes = stream->read_subbuffer_ops.consume_subbuffer(
+				ctx, stream, &subbuffer);
+		stream->zerocopy.can_defer = false;
+		if (written_bytes <= 0) {
+			ERR("Error consuming subbuffer: (%zd)", written_bytes);
+			ret = (int) written_bytes;
+			stream->zerocopy.in_flight = false;
+			goto error_put_subbuf;
+		}
+		update_stream_consumption_stats(stream, &subbuffer,
+				written_bytes, consume_start_ns);
 	}
 
-	ret = post_consume(stream, &subbuffer, ctx);
-	if (ret) {
+	if (stream->zerocopy.in_flight) {
+		/*
+		 * Released by lttng_consumer_release_zerocopy_subbuffer() so
+		 * that the data thread sends the sub-buffers of other streams
+		 * while the kernel transmits this one.
+		 */
+		stream->zerocopy.subbuffer = subbuffer;
+		ret = written_bytes;
 		goto end;
 	}
 
-	/*
-	 * After extracting the packet, we check if the stream is now ready to
-	 * be rotated and perform the action immediately.
-	 *
-	 * Don't overwrite `ret` as callers expect the number of bytes
-	 * consumed to be returned on success.
-	 */
-	rotation_ret = lttng_consumer_stream_is_rotate_ready(stream);
-	if (rotation_ret == 1) {
-		rotation_ret = lttng_consumer_rotate_stream(stream);
-		if (rotation_ret < 0) {
-			ret = rotation_ret;
-			ERR("Stream rotation error after consuming data");
-			goto end;
-		}
-
-	} else if (rotation_ret < 0) {
-		ret = rotation_ret;
-		ERR("Failed to check if stream was ready to rotate after consuming data");
+	ret = release_subbuffer(stream, &subbuffer, ctx);
+	if (ret) {
 		goto end;
 	}
 
@@ -3520,6 +4260,8 @@ int lttng_consumer_on_recv_stream(struct lttng_consumer_stream *stream)
  */
 int lttng_consumer_init(void)
 {
+	const char *value;
+
 	the_consumer_data.channel_ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
 	if (!the_consumer_data.channel_ht) {
 		goto error;
@@ -3562,6 +4304,56 @@ int lttng_consumer_init(void)
 		goto error;
 	}
 
+	value = lttng_secure_getenv(DEFAULT_LTTNG_CONSUMERD_NETWORK_ZEROCOPY_ENV);
+	if (value) {
+		const int parse_ret = config_parse_value(value);
+
+		if (parse_ret < 0 || parse_ret > 1) {
+			ERR("Invalid value for %s",
+					DEFAULT_LTTNG_CONSUMERD_NETWORK_ZEROCOPY_ENV);
+			goto error;
+		}
+		network_zerocopy = parse_ret;
+	}
+	DBG("Network zero-copy transmission %s",
+			network_zerocopy ? "enabled" : "disabled");
+
+	value = lttng_secure_getenv(DEFAULT_LTTNG_CONSUMERD_SNAPSHOT_WORKERS_ENV);
+	if (value) {
+		char *end;
+		unsigned long count;
+
+		errno = 0;
+		count = strtoul(value, &end, 10);
+		if (errno || end == value || *end != '\0' || count == 0 ||
+				count > UINT_MAX) {
+			ERR("Invalid value for %s",
+					DEFAULT_LTTNG_CONSUMERD_SNAPSHOT_WORKERS_ENV);
+			goto error;
+		}
+		snapshot_worker_count = (unsigned int) count;
+	}
+	DBG("Snapshot worker count: %u", snapshot_worker_count);
+
+	value = lttng_secure_getenv(DEFAULT_LTTNG_CONSUMERD_NUMA_AFFINITY_ENV);
+	if (value) {
+		const int parse_ret = config_parse_value(value);
+
+		if (parse_ret < 0 || parse_ret > 1) {
+			ERR("Invalid value for %s",
+					DEFAULT_LTTNG_CONSUMERD_NUMA_AFFINITY_ENV);
+			goto error;
+		}
+		numa_affinity = parse_ret;
+	}
+
+	if (numa_affinity && consumer_numa_init()) {
+		WARN("Failed to read the NUMA topology, using a single data thread");
+		numa_affinity = false;
+	}
+	DBG("NUMA-affine data stream consumption %s",
+			numa_affinity ? "enabled" : "disabled");
+
 	return 0;
 
 error:
@@ -3679,6 +4471,16 @@ void consumer_add_relayd_socket(uint64_t net_seq_idx,
 		/* Assign version values. */
 		relayd->data_sock.major = relayd_version_major;
 		relayd->data_sock.minor = relayd_version_minor;
+
+		if (ret == 0 && network_zerocopy) {
+			relayd->data_sock_zerocopy.enabled =
+					!lttcomm_enable_zerocopy_inet_sock(
+							&relayd->data_sock.sock);
+			if (!relayd->data_sock_zerocopy.enabled) {
+				WARN("Zero-copy transmission unavailable on relayd data socket, using regular sends (net idx: %" PRIu64 ")",
+						relayd->net_seq_idx);
+			}
+		}
 		break;
 	default:
 		ERR("Unknown relayd socket type (%d)", sock_type);
@@ -3772,6 +4574,12 @@ found:
  * Check if for a given session id there is still data needed to be extract
  * from the buffers.
  *
+ * This is polled repeatedly by the session daemon while a session is being
+ * stopped or destroyed, so it must not slow down consumption: it doesn't take
+ * the consumer data lock, and a stream which is locked by another thread
+ * (typically, a thread consuming it) is reported as having pending data
+ * instead of being waited for.
+ *
  * Return 1 if data is pending or else 0 meaning ready to be read.
  */
 int consumer_data_pending(uint64_t id)
@@ -3786,7 +4594,6 @@ int consumer_data_pending(uint64_t id)
 	DBG("Consumer data pending command on session id %" PRIu64, id);
 
 	rcu_read_lock();
-	pthread_mutex_lock(&the_consumer_data.lock);
 
 	switch (the_consumer_data.type) {
 	case LTTNG_CONSUMER_KERNEL:
@@ -3808,7 +4615,23 @@ int consumer_data_pending(uint64_t id)
 			ht->hash_fct(&id, lttng_ht_seed),
 			ht->match_fct, &id,
 			&iter.iter, stream, node_session_id.node) {
-		pthread_mutex_lock(&stream->lock);
+		/*
+		 * Trade-off: a busy stream is reported as pending even if its
+		 * buffers are about to be empty. Under a sustained load, a
+		 * stream of the session is almost always being consumed, so
+		 * stop and destroy commands can take more polling rounds
+		 * (DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US each, in
+		 * liblttng-ctl) to report that the data is available.
+		 */
+		ret = pthread_mutex_trylock(&stream->lock);
+		if (ret == EBUSY) {
+			DBG("Stream %" PRIu64 " is busy, reporting pending data",
+					stream->key);
+			goto data_pending;
+		} else if (ret) {
+			ERR("Unexpected pthread_mutex_trylock error %d", ret);
+			goto data_pending;
+		}
 
 		/*
 		 * A removed node from the hash table indicates that the stream has
@@ -3817,7 +4640,11 @@ int consumer_data_pending(uint64_t id)
 		 * over the network so don't skip the relayd check.
 		 */
 		ret = cds_lfht_is_node_deleted(&stream->node.node);
-		if (!ret) {
+		if (!ret && stream->zerocopy.in_flight) {
+			/* The held sub-buffer must not be taken again. */
+			pthread_mutex_unlock(&stream->lock);
+			goto data_pending;
+		} else if (!ret) {
 			/* Check the stream if there is data in the buffers. */
 			ret = data_pending(stream);
 			if (ret == 1) {
@@ -3834,11 +4661,11 @@ int consumer_data_pending(uint64_t id)
 		unsigned int is_data_inflight = 0;
 
 		/* Send init command for data pending. */
-		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_lock(relayd);
 		ret = relayd_begin_data_pending(&relayd->control_sock,
 				relayd->relayd_session_id);
 		if (ret < 0) {
-			pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_unlock(relayd);
 			/* Communication error thus the relayd so no data pending. */
 			goto data_not_pending;
 		}
@@ -3857,12 +4684,12 @@ int consumer_data_pending(uint64_t id)
 			}
 
 			if (ret == 1) {
-				pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+				consumer_relayd_ctrl_unlock(relayd);
 				goto data_pending;
 			} else if (ret < 0) {
 				ERR("Relayd data pending failed. Cleaning up relayd %" PRIu64".", relayd->net_seq_idx);
 				lttng_consumer_cleanup_relayd(relayd);
-				pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+				consumer_relayd_ctrl_unlock(relayd);
 				goto data_not_pending;
 			}
 		}
@@ -3870,7 +4697,7 @@ int consumer_data_pending(uint64_t id)
 		/* Send end command for data pending. */
 		ret = relayd_end_data_pending(&relayd->control_sock,
 				relayd->relayd_session_id, &is_data_inflight);
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_unlock(relayd);
 		if (ret < 0) {
 			ERR("Relayd end data pending failed. Cleaning up relayd %" PRIu64".", relayd->net_seq_idx);
 			lttng_consumer_cleanup_relayd(relayd);
@@ -3889,13 +4716,11 @@ int consumer_data_pending(uint64_t id)
 
 data_not_pending:
 	/* Data is available to be read by a viewer. */
-	pthread_mutex_unlock(&the_consumer_data.lock);
 	rcu_read_unlock();
 	return 0;
 
 data_pending:
 	/* Data is still being extracted from buffers. */
-	pthread_mutex_unlock(&the_consumer_data.lock);
 	rcu_read_unlock();
 	return 1;
 }
@@ -3939,6 +4764,14 @@ int consumer_send_status_channel(int sock,
 	return lttcomm_send_unix_sock(sock, &msg, sizeof(msg));
 }
 
+/*
+ * Maximal number of streams of a channel recorded concurrently by a snapshot.
+ */
+unsigned int consumer_get_snapshot_worker_count(void)
+{
+	return snapshot_worker_count;
+}
+
 unsigned long consumer_get_consume_start_pos(unsigned long consumed_pos,
 		unsigned long produced_pos, uint64_t nb_packets_per_stream,
 		uint64_t max_sb_size)
@@ -3993,6 +4826,16 @@ end:
  * replied to the session daemon that we have finished sampling the positions.
  * Must be called with RCU read-side lock held to ensure existence of channel.
  *
+ * The streams of a local trace keep being consumed while their positions are
+ * sampled: only the lock of the stream being sampled is held. Each stream
+ * keeps writing to the current trace chunk until it reaches its rotate
+ * position.
+ *
+ * The channel lock is held for the whole sampling when the channel is
+ * streamed to a relay daemon. No packet beyond a rotate position may reach
+ * the relay daemon before the rotate positions since it would index it in the
+ * previous trace chunk.
+ *
  * Returns 0 on success, < 0 on error
  */
 int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
@@ -4006,6 +4849,8 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 	uint64_t next_chunk_id, stream_count = 0;
 	enum lttng_trace_chunk_status chunk_status;
 	const bool is_local_trace = relayd_id == -1ULL;
+	const struct lttng_trace_chunk *channel_trace_chunk;
+	bool channel_locked;
 	struct consumer_relayd_sock_pair *relayd = NULL;
 	bool rotating_to_new_chunk = true;
 	/* Array of `struct lttng_consumer_stream *` */
@@ -4023,6 +4868,7 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 	rcu_read_lock();
 
 	pthread_mutex_lock(&channel->lock);
+	channel_locked = true;
 	LTTNG_ASSERT(channel->trace_chunk);
 	chunk_status = lttng_trace_chunk_get_id(channel->trace_chunk,
 			&next_chunk_id);
@@ -4031,6 +4877,16 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 		goto end_unlock_channel;
 	}
 
+	/*
+	 * The channel's trace chunk is only changed by the commands of the
+	 * session daemon, which are handled by this thread.
+	 */
+	channel_trace_chunk = channel->trace_chunk;
+	if (is_local_trace) {
+		pthread_mutex_unlock(&channel->lock);
+		channel_locked = false;
+	}
+
 	cds_lfht_for_each_entry_duplicate(ht->ht,
 			ht->hash_fct(&channel->key, lttng_ht_seed),
 			ht->match_fct, &channel->key, &iter.iter,
@@ -4044,7 +4900,16 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 		 */
 		pthread_mutex_lock(&stream->lock);
 
-		if (stream->trace_chunk == stream->chan->trace_chunk) {
+		/*
+		 * Without the channel lock, the stream may have been deleted
+		 * since the lookup.
+		 */
+		if (consumer_stream_is_deleted(stream)) {
+			pthread_mutex_unlock(&stream->lock);
+			continue;
+		}
+
+		if (stream->trace_chunk == channel_trace_chunk) {
 			rotating_to_new_chunk = false;
 		}
 
@@ -4300,19 +5165,23 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 			goto end_unlock_channel;
 		}
 
-		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_lock(relayd);
 		ret = relayd_rotate_streams(&relayd->control_sock, stream_count,
 				rotating_to_new_chunk ? &next_chunk_id : NULL,
 				(const struct relayd_stream_rotation_position *)
 						stream_rotation_positions.buffer
 								.data);
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		consumer_relayd_ctrl_unlock(relayd);
 		if (ret < 0) {
 			ERR("Relayd rotate stream failed. Cleaning up relayd %" PRIu64,
 					relayd->net_seq_idx);
 			lttng_consumer_cleanup_relayd(relayd);
 			goto end_unlock_channel;
 		}
+
+		/* The relay daemon knows the rotate positions; resume consumption. */
+		pthread_mutex_unlock(&channel->lock);
+		channel_locked = false;
 	}
 
 	for (stream_idx = 0;
@@ -4325,6 +5194,11 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 				&streams_packet_to_open, stream_idx);
 
 		pthread_mutex_lock(&stream->lock);
+		if (consumer_stream_is_deleted(stream)) {
+			pthread_mutex_unlock(&stream->lock);
+			continue;
+		}
+
 		status = consumer_stream_open_packet(stream);
 		pthread_mutex_unlock(&stream->lock);
 		switch (status) {
@@ -4354,15 +5228,15 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 		}
 	}
 
-	pthread_mutex_unlock(&channel->lock);
 	ret = 0;
-	goto end;
+	goto end_unlock_channel;
 
 end_unlock_stream:
 	pthread_mutex_unlock(&stream->lock);
 end_unlock_channel:
-	pthread_mutex_unlock(&channel->lock);
-end:
+	if (channel_locked) {
+		pthread_mutex_unlock(&channel->lock);
+	}
 	rcu_read_unlock();
 	lttng_dynamic_array_reset(&stream_rotation_positions);
 	lttng_dynamic_pointer_array_reset(&streams_packet_to_open);
@@ -4591,6 +5465,15 @@ int lttng_consumer_rotate_stream(struct lttng_consumer_stream *stream)
 
 	DBG("Consumer rotate stream %" PRIu64, stream->key);
 
+	/* The last suppressed packet belongs to the current trace chunk. */
+	ret = consumer_stream_write_suppressed_packet(stream);
+	if (ret) {
+		ERR("Failed to write the last suppressed packet of stream %" PRIu64,
+				stream->key);
+		goto error;
+	}
+	stream->empty_packets.wrote_packet_in_current_trace_chunk = false;
+
 	/*
 	 * Update the stream's 'current' chunk to the session's (channel)
 	 * now-current chunk.
@@ -4882,10 +5765,10 @@ enum lttcomm_return_code lttng_consumer_create_trace_chunk(
 
 		relayd = consumer_find_relayd(*relayd_id);
 		if (relayd) {
-			pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_lock(relayd);
 			ret = relayd_create_trace_chunk(
 					&relayd->control_sock, published_chunk);
-			pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_unlock(relayd);
 		} else {
 			ERR("Failed to find relay daemon socket: relayd_id = %" PRIu64, *relayd_id);
 		}
@@ -5018,11 +5901,11 @@ enum lttcomm_return_code lttng_consumer_close_trace_chunk(
 
 		relayd = consumer_find_relayd(*relayd_id);
 		if (relayd) {
-			pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_lock(relayd);
 			ret = relayd_close_trace_chunk(
 					&relayd->control_sock, chunk,
 					path);
-			pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+			consumer_relayd_ctrl_unlock(relayd);
 		} else {
 			ERR("Failed to find relay daemon socket: relayd_id = %" PRIu64,
 					*relayd_id);
@@ -5099,10 +5982,10 @@ enum lttcomm_return_code lttng_consumer_trace_chunk_exists(
 		goto end_rcu_unlock;
 	}
 	DBG("Looking up existence of trace chunk on relay daemon");
-	pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+	consumer_relayd_ctrl_lock(relayd);
 	ret = relayd_trace_chunk_exists(&relayd->control_sock, chunk_id,
 			&chunk_exists_remote);
-	pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+	consumer_relayd_ctrl_unlock(relayd);
 	if (ret < 0) {
 		ERR("Failed to look-up the existence of trace chunk on relay daemon");
 		ret_code = LTTCOMM_CONSUMERD_RELAYD_FAIL;
@@ -5256,3 +6139,106 @@ void lttng_consumer_sigbus_handle(void *addr)
 {
 	lttng_ustconsumer_sigbus_handle(addr);
 }
+
+/*
+ * Sample the consumption statistics of all the streams of a session and send
+ * them on the session daemon command socket `sock`: a uint64_t stream count
+ * followed by that many struct lttcomm_consumer_stream_stats.
+ *
+ * The statistics are read without taking the stream locks; a stream being
+ * consumed concurrently may report counters that are one sub-buffer apart.
+ *
+ * Return 0 on success or else a negative value if the reply could not be sent.
+ */
+int lttng_consumer_send_stream_stats(int sock, uint64_t session_id)
+{
+	int ret;
+	ssize_t ret_send;
+	uint64_t count;
+	struct lttng_consumer_stream *stream;
+	struct lttng_ht_iter iter;
+	struct lttng_ht *ht = the_consumer_data.stream_list_ht;
+	struct lttng_dynamic_array stats;
+
+	DBG("Consumer stream statistics command for session id %" PRIu64,
+			session_id);
+
+	lttng_dynamic_array_init(&stats,
+			sizeof(struct lttcomm_consumer_stream_stats), NULL);
+
+	rcu_read_lock();
+	cds_lfht_for_each_entry_duplicate(ht->ht,
+			ht->hash_fct(&session_id, lttng_ht_seed),
+			ht->match_fct, &session_id,
+			&iter.iter, stream, node_session_id.node) {
+		struct lttcomm_consumer_stream_stats entry;
+
+		memset(&entry, 0, sizeof(entry));
+
+		/*
+		 * The stream's channel is only stable while the stream is
+		 * locked and not deleted.
+		 */
+		pthread_mutex_lock(&stream->lock);
+		if (consumer_stream_is_deleted(stream)) {
+			pthread_mutex_unlock(&stream->lock);
+			continue;
+		}
+		if (lttng_strncpy(entry.channel_name, stream->chan->name,
+				sizeof(entry.channel_name)) ||
+				lttng_strncpy(entry.stream_name, stream->name,
+						sizeof(entry.stream_name))) {
+			ERR("Stream name of stream %" PRIu64 " is too long",
+					stream->key);
+			pthread_mutex_unlock(&stream->lock);
+			continue;
+		}
+		entry.channel_key = stream->chan->key;
+		pthread_mutex_unlock(&stream->lock);
+		entry.stream_key = stream->key;
+		entry.metadata = !!stream->metadata_flag;
+		entry.subbuffers_consumed =
+				CMM_LOAD_SHARED(stream->stats.subbuffers_consumed);
+		entry.bytes_written = CMM_LOAD_SHARED(stream->stats.bytes_written);
+		entry.write_syscalls = CMM_LOAD_SHARED(stream->stats.write_syscalls);
+		entry.write_time_ns = CMM_LOAD_SHARED(stream->stats.write_time_ns);
+		entry.relayd_sends = CMM_LOAD_SHARED(stream->stats.relayd_sends);
+		entry.relayd_send_time_ns =
+				CMM_LOAD_SHARED(stream->stats.relayd_send_time_ns);
+		entry.relayd_send_max_ns =
+				CMM_LOAD_SHARED(stream->stats.relayd_send_max_ns);
+		entry.last_lag_ns = CMM_LOAD_SHARED(stream->stats.last_lag_ns);
+		entry.max_lag_ns = CMM_LOAD_SHARED(stream->stats.max_lag_ns);
+
+		if (lttng_dynamic_array_add_element(&stats, &entry)) {
+			ERR("Failed to allocate stream statistics entry");
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	health_code_update();
+
+	count = (uint64_t) lttng_dynamic_array_get_count(&stats);
+	ret_send = lttcomm_send_unix_sock(sock, &count, sizeof(count));
+	if (ret_send < 0) {
+		PERROR("send stream statistics count");
+		ret = -1;
+		goto end;
+	}
+
+	if (count) {
+		ret_send = lttcomm_send_unix_sock(sock, stats.buffer.data,
+				stats.buffer.size);
+		if (ret_send < 0) {
+			PERROR("send stream statistics");
+			ret = -1;
+			goto end;
+		}
+	}
+
+	ret = 0;
+end:
+	lttng_dynamic_array_reset(&stats);
+	return ret;
+}
@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <urcu/list.h>
+#include <urcu/wfcqueue.h>
 
 #include <lttng/lttng.h>
 
@@ -29,6 +30,9 @@
 #include <common/credentials.hpp>
 #include <common/buffer-view.hpp>
 #include <common/dynamic-array.hpp>
+#include <common/dynamic-buffer.hpp>
+#include <common/index/packet-compression.hpp>
+#include <common/timer-wheel.hpp>
 
 struct lttng_consumer_local_data;
 
@@ -67,6 +71,7 @@ enum lttng_consumer_command {
 	LTTNG_CONSUMER_TRACE_CHUNK_EXISTS,
 	LTTNG_CONSUMER_CLEAR_CHANNEL,
 	LTTNG_CONSUMER_OPEN_CHANNEL_PACKETS,
+	LTTNG_CONSUMER_GET_STREAM_STATS,
 };
 
 enum lttng_consumer_type {
@@ -156,6 +161,10 @@ struct lttng_consumer_channel {
 	unsigned int nb_init_stream_left;
 	/* Output type (mmap or splice). */
 	enum consumer_channel_output output;
+	/* Compression of the packets written to local trace files. */
+	enum lttng_channel_compression compression;
+	/* Don't write out the packets containing no event record. */
+	bool suppress_empty_packets;
 	/* Channel type for stream */
 	enum consumer_channel_type type;
 
@@ -187,19 +196,19 @@ struct lttng_consumer_channel {
 
 	/* For UST metadata periodical flush */
 	int switch_timer_enabled;
-	timer_t switch_timer;
+	struct timer_wheel_entry switch_timer;
 	int switch_timer_error;
 
 	/* For the live mode */
 	int live_timer_enabled;
-	timer_t live_timer;
+	struct timer_wheel_entry live_timer;
 	int live_timer_error;
 	/* Channel is part of a live session ? */
 	bool is_live;
 
 	/* For channel monitoring timer. */
 	int monitor_timer_enabled;
-	timer_t monitor_timer;
+	struct timer_wheel_entry monitor_timer;
 
 	/* On-disk circular buffer */
 	uint64_t tracefile_size;
@@ -256,6 +265,35 @@ struct lttng_consumer_channel {
 	uint64_t last_consumed_size_sample_sent;
 };
 
+/*
+ * Consumption statistics of a stream.
+ *
+ * The counters are only modified by the thread consuming the stream, with the
+ * stream lock held, and are sampled without locking when the session daemon
+ * queries them (see consumer_stream_stats_add()).
+ */
+struct lttng_consumer_stream_stats {
+	/* Number of sub-buffers extracted from the ring buffer. */
+	uint64_t subbuffers_consumed;
+	/* Bytes written to the output (file or relayd). */
+	uint64_t bytes_written;
+	/* Number of write/splice system calls issued on the output. */
+	uint64_t write_syscalls;
+	/* Time spent writing sub-buffers to a local output. */
+	uint64_t write_time_ns;
+	/* Number of sub-buffers sent to a relay daemon. */
+	uint64_t relayd_sends;
+	/* Total and worst time spent sending a sub-buffer to a relay daemon. */
+	uint64_t relayd_send_time_ns;
+	uint64_t relayd_send_max_ns;
+	/*
+	 * Delay between the end of the last consumed packet, as recorded by
+	 * the tracer, and the moment it was written out (latest and worst).
+	 */
+	uint64_t last_lag_ns;
+	uint64_t max_lag_ns;
+};
+
 struct stream_subbuffer {
 	union {
 		/*
@@ -349,6 +387,16 @@ typedef int (*extract_subbuffer_info_cb)(
 typedef int (*pre_consume_subbuffer_cb)(struct lttng_consumer_stream *,
 		const struct stream_subbuffer *);
 
+/*
+ * Decide whether a sub-buffer is consumed or dropped. Returns 1 if the
+ * sub-buffer must not be consumed, 0 if it must be consumed, and a negative
+ * value on error.
+ *
+ * Stream and channel locks are acquired during this call.
+ */
+typedef int (*suppress_subbuffer_cb)(struct lttng_consumer_stream *,
+		const struct stream_subbuffer *);
+
 /*
  * Consume subbuffer contents.
  *
@@ -549,6 +597,7 @@ struct lttng_consumer_stream {
 	 * This is nested INSIDE the channel lock.
 	 * This is nested INSIDE the channel timer lock.
 	 * This is nested OUTSIDE the metadata cache lock.
+	 * This is nested OUTSIDE the data thread lock.
 	 * This is nested OUTSIDE consumer_relayd_sock_pair lock.
 	 */
 	pthread_mutex_t lock;
@@ -563,6 +612,13 @@ struct lttng_consumer_stream {
 	enum consumer_endpoint_status endpoint_status;
 	/* Stream name. Format is: <channel_name>_<cpu_number> */
 	char name[LTTNG_SYMBOL_NAME_LEN];
+	/* CPU of the per-CPU ring buffer of this stream. */
+	int cpu;
+	/*
+	 * Data thread consuming this stream. Set when the stream is added to
+	 * the data stream hash table and never changed afterwards.
+	 */
+	struct lttng_consumer_data_thread *data_thread;
 	/* Internal state of libustctl. */
 	struct lttng_ust_ctl_consumer_stream *ustream;
 	/* On-disk circular buffer */
@@ -597,6 +653,11 @@ struct lttng_consumer_stream {
 	uint64_t last_discarded_events;
 	/* Copy of the sequence number of the last packet extracted. */
 	uint64_t last_sequence_number;
+	/*
+	 * Produced position up to which the last snapshot recorded the stream.
+	 * Incremental snapshots start from there.
+	 */
+	LTTNG_OPTIONAL(unsigned long) last_snapshot_produced_pos;
 	/*
 	 * Index file object of the index file for this stream.
 	 */
@@ -658,6 +719,8 @@ struct lttng_consumer_stream {
 		extract_subbuffer_info_cb extract_subbuffer_info;
 		pre_consume_subbuffer_cb pre_consume_subbuffer;
 		reset_metadata_cb reset_metadata;
+		/* Only set when the channel suppresses its empty packets. */
+		suppress_subbuffer_cb suppress_subbuffer;
 		consume_subbuffer_cb consume_subbuffer;
 		put_next_subbuffer_cb put_next_subbuffer;
 		struct lttng_dynamic_array post_consume_cbs;
@@ -667,6 +730,41 @@ struct lttng_consumer_stream {
 		assert_locked_cb assert_locked;
 	} read_subbuffer_ops;
 	struct metadata_bucket *metadata_bucket;
+	struct lttng_consumer_stream_stats stats;
+	/*
+	 * Compressor of the packets written to the local trace file. Allocated
+	 * on the first packet when the channel is compressed.
+	 */
+	struct lttng_packet_compressor *compressor;
+	/* Size, in the trace file, of the last compressed packet. */
+	uint64_t compressed_packet_size;
+	/* See consumer_stream_suppress_empty_packet(). */
+	struct {
+		/* A packet was written out during the current trace chunk. */
+		bool wrote_packet_in_current_trace_chunk;
+		/* The sub-buffer being consumed is suppressed. */
+		bool suppressing;
+		/*
+		 * Last suppressed packet, if no packet was written out since.
+		 * `content` holds its header and context.
+		 */
+		bool has_pending;
+		struct stream_subbuffer pending;
+		struct lttng_dynamic_buffer content;
+	} empty_packets;
+	/*
+	 * Sub-buffer sent to the relay daemon with MSG_ZEROCOPY and not yet
+	 * handed back to the tracer as the kernel may still use its pages.
+	 * Protected by the stream lock.
+	 */
+	struct {
+		/* The data thread may release the consumed sub-buffer later. */
+		bool can_defer;
+		bool in_flight;
+		/* Value of the data socket's send counter to wait for. */
+		uint32_t release_at;
+		struct stream_subbuffer subbuffer;
+	} zerocopy;
 };
 
 /*
@@ -691,11 +789,23 @@ struct consumer_relayd_sock_pair {
 	 * over that socket, at least two sendmsg() are needed (header + data)
 	 * creating a race for packets to overlap between threads using it.
 	 *
+	 * Taken with consumer_relayd_ctrl_lock() and released with
+	 * consumer_relayd_ctrl_unlock(), never directly.
+	 *
 	 * This is nested INSIDE the consumer_data lock.
 	 * This is nested INSIDE the stream lock.
 	 */
 	pthread_mutex_t ctrl_sock_mutex;
 
+	/*
+	 * Index commands waiting to be sent on the control socket, as
+	 * consumer_relayd_index_msg. Producers enqueue without taking the control
+	 * socket mutex; whichever thread holds the mutex sends them, in order,
+	 * before using the socket itself.
+	 */
+	struct cds_wfcq_head index_queue_head;
+	struct cds_wfcq_tail index_queue_tail;
+
 	/* Control socket. Command and metadata are passed over it */
 	struct lttcomm_relayd_sock control_sock;
 
@@ -705,12 +815,89 @@ struct consumer_relayd_sock_pair {
 	 * this socket is for now only used in a single thread.
 	 */
 	struct lttcomm_relayd_sock data_sock;
+	/*
+	 * Zero-copy (MSG_ZEROCOPY) transmission state of the data socket. Same
+	 * access rules as the data socket itself.
+	 */
+	struct {
+		bool enabled;
+		/* Number of zero-copy sends issued on the data socket. */
+		uint32_t sent;
+		/* Number of zero-copy sends whose pages were released. */
+		uint32_t completed;
+	} data_sock_zerocopy;
 	struct lttng_ht_node_u64 node;
 
 	/* Session id on both sides for the sockets. */
 	uint64_t relayd_session_id;
 	uint64_t sessiond_session_id;
 	struct lttng_consumer_local_data *ctx;
+
+	/*
+	 * Live viewer status of the session, as last reported by the relay
+	 * daemon. Protected by the control socket mutex.
+	 */
+	struct {
+		bool viewer_attached;
+		/* CLOCK_MONOTONIC time of the last query, 0 if never queried. */
+		uint64_t timestamp_ns;
+	} viewer_status;
+};
+
+/*
+ * Index command queued on a relayd control socket.
+ */
+struct consumer_relayd_index_msg {
+	struct ctf_packet_index index;
+	uint64_t relay_stream_id;
+	uint64_t net_seq_num;
+	struct cds_wfcq_node node;
+};
+
+/*
+ * Data stream poll thread.
+ *
+ * The consumer daemon runs one data thread per NUMA node, bound to the CPUs of
+ * that node, so that the per-CPU ring buffers are read by a thread local to the
+ * memory they live in. Streams of an unknown node and streams sent to a relay
+ * daemon, which share the relay daemon's data socket, are consumed by the
+ * first data thread.
+ */
+struct lttng_consumer_data_thread {
+	struct lttng_consumer_local_data *ctx;
+	/* Index of the NUMA node to which the thread is bound, -1 if unbound. */
+	int numa_node;
+	pthread_t thread;
+	/* Data stream poll thread pipe. To transfer data stream to the thread */
+	struct lttng_pipe *data_pipe;
+	/*
+	 * The thread uses that pipe to catch wakeup from read subbuffer that
+	 * detects that there is still data to be read for the stream encountered.
+	 * Before doing so, the stream is flagged to indicate that there is still
+	 * data to be read.
+	 *
+	 * Both pipes (read/write) are owned and used inside the data thread.
+	 */
+	struct lttng_pipe *wakeup_pipe;
+	/* Indicate if the wakeup thread has been notified. */
+	unsigned int has_wakeup:1;
+
+	/*
+	 * Protects the insertion and removal of the thread's streams in the data
+	 * stream hash table, along with the following fields, so that the thread
+	 * gets a coherent view of its streams when it rebuilds its poll set.
+	 *
+	 * This is nested INSIDE the stream lock.
+	 */
+	pthread_mutex_t lock;
+	/* Number of streams of the data stream hash table consumed by the thread. */
+	unsigned int stream_count;
+	/*
+	 * Incremented every time the set of streams of the thread changes, so
+	 * that the thread knows its local array of FDs needs update in the poll
+	 * function.
+	 */
+	unsigned long streams_generation;
 };
 
 /*
@@ -777,20 +964,11 @@ struct lttng_consumer_local_data {
 	char *consumer_command_sock_path;
 	/* communication with splice */
 	int consumer_channel_pipe[2];
-	/* Data stream poll thread pipe. To transfer data stream to the thread */
-	struct lttng_pipe *consumer_data_pipe;
-
-	/*
-	 * Data thread use that pipe to catch wakeup from read subbuffer that
-	 * detects that there is still data to be read for the stream encountered.
-	 * Before doing so, the stream is flagged to indicate that there is still
-	 * data to be read.
-	 *
-	 * Both pipes (read/write) are owned and used inside the data thread.
-	 */
-	struct lttng_pipe *consumer_wakeup_pipe;
-	/* Indicate if the wakeup thread has been notified. */
-	unsigned int has_wakeup:1;
+	/* Data stream poll threads; see lttng_consumer_data_thread. */
+	struct lttng_consumer_data_thread *data_threads;
+	unsigned int nb_data_threads;
+	/* Number of data threads which have not exited yet. */
+	unsigned int nb_running_data_threads;
 
 	/* to let the signal handler wake up the fd receiver thread */
 	int consumer_should_quit[2];
@@ -809,30 +987,21 @@ struct lttng_consumer_local_data {
  */
 struct lttng_consumer_global_data {
 	/*
-	 * At this time, this lock is used to ensure coherence between the count
-	 * and number of element in the hash table. It's also a protection for
-	 * concurrent read/write between threads.
+	 * Serializes the publication of channels, whose key may be stolen from
+	 * a stale channel. The stream and channel teardown paths don't take it:
+	 * the hash tables below are RCU-protected, streams and channels are
+	 * protected by their own lock, and each data thread tracks its own
+	 * streams under its lock.
 	 *
 	 * This is nested OUTSIDE the stream lock.
 	 * This is nested OUTSIDE the consumer_relayd_sock_pair lock.
 	 */
 	pthread_mutex_t lock {};
 
-	/*
-	 * Number of streams in the data stream hash table declared outside.
-	 * Protected by consumer_data.lock.
-	 */
-	int stream_count = 0;
-
-	/* Channel hash table protected by consumer_data.lock. */
+	/* Channel hash table. */
 	struct lttng_ht *channel_ht = nullptr;
 	/* Channel hash table indexed by session id. */
 	struct lttng_ht *channels_by_session_id_ht = nullptr;
-	/*
-	 * Flag specifying if the local array of FDs needs update in the
-	 * poll function. Protected by consumer_data.lock.
-	 */
-	unsigned int need_update = 1;
 	enum lttng_consumer_type type = LTTNG_CONSUMER_UNKNOWN;
 
 	/*
@@ -1009,6 +1178,10 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 		struct lttng_consumer_local_data *ctx,
 		struct lttng_consumer_stream *stream, unsigned long len,
 		unsigned long padding);
+ssize_t lttng_consumer_on_read_subbuffer_vmsplice(
+		struct lttng_consumer_local_data *ctx,
+		struct lttng_consumer_stream *stream,
+		const struct lttng_buffer_view *buffer);
 int lttng_consumer_sample_snapshot_positions(struct lttng_consumer_stream *stream);
 int lttng_consumer_take_snapshot(struct lttng_consumer_stream *stream);
 int lttng_consumer_get_produced_snapshot(struct lttng_consumer_stream *stream,
@@ -1027,6 +1200,9 @@ int lttng_consumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		struct lttng_consumer_local_data *ctx,
 		bool locked_by_caller);
+int lttng_consumer_release_zerocopy_subbuffer(
+		struct lttng_consumer_stream *stream,
+		struct lttng_consumer_local_data *ctx);
 int lttng_consumer_on_recv_stream(struct lttng_consumer_stream *stream);
 void consumer_add_relayd_socket(uint64_t net_seq_idx,
 		int sock_type,
@@ -1047,10 +1223,12 @@ int consumer_send_status_channel(int sock,
 void notify_thread_del_channel(struct lttng_consumer_local_data *ctx,
 		uint64_t key);
 void consumer_destroy_relayd(struct consumer_relayd_sock_pair *relayd);
+unsigned int consumer_get_snapshot_worker_count(void);
 unsigned long consumer_get_consume_start_pos(unsigned long consumed_pos,
 		unsigned long produced_pos, uint64_t nb_packets_per_stream,
 		uint64_t max_sb_size);
-void consumer_add_data_stream(struct lttng_consumer_stream *stream);
+void consumer_add_data_stream(struct lttng_consumer_stream *stream,
+		struct lttng_consumer_local_data *ctx);
 void consumer_del_stream_for_data(struct lttng_consumer_stream *stream);
 void consumer_add_metadata_stream(struct lttng_consumer_stream *stream);
 void consumer_del_stream_for_metadata(struct lttng_consumer_stream *stream);
@@ -1078,6 +1256,11 @@ enum lttcomm_return_code lttng_consumer_trace_chunk_exists(
 		const uint64_t *relayd_id, uint64_t session_id,
 		uint64_t chunk_id);
 void lttng_consumer_cleanup_relayd(struct consumer_relayd_sock_pair *relayd);
+void consumer_relayd_ctrl_lock(struct consumer_relayd_sock_pair *relayd);
+void consumer_relayd_ctrl_unlock(struct consumer_relayd_sock_pair *relayd);
+int consumer_relayd_queue_index(struct consumer_relayd_sock_pair *relayd,
+		const struct ctf_packet_index *index, uint64_t relay_stream_id,
+		uint64_t net_seq_num);
 enum lttcomm_return_code lttng_consumer_init_command(
 		struct lttng_consumer_local_data *ctx,
 		const lttng_uuid& sessiond_uuid);
@@ -1087,5 +1270,6 @@ enum lttcomm_return_code lttng_consumer_open_channel_packets(
 int consumer_metadata_wakeup_pipe(const struct lttng_consumer_channel *channel);
 void lttng_consumer_sigbus_handle(void *addr);
 void sample_and_send_channel_buffer_stats(struct lttng_consumer_channel *channel);
+int lttng_consumer_send_stream_stats(int sock, uint64_t session_id);
 
 #endif /* LIB_CONSUMER_H */
@@ -318,6 +318,18 @@
 #define DEFAULT_APP_SOCKET_RW_TIMEOUT       CONFIG_DEFAULT_APP_SOCKET_RW_TIMEOUT
 #define DEFAULT_APP_SOCKET_TIMEOUT_ENV      "LTTNG_APP_SOCKET_TIMEOUT"
 
+/* Number of threads handling the notify sockets of the applications. */
+#define DEFAULT_SESSIOND_APP_NOTIFY_THREADS     4
+#define DEFAULT_SESSIOND_APP_NOTIFY_THREADS_ENV "LTTNG_SESSIOND_APP_NOTIFY_THREADS"
+
+/* Number of threads setting up newly registered applications concurrently. */
+#define DEFAULT_SESSIOND_APP_SETUP_WORKERS     4
+#define DEFAULT_SESSIOND_APP_SETUP_WORKERS_ENV "LTTNG_SESSIOND_APP_SETUP_WORKERS"
+
+/* Number of threads processing the client commands concurrently. */
+#define DEFAULT_SESSIOND_CLIENT_WORKERS     4
+#define DEFAULT_SESSIOND_CLIENT_WORKERS_ENV "LTTNG_SESSIOND_CLIENT_WORKERS"
+
 #define DEFAULT_UST_STREAM_FD_NUM			2 /* Number of fd per UST stream. */
 
 #define DEFAULT_SNAPSHOT_NAME				"snapshot"
@@ -358,6 +370,13 @@
 
 #define DEFAULT_LTTNG_RELAYD_WORKING_DIRECTORY_ENV "LTTNG_RELAYD_WORKING_DIRECTORY"
 
+#define DEFAULT_LTTNG_CONSUMERD_NETWORK_ZEROCOPY_ENV "LTTNG_CONSUMERD_NETWORK_ZEROCOPY"
+#define DEFAULT_LTTNG_CONSUMERD_SNAPSHOT_WORKERS_ENV "LTTNG_CONSUMERD_SNAPSHOT_WORKERS"
+#define DEFAULT_LTTNG_CONSUMERD_NUMA_AFFINITY_ENV "LTTNG_CONSUMERD_NUMA_AFFINITY"
+
+/* Maximal number of streams of a channel recorded concurrently by a snapshot. */
+#define DEFAULT_CONSUMERD_SNAPSHOT_WORKERS	8
+
 /*
  * Name of the intermediate directory used to rename the trace chunk of a
  * session's first rotation.
@@ -0,0 +1,734 @@
+/*
+ * filter-benchmark.c
+ *
+ * LTTng filter and capture bytecode benchmark
+ *
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <ctype.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/bytecode/bytecode-interpreter.hpp>
+#include <common/bytecode/bytecode.hpp>
+#include <common/compat/errno.hpp>
+#include <common/compat/time.hpp>
+#include <common/error.hpp>
+#include <common/filter/filter-bytecode-cache.hpp>
+#include <common/macros.hpp>
+#include <common/time.hpp>
+#include <lttng/event-expr-internal.hpp>
+#include <lttng/event-expr.h>
+
+#define DEFAULT_ITERATIONS	1000000
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+struct synthetic_event {
+	struct bytecode_interpreter_field *fields;
+	unsigned int field_count;
+};
+
+static const struct option long_options[] = {
+	{ "capture", required_argument, NULL, 'c' },
+	{ "events", required_argument, NULL, 'e' },
+	{ "field", required_argument, NULL, 'f' },
+	{ "iterations", required_argument, NULL, 'n' },
+	{ "help", no_argument, NULL, 'h' },
+	{ NULL, 0, NULL, 0 },
+};
+
+static
+void usage(FILE *stream, const char *name)
+{
+	fprintf(stream,
+		"Usage: %s [OPTION]... [FILTER-EXPRESSION]...\n"
+		"\n"
+		"Compile filter expressions and capture descriptors and report the time\n"
+		"taken to evaluate their bytecode against synthetic events.\n"
+		"\n"
+		"  -f, --field=FIELD=VALUE     Add a field to the synthetic event\n"
+		"  -e, --events=PATH           Read the synthetic events from PATH, one\n"
+		"                              event per line, made of blank-separated\n"
+		"                              FIELD=VALUE pairs\n"
+		"  -c, --capture=FIELD         Benchmark the capture of FIELD\n"
+		"  -n, --iterations=COUNT      Evaluate COUNT times per event (default: %d)\n"
+		"  -h, --help                  Show this help\n"
+		"\n"
+		"FIELD is NAME, $ctx.NAME, or $app.PROVIDER:TYPE, optionally followed by\n"
+		"[INDEX] for a capture. VALUE is an integer, a floating point number,\n"
+		"a string, optionally double-quoted, or an array of integers: [1,2,3].\n",
+		name, DEFAULT_ITERATIONS);
+}
+
+static
+void value_fini(struct bytecode_interpreter_value *value)
+{
+	switch (value->type) {
+	case BYTECODE_INTERPRETER_VALUE_TYPE_STRING:
+		free((char *) value->u.string);
+		break;
+	case BYTECODE_INTERPRETER_VALUE_TYPE_ARRAY:
+		free((int64_t *) value->u.array.elements);
+		break;
+	default:
+		break;
+	}
+}
+
+static
+void synthetic_event_fini(struct synthetic_event *event)
+{
+	unsigned int i;
+
+	for (i = 0; i < event->field_count; i++) {
+		free((char *) event->fields[i].name);
+		value_fini(&event->fields[i].value);
+	}
+
+	free(event->fields);
+	event->fields = NULL;
+	event->field_count = 0;
+}
+
+static
+int parse_quoted_string(const char *text, struct bytecode_interpreter_value *value)
+{
+	char *str, *out;
+	const char *in;
+
+	str = strdup(text + 1);
+	if (!str) {
+		return -ENOMEM;
+	}
+
+	for (in = text + 1, out = str; *in != '"'; in++) {
+		if (*in == '\0') {
+			fprintf(stderr, "Unterminated string: %s\n", text);
+			free(str);
+			return -EINVAL;
+		}
+
+		if (*in == '\\' && in[1] != '\0') {
+			in++;
+		}
+
+		*out++ = *in;
+	}
+
+	if (in[1] != '\0') {
+		fprintf(stderr, "Unexpected characters after string: %s\n", text);
+		free(str);
+		return -EINVAL;
+	}
+
+	*out = '\0';
+	value->type = BYTECODE_INTERPRETER_VALUE_TYPE_STRING;
+	value->u.string = str;
+	return 0;
+}
+
+static
+int parse_array(const char *text, struct bytecode_interpreter_value *value)
+{
+	int64_t *elements = NULL;
+	uint64_t count = 0;
+	const char *p = text + 1;
+
+	while (*p != ']') {
+		char *end;
+		int64_t *new_elements;
+
+		new_elements = (int64_t *) realloc(elements,
+				(count + 1) * sizeof(*elements));
+		if (!new_elements) {
+			free(elements);
+			return -ENOMEM;
+		}
+		elements = new_elements;
+
+		errno = 0;
+		elements[count++] = strtoll(p, &end, 0);
+		if (end == p || errno) {
+			goto invalid;
+		}
+
+		p = end;
+		if (*p == ',') {
+			p++;
+		} else if (*p != ']') {
+			goto invalid;
+		}
+	}
+
+	if (p[1] != '\0') {
+		goto invalid;
+	}
+
+	value->type = BYTECODE_INTERPRETER_VALUE_TYPE_ARRAY;
+	value->u.array.elements = elements;
+	value->u.array.count = count;
+	return 0;
+
+invalid:
+	fprintf(stderr, "Invalid array: %s\n", text);
+	free(elements);
+	return -EINVAL;
+}
+
+static
+int parse_value(const char *text, struct bytecode_interpreter_value *value)
+{
+	char *end;
+
+	if (text[0] == '"') {
+		return parse_quoted_string(text, value);
+	} else if (text[0] == '[') {
+		return parse_array(text, value);
+	}
+
+	if (text[0] != '\0') {
+		errno = 0;
+		value->u.s64 = strtoll(text, &end, 0);
+		if (*end == '\0' && !errno) {
+			value->type = BYTECODE_INTERPRETER_VALUE_TYPE_S64;
+			return 0;
+		}
+
+		errno = 0;
+		value->u.u64 = strtoull(text, &end, 0);
+		if (text[0] != '-' && *end == '\0' && !errno) {
+			value->type = BYTECODE_INTERPRETER_VALUE_TYPE_U64;
+			return 0;
+		}
+
+		value->u.d = strtod(text, &end);
+		if (*end == '\0') {
+			value->type = BYTECODE_INTERPRETER_VALUE_TYPE_DOUBLE;
+			return 0;
+		}
+	}
+
+	value->u.string = strdup(text);
+	if (!value->u.string) {
+		return -ENOMEM;
+	}
+
+	value->type = BYTECODE_INTERPRETER_VALUE_TYPE_STRING;
+	return 0;
+}
+
+/*
+ * Split a field name in its scope and its name within that scope.
+ */
+static
+const char *parse_field_name(const char *name,
+		enum bytecode_interpreter_scope *scope)
+{
+	if (!strncmp(name, "$ctx.", strlen("$ctx."))) {
+		*scope = BYTECODE_INTERPRETER_SCOPE_CONTEXT;
+		return name + strlen("$ctx.");
+	} else if (!strncmp(name, "$app.", strlen("$app."))) {
+		*scope = BYTECODE_INTERPRETER_SCOPE_APP_CONTEXT;
+		return name + strlen("$app.");
+	}
+
+	*scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+	return name;
+}
+
+/* Add a field, described by `FIELD=VALUE`, to a synthetic event. */
+static
+int add_field(struct synthetic_event *event, const char *spec)
+{
+	int ret;
+	const char *equal = strchr(spec, '=');
+	struct bytecode_interpreter_field *new_fields, *field;
+	char *full_name = NULL;
+
+	if (!equal || equal == spec) {
+		fprintf(stderr, "Invalid field: %s\n", spec);
+		return -EINVAL;
+	}
+
+	new_fields = (bytecode_interpreter_field *) realloc(event->fields,
+			(event->field_count + 1) * sizeof(*new_fields));
+	if (!new_fields) {
+		return -ENOMEM;
+	}
+	event->fields = new_fields;
+	field = &event->fields[event->field_count];
+
+	full_name = lttng_strndup(spec, equal - spec);
+	if (!full_name) {
+		return -ENOMEM;
+	}
+
+	ret = parse_value(equal + 1, &field->value);
+	if (ret) {
+		free(full_name);
+		return ret;
+	}
+
+	field->name = strdup(parse_field_name(full_name, &field->scope));
+	free(full_name);
+	if (!field->name) {
+		value_fini(&field->value);
+		return -ENOMEM;
+	}
+
+	event->field_count++;
+	return 0;
+}
+
+/*
+ * Parse a line of an events file: blank-separated `FIELD=VALUE` pairs, in
+ * which double-quoted strings may contain blanks.
+ */
+static
+int parse_event_line(char *line, struct synthetic_event *event)
+{
+	char *p = line;
+
+	for (;;) {
+		char *spec;
+		bool in_quotes = false;
+		int ret;
+
+		while (isspace((unsigned char) *p)) {
+			p++;
+		}
+
+		if (*p == '\0') {
+			return 0;
+		}
+
+		spec = p;
+		for (; *p != '\0' && (in_quotes || !isspace((unsigned char) *p)); p++) {
+			if (*p == '"') {
+				in_quotes = !in_quotes;
+			} else if (in_quotes && *p == '\\' && p[1] != '\0') {
+				p++;
+			}
+		}
+
+		if (*p != '\0') {
+			*p++ = '\0';
+		}
+
+		ret = add_field(event, spec);
+		if (ret) {
+			return ret;
+		}
+	}
+}
+
+static
+int load_events(const char *path, struct synthetic_event **events,
+		unsigned int *event_count)
+{
+	int ret = 0;
+	FILE *file;
+	char *line = NULL;
+	size_t line_len = 0;
+
+	file = fopen(path, "r");
+	if (!file) {
+		PERROR("Failed to open events file: path = `%s`", path);
+		return -errno;
+	}
+
+	while (getline(&line, &line_len, file) >= 0) {
+		struct synthetic_event *new_events;
+		struct synthetic_event event = {};
+
+		if (line[0] == '#') {
+			continue;
+		}
+
+		ret = parse_event_line(line, &event);
+		if (ret) {
+			synthetic_event_fini(&event);
+			goto end;
+		}
+
+		if (event.field_count == 0) {
+			continue;
+		}
+
+		new_events = (synthetic_event *) realloc(*events,
+				(*event_count + 1) * sizeof(*new_events));
+		if (!new_events) {
+			synthetic_event_fini(&event);
+			ret = -ENOMEM;
+			goto end;
+		}
+
+		*events = new_events;
+		(*events)[(*event_count)++] = event;
+	}
+
+end:
+	free(line);
+	fclose(file);
+	return ret;
+}
+
+/*
+ * Generate the bytecode capturing a field described by
+ * `FIELD[INDEX]`.
+ */
+static
+int generate_capture_bytecode(const char *spec, struct lttng_bytecode **bytecode)
+{
+	int ret;
+	char *name = NULL, *bracket;
+	const char *scoped_name;
+	enum bytecode_interpreter_scope scope;
+	struct lttng_event_expr *expr = NULL;
+
+	name = strdup(spec);
+	if (!name) {
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	bracket = strchr(name, '[');
+	if (bracket) {
+		*bracket = '\0';
+	}
+
+	scoped_name = parse_field_name(name, &scope);
+	switch (scope) {
+	case BYTECODE_INTERPRETER_SCOPE_PAYLOAD:
+		expr = lttng_event_expr_event_payload_field_create(scoped_name);
+		break;
+	case BYTECODE_INTERPRETER_SCOPE_CONTEXT:
+		expr = lttng_event_expr_channel_context_field_create(scoped_name);
+		break;
+	case BYTECODE_INTERPRETER_SCOPE_APP_CONTEXT:
+	{
+		char *colon = (char *) strchr(scoped_name, ':');
+
+		if (!colon) {
+			break;
+		}
+
+		*colon = '\0';
+		expr = lttng_event_expr_app_specific_context_field_create(
+				scoped_name, colon + 1);
+		break;
+	}
+	}
+
+	if (expr && bracket) {
+		struct lttng_event_expr *element_expr;
+		char *end;
+		unsigned long index;
+
+		errno = 0;
+		index = strtoul(bracket + 1, &end, 0);
+		if (errno || end == bracket + 1 || strcmp(end, "]") ||
+				index > UINT_MAX) {
+			lttng_event_expr_destroy(expr);
+			expr = NULL;
+		} else {
+			element_expr = lttng_event_expr_array_field_element_create(
+					expr, (unsigned int) index);
+			if (!element_expr) {
+				lttng_event_expr_destroy(expr);
+			}
+			expr = element_expr;
+		}
+	}
+
+	if (!expr) {
+		fprintf(stderr, "Invalid capture: %s\n", spec);
+		ret = -EINVAL;
+		goto end;
+	}
+
+	ret = lttng_event_expr_to_bytecode(expr, bytecode);
+	if (ret) {
+		fprintf(stderr, "Failed to generate capture bytecode: %s\n", spec);
+		ret = -EINVAL;
+	}
+
+end:
+	lttng_event_expr_destroy(expr);
+	free(name);
+	return ret;
+}
+
+/*
+ * Link a bytecode against each event, then evaluate it `iterations` times
+ * per event and report its mean evaluation time.
+ *
+ * Like in the tracers, the events against which the bytecode fails to link
+ * are not evaluated: they are always discarded by filters and their
+ * captures are empty.
+ */
+static
+int benchmark(const char *description, bool is_filter,
+		const struct lttng_bytecode *bytecode,
+		const struct synthetic_event *events, unsigned int event_count,
+		unsigned long iterations)
+{
+	int ret = 0;
+	unsigned int i, linked_count = 0, accepted_count = 0, error_count = 0;
+	unsigned long iteration;
+	struct bytecode_interpreter_program **programs;
+	struct bytecode_interpreter_event *views;
+	struct timespec begin, end;
+	uint64_t elapsed_ns, evaluation_count;
+
+	programs = calloc<bytecode_interpreter_program *>(event_count);
+	views = calloc<bytecode_interpreter_event>(event_count);
+	if (!programs || !views) {
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < event_count; i++) {
+		views[i].fields = events[i].fields;
+		views[i].field_count = events[i].field_count;
+
+		ret = bytecode_interpreter_link(bytecode, &views[i], &programs[i]);
+		if (ret == -ENOENT) {
+			programs[i] = NULL;
+			continue;
+		} else if (ret) {
+			fprintf(stderr, "Failed to link bytecode: %s\n",
+					description);
+			goto end;
+		}
+
+		linked_count++;
+	}
+	ret = 0;
+
+	/* Untimed pass, which also gathers the results. */
+	for (i = 0; i < event_count; i++) {
+		struct bytecode_interpreter_value value;
+		int result;
+
+		if (!programs[i]) {
+			continue;
+		}
+
+		result = is_filter ?
+				bytecode_interpreter_filter(programs[i], &views[i]) :
+				bytecode_interpreter_run(programs[i], &views[i], &value);
+		if (result < 0) {
+			error_count++;
+		} else if (!is_filter || result > 0) {
+			accepted_count++;
+		}
+	}
+
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &begin);
+	if (ret) {
+		PERROR("Failed to sample time");
+		goto end;
+	}
+
+	for (iteration = 0; iteration < iterations; iteration++) {
+		for (i = 0; i < event_count; i++) {
+			struct bytecode_interpreter_value value;
+
+			if (!programs[i]) {
+				continue;
+			}
+
+			(void) bytecode_interpreter_run(programs[i], &views[i], &value);
+		}
+	}
+
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &end);
+	if (ret) {
+		PERROR("Failed to sample time");
+		goto end;
+	}
+
+	elapsed_ns = (uint64_t) (end.tv_sec - begin.tv_sec) * NSEC_PER_SEC +
+			end.tv_nsec - begin.tv_nsec;
+	evaluation_count = (uint64_t) iterations * linked_count;
+
+	printf("%s\n", description);
+	printf("  Bytecode length: %" PRIu32 " bytes\n", bytecode->len);
+	printf("  Events: %u, linked: %u, %s: %u, runtime errors: %u\n",
+			event_count, linked_count,
+			is_filter ? "recorded" : "captured", accepted_count,
+			error_count);
+	if (evaluation_count) {
+		printf("  Evaluation time: %.2f ns\n",
+				(double) elapsed_ns / evaluation_count);
+	}
+
+end:
+	if (programs) {
+		for (i = 0; i < event_count; i++) {
+			bytecode_interpreter_program_destroy(programs[i]);
+		}
+	}
+	free(programs);
+	free(views);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int ret, opt, i;
+	unsigned long iterations = DEFAULT_ITERATIONS;
+	struct synthetic_event *events = NULL;
+	unsigned int event_count = 0, capture_count = 0, j;
+	const char *events_path = NULL, **captures = NULL;
+	struct synthetic_event cmdline_event = {};
+
+	while ((opt = getopt_long(argc, argv, "c:e:f:n:h", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'c':
+		{
+			const char **new_captures = (const char **) realloc(captures,
+					(capture_count + 1) * sizeof(*captures));
+
+			if (!new_captures) {
+				ret = -ENOMEM;
+				goto end;
+			}
+			captures = new_captures;
+			captures[capture_count++] = optarg;
+			break;
+		}
+		case 'e':
+			events_path = optarg;
+			break;
+		case 'f':
+			ret = add_field(&cmdline_event, optarg);
+			if (ret) {
+				goto end;
+			}
+			break;
+		case 'n':
+		{
+			char *end;
+
+			errno = 0;
+			iterations = strtoul(optarg, &end, 0);
+			if (errno || *end != '\0' || iterations == 0) {
+				fprintf(stderr, "Invalid iteration count: %s\n", optarg);
+				ret = -EINVAL;
+				goto end;
+			}
+			break;
+		}
+		case 'h':
+			usage(stdout, argv[0]);
+			ret = 0;
+			goto end;
+		default:
+			usage(stderr, argv[0]);
+			ret = -EINVAL;
+			goto end;
+		}
+	}
+
+	if (optind == argc && capture_count == 0) {
+		usage(stderr, argv[0]);
+		ret = -EINVAL;
+		goto end;
+	}
+
+	if (events_path) {
+		ret = load_events(events_path, &events, &event_count);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	if (cmdline_event.field_count > 0 || event_count == 0) {
+		struct synthetic_event *new_events = (synthetic_event *) realloc(
+				events, (event_count + 1) * sizeof(*events));
+
+		if (!new_events) {
+			ret = -ENOMEM;
+			goto end;
+		}
+
+		events = new_events;
+		events[event_count++] = cmdline_event;
+		cmdline_event = {};
+	}
+
+	for (i = optind; i < argc; i++) {
+		struct lttng_bytecode *bytecode = NULL;
+		char *description;
+
+		ret = filter_bytecode_cache_generate(argv[i], &bytecode);
+		if (ret) {
+			fprintf(stderr, "Failed to compile filter expression: %s\n",
+					argv[i]);
+			goto end;
+		}
+
+		ret = asprintf(&description, "Filter: %s", argv[i]);
+		if (ret < 0) {
+			free(bytecode);
+			ret = -ENOMEM;
+			goto end;
+		}
+
+		ret = benchmark(description, true, bytecode, events, event_count,
+				iterations);
+		free(description);
+		free(bytecode);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	for (j = 0; j < capture_count; j++) {
+		struct lttng_bytecode *bytecode = NULL;
+		char *description;
+
+		ret = generate_capture_bytecode(captures[j], &bytecode);
+		if (ret) {
+			goto end;
+		}
+
+		ret = asprintf(&description, "Capture: %s", captures[j]);
+		if (ret < 0) {
+			free(bytecode);
+			ret = -ENOMEM;
+			goto end;
+		}
+
+		ret = benchmark(description, false, bytecode, events, event_count,
+				iterations);
+		free(description);
+		free(bytecode);
+		if (ret) {
+			goto end;
+		}
+	}
+
+end:
+	for (j = 0; j < event_count; j++) {
+		synthetic_event_fini(&events[j]);
+	}
+	synthetic_event_fini(&cmdline_event);
+	free(events);
+	free(captures);
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -97,6 +97,15 @@ int main(int argc, char **argv)
 			goto parse_error;
 		}
 		printf("done\n");
+
+		printf("Optimizing IR... ");
+		fflush(stdout);
+		ret = filter_visitor_ir_optimize(ctx);
+		if (ret) {
+			fprintf(stderr, "Optimize IR error\n");
+			goto parse_error;
+		}
+		printf("done\n");
 	}
 	if (generate_bytecode) {
 		printf("Generating bytecode... ");
@@ -189,5 +189,6 @@ int filter_visitor_ir_check_binary_comparator(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_validate_string(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_normalize_glob_patterns(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_validate_globbing(struct filter_parser_ctx *ctx);
+int filter_visitor_ir_optimize(struct filter_parser_ctx *ctx);
 
 #endif /* _FILTER_AST_H */
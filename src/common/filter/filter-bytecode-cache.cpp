@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/bytecode/bytecode.hpp>
+#include <common/error.hpp>
+#include <common/macros.hpp>
+#include <lttng/lttng-error.h>
+
+#include "filter-ast.hpp"
+#include "filter-bytecode-cache.hpp"
+
+/*
+ * Session configurations typically use a handful of distinct filter
+ * expressions for many events.
+ */
+#define FILTER_BYTECODE_CACHE_SIZE	64
+
+namespace {
+struct filter_bytecode_cache_entry {
+	/* Normalised filter expression, NULL if the entry is unused. */
+	char *expression;
+	size_t expression_len;
+	struct lttng_bytecode *bytecode;
+};
+} /* namespace */
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Protected by cache_lock. */
+static struct filter_bytecode_cache_entry cache_entries[FILTER_BYTECODE_CACHE_SIZE];
+/* Index of the entry replaced by the next insertion, protected by cache_lock. */
+static unsigned int cache_next_entry;
+
+char *filter_bytecode_cache_normalize_expression(const char *filter_expression)
+{
+	char *normalized, *out;
+	const char *in = filter_expression;
+	char quote = '\0';
+	bool pending_blank = false;
+
+	normalized = zmalloc<char>(strlen(filter_expression) + 1);
+	if (!normalized) {
+		return NULL;
+	}
+
+	out = normalized;
+	while (*in == ' ' || *in == '\t') {
+		in++;
+	}
+
+	for (; *in != '\0'; in++) {
+		const char c = *in;
+
+		if (quote) {
+			/* Literals are copied as-is, escape sequences included. */
+			*out++ = c;
+			if (c == '\\' && in[1] != '\0') {
+				*out++ = *++in;
+			} else if (c == quote) {
+				quote = '\0';
+			}
+			continue;
+		}
+
+		if (c == ' ' || c == '\t') {
+			pending_blank = true;
+			continue;
+		}
+
+		if (pending_blank) {
+			*out++ = ' ';
+			pending_blank = false;
+		}
+
+		if (c == '/' && (in[1] == '*' || in[1] == '/')) {
+			/* Keep comments, and what follows them, verbatim. */
+			strcpy(out, in);
+			return normalized;
+		}
+
+		if (c == '"' || c == '\'') {
+			quote = c;
+		}
+
+		*out++ = c;
+	}
+
+	*out = '\0';
+	return normalized;
+}
+
+/*
+ * Find the entry of a normalised expression. Called with cache_lock held.
+ */
+static struct filter_bytecode_cache_entry *find_entry(
+		const char *expression, size_t expression_len)
+{
+	unsigned int i;
+
+	for (i = 0; i < FILTER_BYTECODE_CACHE_SIZE; i++) {
+		struct filter_bytecode_cache_entry *entry = &cache_entries[i];
+
+		if (entry->expression && entry->expression_len == expression_len &&
+				!memcmp(entry->expression, expression, expression_len)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static struct lttng_bytecode *lookup_normalized(const char *expression)
+{
+	struct lttng_bytecode *bytecode = NULL;
+	const struct filter_bytecode_cache_entry *entry;
+
+	pthread_mutex_lock(&cache_lock);
+	entry = find_entry(expression, strlen(expression));
+	if (entry) {
+		bytecode = lttng_bytecode_copy(entry->bytecode);
+	}
+	pthread_mutex_unlock(&cache_lock);
+
+	return bytecode;
+}
+
+static void add_normalized(const char *expression,
+		const struct lttng_bytecode *bytecode)
+{
+	char *expression_copy = NULL;
+	struct lttng_bytecode *bytecode_copy = NULL;
+	struct filter_bytecode_cache_entry *entry;
+	const size_t expression_len = strlen(expression);
+
+	pthread_mutex_lock(&cache_lock);
+	if (find_entry(expression, expression_len)) {
+		goto end;
+	}
+
+	expression_copy = strdup(expression);
+	bytecode_copy = lttng_bytecode_copy(bytecode);
+	if (!expression_copy || !bytecode_copy) {
+		free(expression_copy);
+		free(bytecode_copy);
+		goto end;
+	}
+
+	entry = &cache_entries[cache_next_entry];
+	cache_next_entry = (cache_next_entry + 1) % FILTER_BYTECODE_CACHE_SIZE;
+
+	free(entry->expression);
+	free(entry->bytecode);
+	entry->expression = expression_copy;
+	entry->expression_len = expression_len;
+	entry->bytecode = bytecode_copy;
+end:
+	pthread_mutex_unlock(&cache_lock);
+}
+
+struct lttng_bytecode *filter_bytecode_cache_lookup(const char *filter_expression)
+{
+	char *normalized;
+	struct lttng_bytecode *bytecode;
+
+	normalized = filter_bytecode_cache_normalize_expression(filter_expression);
+	if (!normalized) {
+		return NULL;
+	}
+
+	bytecode = lookup_normalized(normalized);
+	free(normalized);
+	return bytecode;
+}
+
+void filter_bytecode_cache_add(const char *filter_expression,
+		const struct lttng_bytecode *bytecode)
+{
+	char *normalized;
+
+	normalized = filter_bytecode_cache_normalize_expression(filter_expression);
+	if (!normalized) {
+		return;
+	}
+
+	add_normalized(normalized, bytecode);
+	free(normalized);
+}
+
+int filter_bytecode_cache_generate(const char *filter_expression,
+		struct lttng_bytecode **bytecode)
+{
+	int ret;
+	char *normalized;
+	struct filter_parser_ctx *ctx = NULL;
+	struct lttng_bytecode *local_bytecode;
+
+	normalized = filter_bytecode_cache_normalize_expression(filter_expression);
+	if (!normalized) {
+		ret = -LTTNG_ERR_FILTER_NOMEM;
+		goto end;
+	}
+
+	local_bytecode = lookup_normalized(normalized);
+	if (local_bytecode) {
+		DBG3("Reusing cached bytecode of filter expression: expression = \"%s\"",
+				filter_expression);
+		*bytecode = local_bytecode;
+		ret = 0;
+		goto end;
+	}
+
+	ret = filter_parser_ctx_create_from_filter_expression(filter_expression, &ctx);
+	if (ret) {
+		goto end;
+	}
+
+	local_bytecode = lttng_bytecode_copy(&ctx->bytecode->b);
+	if (!local_bytecode) {
+		ret = -LTTNG_ERR_FILTER_NOMEM;
+		goto end;
+	}
+
+	add_normalized(normalized, local_bytecode);
+	*bytecode = local_bytecode;
+end:
+	if (ctx) {
+		filter_bytecode_free(ctx);
+		filter_ir_free(ctx);
+		filter_parser_ctx_free(ctx);
+	}
+	free(normalized);
+	return ret;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_FILTER_BYTECODE_CACHE_H
+#define LTTNG_FILTER_BYTECODE_CACHE_H
+
+struct lttng_bytecode;
+
+/*
+ * Per-process cache of the bytecode compiled from filter expressions.
+ *
+ * Expressions are looked up in their normalised form: runs of blanks
+ * outside of literals are collapsed to a single space and leading and
+ * trailing blanks are ignored, so that " a  == 1 " and "a == 1" share the
+ * same bytecode while "a==1" doesn't. Only the most recently added
+ * expressions are kept.
+ *
+ * All functions may be called concurrently.
+ */
+
+/*
+ * Return the normalised form of a filter expression, as used as the key of
+ * the cache.
+ *
+ * Returns a string owned by the caller or NULL on allocation failure.
+ */
+char *filter_bytecode_cache_normalize_expression(const char *filter_expression);
+
+/*
+ * Return a copy, owned by the caller, of the bytecode cached for a filter
+ * expression or NULL if it is not cached.
+ */
+struct lttng_bytecode *filter_bytecode_cache_lookup(const char *filter_expression);
+
+/*
+ * Add the bytecode compiled from a filter expression to the cache. Errors
+ * are not reported: the bytecode is then simply not cached.
+ */
+void filter_bytecode_cache_add(const char *filter_expression,
+		const struct lttng_bytecode *bytecode);
+
+/*
+ * Compile a filter expression, reusing the cached bytecode of an identical
+ * expression if available.
+ *
+ * On success, returns 0 and sets `bytecode` to a copy owned by the caller.
+ * Returns a negative LTTNG_ERR_FILTER_* error code on error.
+ */
+int filter_bytecode_cache_generate(const char *filter_expression,
+		struct lttng_bytecode **bytecode);
+
+#endif /* LTTNG_FILTER_BYTECODE_CACHE_H */
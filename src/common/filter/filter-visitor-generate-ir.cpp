@@ -574,7 +574,6 @@ struct ir_op *make_op_binary_bitwise_xor(struct ir_op *left, struct ir_op *right
 	return make_op_binary_bitwise(AST_OP_BIT_XOR, "^", left, right, side);
 }
 
-static
 void filter_free_ir_recursive(struct ir_op *op)
 {
 	if (!op)
@@ -0,0 +1,583 @@
+/*
+ * filter-visitor-ir-optimize.c
+ *
+ * LTTng filter IR optimizer
+ *
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include <common/macros.hpp>
+#include <common/compat/errno.hpp>
+
+#include "filter-ast.hpp"
+#include "filter-parser.hpp"
+#include "filter-ir.hpp"
+
+/*
+ * Relative evaluation cost of the operations of a filter, used to order the
+ * operands of a conjunction. Comparing against a string literal is much more
+ * expensive than comparing integers, and matching a globbing pattern even
+ * more so.
+ */
+#define IR_COST_CONSTANT	1
+#define IR_COST_OP		1
+#define IR_COST_FIELD_LOAD	2
+#define IR_COST_STRING		16
+#define IR_COST_GLOB		64
+
+static
+bool is_numeric_constant(const struct ir_op *op)
+{
+	return op->op == IR_OP_LOAD && op->data_type == IR_DATA_NUMERIC;
+}
+
+static
+bool is_float_constant(const struct ir_op *op)
+{
+	return op->op == IR_OP_LOAD && op->data_type == IR_DATA_FLOAT;
+}
+
+static
+double constant_to_double(const struct ir_op *op)
+{
+	return is_float_constant(op) ? op->u.load.u.flt :
+			(double) op->u.load.u.num;
+}
+
+/*
+ * Truth value of an operand of a logical operator: 0 or 1 if the operand is
+ * an integer constant, -1 otherwise.
+ *
+ * Floating point constants are converted to integers by the tracer before
+ * being tested; they are not considered to keep their semantics exact.
+ */
+static
+int constant_truth(const struct ir_op *op)
+{
+	if (!is_numeric_constant(op)) {
+		return -1;
+	}
+
+	return op->u.load.u.num != 0;
+}
+
+/*
+ * Whether the value of an operation is always 0 or 1, in which case it can
+ * replace a logical operator of which it is an operand.
+ */
+static
+bool is_boolean(const struct ir_op *op)
+{
+	switch (op->op) {
+	case IR_OP_LOGICAL:
+		return true;
+	case IR_OP_BINARY:
+		switch (op->u.binary.type) {
+		case AST_OP_EQ:
+		case AST_OP_NE:
+		case AST_OP_GT:
+		case AST_OP_LT:
+		case AST_OP_GE:
+		case AST_OP_LE:
+			return true;
+		default:
+			return false;
+		}
+	case IR_OP_LOAD:
+		return is_numeric_constant(op) &&
+				(op->u.load.u.num == 0 || op->u.load.u.num == 1);
+	default:
+		return false;
+	}
+}
+
+/*
+ * Turn an operation into an integer constant, freeing its operands.
+ */
+static
+void make_numeric_constant(struct ir_op *op, int64_t value)
+{
+	switch (op->op) {
+	case IR_OP_UNARY:
+		filter_free_ir_recursive(op->u.unary.child);
+		break;
+	case IR_OP_BINARY:
+		filter_free_ir_recursive(op->u.binary.left);
+		filter_free_ir_recursive(op->u.binary.right);
+		break;
+	case IR_OP_LOGICAL:
+		filter_free_ir_recursive(op->u.logical.left);
+		filter_free_ir_recursive(op->u.logical.right);
+		break;
+	default:
+		/* Only constants are turned into other constants. */
+		LTTNG_ASSERT(is_numeric_constant(op) || is_float_constant(op));
+		break;
+	}
+
+	op->op = IR_OP_LOAD;
+	op->data_type = IR_DATA_NUMERIC;
+	op->signedness = IR_SIGNED;
+	op->u.load.u.num = value;
+}
+
+/*
+ * Replace the operation at `opp` by one of its operands, freeing the
+ * operation and its other operands.
+ */
+static
+void replace_with_operand(struct ir_op **opp, struct ir_op *operand)
+{
+	struct ir_op *op = *opp;
+
+	switch (op->op) {
+	case IR_OP_UNARY:
+		LTTNG_ASSERT(op->u.unary.child == operand);
+		break;
+	case IR_OP_BINARY:
+	case IR_OP_LOGICAL:
+		LTTNG_ASSERT(op->u.binary.left == operand ||
+				op->u.binary.right == operand);
+		filter_free_ir_recursive(op->u.binary.left == operand ?
+				op->u.binary.right : op->u.binary.left);
+		break;
+	default:
+		abort();
+	}
+
+	/* The operand takes the register of the operation it replaces. */
+	operand->side = op->side;
+	*opp = operand;
+	free(op);
+}
+
+static
+void fold_unary(struct ir_op **opp)
+{
+	struct ir_op *op = *opp;
+	struct ir_op *child = op->u.unary.child;
+
+	switch (op->u.unary.type) {
+	case AST_UNARY_PLUS:
+		/* No instruction is generated for an unary plus. */
+		replace_with_operand(opp, child);
+		break;
+	case AST_UNARY_MINUS:
+		if (is_numeric_constant(child) && child->u.load.u.num != INT64_MIN) {
+			child->u.load.u.num = -child->u.load.u.num;
+			replace_with_operand(opp, child);
+		} else if (is_float_constant(child)) {
+			child->u.load.u.flt = -child->u.load.u.flt;
+			replace_with_operand(opp, child);
+		}
+		break;
+	case AST_UNARY_NOT:
+		if (is_numeric_constant(child) || is_float_constant(child)) {
+			make_numeric_constant(op, !constant_to_double(child));
+		}
+		break;
+	case AST_UNARY_BIT_NOT:
+		if (is_numeric_constant(child)) {
+			make_numeric_constant(op, ~child->u.load.u.num);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static
+void fold_binary(struct ir_op *op)
+{
+	const struct ir_op *left = op->u.binary.left;
+	const struct ir_op *right = op->u.binary.right;
+	bool both_numeric;
+	double l, r;
+
+	if (!(is_numeric_constant(left) || is_float_constant(left)) ||
+			!(is_numeric_constant(right) || is_float_constant(right))) {
+		return;
+	}
+
+	/*
+	 * Integers are compared as integers; like the tracer does, they are
+	 * converted to double when compared to a floating point number.
+	 */
+	both_numeric = is_numeric_constant(left) && is_numeric_constant(right);
+	l = constant_to_double(left);
+	r = constant_to_double(right);
+
+	switch (op->u.binary.type) {
+	case AST_OP_EQ:
+		make_numeric_constant(op, both_numeric ?
+				left->u.load.u.num == right->u.load.u.num : l == r);
+		break;
+	case AST_OP_NE:
+		make_numeric_constant(op, both_numeric ?
+				left->u.load.u.num != right->u.load.u.num : l != r);
+		break;
+	case AST_OP_GT:
+		make_numeric_constant(op, both_numeric ?
+				left->u.load.u.num > right->u.load.u.num : l > r);
+		break;
+	case AST_OP_LT:
+		make_numeric_constant(op, both_numeric ?
+				left->u.load.u.num < right->u.load.u.num : l < r);
+		break;
+	case AST_OP_GE:
+		make_numeric_constant(op, both_numeric ?
+				left->u.load.u.num >= right->u.load.u.num : l >= r);
+		break;
+	case AST_OP_LE:
+		make_numeric_constant(op, both_numeric ?
+				left->u.load.u.num <= right->u.load.u.num : l <= r);
+		break;
+	case AST_OP_BIT_AND:
+		if (both_numeric) {
+			make_numeric_constant(op,
+					left->u.load.u.num & right->u.load.u.num);
+		}
+		break;
+	case AST_OP_BIT_OR:
+		if (both_numeric) {
+			make_numeric_constant(op,
+					left->u.load.u.num | right->u.load.u.num);
+		}
+		break;
+	case AST_OP_BIT_XOR:
+		if (both_numeric) {
+			make_numeric_constant(op,
+					left->u.load.u.num ^ right->u.load.u.num);
+		}
+		break;
+	default:
+		/*
+		 * Shifts are left to the tracer, which rejects out of range
+		 * shift counts at runtime.
+		 */
+		break;
+	}
+}
+
+/*
+ * Eliminate the branches of a logical operator which don't affect its
+ * value.
+ *
+ * Only the right operand may be dropped: when the left one is constant, the
+ * right one is either never evaluated or decides the value. The left operand
+ * is always evaluated and may fail at runtime (e.g. a string field cast to
+ * an integer), which discards the event: it is kept even when its value
+ * doesn't matter.
+ */
+static
+void fold_logical(struct ir_op **opp)
+{
+	struct ir_op *op = *opp;
+	struct ir_op *left = op->u.logical.left;
+	struct ir_op *right = op->u.logical.right;
+	const bool is_and = op->u.logical.type == AST_OP_AND;
+	const int left_truth = constant_truth(left);
+	const int right_truth = constant_truth(right);
+
+	if (left_truth < 0) {
+		/* `x && 1` and `x || 0` are `x`. */
+		if (is_boolean(left) && right_truth == (is_and ? 1 : 0)) {
+			replace_with_operand(opp, left);
+		}
+		return;
+	}
+
+	if (left_truth == (is_and ? 0 : 1)) {
+		/* Short-circuited: the right operand is dead. */
+		make_numeric_constant(op, left_truth);
+	} else if (right_truth >= 0) {
+		make_numeric_constant(op, right_truth);
+	} else if (is_boolean(right)) {
+		replace_with_operand(opp, right);
+	}
+}
+
+static
+int optimize_recursive(struct ir_op **opp)
+{
+	int ret;
+	struct ir_op *op = *opp;
+
+	switch (op->op) {
+	case IR_OP_UNKNOWN:
+	default:
+		fprintf(stderr, "[error] %s: unknown op type\n", __func__);
+		return -EINVAL;
+
+	case IR_OP_ROOT:
+		return optimize_recursive(&op->u.root.child);
+	case IR_OP_LOAD:
+		return 0;
+	case IR_OP_UNARY:
+		ret = optimize_recursive(&op->u.unary.child);
+		if (ret) {
+			return ret;
+		}
+		fold_unary(opp);
+		return 0;
+	case IR_OP_BINARY:
+		ret = optimize_recursive(&op->u.binary.left);
+		if (ret) {
+			return ret;
+		}
+		ret = optimize_recursive(&op->u.binary.right);
+		if (ret) {
+			return ret;
+		}
+		fold_binary(op);
+		return 0;
+	case IR_OP_LOGICAL:
+		ret = optimize_recursive(&op->u.logical.left);
+		if (ret) {
+			return ret;
+		}
+		ret = optimize_recursive(&op->u.logical.right);
+		if (ret) {
+			return ret;
+		}
+		fold_logical(opp);
+		return 0;
+	}
+}
+
+static
+unsigned int estimate_cost(const struct ir_op *op)
+{
+	switch (op->op) {
+	case IR_OP_LOAD:
+		switch (op->data_type) {
+		case IR_DATA_STRING:
+			return op->u.load.u.string.type == IR_LOAD_STRING_TYPE_GLOB_STAR ?
+					IR_COST_GLOB : IR_COST_STRING;
+		case IR_DATA_EXPRESSION:
+		{
+			unsigned int cost = 0;
+			const struct ir_load_expression_op *exp_op;
+
+			for (exp_op = op->u.load.u.expression->child; exp_op;
+					exp_op = exp_op->next) {
+				cost += IR_COST_FIELD_LOAD;
+			}
+			return cost;
+		}
+		default:
+			return IR_COST_CONSTANT;
+		}
+	case IR_OP_UNARY:
+		return IR_COST_OP + estimate_cost(op->u.unary.child);
+	case IR_OP_BINARY:
+	case IR_OP_LOGICAL:
+		return IR_COST_OP + estimate_cost(op->u.binary.left) +
+				estimate_cost(op->u.binary.right);
+	default:
+		return 0;
+	}
+}
+
+static
+bool is_conjunction(const struct ir_op *op)
+{
+	return op->op == IR_OP_LOGICAL && op->u.logical.type == AST_OP_AND;
+}
+
+static
+unsigned int count_conjunction_operands(const struct ir_op *op)
+{
+	if (!is_conjunction(op)) {
+		return 1;
+	}
+
+	return count_conjunction_operands(op->u.logical.left) +
+			count_conjunction_operands(op->u.logical.right);
+}
+
+/*
+ * Move the operands of a conjunction to `operands` and its logical
+ * operators to `ops`, in evaluation order.
+ */
+static
+void flatten_conjunction(struct ir_op *op, struct ir_op **operands,
+		unsigned int *operand_count, struct ir_op **ops,
+		unsigned int *op_count)
+{
+	if (!is_conjunction(op)) {
+		operands[(*operand_count)++] = op;
+		return;
+	}
+
+	flatten_conjunction(op->u.logical.left, operands, operand_count, ops,
+			op_count);
+	flatten_conjunction(op->u.logical.right, operands, operand_count, ops,
+			op_count);
+	ops[(*op_count)++] = op;
+}
+
+/*
+ * Optimize the conjunction (chain of `&&`) which is the value of the filter.
+ *
+ * The filter discards an event as soon as one of the operands is false or
+ * fails to evaluate, whatever their order: the operands are sorted by
+ * increasing cost, so that cheap integer comparisons short-circuit the
+ * expensive string and globbing pattern matches, and constant operands are
+ * folded.
+ *
+ * This only holds at the top level: the disjunctions, and the conjunctions
+ * of which the value is used by another operator, could otherwise evaluate
+ * to true where an operand which failed to evaluate previously discarded
+ * the event.
+ */
+static
+int optimize_root_conjunction(struct ir_op *root)
+{
+	int ret = 0;
+	struct ir_op **operands = NULL, **ops = NULL, *kept_true = NULL;
+	unsigned int *costs = NULL;
+	unsigned int operand_count = 0, op_count = 0, kept_count = 0, i, j;
+	const unsigned int count = count_conjunction_operands(root->u.root.child);
+
+	if (count < 2) {
+		goto end;
+	}
+
+	operands = calloc<ir_op *>(count);
+	ops = calloc<ir_op *>(count - 1);
+	costs = calloc<unsigned int>(count);
+	if (!operands || !ops || !costs) {
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	flatten_conjunction(root->u.root.child, operands, &operand_count, ops,
+			&op_count);
+	LTTNG_ASSERT(operand_count == count && op_count == count - 1);
+
+	/* Drop the constant operands. */
+	for (i = 0; i < operand_count; i++) {
+		struct ir_op *operand = operands[i];
+		const int truth = constant_truth(operand);
+
+		if (truth == 0) {
+			/* The filter never matches. */
+			for (j = 0; j < kept_count; j++) {
+				filter_free_ir_recursive(operands[j]);
+			}
+			for (j = i + 1; j < operand_count; j++) {
+				filter_free_ir_recursive(operands[j]);
+			}
+			filter_free_ir_recursive(kept_true);
+			for (j = 0; j < op_count; j++) {
+				free(ops[j]);
+			}
+			operand->side = IR_LEFT;
+			root->u.root.child = operand;
+			goto end;
+		} else if (truth > 0) {
+			if (kept_true) {
+				filter_free_ir_recursive(operand);
+			} else {
+				kept_true = operand;
+			}
+		} else {
+			operands[kept_count] = operand;
+			costs[kept_count] = estimate_cost(operand);
+			kept_count++;
+		}
+	}
+
+	/*
+	 * The value of the filter must remain an integer: a single operand
+	 * which isn't one is kept in a conjunction with a true constant.
+	 */
+	if (kept_count == 0 ||
+			(kept_count == 1 && operands[0]->data_type != IR_DATA_NUMERIC)) {
+		operands[kept_count] = kept_true;
+		costs[kept_count] = IR_COST_CONSTANT;
+		kept_count++;
+	} else {
+		filter_free_ir_recursive(kept_true);
+	}
+
+	/* Stable insertion sort of the remaining operands by cost. */
+	for (i = 1; i < kept_count; i++) {
+		struct ir_op *operand = operands[i];
+		const unsigned int cost = costs[i];
+
+		for (j = i; j > 0 && costs[j - 1] > cost; j--) {
+			operands[j] = operands[j - 1];
+			costs[j] = costs[j - 1];
+		}
+		operands[j] = operand;
+		costs[j] = cost;
+	}
+
+	/* Rebuild a left-deep conjunction, reusing the logical operators. */
+	root->u.root.child = operands[0];
+	operands[0]->side = IR_LEFT;
+	for (i = 1; i < kept_count; i++) {
+		struct ir_op *op = ops[i - 1];
+
+		op->u.logical.left = root->u.root.child;
+		op->u.logical.right = operands[i];
+		op->side = IR_LEFT;
+		operands[i]->side = IR_LEFT;
+		root->u.root.child = op;
+	}
+
+	for (i = kept_count - 1; i < op_count; i++) {
+		free(ops[i]);
+	}
+
+end:
+	free(operands);
+	free(ops);
+	free(costs);
+	return ret;
+}
+
+/*
+ * Simplify the IR of a filter before generating its bytecode, which is
+ * evaluated by the tracer for every event:
+ *
+ *   - integer and floating point constant sub-expressions are folded;
+ *   - the dead branches of logical operators are eliminated;
+ *   - the operands of the top-level conjunction are ordered by increasing
+ *     evaluation cost.
+ *
+ * Operands which are never evaluated are removed, and with them the fields
+ * which they reference: a filter such as `0 && field == 1` no longer fails to
+ * apply to events which don't have `field`.
+ */
+int filter_visitor_ir_optimize(struct filter_parser_ctx *ctx)
+{
+	int ret;
+
+	LTTNG_ASSERT(ctx->ir_root->op == IR_OP_ROOT);
+
+	ret = optimize_recursive(&ctx->ir_root);
+	if (ret) {
+		return ret;
+	}
+
+	ret = optimize_root_conjunction(ctx->ir_root);
+	if (ret) {
+		return ret;
+	}
+
+	ctx->ir_root->data_type = ctx->ir_root->u.root.child->data_type;
+	ctx->ir_root->signedness = ctx->ir_root->u.root.child->signedness;
+	return 0;
+}
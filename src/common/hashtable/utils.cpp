@@ -490,6 +490,14 @@ unsigned long hash_key_str(const void *key, unsigned long seed)
 	return hashlittle(key, strlen((const char *) key), seed);
 }
 
+/*
+ * Hash function for a buffer of arbitrary length.
+ */
+unsigned long hash_key_buffer(const void *key, size_t len, unsigned long seed)
+{
+	return hashlittle(key, len, seed);
+}
+
 /*
  * Hash function for two uint64_t.
  */
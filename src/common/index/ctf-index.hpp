@@ -20,6 +20,8 @@
 #define CTF_INDEX_MAGIC 0xC1F1DCC1
 #define CTF_INDEX_MAJOR 1
 #define CTF_INDEX_MINOR 1
+/* Index minor version of streams whose packets are compressed. */
+#define CTF_INDEX_COMPRESSED_MINOR 2
 
 /*
  * Header at the beginning of each index file.
@@ -48,6 +50,13 @@ struct ctf_packet_index {
 	/* CTF_INDEX 1.0 limit */
 	uint64_t stream_instance_id;	/* ID of the channel instance */
 	uint64_t packet_seq_num;	/* packet sequence number */
+	/* CTF_INDEX 1.1 limit */
+	/*
+	 * Size of the compressed packet in the file, in bytes. When set,
+	 * `offset` is the offset of the compressed packet in the file and
+	 * `packet_size` is the size of the packet once decompressed.
+	 */
+	uint64_t compressed_size;
 } __attribute__((__packed__));
 
 static inline size_t ctf_packet_index_len(uint32_t major, uint32_t minor)
@@ -62,6 +71,10 @@ static inline size_t ctf_packet_index_len(uint32_t major, uint32_t minor)
 			return offsetof(struct ctf_packet_index, packet_seq_num)
 				+ member_sizeof(struct ctf_packet_index,
 						packet_seq_num);
+		case 2:
+			return offsetof(struct ctf_packet_index, compressed_size)
+				+ member_sizeof(struct ctf_packet_index,
+						compressed_size);
 		default:
 			abort();
 		}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <common/common.hpp>
+
+#include "packet-compression.hpp"
+
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+
+/*
+ * Favor speed over ratio: packets are compressed by the consumer daemon
+ * thread that drains the ring buffers.
+ */
+#define PACKET_COMPRESSION_ZSTD_LEVEL	1
+
+struct lttng_packet_compressor {
+	ZSTD_CCtx *zstd_ctx;
+	/* Compressed packet returned by the last lttng_packet_compress(). */
+	struct lttng_dynamic_buffer buffer;
+};
+
+bool lttng_packet_compression_is_supported(
+		enum lttng_channel_compression compression)
+{
+	switch (compression) {
+	case LTTNG_CHANNEL_COMPRESSION_NONE:
+	case LTTNG_CHANNEL_COMPRESSION_ZSTD:
+		return true;
+	default:
+		return false;
+	}
+}
+
+struct lttng_packet_compressor *lttng_packet_compressor_create(
+		enum lttng_channel_compression compression)
+{
+	struct lttng_packet_compressor *compressor = NULL;
+
+	if (compression != LTTNG_CHANNEL_COMPRESSION_ZSTD) {
+		ERR("Unsupported packet compression: %d", (int) compression);
+		goto error;
+	}
+
+	compressor = zmalloc<lttng_packet_compressor>();
+	if (!compressor) {
+		PERROR("Failed to allocate packet compressor");
+		goto error;
+	}
+
+	lttng_dynamic_buffer_init(&compressor->buffer);
+	compressor->zstd_ctx = ZSTD_createCCtx();
+	if (!compressor->zstd_ctx) {
+		ERR("Failed to allocate zstd compression context");
+		goto error;
+	}
+
+	return compressor;
+error:
+	lttng_packet_compressor_destroy(compressor);
+	return NULL;
+}
+
+void lttng_packet_compressor_destroy(struct lttng_packet_compressor *compressor)
+{
+	if (!compressor) {
+		return;
+	}
+
+	ZSTD_freeCCtx(compressor->zstd_ctx);
+	lttng_dynamic_buffer_reset(&compressor->buffer);
+	free(compressor);
+}
+
+int lttng_packet_compress(struct lttng_packet_compressor *compressor,
+		const struct lttng_buffer_view *packet,
+		struct lttng_buffer_view *compressed)
+{
+	int ret;
+	size_t compressed_size;
+	const size_t bound = ZSTD_compressBound(packet->size);
+
+	/* Only grows; the buffer is reused for every packet of the stream. */
+	ret = lttng_dynamic_buffer_set_size(&compressor->buffer, bound);
+	if (ret) {
+		ERR("Failed to allocate %zu bytes compressed packet buffer",
+				bound);
+		ret = -1;
+		goto end;
+	}
+
+	compressed_size = ZSTD_compressCCtx(compressor->zstd_ctx,
+			compressor->buffer.data, bound,
+			packet->data, packet->size,
+			PACKET_COMPRESSION_ZSTD_LEVEL);
+	if (ZSTD_isError(compressed_size)) {
+		ERR("Failed to compress packet: %s",
+				ZSTD_getErrorName(compressed_size));
+		ret = -1;
+		goto end;
+	}
+
+	*compressed = lttng_buffer_view_init(
+			compressor->buffer.data, 0, compressed_size);
+	ret = 0;
+end:
+	return ret;
+}
+
+int lttng_packet_decompress(enum lttng_channel_compression compression,
+		const struct lttng_buffer_view *compressed, size_t packet_size,
+		struct lttng_dynamic_buffer *packet)
+{
+	int ret;
+	size_t decompressed_size;
+
+	if (compression != LTTNG_CHANNEL_COMPRESSION_ZSTD) {
+		ERR("Unsupported packet compression: %d", (int) compression);
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_set_size(packet, packet_size);
+	if (ret) {
+		ERR("Failed to allocate %zu bytes packet buffer", packet_size);
+		ret = -1;
+		goto end;
+	}
+
+	decompressed_size = ZSTD_decompress(packet->data, packet_size,
+			compressed->data, compressed->size);
+	if (ZSTD_isError(decompressed_size)) {
+		ERR("Failed to decompress packet: %s",
+				ZSTD_getErrorName(decompressed_size));
+		ret = -1;
+		goto end;
+	}
+
+	if (decompressed_size != packet_size) {
+		ERR("Decompressed packet size mismatch: expected %zu bytes, got %zu bytes",
+				packet_size, decompressed_size);
+		ret = -1;
+		goto end;
+	}
+
+	ret = 0;
+end:
+	return ret;
+}
+
+#else /* HAVE_LIBZSTD */
+
+bool lttng_packet_compression_is_supported(
+		enum lttng_channel_compression compression)
+{
+	return compression == LTTNG_CHANNEL_COMPRESSION_NONE;
+}
+
+struct lttng_packet_compressor *lttng_packet_compressor_create(
+		enum lttng_channel_compression compression)
+{
+	ERR("Packet compression %d is not supported by this build",
+			(int) compression);
+	return NULL;
+}
+
+void lttng_packet_compressor_destroy(
+		struct lttng_packet_compressor *compressor __attribute__((unused)))
+{
+}
+
+int lttng_packet_compress(
+		struct lttng_packet_compressor *compressor __attribute__((unused)),
+		const struct lttng_buffer_view *packet __attribute__((unused)),
+		struct lttng_buffer_view *compressed __attribute__((unused)))
+{
+	return -1;
+}
+
+int lttng_packet_decompress(enum lttng_channel_compression compression,
+		const struct lttng_buffer_view *compressed __attribute__((unused)),
+		size_t packet_size __attribute__((unused)),
+		struct lttng_dynamic_buffer *packet __attribute__((unused)))
+{
+	ERR("Packet compression %d is not supported by this build",
+			(int) compression);
+	return -1;
+}
+
+#endif /* HAVE_LIBZSTD */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_PACKET_COMPRESSION_H
+#define LTTNG_PACKET_COMPRESSION_H
+
+#include <common/buffer-view.hpp>
+#include <common/dynamic-buffer.hpp>
+#include <lttng/channel.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Per-stream packet compression state.
+ *
+ * Packets are compressed independently of each other so that any of them
+ * can be read back using only its index entry (see struct ctf_packet_index,
+ * index minor version CTF_INDEX_COMPRESSED_MINOR).
+ */
+struct lttng_packet_compressor;
+
+/*
+ * Returns true if this build supports the given compression.
+ */
+bool lttng_packet_compression_is_supported(
+		enum lttng_channel_compression compression);
+
+/*
+ * Create a compressor for the given compression. Returns NULL on error or if
+ * the compression is not supported.
+ */
+struct lttng_packet_compressor *lttng_packet_compressor_create(
+		enum lttng_channel_compression compression);
+
+void lttng_packet_compressor_destroy(struct lttng_packet_compressor *compressor);
+
+/*
+ * Compress a packet. On success, `compressed` points to the compressed
+ * packet, which is owned by the compressor and remains valid until the next
+ * call.
+ *
+ * Returns 0 on success, a negative value on error.
+ */
+int lttng_packet_compress(struct lttng_packet_compressor *compressor,
+		const struct lttng_buffer_view *packet,
+		struct lttng_buffer_view *compressed);
+
+/*
+ * Decompress a packet compressed with lttng_packet_compress() into `packet`,
+ * resized to `packet_size` bytes (the decompressed size recorded in the
+ * packet's index entry).
+ *
+ * Returns 0 on success, a negative value on error.
+ */
+int lttng_packet_decompress(enum lttng_channel_compression compression,
+		const struct lttng_buffer_view *compressed, size_t packet_size,
+		struct lttng_dynamic_buffer *packet);
+
+#endif /* LTTNG_PACKET_COMPRESSION_H */
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <common/common.hpp>
+
+#include "packet-header.hpp"
+
+int lttng_packet_header_read(const struct lttng_buffer_view *packet,
+		struct lttng_packet_header *header)
+{
+	if (packet->size < sizeof(*header)) {
+		return -1;
+	}
+
+	memcpy(header, packet->data, sizeof(*header));
+	if (header->magic != LTTNG_PACKET_HEADER_MAGIC) {
+		return -1;
+	}
+
+	return 0;
+}
+
+bool lttng_packet_header_is_empty(const struct lttng_packet_header *header)
+{
+	return header->ctx.content_size ==
+			(uint64_t) sizeof(*header) * CHAR_BIT;
+}
+
+int lttng_packet_header_trim(const struct lttng_buffer_view *packet,
+		struct lttng_dynamic_buffer *trimmed)
+{
+	int ret;
+	struct lttng_packet_header header;
+
+	ret = lttng_packet_header_read(packet, &header);
+	if (ret || !lttng_packet_header_is_empty(&header)) {
+		ret = -1;
+		goto end;
+	}
+
+	header.ctx.packet_size = header.ctx.content_size;
+	ret = lttng_dynamic_buffer_set_size(trimmed, 0);
+	if (ret) {
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_append(trimmed, &header, sizeof(header));
+end:
+	return ret;
+}
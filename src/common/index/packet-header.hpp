@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_PACKET_HEADER_H
+#define LTTNG_PACKET_HEADER_H
+
+#include <common/buffer-view.hpp>
+#include <common/dynamic-buffer.hpp>
+#include <common/macros.hpp>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LTTNG_PACKET_HEADER_MAGIC	0xC1FC1FC1
+#define LTTNG_PACKET_HEADER_UUID_LEN	16
+
+/*
+ * Packet header and context of the data packets written by the ring buffer
+ * clients of LTTng-UST and LTTng-modules (`struct packet_header`), in the
+ * tracer's native byte order.
+ *
+ * events_discarded is an `unsigned long` of the tracer. This layout is only
+ * valid when the tracer and the reader have the same bitness, which is the
+ * case of a UST consumer daemon and of a 64-bit kernel consumer daemon.
+ */
+struct lttng_packet_header {
+	uint32_t magic;
+	uint8_t uuid[LTTNG_PACKET_HEADER_UUID_LEN];
+	uint32_t stream_id;
+	uint64_t stream_instance_id;
+	struct {
+		uint64_t timestamp_begin;
+		uint64_t timestamp_end;
+		uint64_t content_size;
+		uint64_t packet_size;
+		uint64_t packet_seq_num;
+		unsigned long events_discarded;
+		uint32_t cpu_id;
+	} LTTNG_PACKED ctx;
+} LTTNG_PACKED;
+
+/*
+ * Read the packet header and context at the beginning of a packet.
+ *
+ * Returns 0 on success, or -1 if the packet is too small to contain a header
+ * or doesn't start with the CTF magic number.
+ */
+int lttng_packet_header_read(const struct lttng_buffer_view *packet,
+		struct lttng_packet_header *header);
+
+/*
+ * Returns true if a packet contains no event record, that is if its content
+ * ends with its packet context.
+ */
+bool lttng_packet_header_is_empty(const struct lttng_packet_header *header);
+
+/*
+ * Copy the packet header and context of an empty packet to `trimmed`, with
+ * its packet_size patched to the size of the copy. The result is a valid
+ * packet without the original packet's padding.
+ *
+ * Returns 0 on success, or -1 if the packet is not empty or on allocation
+ * error.
+ */
+int lttng_packet_header_trim(const struct lttng_buffer_view *packet,
+		struct lttng_dynamic_buffer *trimmed);
+
+#endif /* LTTNG_PACKET_HEADER_H */
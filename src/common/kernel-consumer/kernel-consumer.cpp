@@ -30,6 +30,7 @@
 #include <common/pipe.hpp>
 #include <common/relayd/relayd.hpp>
 #include <common/utils.hpp>
+#include <common/consumer/consumer-snapshot.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/index/index.hpp>
 #include <common/consumer/consumer-timer.hpp>
@@ -135,20 +136,164 @@ error:
 	return ret;
 }
 
+/*
+ * Record the sampled sub-buffers of a stream of a snapshot.
+ *
+ * Returns 0 on success, < 0 on error
+ */
+static int record_snapshot_stream(
+		struct consumer_snapshot_stream *snapshot_stream)
+{
+	int ret;
+	unsigned long consumed_pos = snapshot_stream->consumed_pos;
+	struct lttng_consumer_stream *stream = snapshot_stream->stream;
+	struct lttng_consumer_channel *channel = stream->chan;
+	const uint64_t relayd_id = snapshot_stream->relayd_id;
+
+	health_code_update();
+
+	/*
+	 * Lock stream because we are about to change its state.
+	 */
+	pthread_mutex_lock(&stream->lock);
+
+	LTTNG_ASSERT(channel->trace_chunk);
+	if (!lttng_trace_chunk_get(channel->trace_chunk)) {
+		/*
+		 * Can't happen barring an internal error as the channel
+		 * holds a reference to the trace chunk.
+		 */
+		ERR("Failed to acquire reference to channel's trace chunk");
+		ret = -1;
+		goto end_unlock;
+	}
+	LTTNG_ASSERT(!stream->trace_chunk);
+	stream->trace_chunk = channel->trace_chunk;
+
+	/*
+	 * Assign the received relayd ID so we can use it for streaming. The streams
+	 * are not visible to anyone so this is OK to change it.
+	 */
+	stream->net_seq_idx = relayd_id;
+	if (relayd_id != (uint64_t) -1ULL) {
+		ret = consumer_send_relayd_stream(stream, snapshot_stream->path);
+		if (ret < 0) {
+			ERR("sending stream to relayd");
+			goto error_close_stream_output;
+		}
+	} else {
+		ret = consumer_stream_create_output_files(stream,
+				false);
+		if (ret < 0) {
+			goto error_close_stream_output;
+		}
+		DBG("Kernel consumer snapshot stream (%" PRIu64 ")",
+				stream->key);
+	}
+
+	while ((long) (consumed_pos - snapshot_stream->produced_pos) < 0) {
+		ssize_t read_len;
+		unsigned long len, padded_len;
+		const char *subbuf_addr;
+		struct lttng_buffer_view subbuf_view;
+
+		health_code_update();
+		DBG("Kernel consumer taking snapshot at pos %lu", consumed_pos);
+
+		ret = kernctl_get_subbuf(stream->wait_fd, &consumed_pos);
+		if (ret < 0) {
+			if (ret != -EAGAIN) {
+				PERROR("kernctl_get_subbuf snapshot");
+				goto error_close_stream_output;
+			}
+			DBG("Kernel consumer get subbuf failed. Skipping it.");
+			consumed_pos += stream->max_sb_size;
+			snapshot_stream->lost_packets++;
+			continue;
+		}
+
+		ret = kernctl_get_subbuf_size(stream->wait_fd, &len);
+		if (ret < 0) {
+			ERR("Snapshot kernctl_get_subbuf_size");
+			goto error_put_subbuf;
+		}
+
+		ret = kernctl_get_padded_subbuf_size(stream->wait_fd, &padded_len);
+		if (ret < 0) {
+			ERR("Snapshot kernctl_get_padded_subbuf_size");
+			goto error_put_subbuf;
+		}
+
+		ret = get_current_subbuf_addr(stream, &subbuf_addr);
+		if (ret) {
+			goto error_put_subbuf;
+		}
+
+		subbuf_view = lttng_buffer_view_init(
+				subbuf_addr, 0, padded_len);
+		read_len = lttng_consumer_on_read_subbuffer_mmap(
+				stream, &subbuf_view,
+				padded_len - len);
+		/*
+		 * We write the padded len in local tracefiles but the data len
+		 * when using a relay. Display the error but continue processing
+		 * to try to release the subbuffer.
+		 */
+		if (relayd_id != (uint64_t) -1ULL) {
+			if (read_len != len) {
+				ERR("Error sending to the relay (ret: %zd != len: %lu)",
+						read_len, len);
+			}
+		} else {
+			if (read_len != padded_len) {
+				ERR("Error writing to tracefile (ret: %zd != len: %lu)",
+						read_len, padded_len);
+			}
+		}
+
+		ret = kernctl_put_subbuf(stream->wait_fd);
+		if (ret < 0) {
+			ERR("Snapshot kernctl_put_subbuf");
+			goto error_close_stream_output;
+		}
+		consumed_pos += stream->max_sb_size;
+	}
+
+	consumer_stream_close_output(stream);
+	pthread_mutex_unlock(&stream->lock);
+	return 0;
+
+error_put_subbuf:
+	ret = kernctl_put_subbuf(stream->wait_fd);
+	if (ret < 0) {
+		ERR("Snapshot kernctl_put_subbuf error path");
+	}
+error_close_stream_output:
+	consumer_stream_close_output(stream);
+end_unlock:
+	pthread_mutex_unlock(&stream->lock);
+	return ret;
+}
+
 /*
  * Take a snapshot of all the stream of a channel
  * RCU read-side lock must be held across this function to ensure existence of
  * channel.
  *
+ * The positions of all the streams are sampled before recording them
+ * concurrently (see consumer_snapshot_record_streams()).
+ *
  * Returns 0 on success, < 0 on error
  */
 static int lttng_kconsumer_snapshot_channel(
 		struct lttng_consumer_channel *channel,
 		uint64_t key, char *path, uint64_t relayd_id,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream, bool incremental)
 {
 	int ret;
+	size_t stream_count = 0, sampled_count = 0;
 	struct lttng_consumer_stream *stream;
+	struct consumer_snapshot_stream *snapshot_streams = NULL;
 
 	DBG("Kernel consumer snapshot channel %" PRIu64, key);
 
@@ -166,50 +311,27 @@ static int lttng_kconsumer_snapshot_channel(
 	}
 
 	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		stream_count++;
+	}
+
+	snapshot_streams = calloc<consumer_snapshot_stream>(stream_count);
+	if (stream_count && !snapshot_streams) {
+		PERROR("Failed to allocate snapshot streams");
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	channel->relayd_id = relayd_id;
+
+	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		struct consumer_snapshot_stream *snapshot_stream =
+				&snapshot_streams[sampled_count];
 		unsigned long consumed_pos, produced_pos;
 
 		health_code_update();
 
-		/*
-		 * Lock stream because we are about to change its state.
-		 */
 		pthread_mutex_lock(&stream->lock);
 
-		LTTNG_ASSERT(channel->trace_chunk);
-		if (!lttng_trace_chunk_get(channel->trace_chunk)) {
-			/*
-			 * Can't happen barring an internal error as the channel
-			 * holds a reference to the trace chunk.
-			 */
-			ERR("Failed to acquire reference to channel's trace chunk");
-			ret = -1;
-			goto end_unlock;
-		}
-		LTTNG_ASSERT(!stream->trace_chunk);
-		stream->trace_chunk = channel->trace_chunk;
-
-		/*
-		 * Assign the received relayd ID so we can use it for streaming. The streams
-		 * are not visible to anyone so this is OK to change it.
-		 */
-		stream->net_seq_idx = relayd_id;
-		channel->relayd_id = relayd_id;
-		if (relayd_id != (uint64_t) -1ULL) {
-			ret = consumer_send_relayd_stream(stream, path);
-			if (ret < 0) {
-				ERR("sending stream to relayd");
-				goto error_close_stream_output;
-			}
-		} else {
-			ret = consumer_stream_create_output_files(stream,
-					false);
-			if (ret < 0) {
-				goto error_close_stream_output;
-			}
-			DBG("Kernel consumer snapshot stream (%" PRIu64 ")",
-					stream->key);
-		}
-
 		ret = kernctl_buffer_flush_empty(stream->wait_fd);
 		if (ret < 0) {
 			/*
@@ -222,119 +344,49 @@ static int lttng_kconsumer_snapshot_channel(
 			ret = kernctl_buffer_flush(stream->wait_fd);
 			if (ret < 0) {
 				ERR("Failed to flush kernel stream");
-				goto error_close_stream_output;
+				goto end_unlock;
 			}
-			goto end_unlock;
+			pthread_mutex_unlock(&stream->lock);
+			break;
 		}
 
 		ret = lttng_kconsumer_take_snapshot(stream);
 		if (ret < 0) {
 			ERR("Taking kernel snapshot");
-			goto error_close_stream_output;
+			goto end_unlock;
 		}
 
 		ret = lttng_kconsumer_get_produced_snapshot(stream, &produced_pos);
 		if (ret < 0) {
 			ERR("Produced kernel snapshot position");
-			goto error_close_stream_output;
+			goto end_unlock;
 		}
 
 		ret = lttng_kconsumer_get_consumed_snapshot(stream, &consumed_pos);
 		if (ret < 0) {
 			ERR("Consumerd kernel snapshot position");
-			goto error_close_stream_output;
-		}
-
-		consumed_pos = consumer_get_consume_start_pos(consumed_pos,
-				produced_pos, nb_packets_per_stream,
-				stream->max_sb_size);
-
-		while ((long) (consumed_pos - produced_pos) < 0) {
-			ssize_t read_len;
-			unsigned long len, padded_len;
-			const char *subbuf_addr;
-			struct lttng_buffer_view subbuf_view;
-
-			health_code_update();
-			DBG("Kernel consumer taking snapshot at pos %lu", consumed_pos);
-
-			ret = kernctl_get_subbuf(stream->wait_fd, &consumed_pos);
-			if (ret < 0) {
-				if (ret != -EAGAIN) {
-					PERROR("kernctl_get_subbuf snapshot");
-					goto error_close_stream_output;
-				}
-				DBG("Kernel consumer get subbuf failed. Skipping it.");
-				consumed_pos += stream->max_sb_size;
-				stream->chan->lost_packets++;
-				continue;
-			}
-
-			ret = kernctl_get_subbuf_size(stream->wait_fd, &len);
-			if (ret < 0) {
-				ERR("Snapshot kernctl_get_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = kernctl_get_padded_subbuf_size(stream->wait_fd, &padded_len);
-			if (ret < 0) {
-				ERR("Snapshot kernctl_get_padded_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = get_current_subbuf_addr(stream, &subbuf_addr);
-			if (ret) {
-				goto error_put_subbuf;
-			}
-
-			subbuf_view = lttng_buffer_view_init(
-					subbuf_addr, 0, padded_len);
-			read_len = lttng_consumer_on_read_subbuffer_mmap(
-					stream, &subbuf_view,
-					padded_len - len);
-			/*
-			 * We write the padded len in local tracefiles but the data len
-			 * when using a relay. Display the error but continue processing
-			 * to try to release the subbuffer.
-			 */
-			if (relayd_id != (uint64_t) -1ULL) {
-				if (read_len != len) {
-					ERR("Error sending to the relay (ret: %zd != len: %lu)",
-							read_len, len);
-				}
-			} else {
-				if (read_len != padded_len) {
-					ERR("Error writing to tracefile (ret: %zd != len: %lu)",
-							read_len, padded_len);
-				}
-			}
-
-			ret = kernctl_put_subbuf(stream->wait_fd);
-			if (ret < 0) {
-				ERR("Snapshot kernctl_put_subbuf");
-				goto error_close_stream_output;
-			}
-			consumed_pos += stream->max_sb_size;
+			goto end_unlock;
 		}
-
-		consumer_stream_close_output(stream);
 		pthread_mutex_unlock(&stream->lock);
+
+		snapshot_stream->stream = stream;
+		snapshot_stream->path = path;
+		snapshot_stream->relayd_id = relayd_id;
+		snapshot_stream->produced_pos = produced_pos;
+		snapshot_stream->consumed_pos = consumer_snapshot_get_start_pos(
+				stream, consumed_pos, produced_pos,
+				nb_packets_per_stream, incremental);
+		sampled_count++;
 	}
 
-	/* All good! */
-	ret = 0;
+	ret = consumer_snapshot_record_streams(snapshot_streams, sampled_count,
+			record_snapshot_stream);
 	goto end;
 
-error_put_subbuf:
-	ret = kernctl_put_subbuf(stream->wait_fd);
-	if (ret < 0) {
-		ERR("Snapshot kernctl_put_subbuf error path");
-	}
-error_close_stream_output:
-	consumer_stream_close_output(stream);
 end_unlock:
 	pthread_mutex_unlock(&stream->lock);
 end:
+	free(snapshot_streams);
 	rcu_read_unlock();
 	pthread_mutex_unlock(&channel->lock);
 	return ret;
@@ -529,6 +581,10 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 			ERR("Channel output unknown %d", msg.u.channel.output);
 			goto end_nosignal;
 		}
+		new_channel->compression = (enum lttng_channel_compression)
+				msg.u.channel.compression;
+		new_channel->suppress_empty_packets =
+				!!msg.u.channel.suppress_empty_packets;
 
 		/* Translate and save channel type. */
 		switch (msg.u.channel.type) {
@@ -784,8 +840,8 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 			consumer_add_metadata_stream(new_stream);
 			stream_pipe = ctx->consumer_metadata_pipe;
 		} else {
-			consumer_add_data_stream(new_stream);
-			stream_pipe = ctx->consumer_data_pipe;
+			consumer_add_data_stream(new_stream, ctx);
+			stream_pipe = new_stream->data_thread->data_pipe;
 		}
 
 		/* Visible to other threads */
@@ -976,7 +1032,8 @@ error_streams_sent_nosignal:
 						msg.u.snapshot_channel.pathname,
 						msg.u.snapshot_channel.relayd_id,
 						msg.u.snapshot_channel
-								.nb_packets_per_stream);
+								.nb_packets_per_stream,
+						msg.u.snapshot_channel.incremental);
 				if (ret_snapshot < 0) {
 					ERR("Snapshot channel failed");
 					ret_code = LTTCOMM_CONSUMERD_SNAPSHOT_FAILED;
@@ -1377,6 +1434,16 @@ error_rotate_channel:
 		health_code_update();
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_GET_STREAM_STATS:
+	{
+		/* The statistics are the reply; no status message is sent. */
+		if (lttng_consumer_send_stream_stats(sock,
+				msg.u.get_stream_stats.session_id)) {
+			goto error_fatal;
+		}
+
+		goto end_nosignal;
+	}
 	default:
 		goto end_nosignal;
 	}
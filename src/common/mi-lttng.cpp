@@ -169,6 +169,7 @@ const char * const mi_lttng_loglevel_type_unknown = "UNKNOWN";
 const char * const mi_lttng_element_snapshot_ctrl_url = "ctrl_url";
 const char * const mi_lttng_element_snapshot_data_url = "data_url";
 const char * const mi_lttng_element_snapshot_max_size = "max_size";
+const char * const mi_lttng_element_snapshot_incremental = "incremental";
 const char * const mi_lttng_element_snapshot_n_ptr = "n_ptr";
 const char * const mi_lttng_element_snapshot_session_name = "session_name";
 const char * const mi_lttng_element_snapshots = "snapshots";
@@ -2255,6 +2256,14 @@ int mi_lttng_snapshot_list_output(struct mi_writer *writer,
 		goto end;
 	}
 
+	/* Only record the packets produced since the previous snapshot */
+	ret = mi_lttng_writer_write_element_bool(writer,
+			mi_lttng_element_snapshot_incremental,
+			output->incremental);
+	if (ret) {
+		goto end;
+	}
+
 	/* Close snapshot output element */
 	ret = mi_lttng_writer_close_element(writer);
 
@@ -2360,6 +2369,14 @@ int mi_lttng_snapshot_add_output(struct mi_writer *writer,
 		goto end;
 	}
 
+	/* Only record the packets produced since the previous snapshot */
+	ret = mi_lttng_writer_write_element_bool(writer,
+			mi_lttng_element_snapshot_incremental,
+			output->incremental);
+	if (ret) {
+		goto end;
+	}
+
 	/* Close snapshot element */
 	ret = mi_lttng_writer_close_element(writer);
 
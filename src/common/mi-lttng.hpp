@@ -192,6 +192,7 @@ LTTNG_EXPORT extern const char * const mi_lttng_loglevel_type_unknown;
 LTTNG_EXPORT extern const char * const mi_lttng_element_snapshot_ctrl_url;
 LTTNG_EXPORT extern const char * const mi_lttng_element_snapshot_data_url;
 LTTNG_EXPORT extern const char * const mi_lttng_element_snapshot_max_size;
+extern const char * const mi_lttng_element_snapshot_incremental;
 LTTNG_EXPORT extern const char * const mi_lttng_element_snapshot_n_ptr;
 LTTNG_EXPORT extern const char * const mi_lttng_element_snapshot_session_name;
 LTTNG_EXPORT extern const char * const mi_lttng_element_snapshots;
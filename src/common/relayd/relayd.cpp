@@ -45,6 +45,17 @@ bool relayd_supports_get_configuration(const struct lttcomm_relayd_sock *sock)
 	return false;
 }
 
+static
+bool relayd_supports_get_viewer_status(const struct lttcomm_relayd_sock *sock)
+{
+	if (sock->major > 2) {
+		return true;
+	} else if (sock->major == 2 && sock->minor >= 14) {
+		return true;
+	}
+	return false;
+}
+
 /*
  * Send command. Fill up the header and append the data.
  */
@@ -1080,15 +1091,18 @@ error:
 }
 
 /*
- * Send index to the relayd.
+ * Send an index command to the relayd without waiting for its reply, which
+ * must be received with relayd_recv_index_reply(). Several index commands can
+ * be sent before their replies are received; the relayd replies in order.
+ *
+ * Nothing is sent to a relayd older than 2.4.
  */
-int relayd_send_index(struct lttcomm_relayd_sock *rsock,
-		struct ctf_packet_index *index, uint64_t relay_stream_id,
+int relayd_send_index_command(struct lttcomm_relayd_sock *rsock,
+		const struct ctf_packet_index *index, uint64_t relay_stream_id,
 		uint64_t net_seq_num)
 {
 	int ret;
 	struct lttcomm_relayd_index msg;
-	struct lttcomm_relayd_generic_reply reply;
 
 	/* Code flow error. Safety net. */
 	LTTNG_ASSERT(rsock);
@@ -1128,6 +1142,28 @@ int relayd_send_index(struct lttcomm_relayd_sock *rsock,
 		goto error;
 	}
 
+	ret = 0;
+error:
+	return ret;
+}
+
+/*
+ * Receive the reply to an index command sent with relayd_send_index_command().
+ */
+int relayd_recv_index_reply(struct lttcomm_relayd_sock *rsock)
+{
+	int ret;
+	struct lttcomm_relayd_generic_reply reply;
+
+	/* Code flow error. Safety net. */
+	LTTNG_ASSERT(rsock);
+
+	if (rsock->minor < 4) {
+		/* No command was sent. */
+		ret = 0;
+		goto error;
+	}
+
 	/* Receive response */
 	ret = recv_reply(rsock, (void *) &reply, sizeof(reply));
 	if (ret < 0) {
@@ -1587,3 +1623,49 @@ int relayd_get_configuration(struct lttcomm_relayd_sock *sock,
 end:
 	return ret;
 }
+
+/*
+ * Ask the relay daemon whether a live viewer is attached to the session of
+ * the control socket.
+ *
+ * A relay daemon not supporting the command is assumed to have a viewer
+ * attached.
+ */
+int relayd_get_viewer_status(struct lttcomm_relayd_sock *sock,
+		bool *viewer_attached)
+{
+	int ret = 0;
+	struct lttcomm_relayd_get_viewer_status_reply reply = {};
+
+	if (!relayd_supports_get_viewer_status(sock)) {
+		DBG("Refusing to get viewer status (unsupported by relayd)");
+		*viewer_attached = true;
+		goto end;
+	}
+
+	ret = send_command(sock, RELAYD_GET_VIEWER_STATUS, NULL, 0, 0);
+	if (ret < 0) {
+		ERR("Failed to send get viewer status command to relay daemon");
+		goto end;
+	}
+
+	ret = recv_reply(sock, &reply, sizeof(reply));
+	if (ret < 0) {
+		ERR("Failed to receive relay daemon get viewer status command reply");
+		goto end;
+	}
+
+	reply.generic.ret_code = be32toh(reply.generic.ret_code);
+	if (reply.generic.ret_code != LTTNG_OK) {
+		ret = -1;
+		ERR("Relayd get viewer status replied error %d",
+				reply.generic.ret_code);
+	} else {
+		ret = 0;
+		*viewer_attached = !!reply.viewer_attached;
+		DBG("Relayd successfully got viewer status: viewer_attached = %d",
+				(int) *viewer_attached);
+	}
+end:
+	return ret;
+}
@@ -57,9 +57,10 @@ int relayd_quiescent_control(struct lttcomm_relayd_sock *sock,
 int relayd_begin_data_pending(struct lttcomm_relayd_sock *sock, uint64_t id);
 int relayd_end_data_pending(struct lttcomm_relayd_sock *sock, uint64_t id,
 		unsigned int *is_data_inflight);
-int relayd_send_index(struct lttcomm_relayd_sock *rsock,
-		struct ctf_packet_index *index, uint64_t relay_stream_id,
+int relayd_send_index_command(struct lttcomm_relayd_sock *rsock,
+		const struct ctf_packet_index *index, uint64_t relay_stream_id,
 		uint64_t net_seq_num);
+int relayd_recv_index_reply(struct lttcomm_relayd_sock *rsock);
 int relayd_reset_metadata(struct lttcomm_relayd_sock *rsock,
 		uint64_t stream_id, uint64_t version);
 /* `positions` is an array of `stream_count` relayd_stream_rotation_position. */
@@ -76,5 +77,7 @@ int relayd_trace_chunk_exists(struct lttcomm_relayd_sock *sock,
 int relayd_get_configuration(struct lttcomm_relayd_sock *sock,
 		uint64_t query_flags,
 		uint64_t *result_flags);
+int relayd_get_viewer_status(struct lttcomm_relayd_sock *sock,
+		bool *viewer_attached);
 
 #endif /* _RELAYD_H */
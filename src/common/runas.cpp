@@ -38,6 +38,7 @@
 
 #include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/filter/filter-ast.hpp>
+#include <common/filter/filter-bytecode-cache.hpp>
 
 #include "runas.hpp"
 
@@ -1988,17 +1989,37 @@ int run_as_generate_filter_bytecode(const char *filter_expression,
 	DBG3("generate_filter_bytecode() from expression=\"%s\" for uid %d and gid %d",
 			filter_expression, (int) uid, (int) gid);
 
+	/*
+	 * The bytecode only depends on the expression: an expression which was
+	 * already compiled, whatever the credentials, doesn't need to be
+	 * parsed again.
+	 *
+	 * Skipping the run-as worker is safe. The worker parses the expression
+	 * with the caller's credentials so that untrusted input is not parsed
+	 * by a privileged process; it accesses no resource on their behalf, so
+	 * they can't change the outcome. A lookup only normalizes the
+	 * expression's blanks, and entries are only added once the worker has
+	 * successfully compiled the expression.
+	 */
+	local_bytecode = filter_bytecode_cache_lookup(filter_expression);
+	if (local_bytecode) {
+		DBG3("Reusing cached bytecode of filter expression");
+		*bytecode = local_bytecode;
+		ret = 0;
+		goto end;
+	}
+
 	ret = lttng_strncpy(data.u.generate_filter_bytecode.filter_expression, filter_expression,
 			sizeof(data.u.generate_filter_bytecode.filter_expression));
 	if (ret) {
-		goto error;
+		goto end;
 	}
 
 	run_as(RUN_AS_GENERATE_FILTER_BYTECODE, &data, &run_as_ret, uid, gid);
 	errno = run_as_ret._errno;
 	if (run_as_ret._error) {
 		ret = -1;
-		goto error;
+		goto end;
 	}
 
 	view_bytecode = (const struct lttng_bytecode *) run_as_ret.u.generate_filter_bytecode.bytecode;
@@ -2006,13 +2027,14 @@ int run_as_generate_filter_bytecode(const char *filter_expression,
 	local_bytecode = calloc<lttng_bytecode>(view_bytecode->len);
 	if (!local_bytecode) {
 		ret = -ENOMEM;
-		goto error;
+		goto end;
 	}
 
 	memcpy(local_bytecode, run_as_ret.u.generate_filter_bytecode.bytecode,
 			sizeof(*local_bytecode) + view_bytecode->len);
+	filter_bytecode_cache_add(filter_expression, local_bytecode);
 	*bytecode = local_bytecode;
-error:
+end:
 	return ret;
 }
 
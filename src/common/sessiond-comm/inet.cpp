@@ -17,6 +17,11 @@
 #include <fcntl.h>
 #include <common/compat/time.hpp>
 #include <poll.h>
+#include <netinet/in.h>
+
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <common/common.hpp>
 #include <common/time.hpp>
@@ -26,6 +31,11 @@
 
 #define RECONNECT_DELAY	200	/* ms */
 
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && \
+		defined(SO_EE_ORIGIN_ZEROCOPY)
+#define LTTCOMM_HAVE_ZEROCOPY
+#endif
+
 /*
  * INET protocol operations.
  */
@@ -433,6 +443,202 @@ ssize_t lttcomm_sendmsg_inet_sock(struct lttcomm_sock *sock, const void *buf,
 	return ret;
 }
 
+#ifdef LTTCOMM_HAVE_ZEROCOPY
+/*
+ * Enable zero-copy transmission on a connected TCP socket.
+ *
+ * Return 0 on success, -1 if the socket does not support it.
+ */
+int lttcomm_enable_zerocopy_inet_sock(struct lttcomm_sock *sock)
+{
+	int ret;
+	const int enable = 1;
+
+	if (sock->proto != LTTCOMM_SOCK_TCP) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = setsockopt(sock->fd, SOL_SOCKET, SO_ZEROCOPY, &enable,
+			sizeof(enable));
+	if (ret < 0) {
+		PERROR("setsockopt SO_ZEROCOPY");
+	}
+
+end:
+	return ret;
+}
+
+/*
+ * Send buf data of size len using MSG_ZEROCOPY. `sent` is incremented for
+ * every send which will be acknowledged on the socket's error queue.
+ *
+ * When the kernel refuses to pin more pages (ENOBUFS), the remainder of the
+ * buffer is sent through an ordinary copying write.
+ *
+ * Return the size of sent data, or a negative value on error.
+ */
+ssize_t lttcomm_sendmsg_zerocopy_inet_sock(struct lttcomm_sock *sock,
+		const void *buf, size_t len, uint32_t *sent)
+{
+	ssize_t ret;
+	const char *ptr = (const char *) buf;
+	size_t left = len;
+
+	while (left > 0) {
+		struct msghdr msg = {};
+		struct iovec iov;
+
+		iov.iov_base = (void *) ptr;
+		iov.iov_len = left;
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+
+		ret = sendmsg(sock->fd, &msg, MSG_ZEROCOPY);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno == ENOBUFS) {
+				DBG("Zero-copy send refused, falling back to copy for %zu bytes",
+						left);
+				ret = lttng_write(sock->fd, ptr, left);
+				if (ret < 0 || (size_t) ret != left) {
+					goto error;
+				}
+				break;
+			}
+
+			goto error;
+		}
+
+		(*sent)++;
+		ptr += ret;
+		left -= ret;
+	}
+
+	return len;
+
+error:
+	if (errno != EPIPE || !lttng_opt_quiet) {
+		PERROR("sendmsg zerocopy inet");
+	}
+	return -1;
+}
+
+/*
+ * Wait until the kernel has released the buffers of the sends issued before
+ * the send counter reached `target`, that is until `completed` catches up
+ * with `target`. Completion notifications of a TCP socket are reported in
+ * order, possibly coalesced into ranges.
+ *
+ * Return 0 on success, -1 on error or timeout.
+ */
+int lttcomm_wait_zerocopy_inet_sock(struct lttcomm_sock *sock,
+		uint32_t target, uint32_t *completed)
+{
+	int ret = 0;
+	const int timeout_ms = lttcomm_inet_tcp_timeout ?
+			(int) (lttcomm_inet_tcp_timeout * 1000) : -1;
+
+	/* The counters wrap around. */
+	while ((int32_t) (*completed - target) < 0) {
+		char control[128];
+		struct msghdr msg = {};
+		struct cmsghdr *cmsg;
+		ssize_t recv_ret;
+
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		recv_ret = recvmsg(sock->fd, &msg, MSG_ERRQUEUE);
+		if (recv_ret < 0) {
+			struct pollfd pfd = {};
+
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				PERROR("recvmsg MSG_ERRQUEUE");
+				ret = -1;
+				goto end;
+			}
+
+			/* The error queue is signaled through POLLERR. */
+			pfd.fd = sock->fd;
+			ret = poll(&pfd, 1, timeout_ms);
+			if (ret < 0 && errno != EINTR) {
+				PERROR("poll zerocopy completion");
+				ret = -1;
+				goto end;
+			} else if (ret == 0) {
+				ERR("Timed out waiting for zero-copy send completion (target: %u, completed: %u)",
+						target, *completed);
+				ret = -1;
+				goto end;
+			}
+
+			ret = 0;
+			continue;
+		}
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			const struct sock_extended_err *serr;
+
+			if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+					!(cmsg->cmsg_level == SOL_IPV6 &&
+							cmsg->cmsg_type == IPV6_RECVERR)) {
+				continue;
+			}
+
+			serr = (const struct sock_extended_err *) CMSG_DATA(cmsg);
+			if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+				continue;
+			}
+
+			if (serr->ee_errno != 0) {
+				errno = serr->ee_errno;
+				PERROR("Zero-copy send completion");
+				ret = -1;
+				goto end;
+			}
+
+			/* ee_data is the id of the last send of the completed range. */
+			*completed = serr->ee_data + 1;
+		}
+	}
+
+end:
+	return ret;
+}
+#else /* LTTCOMM_HAVE_ZEROCOPY */
+int lttcomm_enable_zerocopy_inet_sock(
+		struct lttcomm_sock *sock __attribute__((unused)))
+{
+	return -1;
+}
+
+ssize_t lttcomm_sendmsg_zerocopy_inet_sock(
+		struct lttcomm_sock *sock __attribute__((unused)),
+		const void *buf __attribute__((unused)),
+		size_t len __attribute__((unused)),
+		uint32_t *sent __attribute__((unused)))
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+int lttcomm_wait_zerocopy_inet_sock(
+		struct lttcomm_sock *sock __attribute__((unused)),
+		uint32_t target __attribute__((unused)),
+		uint32_t *completed __attribute__((unused)))
+{
+	return -1;
+}
+#endif /* LTTCOMM_HAVE_ZEROCOPY */
+
 /*
  * Shutdown cleanly and close.
  */
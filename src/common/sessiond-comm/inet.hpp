@@ -50,6 +50,22 @@ extern ssize_t lttcomm_recvmsg_inet_sock(struct lttcomm_sock *sock, void *buf,
 extern ssize_t lttcomm_sendmsg_inet_sock(struct lttcomm_sock *sock,
 		const void *buf, size_t len, int flags);
 
+/*
+ * Zero-copy transmission (MSG_ZEROCOPY) of TCP sockets.
+ *
+ * Each successful zero-copy send is identified by a per-socket, free-running
+ * 32-bit counter maintained by the kernel. The caller keeps track of the
+ * number of sends issued (`sent`) and completed (`completed`) and must not
+ * modify the memory handed to lttcomm_sendmsg_zerocopy_inet_sock() until
+ * lttcomm_wait_zerocopy_inet_sock() reports that the sends issued up to that
+ * point have completed.
+ */
+extern int lttcomm_enable_zerocopy_inet_sock(struct lttcomm_sock *sock);
+extern ssize_t lttcomm_sendmsg_zerocopy_inet_sock(struct lttcomm_sock *sock,
+		const void *buf, size_t len, uint32_t *sent);
+extern int lttcomm_wait_zerocopy_inet_sock(struct lttcomm_sock *sock,
+		uint32_t target, uint32_t *completed);
+
 /* Initialize inet communication layer. */
 extern void lttcomm_inet_init(void);
 
@@ -357,4 +357,13 @@ struct lttcomm_relayd_get_configuration_reply {
 	char payload[];
 } LTTNG_PACKED;
 
+/*
+ * Reply to the RELAYD_GET_VIEWER_STATUS command, which has no payload as it
+ * applies to the session of the control connection.
+ */
+struct lttcomm_relayd_get_viewer_status_reply {
+	struct lttcomm_relayd_generic_reply generic;
+	uint8_t viewer_attached;
+} LTTNG_PACKED;
+
 #endif	/* _RELAYD_COMM */
@@ -93,6 +93,8 @@ enum lttcomm_sessiond_command {
 	LTTCOMM_SESSIOND_COMMAND_CLEAR_SESSION,
 	LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS,
 	LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY,
+	LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS,
+	LTTCOMM_SESSIOND_COMMAND_ENABLE_EVENTS,
 	LTTCOMM_SESSIOND_COMMAND_MAX,
 };
 
@@ -192,6 +194,10 @@ const char *lttcomm_sessiond_command_str(enum lttcomm_sessiond_command cmd)
 		return "LIST_TRIGGERS";
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
 		return "EXECUTE_ERROR_QUERY";
+	case LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS:
+		return "LIST_STREAM_STATS";
+	case LTTCOMM_SESSIOND_COMMAND_ENABLE_EVENTS:
+		return "ENABLE_EVENTS";
 	default:
 		abort();
 	}
@@ -228,6 +234,8 @@ enum lttcomm_relayd_command {
 	RELAYD_TRACE_CHUNK_EXISTS           = 21,
 	/* Get the current configuration of a relayd peer (2.12+) */
 	RELAYD_GET_CONFIGURATION            = 22,
+	/* Ask the relay whether a live viewer is attached to the session (2.14+) */
+	RELAYD_GET_VIEWER_STATUS            = 23,
 
 	/* Feature branch specific commands start at 10000. */
 };
@@ -280,6 +288,8 @@ const char *lttcomm_relayd_command_str(lttcomm_relayd_command cmd)
 		return "RELAYD_TRACE_CHUNK_EXISTS";
 	case RELAYD_GET_CONFIGURATION:
 		return "RELAYD_GET_CONFIGURATION";
+	case RELAYD_GET_VIEWER_STATUS:
+		return "RELAYD_GET_VIEWER_STATUS";
 	default:
 		abort();
 	}
@@ -427,6 +437,12 @@ struct lttcomm_session_msg {
 			char channel_name[LTTNG_SYMBOL_NAME_LEN];
 			uint32_t length;
 		} LTTNG_PACKED enable;
+		/* Batch of serialized events, each with its own filter. */
+		struct {
+			char channel_name[LTTNG_SYMBOL_NAME_LEN];
+			uint32_t count;
+			uint32_t length;
+		} LTTNG_PACKED enable_events;
 		struct {
 			char channel_name[LTTNG_SYMBOL_NAME_LEN];
 			uint32_t length;
@@ -664,6 +680,8 @@ struct lttcomm_consumer_msg {
 			uint8_t is_live;
 			/* timer to sample a channel's positions (usec). */
 			unsigned int monitor_timer_interval;
+			uint8_t compression; /* enum lttng_channel_compression */
+			uint8_t suppress_empty_packets;
 		} LTTNG_PACKED channel; /* Only used by Kernel. */
 		struct {
 			uint64_t stream_key;
@@ -729,6 +747,8 @@ struct lttcomm_consumer_msg {
 			int64_t blocking_timeout;
 			char root_shm_path[PATH_MAX];
 			char shm_path[PATH_MAX];
+			uint8_t compression; /* enum lttng_channel_compression */
+			uint8_t suppress_empty_packets;
 		} LTTNG_PACKED ask_channel;
 		struct {
 			uint64_t key;
@@ -762,6 +782,8 @@ struct lttcomm_consumer_msg {
 			uint64_t relayd_id;		/* Relayd id if apply. */
 			uint64_t key;
 			uint64_t nb_packets_per_stream;
+			/* Only record the sub-buffers produced since the last snapshot. */
+			uint8_t incremental;
 		} LTTNG_PACKED snapshot_channel;
 		struct {
 			uint64_t channel_key;
@@ -835,6 +857,9 @@ struct lttcomm_consumer_msg {
 		struct {
 			uint64_t key;
 		} LTTNG_PACKED open_channel_packets;
+		struct {
+			uint64_t session_id;
+		} LTTNG_PACKED get_stream_stats;
 	} u;
 } LTTNG_PACKED;
 
@@ -857,6 +882,28 @@ struct lttcomm_consumer_channel_monitor_msg {
 	uint64_t consumed_since_last_sample;
 } LTTNG_PACKED;
 
+/*
+ * Consumption statistics of a stream returned to the session daemon in reply
+ * to a LTTNG_CONSUMER_GET_STREAM_STATS command. The reply is made of a
+ * uint64_t stream count followed by that many entries.
+ */
+struct lttcomm_consumer_stream_stats {
+	char channel_name[LTTNG_SYMBOL_NAME_LEN];
+	char stream_name[LTTNG_SYMBOL_NAME_LEN];
+	uint64_t channel_key;
+	uint64_t stream_key;
+	uint8_t metadata;
+	uint64_t subbuffers_consumed;
+	uint64_t bytes_written;
+	uint64_t write_syscalls;
+	uint64_t write_time_ns;
+	uint64_t relayd_sends;
+	uint64_t relayd_send_time_ns;
+	uint64_t relayd_send_max_ns;
+	uint64_t last_lag_ns;
+	uint64_t max_lag_ns;
+} LTTNG_PACKED;
+
 /*
  * Status message returned to the sessiond after a received command.
  */
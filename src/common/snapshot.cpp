@@ -13,6 +13,7 @@
 #include <lttng/snapshot-internal.hpp>
 #include <lttng/snapshot.h>
 
+#include <stddef.h>
 #include <stdlib.h>
 
 bool lttng_snapshot_output_validate(const struct lttng_snapshot_output *output)
@@ -59,6 +60,10 @@ bool lttng_snapshot_output_is_equal(
 		goto end;
 	}
 
+	if (a->incremental != b->incremental) {
+		goto end;
+	}
+
 	if (strcmp(a->name, b->name) != 0) {
 		goto end;
 	}
@@ -80,6 +85,10 @@ end:
 namespace {
 /*
  * This is essentially the same as `struct lttng_snapshot_output`, but packed.
+ *
+ * `incremental` was appended to the original layout. It is only serialized
+ * when set so that peers which predate it can still deserialize the
+ * non-incremental outputs; its absence means "not incremental".
  */
 struct lttng_snapshot_output_comm {
 	uint32_t id;
@@ -87,9 +96,13 @@ struct lttng_snapshot_output_comm {
 	char name[LTTNG_NAME_MAX];
 	char ctrl_url[PATH_MAX];
 	char data_url[PATH_MAX];
+	uint8_t incremental;
 } LTTNG_PACKED;
 } /* namespace */
 
+#define LTTNG_SNAPSHOT_OUTPUT_COMM_LEGACY_SIZE \
+	offsetof(struct lttng_snapshot_output_comm, incremental)
+
 int lttng_snapshot_output_serialize(
 		const struct lttng_snapshot_output *output,
 		struct lttng_payload *payload)
@@ -99,6 +112,7 @@ int lttng_snapshot_output_serialize(
 
 	comm.id = output->id;
 	comm.max_size = output->max_size;
+	comm.incremental = output->incremental;
 
 	ret = lttng_strncpy(comm.name, output->name, sizeof(comm.name));
 	if (ret) {
@@ -117,8 +131,9 @@ int lttng_snapshot_output_serialize(
 		goto end;
 	}
 
-	ret = lttng_dynamic_buffer_append(
-			&payload->buffer, &comm, sizeof(comm));
+	ret = lttng_dynamic_buffer_append(&payload->buffer, &comm,
+			comm.incremental ? sizeof(comm) :
+					LTTNG_SNAPSHOT_OUTPUT_COMM_LEGACY_SIZE);
 	if (ret) {
 		goto end;
 	}
@@ -135,7 +150,8 @@ ssize_t lttng_snapshot_output_create_from_payload(
 	struct lttng_snapshot_output *output = NULL;
 	int ret;
 
-	if (view->buffer.size != sizeof(*comm)) {
+	if (view->buffer.size != sizeof(*comm) &&
+			view->buffer.size != LTTNG_SNAPSHOT_OUTPUT_COMM_LEGACY_SIZE) {
 		ret = -1;
 		goto end;
 	}
@@ -150,6 +166,9 @@ ssize_t lttng_snapshot_output_create_from_payload(
 
 	output->id = comm->id;
 	output->max_size = comm->max_size;
+	if (view->buffer.size == sizeof(*comm)) {
+		output->incremental = !!comm->incremental;
+	}
 
 	ret = lttng_strncpy(output->name, comm->name, sizeof(output->name));
 	if (ret) {
@@ -170,7 +189,7 @@ ssize_t lttng_snapshot_output_create_from_payload(
 
 	*output_p = output;
 	output = NULL;
-	ret = sizeof(*comm);
+	ret = view->buffer.size;
 
 end:
 	lttng_snapshot_output_destroy(output);
@@ -238,6 +257,14 @@ enum lttng_error_code lttng_snapshot_output_mi_serialize(
 		}
 	}
 
+	if (output->incremental) {
+		ret = mi_lttng_writer_write_element_bool(writer,
+				mi_lttng_element_snapshot_incremental, 1);
+		if (ret) {
+			goto mi_error;
+		}
+	}
+
 	/* Close output element. */
 	ret = mi_lttng_writer_close_element(writer);
 	if (ret) {
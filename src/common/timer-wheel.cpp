@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+
+#include <urcu/list.h>
+
+#include "macros.hpp"
+
+#include "timer-wheel.hpp"
+
+/* Number of ticks spanned by a slot of the given level. */
+static uint64_t level_slot_ticks(unsigned int level)
+{
+	return UINT64_C(1) << (level * TIMER_WHEEL_LEVEL_BITS);
+}
+
+static unsigned int level_slot_index(unsigned int level, uint64_t tick)
+{
+	return (tick >> (level * TIMER_WHEEL_LEVEL_BITS)) &
+			(TIMER_WHEEL_SLOTS - 1);
+}
+
+/*
+ * Insert an entry in the slot matching its expiry relative to the current
+ * tick. An entry expiring on the current tick is placed in the level 0 slot
+ * that is about to be expired by process_tick().
+ */
+static void wheel_insert(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry)
+{
+	unsigned int level;
+	uint64_t slot_expiry = entry->expiry;
+	const uint64_t delta = entry->expiry - wheel->current_tick;
+
+	LTTNG_ASSERT(entry->expiry >= wheel->current_tick);
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+		if (delta < level_slot_ticks(level + 1)) {
+			break;
+		}
+	}
+
+	if (delta >= level_slot_ticks(TIMER_WHEEL_LEVELS)) {
+		/*
+		 * Beyond the range of the wheel: park the entry in the furthest
+		 * slot; it is re-inserted when that slot is cascaded.
+		 */
+		slot_expiry = wheel->current_tick +
+				level_slot_ticks(TIMER_WHEEL_LEVELS) - 1;
+	}
+
+	cds_list_add_tail(&entry->node,
+			&wheel->slots[level][level_slot_index(level, slot_expiry)]);
+	entry->state = TIMER_WHEEL_ENTRY_STATE_PENDING;
+}
+
+/*
+ * Move the entries of the higher levels' slots starting on the current tick
+ * to the lower levels, then expire the current level 0 slot.
+ */
+static void process_tick(struct timer_wheel *wheel)
+{
+	unsigned int level;
+	struct cds_list_head *slot;
+	struct timer_wheel_entry *entry, *tmp;
+
+	for (level = TIMER_WHEEL_LEVELS - 1; level >= 1; level--) {
+		struct cds_list_head cascaded;
+
+		if (wheel->current_tick & (level_slot_ticks(level) - 1)) {
+			continue;
+		}
+
+		slot = &wheel->slots[level][level_slot_index(level,
+				wheel->current_tick)];
+		CDS_INIT_LIST_HEAD(&cascaded);
+		cds_list_splice(slot, &cascaded);
+		CDS_INIT_LIST_HEAD(slot);
+		cds_list_for_each_entry_safe(entry, tmp, &cascaded, node) {
+			cds_list_del(&entry->node);
+			wheel_insert(wheel, entry);
+		}
+	}
+
+	slot = &wheel->slots[0][level_slot_index(0, wheel->current_tick)];
+	cds_list_for_each_entry_safe(entry, tmp, slot, node) {
+		LTTNG_ASSERT(entry->expiry == wheel->current_tick);
+		cds_list_del(&entry->node);
+		cds_list_add_tail(&entry->node, &wheel->expired);
+		entry->state = TIMER_WHEEL_ENTRY_STATE_EXPIRED;
+	}
+}
+
+/*
+ * Next tick at which a level 0 slot expires or a higher level slot is
+ * cascaded. Returns UINT64_MAX if no entry is pending.
+ */
+static uint64_t next_event_tick(const struct timer_wheel *wheel)
+{
+	unsigned int level;
+	uint64_t next = UINT64_MAX;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		unsigned int i;
+		const uint64_t current_slot = wheel->current_tick >>
+				(level * TIMER_WHEEL_LEVEL_BITS);
+
+		for (i = 1; i <= TIMER_WHEEL_SLOTS; i++) {
+			const uint64_t slot = current_slot + i;
+
+			if (cds_list_empty(&wheel->slots[level][slot &
+					(TIMER_WHEEL_SLOTS - 1)])) {
+				continue;
+			}
+
+			next = std::min(next,
+					slot << (level * TIMER_WHEEL_LEVEL_BITS));
+			break;
+		}
+	}
+
+	return next;
+}
+
+void timer_wheel_init(struct timer_wheel *wheel, uint64_t tick_ns,
+		uint64_t now_ns)
+{
+	unsigned int level, i;
+
+	LTTNG_ASSERT(tick_ns > 0);
+
+	wheel->tick_ns = tick_ns;
+	wheel->current_tick = now_ns / tick_ns;
+	wheel->nr_entries = 0;
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+			CDS_INIT_LIST_HEAD(&wheel->slots[level][i]);
+		}
+	}
+	CDS_INIT_LIST_HEAD(&wheel->expired);
+}
+
+void timer_wheel_add(struct timer_wheel *wheel, struct timer_wheel_entry *entry,
+		uint64_t period_ns, timer_wheel_cb callback, uint64_t now_ns)
+{
+	uint64_t now_tick = now_ns / wheel->tick_ns;
+
+	LTTNG_ASSERT(entry->state == TIMER_WHEEL_ENTRY_STATE_INACTIVE);
+
+	if (wheel->nr_entries == 0) {
+		/* Nothing to process in between; catch up. */
+		wheel->current_tick = std::max(wheel->current_tick, now_tick);
+	}
+
+	now_tick = std::max(wheel->current_tick, now_tick);
+	entry->period = std::max<uint64_t>(1,
+			(period_ns + wheel->tick_ns - 1) / wheel->tick_ns);
+	entry->expiry = (now_tick / entry->period + 1) * entry->period;
+	entry->callback = callback;
+	wheel_insert(wheel, entry);
+	wheel->nr_entries++;
+}
+
+void timer_wheel_remove(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry)
+{
+	if (entry->state == TIMER_WHEEL_ENTRY_STATE_INACTIVE) {
+		return;
+	}
+
+	cds_list_del(&entry->node);
+	entry->state = TIMER_WHEEL_ENTRY_STATE_INACTIVE;
+	LTTNG_ASSERT(wheel->nr_entries > 0);
+	wheel->nr_entries--;
+}
+
+bool timer_wheel_advance(struct timer_wheel *wheel, uint64_t now_ns)
+{
+	const uint64_t target_tick = now_ns / wheel->tick_ns;
+
+	while (wheel->current_tick < target_tick) {
+		const uint64_t next_tick = next_event_tick(wheel);
+
+		if (next_tick > target_tick) {
+			/* No slot to process until the target tick. */
+			wheel->current_tick = target_tick;
+			break;
+		}
+
+		wheel->current_tick = next_tick;
+		process_tick(wheel);
+	}
+
+	return !cds_list_empty(&wheel->expired);
+}
+
+struct timer_wheel_entry *timer_wheel_pop_expired(struct timer_wheel *wheel)
+{
+	struct timer_wheel_entry *entry;
+
+	if (cds_list_empty(&wheel->expired)) {
+		return NULL;
+	}
+
+	entry = cds_list_first_entry(&wheel->expired, struct timer_wheel_entry,
+			node);
+	cds_list_del(&entry->node);
+
+	entry->expiry += entry->period;
+	if (entry->expiry <= wheel->current_tick) {
+		/* Coalesce the missed expiries. */
+		entry->expiry = (wheel->current_tick / entry->period + 1) *
+				entry->period;
+	}
+
+	wheel_insert(wheel, entry);
+	return entry;
+}
+
+/*
+ * Earliest expiry of the pending entries. Only the first non-empty slot of
+ * each level needs to be scanned as slots are ordered by expiry.
+ */
+static uint64_t next_expiry_tick(const struct timer_wheel *wheel)
+{
+	unsigned int level;
+	uint64_t next = UINT64_MAX;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		unsigned int i;
+		const uint64_t current_slot = wheel->current_tick >>
+				(level * TIMER_WHEEL_LEVEL_BITS);
+
+		for (i = 1; i <= TIMER_WHEEL_SLOTS; i++) {
+			const struct cds_list_head *slot = &wheel->slots[level][
+					(current_slot + i) & (TIMER_WHEEL_SLOTS - 1)];
+			const struct timer_wheel_entry *entry;
+
+			if (cds_list_empty(slot)) {
+				continue;
+			}
+
+			cds_list_for_each_entry(entry, slot, node) {
+				next = std::min(next, entry->expiry);
+			}
+			break;
+		}
+	}
+
+	return next;
+}
+
+bool timer_wheel_get_next_expiry(const struct timer_wheel *wheel,
+		uint64_t *next_expiry_ns)
+{
+	if (wheel->nr_entries == 0) {
+		return false;
+	}
+
+	if (!cds_list_empty(&wheel->expired)) {
+		*next_expiry_ns = wheel->current_tick * wheel->tick_ns;
+	} else {
+		*next_expiry_ns = next_expiry_tick(wheel) * wheel->tick_ns;
+	}
+
+	return true;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_TIMER_WHEEL_H
+#define LTTNG_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <urcu/list.h>
+
+/*
+ * Hierarchical timer wheel of periodic timers.
+ *
+ * Time is expressed in nanoseconds and rounded to the wheel's tick. Each
+ * level holds TIMER_WHEEL_SLOTS slots; a slot of level `n` spans
+ * TIMER_WHEEL_SLOTS^n ticks. Timers are cascaded to the lower levels as their
+ * expiry approaches, which makes adding, removing and expiring a timer O(1).
+ *
+ * The first expiry of a timer is aligned on a multiple of its period: all the
+ * timers sharing a period expire on the same tick.
+ *
+ * The wheel does not keep track of time nor does it provide any locking: the
+ * user drives it with timer_wheel_advance() and arms an OS timer (e.g.
+ * timerfd) at the time returned by timer_wheel_get_next_expiry().
+ */
+
+#define TIMER_WHEEL_LEVEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1U << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVELS	4
+
+struct timer_wheel_entry;
+
+typedef void (*timer_wheel_cb)(struct timer_wheel_entry *entry, void *data);
+
+enum timer_wheel_entry_state {
+	TIMER_WHEEL_ENTRY_STATE_INACTIVE = 0,
+	/* Waiting in one of the wheel's slots. */
+	TIMER_WHEEL_ENTRY_STATE_PENDING,
+	/* Expired; waiting to be returned by timer_wheel_pop_expired(). */
+	TIMER_WHEEL_ENTRY_STATE_EXPIRED,
+};
+
+/*
+ * A zero-initialized entry is inactive and can be passed to
+ * timer_wheel_remove().
+ */
+struct timer_wheel_entry {
+	enum timer_wheel_entry_state state;
+	/* Ticks. */
+	uint64_t expiry;
+	uint64_t period;
+	/* Not used by the wheel; invoked by its user on expiry. */
+	timer_wheel_cb callback;
+	struct cds_list_head node;
+};
+
+struct timer_wheel {
+	uint64_t tick_ns;
+	/* Last tick processed by timer_wheel_advance(). */
+	uint64_t current_tick;
+	unsigned int nr_entries;
+	struct cds_list_head slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	/* Entries in the TIMER_WHEEL_ENTRY_STATE_EXPIRED state. */
+	struct cds_list_head expired;
+};
+
+void timer_wheel_init(struct timer_wheel *wheel, uint64_t tick_ns,
+		uint64_t now_ns);
+
+/*
+ * Add a periodic timer expiring every `period_ns` nanoseconds (rounded up to
+ * a multiple of the wheel's tick).
+ */
+void timer_wheel_add(struct timer_wheel *wheel, struct timer_wheel_entry *entry,
+		uint64_t period_ns, timer_wheel_cb callback, uint64_t now_ns);
+
+/*
+ * Remove a timer from the wheel, whether it is pending or expired. Removing
+ * an inactive timer has no effect.
+ */
+void timer_wheel_remove(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry);
+
+/*
+ * Process the ticks up to `now_ns`. Returns true if timers expired.
+ */
+bool timer_wheel_advance(struct timer_wheel *wheel, uint64_t now_ns);
+
+/*
+ * Pop an expired timer and schedule its next expiry. Returns NULL when no
+ * expired timer remains.
+ */
+struct timer_wheel_entry *timer_wheel_pop_expired(struct timer_wheel *wheel);
+
+/*
+ * Get the time at which the next timer expires, i.e. when
+ * timer_wheel_advance() must be called next. Returns false if the wheel is
+ * empty.
+ */
+bool timer_wheel_get_next_expiry(const struct timer_wheel *wheel,
+		uint64_t *next_expiry_ns);
+
+#endif /* LTTNG_TIMER_WHEEL_H */
@@ -285,7 +285,7 @@ ssize_t lttcomm_send_unix_sock(int sock, const void *buf, size_t len)
 	msg.msg_iovlen = 1;
 
 	while (iov[0].iov_len) {
-		ret = sendmsg(sock, &msg, 0);
+		ret = lttng_sendmsg_nosigpipe(sock, &msg);
 		if (ret < 0) {
 			if (errno == EINTR) {
 				continue;
@@ -338,7 +338,7 @@ ssize_t lttcomm_send_unix_sock_non_block(int sock, const void *buf, size_t len)
 	msg.msg_iovlen = 1;
 
 retry:
-	ret = sendmsg(sock, &msg, 0);
+	ret = lttng_sendmsg_nosigpipe(sock, &msg);
 	if (ret < 0) {
 		if (errno == EINTR) {
 			goto retry;
@@ -445,7 +445,7 @@ ssize_t lttcomm_send_fds_unix_sock(int sock, const int *fds, size_t nb_fd)
 	msg.msg_iovlen = 1;
 
 	do {
-		ret = sendmsg(sock, &msg, 0);
+		ret = lttng_sendmsg_nosigpipe(sock, &msg);
 	} while (ret < 0 && errno == EINTR);
 	if (ret < 0) {
 		/*
@@ -576,7 +576,7 @@ ssize_t lttcomm_send_fds_unix_sock_non_block(int sock, const int *fds, size_t nb
 	msg.msg_iovlen = 1;
 
 retry:
-	ret = sendmsg(sock, &msg, 0);
+	ret = lttng_sendmsg_nosigpipe(sock, &msg);
 	if (ret < 0) {
 		if (errno == EINTR) {
 			goto retry;
@@ -1033,7 +1033,7 @@ ssize_t lttcomm_send_creds_unix_sock(int sock, const void *buf, size_t len)
 #endif /* __linux__, __CYGWIN__ */
 
 	do {
-		ret = sendmsg(sock, &msg, 0);
+		ret = lttng_sendmsg_nosigpipe(sock, &msg);
 	} while (ret < 0 && errno == EINTR);
 	if (ret < 0) {
 		/*
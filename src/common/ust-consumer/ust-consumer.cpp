@@ -32,6 +32,7 @@
 #include <common/compat/fcntl.hpp>
 #include <common/compat/endian.hpp>
 #include <common/consumer/consumer-metadata-cache.hpp>
+#include <common/consumer/consumer-snapshot.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/utils.hpp>
@@ -152,8 +153,8 @@ static int send_stream_to_thread(struct lttng_consumer_stream *stream,
 		consumer_add_metadata_stream(stream);
 		stream_pipe = ctx->consumer_metadata_pipe;
 	} else {
-		consumer_add_data_stream(stream);
-		stream_pipe = ctx->consumer_data_pipe;
+		consumer_add_data_stream(stream, ctx);
+		stream_pipe = stream->data_thread->data_pipe;
 	}
 
 	/*
@@ -783,7 +784,6 @@ static int close_metadata(uint64_t chan_key)
 		goto error;
 	}
 
-	pthread_mutex_lock(&the_consumer_data.lock);
 	pthread_mutex_lock(&channel->lock);
 	channel_monitor = channel->monitor;
 	if (cds_lfht_is_node_deleted(&channel->node.node)) {
@@ -792,7 +792,6 @@ static int close_metadata(uint64_t chan_key)
 
 	lttng_ustconsumer_close_metadata(channel);
 	pthread_mutex_unlock(&channel->lock);
-	pthread_mutex_unlock(&the_consumer_data.lock);
 
 	/*
 	 * The ownership of a metadata channel depends on the type of
@@ -817,11 +816,10 @@ static int close_metadata(uint64_t chan_key)
 	 */
 	if (!channel_monitor) {
 		/*
-		 * The channel and consumer_data locks must be
-		 * released before this call since consumer_del_channel
-		 * re-acquires the channel and consumer_data locks to teardown
-		 * the channel and queue its reclamation by the "call_rcu"
-		 * worker thread.
+		 * The channel lock must be released before this call
+		 * since consumer_del_channel re-acquires the channel lock
+		 * to teardown the channel and queue its reclamation by the
+		 * "call_rcu" worker thread.
 		 */
 		consumer_del_channel(channel);
 	}
@@ -829,7 +827,6 @@ static int close_metadata(uint64_t chan_key)
 	return ret;
 error_unlock:
 	pthread_mutex_unlock(&channel->lock);
-	pthread_mutex_unlock(&the_consumer_data.lock);
 error:
 	return ret;
 }
@@ -1037,21 +1034,152 @@ error:
 
 }
 
+/*
+ * Record the sampled sub-buffers of a stream of a snapshot.
+ *
+ * Returns 0 on success, < 0 on error
+ */
+static int record_snapshot_stream(
+		struct consumer_snapshot_stream *snapshot_stream)
+{
+	int ret;
+	unsigned long consumed_pos = snapshot_stream->consumed_pos;
+	struct lttng_consumer_stream *stream = snapshot_stream->stream;
+	struct lttng_consumer_channel *channel = stream->chan;
+	const bool use_relayd = snapshot_stream->relayd_id != (uint64_t) -1ULL;
+
+	health_code_update();
+
+	/* Lock stream because we are about to change its state. */
+	pthread_mutex_lock(&stream->lock);
+	LTTNG_ASSERT(channel->trace_chunk);
+	if (!lttng_trace_chunk_get(channel->trace_chunk)) {
+		/*
+		 * Can't happen barring an internal error as the channel
+		 * holds a reference to the trace chunk.
+		 */
+		ERR("Failed to acquire reference to channel's trace chunk");
+		ret = -1;
+		goto error_unlock;
+	}
+	LTTNG_ASSERT(!stream->trace_chunk);
+	stream->trace_chunk = channel->trace_chunk;
+
+	stream->net_seq_idx = snapshot_stream->relayd_id;
+
+	if (use_relayd) {
+		ret = consumer_send_relayd_stream(stream,
+				snapshot_stream->path);
+		if (ret < 0) {
+			goto error_close_stream;
+		}
+	} else {
+		ret = consumer_stream_create_output_files(stream,
+				false);
+		if (ret < 0) {
+			goto error_close_stream;
+		}
+		DBG("UST consumer snapshot stream (%" PRIu64 ")",
+				stream->key);
+	}
+
+	while ((long) (consumed_pos - snapshot_stream->produced_pos) < 0) {
+		ssize_t read_len;
+		unsigned long len, padded_len;
+		const char *subbuf_addr;
+		struct lttng_buffer_view subbuf_view;
+
+		health_code_update();
+
+		DBG("UST consumer taking snapshot at pos %lu", consumed_pos);
+
+		ret = lttng_ust_ctl_get_subbuf(stream->ustream, &consumed_pos);
+		if (ret < 0) {
+			if (ret != -EAGAIN) {
+				PERROR("lttng_ust_ctl_get_subbuf snapshot");
+				goto error_close_stream;
+			}
+			DBG("UST consumer get subbuf failed. Skipping it.");
+			consumed_pos += stream->max_sb_size;
+			snapshot_stream->lost_packets++;
+			continue;
+		}
+
+		ret = lttng_ust_ctl_get_subbuf_size(stream->ustream, &len);
+		if (ret < 0) {
+			ERR("Snapshot lttng_ust_ctl_get_subbuf_size");
+			goto error_put_subbuf;
+		}
+
+		ret = lttng_ust_ctl_get_padded_subbuf_size(stream->ustream, &padded_len);
+		if (ret < 0) {
+			ERR("Snapshot lttng_ust_ctl_get_padded_subbuf_size");
+			goto error_put_subbuf;
+		}
+
+		ret = get_current_subbuf_addr(stream, &subbuf_addr);
+		if (ret) {
+			goto error_put_subbuf;
+		}
+
+		subbuf_view = lttng_buffer_view_init(
+				subbuf_addr, 0, padded_len);
+		read_len = lttng_consumer_on_read_subbuffer_mmap(
+				stream, &subbuf_view, padded_len - len);
+		if (use_relayd) {
+			if (read_len != len) {
+				ret = -EPERM;
+				goto error_put_subbuf;
+			}
+		} else {
+			if (read_len != padded_len) {
+				ret = -EPERM;
+				goto error_put_subbuf;
+			}
+		}
+
+		ret = lttng_ust_ctl_put_subbuf(stream->ustream);
+		if (ret < 0) {
+			ERR("Snapshot lttng_ust_ctl_put_subbuf");
+			goto error_close_stream;
+		}
+		consumed_pos += stream->max_sb_size;
+	}
+
+	/* Simply close the stream so we can use it on the next snapshot. */
+	consumer_stream_close_output(stream);
+	pthread_mutex_unlock(&stream->lock);
+	return 0;
+
+error_put_subbuf:
+	if (lttng_ust_ctl_put_subbuf(stream->ustream) < 0) {
+		ERR("Snapshot lttng_ust_ctl_put_subbuf");
+	}
+error_close_stream:
+	consumer_stream_close_output(stream);
+error_unlock:
+	pthread_mutex_unlock(&stream->lock);
+	return ret;
+}
+
 /*
  * Take a snapshot of all the stream of a channel.
  * RCU read-side lock and the channel lock must be held by the caller.
  *
+ * The positions of all the streams are sampled before recording them
+ * concurrently (see consumer_snapshot_record_streams()).
+ *
  * Returns 0 on success, < 0 on error
  */
 static int snapshot_channel(struct lttng_consumer_channel *channel,
 		uint64_t key, char *path, uint64_t relayd_id,
-		uint64_t nb_packets_per_stream,
+		uint64_t nb_packets_per_stream, bool incremental,
 		struct lttng_consumer_local_data *ctx)
 {
 	int ret;
-	unsigned use_relayd = 0;
-	unsigned long consumed_pos, produced_pos;
+	size_t stream_count = 0, i = 0;
 	struct lttng_consumer_stream *stream;
+	struct consumer_snapshot_stream *snapshot_streams = NULL;
 
 	LTTNG_ASSERT(path);
 	LTTNG_ASSERT(ctx);
@@ -1059,47 +1187,28 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 
 	rcu_read_lock();
 
-	if (relayd_id != (uint64_t) -1ULL) {
-		use_relayd = 1;
-	}
-
 	LTTNG_ASSERT(!channel->monitor);
 	DBG("UST consumer snapshot channel %" PRIu64, key);
 
 	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
-		health_code_update();
+		stream_count++;
+	}
 
-		/* Lock stream because we are about to change its state. */
-		pthread_mutex_lock(&stream->lock);
-		LTTNG_ASSERT(channel->trace_chunk);
-		if (!lttng_trace_chunk_get(channel->trace_chunk)) {
-			/*
-			 * Can't happen barring an internal error as the channel
-			 * holds a reference to the trace chunk.
-			 */
-			ERR("Failed to acquire reference to channel's trace chunk");
-			ret = -1;
-			goto error_unlock;
-		}
-		LTTNG_ASSERT(!stream->trace_chunk);
-		stream->trace_chunk = channel->trace_chunk;
+	snapshot_streams = calloc<consumer_snapshot_stream>(stream_count);
+	if (stream_count && !snapshot_streams) {
+		PERROR("Failed to allocate snapshot streams");
+		ret = -ENOMEM;
+		goto end;
+	}
 
-		stream->net_seq_idx = relayd_id;
+	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		struct consumer_snapshot_stream *snapshot_stream =
+				&snapshot_streams[i++];
+		unsigned long consumed_pos, produced_pos;
 
-		if (use_relayd) {
-			ret = consumer_send_relayd_stream(stream, path);
-			if (ret < 0) {
-				goto error_close_stream;
-			}
-		} else {
-			ret = consumer_stream_create_output_files(stream,
-					false);
-			if (ret < 0) {
-				goto error_close_stream;
-			}
-			DBG("UST consumer snapshot stream (%" PRIu64 ")",
-					stream->key);
-		}
+		health_code_update();
+
+		pthread_mutex_lock(&stream->lock);
 
 		/*
 		 * If tracing is active, we want to perform a "full" buffer flush.
@@ -1117,20 +1226,21 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 		ret = lttng_ustconsumer_take_snapshot(stream);
 		if (ret < 0) {
 			ERR("Taking UST snapshot");
-			goto error_close_stream;
+			goto error_unlock;
 		}
 
 		ret = lttng_ustconsumer_get_produced_snapshot(stream, &produced_pos);
 		if (ret < 0) {
 			ERR("Produced UST snapshot position");
-			goto error_close_stream;
+			goto error_unlock;
 		}
 
 		ret = lttng_ustconsumer_get_consumed_snapshot(stream, &consumed_pos);
 		if (ret < 0) {
 			ERR("Consumerd UST snapshot position");
-			goto error_close_stream;
+			goto error_unlock;
 		}
+		pthread_mutex_unlock(&stream->lock);
 
 		/*
 		 * The original value is sent back if max stream size is larger than
@@ -1138,89 +1248,23 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 		 * daemon should never send a maximum stream size that is lower than
 		 * subbuffer size.
 		 */
-		consumed_pos = consumer_get_consume_start_pos(consumed_pos,
-				produced_pos, nb_packets_per_stream,
-				stream->max_sb_size);
-
-		while ((long) (consumed_pos - produced_pos) < 0) {
-			ssize_t read_len;
-			unsigned long len, padded_len;
-			const char *subbuf_addr;
-			struct lttng_buffer_view subbuf_view;
-
-			health_code_update();
-
-			DBG("UST consumer taking snapshot at pos %lu", consumed_pos);
-
-			ret = lttng_ust_ctl_get_subbuf(stream->ustream, &consumed_pos);
-			if (ret < 0) {
-				if (ret != -EAGAIN) {
-					PERROR("lttng_ust_ctl_get_subbuf snapshot");
-					goto error_close_stream;
-				}
-				DBG("UST consumer get subbuf failed. Skipping it.");
-				consumed_pos += stream->max_sb_size;
-				stream->chan->lost_packets++;
-				continue;
-			}
-
-			ret = lttng_ust_ctl_get_subbuf_size(stream->ustream, &len);
-			if (ret < 0) {
-				ERR("Snapshot lttng_ust_ctl_get_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = lttng_ust_ctl_get_padded_subbuf_size(stream->ustream, &padded_len);
-			if (ret < 0) {
-				ERR("Snapshot lttng_ust_ctl_get_padded_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = get_current_subbuf_addr(stream, &subbuf_addr);
-			if (ret) {
-				goto error_put_subbuf;
-			}
-
-			subbuf_view = lttng_buffer_view_init(
-					subbuf_addr, 0, padded_len);
-			read_len = lttng_consumer_on_read_subbuffer_mmap(
-					stream, &subbuf_view, padded_len - len);
-			if (use_relayd) {
-				if (read_len != len) {
-					ret = -EPERM;
-					goto error_put_subbuf;
-				}
-			} else {
-				if (read_len != padded_len) {
-					ret = -EPERM;
-					goto error_put_subbuf;
-				}
-			}
-
-			ret = lttng_ust_ctl_put_subbuf(stream->ustream);
-			if (ret < 0) {
-				ERR("Snapshot lttng_ust_ctl_put_subbuf");
-				goto error_close_stream;
-			}
-			consumed_pos += stream->max_sb_size;
-		}
-
-		/* Simply close the stream so we can use it on the next snapshot. */
-		consumer_stream_close_output(stream);
-		pthread_mutex_unlock(&stream->lock);
+		snapshot_stream->stream = stream;
+		snapshot_stream->path = path;
+		snapshot_stream->relayd_id = relayd_id;
+		snapshot_stream->produced_pos = produced_pos;
+		snapshot_stream->consumed_pos = consumer_snapshot_get_start_pos(
+				stream, consumed_pos, produced_pos,
+				nb_packets_per_stream, incremental);
 	}
 
-	rcu_read_unlock();
-	return 0;
+	ret = consumer_snapshot_record_streams(snapshot_streams, stream_count,
+			record_snapshot_stream);
+	goto end;
 
-error_put_subbuf:
-	if (lttng_ust_ctl_put_subbuf(stream->ustream) < 0) {
-		ERR("Snapshot lttng_ust_ctl_put_subbuf");
-	}
-error_close_stream:
-	consumer_stream_close_output(stream);
 error_unlock:
 	pthread_mutex_unlock(&stream->lock);
+end:
+	free(snapshot_streams);
 	rcu_read_unlock();
 	return ret;
 }
@@ -1512,6 +1556,10 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		 * allocation.
 		 */
 		channel->ust_app_uid = msg.u.ask_channel.ust_app_uid;
+		channel->compression = (enum lttng_channel_compression)
+				msg.u.ask_channel.compression;
+		channel->suppress_empty_packets =
+				!!msg.u.ask_channel.suppress_empty_packets;
 
 		/* Build channel attributes from received message. */
 		attr.subbuf_size = msg.u.ask_channel.subbuf_size;
@@ -1523,9 +1571,14 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		memcpy(attr.uuid, msg.u.ask_channel.uuid, sizeof(attr.uuid));
 		attr.blocking_timeout= msg.u.ask_channel.blocking_timeout;
 
-		/* Match channel buffer type to the UST abi. */
+		/*
+		 * Match channel buffer type to the UST abi. The tracer always
+		 * maps its buffers; with the splice output, the consumer
+		 * vmsplices the mapped sub-buffers.
+		 */
 		switch (msg.u.ask_channel.output) {
 		case LTTNG_EVENT_MMAP:
+		case LTTNG_EVENT_SPLICE:
 		default:
 			attr.output = LTTNG_UST_ABI_MMAP;
 			break;
@@ -1847,6 +1900,7 @@ error_push_metadata_fatal:
 						msg.u.snapshot_channel.relayd_id,
 						msg.u.snapshot_channel
 								.nb_packets_per_stream,
+						msg.u.snapshot_channel.incremental,
 						ctx);
 				if (ret_snapshot < 0) {
 					ERR("Snapshot channel failed");
@@ -1876,7 +1930,6 @@ error_push_metadata_fatal:
 		DBG("UST consumer discarded events command for session id %"
 				PRIu64, id);
 		rcu_read_lock();
-		pthread_mutex_lock(&the_consumer_data.lock);
 
 		ht = the_consumer_data.stream_list_ht;
 
@@ -1892,12 +1945,18 @@ error_push_metadata_fatal:
 				ht->hash_fct(&id, lttng_ht_seed),
 				ht->match_fct, &id,
 				&iter.iter, stream, node_session_id.node) {
+			/*
+			 * The channel of a metadata stream is reset when the
+			 * stream is deleted; it is not a match anyway.
+			 */
+			if (stream->metadata_flag) {
+				continue;
+			}
 			if (stream->chan->key == key) {
 				discarded_events = stream->chan->discarded_events;
 				break;
 			}
 		}
-		pthread_mutex_unlock(&the_consumer_data.lock);
 		rcu_read_unlock();
 
 		DBG("UST consumer discarded events command for session id %"
@@ -1927,7 +1986,6 @@ error_push_metadata_fatal:
 		DBG("UST consumer lost packets command for session id %"
 				PRIu64, id);
 		rcu_read_lock();
-		pthread_mutex_lock(&the_consumer_data.lock);
 
 		ht = the_consumer_data.stream_list_ht;
 
@@ -1942,12 +2000,18 @@ error_push_metadata_fatal:
 				ht->hash_fct(&id, lttng_ht_seed),
 				ht->match_fct, &id,
 				&iter.iter, stream, node_session_id.node) {
+			/*
+			 * The channel of a metadata stream is reset when the
+			 * stream is deleted; it is not a match anyway.
+			 */
+			if (stream->metadata_flag) {
+				continue;
+			}
 			if (stream->chan->key == key) {
 			        lost_packets = stream->chan->lost_packets;
 				break;
 			}
 		}
-		pthread_mutex_unlock(&the_consumer_data.lock);
 		rcu_read_unlock();
 
 		DBG("UST consumer lost packets command for session id %"
@@ -2253,6 +2317,16 @@ end_rotate_channel_nosignal:
 		health_code_update();
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_GET_STREAM_STATS:
+	{
+		/* The statistics are the reply; no status message is sent. */
+		if (lttng_consumer_send_stream_stats(sock,
+				msg.u.get_stream_stats.session_id)) {
+			goto error_fatal;
+		}
+
+		goto end_nosignal;
+	}
 	default:
 		break;
 	}
@@ -2531,10 +2605,19 @@ int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 {
 	ssize_t write_len;
 	int ret;
+	const struct consumer_metadata_cache_contents *contents;
+	struct lttng_buffer_view view;
+	uint64_t cache_size;
 
-	pthread_mutex_lock(&stream->chan->metadata_cache->lock);
-	if (stream->chan->metadata_cache->contents.size ==
-			stream->ust_metadata_pushed) {
+	/*
+	 * The cache is read without holding its lock: its contents are
+	 * append-only and replaced (RCU) when the metadata version changes.
+	 */
+	rcu_read_lock();
+	contents = consumer_metadata_cache_get_contents(
+			stream->chan->metadata_cache);
+	cache_size = consumer_metadata_cache_contents_get_size(contents);
+	if (cache_size <= stream->ust_metadata_pushed) {
 		/*
 		 * In the context of a user space metadata channel, a
 		 * change in version can be detected in two ways:
@@ -2559,21 +2642,26 @@ int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 		 * occur as part of the pre-consume) until the metadata size
 		 * exceeded the cache size.
 		 */
-		if (stream->metadata_version !=
-				stream->chan->metadata_cache->version) {
+		if (stream->metadata_version != contents->version) {
 			metadata_stream_reset_cache_consumed_position(stream);
 			consumer_stream_metadata_set_version(stream,
-					stream->chan->metadata_cache->version);
-		} else {
+					contents->version);
+		}
+
+		if (cache_size <= stream->ust_metadata_pushed) {
 			ret = 0;
 			goto end;
 		}
 	}
 
+	/*
+	 * At most the remainder of a cache chunk is committed at once; the
+	 * next call continues from the following chunk.
+	 */
+	view = consumer_metadata_cache_contents_get_view(contents,
+			stream->ust_metadata_pushed, cache_size);
 	write_len = lttng_ust_ctl_write_one_packet_to_channel(stream->chan->uchan,
-			&stream->chan->metadata_cache->contents.data[stream->ust_metadata_pushed],
-			stream->chan->metadata_cache->contents.size -
-					stream->ust_metadata_pushed);
+			view.data, view.size);
 	LTTNG_ASSERT(write_len != 0);
 	if (write_len < 0) {
 		ERR("Writing one metadata packet");
@@ -2582,8 +2670,7 @@ int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 	}
 	stream->ust_metadata_pushed += write_len;
 
-	LTTNG_ASSERT(stream->chan->metadata_cache->contents.size >=
-			stream->ust_metadata_pushed);
+	LTTNG_ASSERT(cache_size >= stream->ust_metadata_pushed);
 	ret = write_len;
 
 	/*
@@ -2598,7 +2685,7 @@ int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 		stream->quiescent = true;
 	}
 end:
-	pthread_mutex_unlock(&stream->chan->metadata_cache->lock);
+	rcu_read_unlock();
 	return ret;
 }
 
@@ -2711,17 +2798,18 @@ static int notify_if_more_data(struct lttng_consumer_stream *stream,
 	/* This stream still has data. Flag it and wake up the data thread. */
 	stream->has_data = 1;
 
-	if (stream->monitor && !stream->hangup_flush_done && !ctx->has_wakeup) {
+	if (stream->monitor && !stream->hangup_flush_done &&
+			!stream->data_thread->has_wakeup) {
 		ssize_t writelen;
 
-		writelen = lttng_pipe_write(ctx->consumer_wakeup_pipe, "!", 1);
+		writelen = lttng_pipe_write(stream->data_thread->wakeup_pipe, "!", 1);
 		if (writelen < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
 			ret = writelen;
 			goto end;
 		}
 
 		/* The wake up pipe has been notified. */
-		ctx->has_wakeup = 1;
+		stream->data_thread->has_wakeup = 1;
 	}
 	ret = 0;
 
@@ -2977,10 +3065,9 @@ static enum get_next_subbuffer_status get_next_subbuffer_metadata(
 				cache_empty = false;
 			}
 		} else {
-			pthread_mutex_lock(&stream->chan->metadata_cache->lock);
-			cache_empty = stream->chan->metadata_cache->contents.size ==
+			cache_empty = consumer_metadata_cache_get_size(
+					stream->chan->metadata_cache) ==
 					stream->ust_metadata_pushed;
-			pthread_mutex_unlock(&stream->chan->metadata_cache->lock);
 		}
 	} while (!got_subbuffer);
 
@@ -3087,6 +3174,34 @@ end:
 	return ret;
 }
 
+/*
+ * Grow the splice pipe of a stream so that a whole sub-buffer can be moved
+ * with a single vmsplice()/splice() pair.
+ *
+ * Failing to do so (e.g. the sub-buffer size exceeds
+ * /proc/sys/fs/pipe-max-size for an unprivileged user) is not fatal; the
+ * sub-buffers are then moved in multiple passes.
+ */
+static void fit_splice_pipe_to_subbuffer(struct lttng_consumer_stream *stream)
+{
+	int ret;
+
+	ret = fcntl(stream->splice_pipe[1], F_GETPIPE_SZ);
+	if (ret >= 0 && (unsigned long) ret >= stream->max_sb_size) {
+		return;
+	}
+
+	ret = fcntl(stream->splice_pipe[1], F_SETPIPE_SZ,
+			(int) stream->max_sb_size);
+	if (ret < 0) {
+		DBG("Failed to resize splice pipe of stream %s to %lu bytes (errno: %d)",
+				stream->name, stream->max_sb_size, errno);
+		return;
+	}
+
+	DBG("Splice pipe of stream %s resized to %d bytes", stream->name, ret);
+}
+
 /*
  * Called when a stream is created.
  *
@@ -3110,6 +3225,10 @@ int lttng_ustconsumer_on_recv_stream(struct lttng_consumer_stream *stream)
 		}
 	}
 
+	if (stream->output == LTTNG_EVENT_SPLICE) {
+		fit_splice_pipe_to_subbuffer(stream);
+	}
+
 	lttng_ustconsumer_set_stream_ops(stream);
 	ret = 0;
 
@@ -3144,9 +3263,8 @@ int lttng_ustconsumer_data_pending(struct lttng_consumer_stream *stream)
 		uint64_t contiguous, pushed;
 
 		/* Ease our life a bit. */
-		pthread_mutex_lock(&stream->chan->metadata_cache->lock);
-		contiguous = stream->chan->metadata_cache->contents.size;
-		pthread_mutex_unlock(&stream->chan->metadata_cache->lock);
+		contiguous = consumer_metadata_cache_get_size(
+				stream->chan->metadata_cache);
 		pushed = stream->ust_metadata_pushed;
 
 		/*
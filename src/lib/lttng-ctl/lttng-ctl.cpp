@@ -11,6 +11,7 @@
  */
 
 #define _LGPL_SOURCE
+#include <algorithm>
 #include <grp.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,9 +48,7 @@
 #include <lttng/userspace-probe-internal.hpp>
 
 #include "lttng-ctl-helper.hpp"
-#include <common/filter/filter-ast.hpp>
-#include <common/filter/filter-parser.hpp>
-#include <common/filter/memstream.hpp>
+#include <common/filter/filter-bytecode-cache.hpp>
 
 #define COPY_DOMAIN_PACKED(dst, src)				\
 do {								\
@@ -67,6 +66,29 @@ static char sessiond_sock_path[PATH_MAX];
 static char *tracing_group;
 static int connected;
 
+/*
+ * Maximal number of pipelined commands awaiting their reply on a persistent
+ * connection. Bounds the size of the replies queued in the socket: the session
+ * daemon would otherwise block on their transmission while the client blocks
+ * on the transmission of its next command.
+ */
+#define SESSION_DAEMON_CONNECTION_MAX_PENDING_REPLIES	64
+
+struct lttng_session_daemon_connection {
+	/* Socket to the session daemon, -1 when disconnected. */
+	int socket;
+	bool pipelining;
+	/* Number of pipelined commands awaiting their reply. */
+	unsigned int pending_replies;
+	/* Number of pipelined commands which succeeded. */
+	unsigned int completed_count;
+	/* Error of the first pipelined command which failed. */
+	enum lttng_error_code first_error;
+};
+
+/* Persistent connection on which the commands are sent, if any. */
+static struct lttng_session_daemon_connection *persistent_connection;
+
 /* Global */
 
 /*
@@ -496,6 +518,165 @@ static int disconnect_sessiond(void)
 	return ret;
 }
 
+/*
+ * Record the error of a pipelined command, unless a previous one failed.
+ */
+static void set_pipeline_error(struct lttng_session_daemon_connection *connection,
+		enum lttng_error_code error)
+{
+	if (connection->first_error == LTTNG_OK) {
+		connection->first_error = error;
+	}
+}
+
+/*
+ * Close the socket of a persistent connection. The replies to its pipelined
+ * commands are lost: `error` is reported as the result of the pipeline if
+ * none of them failed so far.
+ */
+static void persistent_connection_close(
+		struct lttng_session_daemon_connection *connection,
+		enum lttng_error_code error)
+{
+	if (connection->socket >= 0) {
+		if (lttcomm_close_unix_sock(connection->socket)) {
+			PERROR("Failed to close the session daemon connection");
+		}
+		connection->socket = -1;
+	}
+
+	if (connection->pending_replies > 0) {
+		set_pipeline_error(connection, error);
+	}
+	connection->pending_replies = 0;
+}
+
+/*
+ * Receive the reply to the oldest pipelined command of a persistent
+ * connection.
+ *
+ * Return 0 on success, -1 if the connection can't be used anymore (the
+ * command failed or the reply could not be received).
+ */
+static int recv_pending_reply(struct lttng_session_daemon_connection *connection)
+{
+	ssize_t ret;
+	struct lttcomm_lttng_msg llm;
+	size_t left;
+
+	ret = lttcomm_recv_unix_sock(connection->socket, &llm, sizeof(llm));
+	if (ret <= 0) {
+		set_pipeline_error(connection, ret == 0 ?
+				LTTNG_ERR_NO_SESSIOND : LTTNG_ERR_FATAL);
+		return -1;
+	}
+
+	if (llm.ret_code != LTTNG_OK) {
+		/* The session daemon closes the connection of failed commands. */
+		if (llm.ret_code < LTTNG_OK || llm.ret_code >= LTTNG_ERR_NR) {
+			set_pipeline_error(connection, LTTNG_ERR_UNK);
+		} else {
+			set_pipeline_error(connection,
+					(lttng_error_code) llm.ret_code);
+		}
+		return -1;
+	}
+
+	if (llm.fd_count > 0) {
+		/* Not expected from the commands which are pipelined. */
+		set_pipeline_error(connection, LTTNG_ERR_INVALID_PROTOCOL);
+		return -1;
+	}
+
+	/* Discard the data which the caller of the command didn't ask for. */
+	left = (size_t) llm.cmd_header_size + llm.data_size;
+	while (left > 0) {
+		char buf[4096];
+		const size_t len = std::min(left, sizeof(buf));
+
+		ret = lttcomm_recv_unix_sock(connection->socket, buf, len);
+		if (ret <= 0) {
+			set_pipeline_error(connection, LTTNG_ERR_FATAL);
+			return -1;
+		}
+		left -= ret;
+	}
+
+	connection->completed_count++;
+	return 0;
+}
+
+/*
+ * Receive the replies to the pipelined commands of a persistent connection.
+ *
+ * The connection is closed if a command failed, as the session daemon
+ * doesn't execute the commands which follow it.
+ */
+static void recv_pending_replies(struct lttng_session_daemon_connection *connection)
+{
+	while (connection->pending_replies > 0) {
+		if (recv_pending_reply(connection)) {
+			persistent_connection_close(connection, LTTNG_ERR_FATAL);
+			break;
+		}
+		connection->pending_replies--;
+	}
+}
+
+/*
+ * Set up the connection on which a command is sent: the persistent connection
+ * if there is one, otherwise a new connection.
+ *
+ * Return 0 on success, a negative lttng_error_code on error.
+ */
+static int open_command_connection(void)
+{
+	int ret;
+
+	if (persistent_connection && persistent_connection->socket >= 0) {
+		sessiond_socket = persistent_connection->socket;
+		connected = 1;
+		return 0;
+	}
+
+	ret = connect_sessiond();
+	if (ret < 0) {
+		return -LTTNG_ERR_NO_SESSIOND;
+	}
+
+	sessiond_socket = ret;
+	connected = 1;
+	if (persistent_connection) {
+		/* Re-establish the persistent connection. */
+		persistent_connection->socket = ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Release the connection on which a command was sent. A persistent connection
+ * is only closed if it can't be used for another command.
+ */
+static void close_command_connection(bool reusable)
+{
+	if (!persistent_connection) {
+		disconnect_sessiond();
+		return;
+	}
+
+	if (!reusable) {
+		/*
+		 * The replies sent by the session daemon before the connection
+		 * broke can still be received.
+		 */
+		recv_pending_replies(persistent_connection);
+		persistent_connection_close(persistent_connection,
+				LTTNG_ERR_FATAL);
+	}
+	reset_global_sessiond_connection_state();
+}
+
 static int recv_sessiond_optional_data(size_t len, void **user_buf,
 	size_t *user_len)
 {
@@ -559,14 +740,24 @@ int lttng_ctl_ask_sessiond_fds_varlen(struct lttcomm_session_msg *lsm,
 	int ret;
 	size_t payload_len;
 	struct lttcomm_lttng_msg llm;
+	bool reusable = false;
+	/*
+	 * While pipelining, the commands which don't return data to the
+	 * caller don't wait for their reply.
+	 */
+	const bool pipelined = persistent_connection &&
+			persistent_connection->pipelining && !user_payload_buf &&
+			!user_cmd_header_buf && !user_cmd_header_len;
 
-	ret = connect_sessiond();
+	if (persistent_connection &&
+			(!pipelined || persistent_connection->pending_replies >=
+					SESSION_DAEMON_CONNECTION_MAX_PENDING_REPLIES)) {
+		recv_pending_replies(persistent_connection);
+	}
+
+	ret = open_command_connection();
 	if (ret < 0) {
-		ret = -LTTNG_ERR_NO_SESSIOND;
 		goto end;
-	} else {
-		sessiond_socket = ret;
-		connected = 1;
 	}
 
 	ret = send_session_msg(lsm);
@@ -588,6 +779,14 @@ int lttng_ctl_ask_sessiond_fds_varlen(struct lttcomm_session_msg *lsm,
 		goto end;
 	}
 
+	if (pipelined) {
+		/* The reply is received by recv_pending_replies(). */
+		persistent_connection->pending_replies++;
+		reusable = true;
+		ret = 0;
+		goto end;
+	}
+
 	/* Get header from data transmission */
 	ret = recv_data_sessiond(&llm, sizeof(llm));
 	if (ret < 0) {
@@ -616,9 +815,11 @@ int lttng_ctl_ask_sessiond_fds_varlen(struct lttcomm_session_msg *lsm,
 	}
 
 	ret = llm.data_size;
+	/* File descriptors are not received by this function. */
+	reusable = llm.fd_count == 0;
 
 end:
-	disconnect_sessiond();
+	close_command_connection(reusable);
 	return ret;
 }
 
@@ -628,17 +829,18 @@ int lttng_ctl_ask_sessiond_payload(struct lttng_payload_view *message,
 	int ret;
 	struct lttcomm_lttng_msg llm;
 	const int fd_count = lttng_payload_view_get_fd_handle_count(message);
+	bool reusable = false;
 
 	LTTNG_ASSERT(reply->buffer.size == 0);
 	LTTNG_ASSERT(lttng_dynamic_pointer_array_get_count(&reply->_fd_handles) == 0);
 
-	ret = connect_sessiond();
+	if (persistent_connection) {
+		recv_pending_replies(persistent_connection);
+	}
+
+	ret = open_command_connection();
 	if (ret < 0) {
-		ret = -LTTNG_ERR_NO_SESSIOND;
 		goto end;
-	} else {
-		sessiond_socket = ret;
-		connected = 1;
 	}
 
 	/* Send command to session daemon */
@@ -712,9 +914,10 @@ int lttng_ctl_ask_sessiond_payload(struct lttng_payload_view *message,
 	}
 
 	ret = reply->buffer.size;
+	reusable = true;
 
 end:
-	disconnect_sessiond();
+	close_command_connection(reusable);
 	return ret;
 }
 
@@ -1078,37 +1281,25 @@ error:
 }
 
 /*
- * Enable event(s) for a channel, possibly with exclusions and a filter.
- * If no event name is specified, all events are enabled.
- * If no channel name is specified, the default name is used.
- * If filter expression is not NULL, the filter is set for the event.
- * If exclusion count is not zero, the exclusions are set for the event.
- * Returns size of returned session payload data or a negative error code.
+ * Serialize an event to enable, along with its filter and exclusions, at the
+ * end of a payload.
+ *
+ * The filter expression is compiled to bytecode here; for the agent domains,
+ * it is combined with the logger name and log level filter of the event.
+ *
+ * Returns 0 on success or a negative lttng error code.
  */
-int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
-		struct lttng_event *ev, const char *channel_name,
+static int serialize_event_to_enable(enum lttng_domain_type domain_type,
+		struct lttng_event *ev,
 		const char *original_filter_expression,
-		int exclusion_count, char **exclusion_list)
+		int exclusion_count, char **exclusion_list,
+		struct lttng_payload *payload)
 {
-	struct lttcomm_session_msg lsm = {
-		.cmd_type = LTTCOMM_SESSIOND_COMMAND_ENABLE_EVENT,
-		.session = {},
-		.domain = {},
-		.u = {},
-		.fd_count = 0,
-	};
-	struct lttng_payload payload;
 	int ret = 0;
 	unsigned int free_filter_expression = 0;
-	struct filter_parser_ctx *ctx = NULL;
+	struct lttng_bytecode *bytecode = NULL;
 	size_t bytecode_len = 0;
 
-	/*
-	 * We have either a filter or some exclusions, so we need to set up
-	 * a variable-length payload from where to send the data.
-	 */
-	lttng_payload_init(&payload);
-
 	/*
 	 * Cast as non-const since we may replace the filter expression
 	 * by a dynamically allocated string. Otherwise, the original
@@ -1116,11 +1307,6 @@ int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
 	 */
 	char *filter_expression = (char *) original_filter_expression;
 
-	if (handle == NULL || ev == NULL) {
-		ret = -LTTNG_ERR_INVALID;
-		goto error;
-	}
-
 	/*
 	 * Empty filter string will always be rejected by the parser
 	 * anyway, so treat this corner-case early to eliminate
@@ -1138,12 +1324,12 @@ int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
 	}
 
 	/* Parse filter expression. */
-	if (filter_expression != NULL || handle->domain.type == LTTNG_DOMAIN_JUL
-			|| handle->domain.type == LTTNG_DOMAIN_LOG4J
-			|| handle->domain.type == LTTNG_DOMAIN_PYTHON) {
-		if (handle->domain.type == LTTNG_DOMAIN_JUL ||
-				handle->domain.type == LTTNG_DOMAIN_LOG4J ||
-				handle->domain.type == LTTNG_DOMAIN_PYTHON) {
+	if (filter_expression != NULL || domain_type == LTTNG_DOMAIN_JUL
+			|| domain_type == LTTNG_DOMAIN_LOG4J
+			|| domain_type == LTTNG_DOMAIN_PYTHON) {
+		if (domain_type == LTTNG_DOMAIN_JUL ||
+				domain_type == LTTNG_DOMAIN_LOG4J ||
+				domain_type == LTTNG_DOMAIN_PYTHON) {
 			char *agent_filter;
 
 			/* Setup agent filter if needed. */
@@ -1173,13 +1359,12 @@ int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
 			goto error;
 		}
 
-		ret = filter_parser_ctx_create_from_filter_expression(filter_expression, &ctx);
+		ret = filter_bytecode_cache_generate(filter_expression, &bytecode);
 		if (ret) {
 			goto error;
 		}
 
-		bytecode_len = bytecode_get_len(&ctx->bytecode->b) +
-				sizeof(ctx->bytecode->b);
+		bytecode_len = bytecode_get_len(bytecode) + sizeof(*bytecode);
 		if (bytecode_len > LTTNG_FILTER_MAX_LEN) {
 			ret = -LTTNG_ERR_FILTER_INVAL;
 			goto error;
@@ -1189,13 +1374,67 @@ int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
 serialize:
 	ret = lttng_event_serialize(ev, exclusion_count, exclusion_list,
 			filter_expression, bytecode_len,
-			(ctx && bytecode_len) ? &ctx->bytecode->b : NULL,
-			&payload);
+			bytecode_len ? bytecode : NULL,
+			payload);
 	if (ret) {
 		ret = -LTTNG_ERR_INVALID;
 		goto error;
 	}
 
+error:
+	free(bytecode);
+	if (free_filter_expression) {
+		/*
+		 * The filter expression has been replaced and must be freed as
+		 * it is not the original filter expression received as a
+		 * parameter.
+		 */
+		free(filter_expression);
+	}
+	return ret;
+}
+
+/*
+ * Enable event(s) for a channel, possibly with exclusions and a filter.
+ * If no event name is specified, all events are enabled.
+ * If no channel name is specified, the default name is used.
+ * If filter expression is not NULL, the filter is set for the event.
+ * If exclusion count is not zero, the exclusions are set for the event.
+ * Returns size of returned session payload data or a negative error code.
+ */
+int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
+		struct lttng_event *ev, const char *channel_name,
+		const char *original_filter_expression,
+		int exclusion_count, char **exclusion_list)
+{
+	struct lttcomm_session_msg lsm = {
+		.cmd_type = LTTCOMM_SESSIOND_COMMAND_ENABLE_EVENT,
+		.session = {},
+		.domain = {},
+		.u = {},
+		.fd_count = 0,
+	};
+	struct lttng_payload payload;
+	int ret = 0;
+
+	/*
+	 * We have either a filter or some exclusions, so we need to set up
+	 * a variable-length payload from where to send the data.
+	 */
+	lttng_payload_init(&payload);
+
+	if (handle == NULL || ev == NULL) {
+		ret = -LTTNG_ERR_INVALID;
+		goto error;
+	}
+
+	ret = serialize_event_to_enable(handle->domain.type, ev,
+			original_filter_expression, exclusion_count,
+			exclusion_list, &payload);
+	if (ret) {
+		goto error;
+	}
+
 	/* If no channel name, send empty string. */
 	ret = lttng_strncpy(lsm.u.enable.channel_name, channel_name ?: "",
 			sizeof(lsm.u.enable.channel_name));
@@ -1250,19 +1489,6 @@ serialize:
 	}
 
 error:
-	if (filter_expression && ctx) {
-		filter_bytecode_free(ctx);
-		filter_ir_free(ctx);
-		filter_parser_ctx_free(ctx);
-	}
-	if (free_filter_expression) {
-		/*
-		 * The filter expression has been replaced and must be freed as
-		 * it is not the original filter expression received as a
-		 * parameter.
-		 */
-		free(filter_expression);
-	}
 	/*
 	 * Return directly to the caller and don't ask the sessiond since
 	 * something went wrong in the parsing of data above.
@@ -1271,6 +1497,83 @@ error:
 	return ret;
 }
 
+/*
+ * Enable a batch of events of the same channel, all with the same filter.
+ *
+ * The session daemon validates the whole batch before enabling any of its
+ * events, and pushes the batch to each traced application at once.
+ *
+ * Returns 0 on success or a negative error code.
+ */
+int lttng_enable_events(struct lttng_handle *handle,
+		struct lttng_event *events, unsigned int count,
+		const char *channel_name, const char *filter_expression)
+{
+	struct lttcomm_session_msg lsm = {
+		.cmd_type = LTTCOMM_SESSIOND_COMMAND_ENABLE_EVENTS,
+		.session = {},
+		.domain = {},
+		.u = {},
+		.fd_count = 0,
+	};
+	struct lttng_payload payload;
+	int ret = 0;
+	unsigned int i;
+
+	lttng_payload_init(&payload);
+
+	if (handle == NULL || events == NULL || count == 0) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		/* Userspace probes (which carry an fd) can't be batched. */
+		if (events[i].type == LTTNG_EVENT_USERSPACE_PROBE) {
+			ret = -LTTNG_ERR_INVALID;
+			goto end;
+		}
+
+		ret = serialize_event_to_enable(handle->domain.type, &events[i],
+				filter_expression, 0, NULL, &payload);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	if (payload.buffer.size > UINT32_MAX) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	/* If no channel name, send empty string. */
+	ret = lttng_strncpy(lsm.u.enable_events.channel_name,
+			channel_name ?: "",
+			sizeof(lsm.u.enable_events.channel_name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	COPY_DOMAIN_PACKED(lsm.domain, handle->domain);
+
+	ret = lttng_strncpy(lsm.session.name, handle->session_name,
+			sizeof(lsm.session.name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	lsm.u.enable_events.count = count;
+	lsm.u.enable_events.length = (uint32_t) payload.buffer.size;
+
+	ret = lttng_ctl_ask_sessiond_varlen_no_cmd_header(&lsm,
+			payload.buffer.data, payload.buffer.size, NULL);
+end:
+	lttng_payload_reset(&payload);
+	return ret;
+}
+
 int lttng_disable_event_ext(struct lttng_handle *handle,
 		struct lttng_event *ev, const char *channel_name,
 		const char *original_filter_expression)
@@ -1285,7 +1588,7 @@ int lttng_disable_event_ext(struct lttng_handle *handle,
 	struct lttng_payload payload;
 	int ret = 0;
 	unsigned int free_filter_expression = 0;
-	struct filter_parser_ctx *ctx = NULL;
+	struct lttng_bytecode *bytecode = NULL;
 	size_t bytecode_len = 0;
 
 	/*
@@ -1352,13 +1655,12 @@ int lttng_disable_event_ext(struct lttng_handle *handle,
 			goto error;
 		}
 
-		ret = filter_parser_ctx_create_from_filter_expression(filter_expression, &ctx);
+		ret = filter_bytecode_cache_generate(filter_expression, &bytecode);
 		if (ret) {
 			goto error;
 		}
 
-		bytecode_len = bytecode_get_len(&ctx->bytecode->b) +
-				sizeof(ctx->bytecode->b);
+		bytecode_len = bytecode_get_len(bytecode) + sizeof(*bytecode);
 		if (bytecode_len > LTTNG_FILTER_MAX_LEN) {
 			ret = -LTTNG_ERR_FILTER_INVAL;
 			goto error;
@@ -1368,7 +1670,7 @@ int lttng_disable_event_ext(struct lttng_handle *handle,
 serialize:
 	ret = lttng_event_serialize(ev, 0, NULL,
 			filter_expression, bytecode_len,
-			(ctx && bytecode_len) ? &ctx->bytecode->b : NULL,
+			bytecode_len ? bytecode : NULL,
 			&payload);
 	if (ret) {
 		ret = -LTTNG_ERR_INVALID;
@@ -1427,11 +1729,7 @@ serialize:
 	}
 
 error:
-	if (filter_expression && ctx) {
-		filter_bytecode_free(ctx);
-		filter_ir_free(ctx);
-		filter_parser_ctx_free(ctx);
-	}
+	free(bytecode);
 	if (free_filter_expression) {
 		/*
 		 * The filter expression has been replaced and must be freed as
@@ -2771,6 +3069,82 @@ end:
 	return ret;
 }
 
+int lttng_channel_get_compression(struct lttng_channel *chan,
+		enum lttng_channel_compression *compression)
+{
+	int ret = 0;
+
+	if (!chan || !compression || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*compression = (enum lttng_channel_compression)
+			((struct lttng_channel_extended *)
+					chan->attr.extended.ptr)->compression;
+end:
+	return ret;
+}
+
+int lttng_channel_set_compression(struct lttng_channel *chan,
+		enum lttng_channel_compression compression)
+{
+	int ret = 0;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	switch (compression) {
+	case LTTNG_CHANNEL_COMPRESSION_NONE:
+	case LTTNG_CHANNEL_COMPRESSION_ZSTD:
+		break;
+	default:
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->compression =
+			(uint8_t) compression;
+end:
+	return ret;
+}
+
+int lttng_channel_get_empty_packet_suppression(struct lttng_channel *chan,
+		int *suppress_empty_packets)
+{
+	int ret = 0;
+
+	if (!chan || !suppress_empty_packets || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*suppress_empty_packets = ((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->suppress_empty_packets;
+end:
+	return ret;
+}
+
+int lttng_channel_set_empty_packet_suppression(struct lttng_channel *chan,
+		int suppress_empty_packets)
+{
+	int ret = 0;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->suppress_empty_packets =
+			!!suppress_empty_packets;
+end:
+	return ret;
+}
+
 /*
  * Check if session daemon is alive.
  *
@@ -2929,6 +3303,62 @@ end:
 	return ret;
 }
 
+/*
+ * List the consumption statistics of the streams of a session.
+ *
+ * Return the number of entries in *stats, which must be freed by the caller,
+ * or a negative error code.
+ */
+int lttng_list_stream_stats(const char *session_name,
+		struct lttng_stream_stats **stats)
+{
+	int ret;
+	struct lttcomm_session_msg lsm;
+	struct lttng_stream_stats *entries = NULL;
+
+	if (!session_name || !stats) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	/*
+	 * Initialize stats to NULL so it can be freed by the caller when no
+	 * entries are returned.
+	 */
+	*stats = NULL;
+
+	memset(&lsm, 0, sizeof(lsm));
+	lsm.cmd_type = LTTCOMM_SESSIOND_COMMAND_LIST_STREAM_STATS;
+
+	ret = lttng_strncpy(lsm.session.name, session_name,
+			sizeof(lsm.session.name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_ctl_ask_sessiond(&lsm, (void **) &entries);
+	if (ret <= 0) {
+		goto end;
+	}
+	if (!entries) {
+		ret = -LTTNG_ERR_FATAL;
+		goto end;
+	}
+
+	if (ret % sizeof(struct lttng_stream_stats)) {
+		/* Unexpected payload size */
+		ret = -LTTNG_ERR_UNK;
+		free(entries);
+		goto end;
+	}
+
+	*stats = entries;
+	ret = ret / (int) sizeof(struct lttng_stream_stats);
+end:
+	return ret;
+}
+
 /*
  * Regenerate the metadata for a session.
  * Return 0 on success, a negative error code on error.
@@ -3418,6 +3848,86 @@ end:
 	return ret_code;
 }
 
+struct lttng_session_daemon_connection *lttng_session_daemon_connection_create(void)
+{
+	int ret;
+	struct lttng_session_daemon_connection *connection = NULL;
+
+	if (persistent_connection) {
+		ERR("A persistent session daemon connection already exists");
+		goto end;
+	}
+
+	connection = zmalloc<lttng_session_daemon_connection>();
+	if (!connection) {
+		PERROR("Failed to allocate session daemon connection");
+		goto end;
+	}
+
+	ret = connect_sessiond();
+	if (ret < 0) {
+		free(connection);
+		connection = NULL;
+		goto end;
+	}
+
+	connection->socket = ret;
+	connection->first_error = LTTNG_OK;
+	persistent_connection = connection;
+end:
+	return connection;
+}
+
+void lttng_session_daemon_connection_destroy(
+		struct lttng_session_daemon_connection *connection)
+{
+	if (!connection) {
+		return;
+	}
+
+	if (connection == persistent_connection) {
+		persistent_connection = NULL;
+	}
+
+	persistent_connection_close(connection, LTTNG_ERR_FATAL);
+	free(connection);
+}
+
+enum lttng_session_daemon_connection_status
+lttng_session_daemon_connection_pipeline_begin(
+		struct lttng_session_daemon_connection *connection)
+{
+	if (!connection || connection->pipelining) {
+		return LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID;
+	}
+
+	connection->pipelining = true;
+	connection->completed_count = 0;
+	connection->first_error = LTTNG_OK;
+	return LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK;
+}
+
+enum lttng_session_daemon_connection_status
+lttng_session_daemon_connection_pipeline_end(
+		struct lttng_session_daemon_connection *connection,
+		enum lttng_error_code *result,
+		unsigned int *completed_count)
+{
+	if (!connection || !result || !connection->pipelining) {
+		return LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID;
+	}
+
+	recv_pending_replies(connection);
+	connection->pipelining = false;
+
+	*result = connection->first_error;
+	if (completed_count) {
+		*completed_count = connection->completed_count;
+	}
+
+	return LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK;
+}
+
 /*
  * lib constructor.
  */
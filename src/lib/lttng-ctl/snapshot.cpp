@@ -292,6 +292,12 @@ uint64_t lttng_snapshot_output_get_maxsize(
 	return output->max_size;
 }
 
+int lttng_snapshot_output_get_incremental(
+		const struct lttng_snapshot_output *output)
+{
+	return output->incremental;
+}
+
 /*
  * Setter family functions for snapshot output.
  */
@@ -318,6 +324,17 @@ int lttng_snapshot_output_set_size(uint64_t size,
 	return 0;
 }
 
+int lttng_snapshot_output_set_incremental(int incremental,
+		struct lttng_snapshot_output *output)
+{
+	if (!output) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	output->incremental = !!incremental;
+	return 0;
+}
+
 int lttng_snapshot_output_set_name(const char *name,
 		struct lttng_snapshot_output *output)
 {
@@ -0,0 +1,185 @@
+/*
+ * enable_events.cpp
+ *
+ * Tests suite for the batched event enablement API.
+ *
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/tap.h>
+#include <lttng/lttng.h>
+#include <common/macros.hpp>
+
+#define TEST_COUNT 13
+
+#define SESSION_NAME		"batch"
+#define CHANNEL_NAME		"chan"
+#define MAX_BATCH_SIZE		4
+
+static struct lttng_handle *handle;
+
+static
+void init_events(struct lttng_event *events, const char * const *names,
+		unsigned int count)
+{
+	unsigned int i;
+
+	LTTNG_ASSERT(count <= MAX_BATCH_SIZE);
+	memset(events, 0, sizeof(*events) * count);
+
+	for (i = 0; i < count; i++) {
+		events[i].type = LTTNG_EVENT_TRACEPOINT;
+		events[i].loglevel_type = LTTNG_EVENT_LOGLEVEL_ALL;
+		events[i].loglevel = -1;
+		strcpy(events[i].name, names[i]);
+	}
+}
+
+static
+int get_event_count(void)
+{
+	int ret;
+	struct lttng_event *events = NULL;
+
+	ret = lttng_list_events(handle, CHANNEL_NAME, &events);
+	free(events);
+	return ret;
+}
+
+static
+void test_invalid_parameters(void)
+{
+	struct lttng_event events[MAX_BATCH_SIZE];
+	static const char * const names[] = { "tp:a" };
+
+	init_events(events, names, 1);
+	ok(lttng_enable_events(NULL, events, 1, CHANNEL_NAME, NULL) ==
+			-LTTNG_ERR_INVALID,
+			"Enabling a batch with a NULL handle is invalid");
+	ok(lttng_enable_events(handle, events, 0, CHANNEL_NAME, NULL) ==
+			-LTTNG_ERR_INVALID,
+			"Enabling an empty batch is invalid");
+}
+
+static
+void test_enable(void)
+{
+	int ret;
+	struct lttng_event events[MAX_BATCH_SIZE];
+	static const char * const names[] = { "tp:a", "tp:b", "tp:c" };
+	static const char * const names_enabled[] = { "tp:a", "tp:d" };
+	static const char * const names_filtered[] = { "tp:e", "tp:f" };
+
+	init_events(events, names, 3);
+	ret = lttng_enable_events(handle, events, 3, CHANNEL_NAME, NULL);
+	ok(ret == 0, "Enable a batch of events");
+	ok(get_event_count() == 3, "All the events of the batch are enabled");
+
+	init_events(events, names_enabled, 2);
+	ret = lttng_enable_events(handle, events, 2, CHANNEL_NAME, NULL);
+	ok(ret == 0, "Enable a batch containing an enabled event");
+	ok(get_event_count() == 4, "Only the new event of the batch is added");
+
+	init_events(events, names_filtered, 2);
+	ret = lttng_enable_events(handle, events, 2, CHANNEL_NAME,
+			"intfield > 1");
+	ok(ret == 0, "Enable a batch of events with a filter");
+	ok(get_event_count() == 6,
+			"All the filtered events of the batch are enabled");
+}
+
+static
+void test_atomicity(void)
+{
+	int ret;
+	struct lttng_event events[MAX_BATCH_SIZE];
+	static const char * const names_reserved[] = {
+		"tp:g", "tp:h", "lttng_jul:event",
+	};
+	static const char * const names_invalid[] = { "tp:g", "tp:h" };
+
+	init_events(events, names_reserved, 3);
+	ret = lttng_enable_events(handle, events, 3, CHANNEL_NAME, NULL);
+	ok(ret == -LTTNG_ERR_INVALID_EVENT_NAME,
+			"Batch containing a reserved event name is rejected");
+	ok(get_event_count() == 6,
+			"No event of a batch with a reserved name is enabled");
+
+	/* Only rejected when the session daemon creates the event. */
+	init_events(events, names_invalid, 2);
+	events[1].loglevel_type = (enum lttng_loglevel_type) 42;
+	ret = lttng_enable_events(handle, events, 2, CHANNEL_NAME, NULL);
+	ok(ret == -LTTNG_ERR_INVALID,
+			"Batch containing an invalid event is rejected");
+	ok(get_event_count() == 6,
+			"No event of a batch with an invalid event is enabled");
+}
+
+static
+void test_need_channel_name(void)
+{
+	struct lttng_event events[MAX_BATCH_SIZE];
+	static const char * const names[] = { "tp:i" };
+
+	init_events(events, names, 1);
+	ok(lttng_enable_events(handle, events, 1, NULL, NULL) ==
+			-LTTNG_ERR_NEED_CHANNEL_NAME,
+			"Batch without channel name is rejected once a channel is created");
+}
+
+int main(void)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct lttng_domain domain = {};
+	struct lttng_channel *channel;
+	struct lttng_session_descriptor *descriptor;
+
+	plan_tests(TEST_COUNT);
+
+	domain.type = LTTNG_DOMAIN_UST;
+	domain.buf_type = LTTNG_BUFFER_PER_UID;
+
+	descriptor = lttng_session_descriptor_create(SESSION_NAME);
+	LTTNG_ASSERT(descriptor);
+	ret_code = lttng_create_session_ext(descriptor);
+	lttng_session_descriptor_destroy(descriptor);
+	if (ret_code != LTTNG_OK) {
+		fail("Failed to create session: %s",
+				lttng_strerror(-ret_code));
+		goto end;
+	}
+
+	handle = lttng_create_handle(SESSION_NAME, &domain);
+	LTTNG_ASSERT(handle);
+
+	channel = lttng_channel_create(&domain);
+	LTTNG_ASSERT(channel);
+	strcpy(channel->name, CHANNEL_NAME);
+	ret = lttng_enable_channel(handle, channel);
+	lttng_channel_destroy(channel);
+	if (ret) {
+		fail("Failed to enable channel: %s", lttng_strerror(ret));
+		goto destroy_session;
+	}
+
+	test_invalid_parameters();
+	test_enable();
+	test_atomicity();
+	test_need_channel_name();
+
+destroy_session:
+	lttng_destroy_handle(handle);
+	ret = lttng_destroy_session(SESSION_NAME);
+	if (ret) {
+		diag("Failed to destroy session: %s", lttng_strerror(ret));
+	}
+end:
+	return exit_status();
+}
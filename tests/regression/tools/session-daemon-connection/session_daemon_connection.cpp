@@ -0,0 +1,201 @@
+/*
+ * session_daemon_connection.cpp
+ *
+ * Tests suite for the persistent and pipelined session daemon connections.
+ *
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/tap.h>
+#include <lttng/lttng.h>
+#include <common/macros.hpp>
+
+#define TEST_COUNT 19
+
+#define SESSION_NAME		"pipeline"
+#define CHANNEL_NAME		"chan"
+/* More than the number of replies which may be pending on a connection. */
+#define PIPELINED_EVENT_COUNT	150
+
+static struct lttng_handle *handle;
+static struct lttng_domain domain;
+
+static
+int enable_event(const char *session_name, const char *event_name)
+{
+	int ret;
+	struct lttng_event *event;
+	struct lttng_handle *event_handle;
+
+	event = lttng_event_create();
+	event_handle = lttng_create_handle(session_name, &domain);
+	LTTNG_ASSERT(event && event_handle);
+
+	event->type = LTTNG_EVENT_TRACEPOINT;
+	strcpy(event->name, event_name);
+	ret = lttng_enable_event(event_handle, event, CHANNEL_NAME);
+
+	lttng_destroy_handle(event_handle);
+	lttng_event_destroy(event);
+	return ret;
+}
+
+static
+int get_event_count(void)
+{
+	int ret;
+	struct lttng_event *events = NULL;
+
+	ret = lttng_list_events(handle, CHANNEL_NAME, &events);
+	free(events);
+	return ret;
+}
+
+static
+void test_connection_lifetime(struct lttng_session_daemon_connection *connection)
+{
+	enum lttng_error_code result;
+
+	ok(lttng_session_daemon_connection_create() == NULL,
+			"Only one persistent connection may exist");
+	ok(lttng_session_daemon_connection_pipeline_end(connection, &result,
+			NULL) == LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID,
+			"Ending a pipeline which was not begun is invalid");
+	ok(lttng_session_daemon_connection_pipeline_begin(NULL) ==
+			LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID,
+			"Beginning a pipeline on a NULL connection is invalid");
+}
+
+static
+void test_pipeline(struct lttng_session_daemon_connection *connection)
+{
+	int ret, i;
+	bool all_sent = true;
+	struct lttng_channel *channel;
+	enum lttng_error_code result;
+	unsigned int completed_count = 0;
+
+	ok(lttng_session_daemon_connection_pipeline_begin(connection) ==
+			LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK,
+			"Begin pipeline");
+	ok(lttng_session_daemon_connection_pipeline_begin(connection) ==
+			LTTNG_SESSION_DAEMON_CONNECTION_STATUS_INVALID,
+			"Beginning a pipeline twice is invalid");
+
+	channel = lttng_channel_create(&domain);
+	LTTNG_ASSERT(channel);
+	strcpy(channel->name, CHANNEL_NAME);
+	ok(lttng_enable_channel(handle, channel) == 0,
+			"Pipelined channel enabling returns once sent");
+	lttng_channel_destroy(channel);
+
+	for (i = 0; i < PIPELINED_EVENT_COUNT; i++) {
+		char event_name[LTTNG_SYMBOL_NAME_LEN];
+
+		snprintf(event_name, sizeof(event_name), "tp:event_%d", i);
+		ret = enable_event(SESSION_NAME, event_name);
+		if (ret) {
+			diag("Failed to send the enabling of `%s`: %s",
+					event_name, lttng_strerror(ret));
+			all_sent = false;
+		}
+	}
+	ok(all_sent, "Pipelined %d event enablings", PIPELINED_EVENT_COUNT);
+
+	ok(lttng_session_daemon_connection_pipeline_end(connection, &result,
+			&completed_count) ==
+					LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK,
+			"End pipeline");
+	ok(result == LTTNG_OK, "All the pipelined commands succeeded");
+	ok(completed_count == PIPELINED_EVENT_COUNT + 1,
+			"Pipeline reports %d completed commands",
+			PIPELINED_EVENT_COUNT + 1);
+	ok(get_event_count() == PIPELINED_EVENT_COUNT,
+			"All the pipelined events are enabled");
+}
+
+static
+void test_pipeline_failure(struct lttng_session_daemon_connection *connection)
+{
+	enum lttng_error_code result;
+	unsigned int completed_count = 0;
+
+	ok(lttng_session_daemon_connection_pipeline_begin(connection) ==
+			LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK,
+			"Begin pipeline expected to fail");
+
+	ok(enable_event(SESSION_NAME, "tp:before_failure") == 0,
+			"Pipelined event enabling returns once sent");
+	ok(enable_event("no_such_session", "tp:failure") == 0,
+			"Pipelined failing command returns once sent");
+	/*
+	 * The session daemon may close the connection before this command
+	 * is sent: its result doesn't matter, but it must not raise SIGPIPE.
+	 */
+	(void) enable_event(SESSION_NAME, "tp:after_failure");
+	pass("Command following a failure doesn't raise SIGPIPE");
+
+	ok(lttng_session_daemon_connection_pipeline_end(connection, &result,
+			&completed_count) ==
+					LTTNG_SESSION_DAEMON_CONNECTION_STATUS_OK,
+			"End failed pipeline");
+	ok(result == LTTNG_ERR_SESS_NOT_FOUND,
+			"Pipeline reports the error of the failed command");
+	ok(completed_count == 1,
+			"Pipeline reports the commands completed before the failure");
+	ok(get_event_count() == PIPELINED_EVENT_COUNT + 1,
+			"Command following the failure is not executed");
+}
+
+int main(void)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct lttng_session_descriptor *descriptor;
+	struct lttng_session_daemon_connection *connection;
+
+	plan_tests(TEST_COUNT);
+
+	domain.type = LTTNG_DOMAIN_UST;
+	domain.buf_type = LTTNG_BUFFER_PER_UID;
+
+	connection = lttng_session_daemon_connection_create();
+	if (!connection) {
+		fail("Failed to connect to the session daemon");
+		goto end;
+	}
+
+	descriptor = lttng_session_descriptor_create(SESSION_NAME);
+	LTTNG_ASSERT(descriptor);
+	ret_code = lttng_create_session_ext(descriptor);
+	lttng_session_descriptor_destroy(descriptor);
+	if (ret_code != LTTNG_OK) {
+		fail("Failed to create session: %s",
+				lttng_strerror(-ret_code));
+		goto destroy_connection;
+	}
+
+	handle = lttng_create_handle(SESSION_NAME, &domain);
+	LTTNG_ASSERT(handle);
+
+	test_connection_lifetime(connection);
+	test_pipeline(connection);
+	test_pipeline_failure(connection);
+
+	lttng_destroy_handle(handle);
+	ret = lttng_destroy_session(SESSION_NAME);
+	if (ret) {
+		diag("Failed to destroy session: %s", lttng_strerror(ret));
+	}
+
+destroy_connection:
+	lttng_session_daemon_connection_destroy(connection);
+end:
+	return exit_status();
+}
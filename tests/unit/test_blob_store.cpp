@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <urcu.h>
+
+#include <bin/lttng-sessiond/blob-store.hpp>
+#include <common/macros.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+
+#include <tap/tap.h>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 20
+
+#define BYTECODE_LEN	64
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+#include <lttng/lttng-export.h>
+#include <lttng/ust-sigbus.h>
+LTTNG_EXPORT DEFINE_LTTNG_UST_SIGBUS_STATE();
+#endif
+
+/*
+ * Allocate a bytecode of BYTECODE_LEN bytes filled with `fill`. Each call
+ * returns a distinct allocation so that deduplication can't rely on the
+ * address of the original.
+ */
+static struct lttng_bytecode *create_bytecode(char fill, uint64_t seqnum)
+{
+	struct lttng_bytecode *bytecode;
+
+	bytecode = zmalloc<lttng_bytecode>(sizeof(*bytecode) + BYTECODE_LEN);
+	LTTNG_ASSERT(bytecode);
+	bytecode->len = BYTECODE_LEN;
+	bytecode->reloc_offset = BYTECODE_LEN / 2;
+	bytecode->seqnum = seqnum;
+	memset(bytecode->data, fill, BYTECODE_LEN);
+
+	return bytecode;
+}
+
+static struct lttng_event_exclusion *create_exclusion(const char *name)
+{
+	struct lttng_event_exclusion *exclusion;
+
+	exclusion = zmalloc<lttng_event_exclusion>(
+			sizeof(*exclusion) + LTTNG_SYMBOL_NAME_LEN);
+	LTTNG_ASSERT(exclusion);
+	exclusion->count = 1;
+	strcpy(LTTNG_EVENT_EXCLUSION_NAME_AT(exclusion, 0), name);
+
+	return exclusion;
+}
+
+static bool bytecode_data_matches(const struct lttng_bytecode *shared,
+		const struct lttng_bytecode *original)
+{
+	return shared->len == original->len &&
+			shared->reloc_offset == original->reloc_offset &&
+			memcmp(shared->data, original->data, original->len) == 0;
+}
+
+static void test_bytecode_deduplication(void)
+{
+	struct lttng_bytecode *a = create_bytecode('a', 0);
+	struct lttng_bytecode *a_copy = create_bytecode('a', 0);
+	struct lttng_bytecode *b = create_bytecode('b', 0);
+	struct lttng_bytecode *a_seqnum = create_bytecode('a', 1);
+	const struct lttng_bytecode *shared_a, *shared_a_copy, *shared_b,
+			*shared_a_seqnum;
+
+	shared_a = blob_store_get_bytecode(a);
+	ok(shared_a && shared_a != a, "Get shared copy of a bytecode");
+	ok(shared_a && bytecode_data_matches(shared_a, a) &&
+					shared_a->seqnum == a->seqnum,
+			"Shared copy of a bytecode has the same content");
+
+	shared_a_copy = blob_store_get_bytecode(a_copy);
+	ok(shared_a_copy == shared_a,
+			"Bytecodes with identical content share a copy");
+
+	shared_b = blob_store_get_bytecode(b);
+	ok(shared_b && shared_b != shared_a,
+			"Bytecodes with different content have distinct copies");
+
+	shared_a_seqnum = blob_store_get_bytecode(a_seqnum);
+	ok(shared_a_seqnum && shared_a_seqnum != shared_a,
+			"Bytecodes with different sequence numbers have distinct copies");
+
+	blob_store_put(shared_a);
+	blob_store_put(shared_a_copy);
+	blob_store_put(shared_b);
+	blob_store_put(shared_a_seqnum);
+	free(a);
+	free(a_copy);
+	free(b);
+	free(a_seqnum);
+}
+
+static void test_capture_bytecode(void)
+{
+	struct lttng_bytecode *bytecode = create_bytecode('c', 0);
+	const struct lttng_bytecode *shared, *capture_1, *capture_1_again,
+			*capture_2, *capture_0;
+
+	shared = blob_store_get_bytecode(bytecode);
+
+	capture_1 = blob_store_get_capture_bytecode(bytecode, 1);
+	ok(capture_1 && capture_1->seqnum == 1,
+			"Capture bytecode has the requested sequence number");
+	ok(capture_1 && bytecode_data_matches(capture_1, bytecode),
+			"Capture bytecode has the content of the original");
+	ok(bytecode->seqnum == 0,
+			"Original bytecode's sequence number is unchanged");
+	ok(capture_1 != shared,
+			"Capture bytecode doesn't share the copy of the original");
+
+	capture_1_again = blob_store_get_capture_bytecode(bytecode, 1);
+	ok(capture_1_again == capture_1,
+			"Capture bytecodes with the same sequence number share a copy");
+
+	capture_2 = blob_store_get_capture_bytecode(bytecode, 2);
+	ok(capture_2 && capture_2 != capture_1 && capture_2->seqnum == 2,
+			"Capture bytecodes with different sequence numbers have distinct copies");
+
+	capture_0 = blob_store_get_capture_bytecode(bytecode, 0);
+	ok(capture_0 == shared,
+			"Capture bytecode with the original's sequence number shares its copy");
+
+	blob_store_put(shared);
+	blob_store_put(capture_1);
+	blob_store_put(capture_1_again);
+	blob_store_put(capture_2);
+	blob_store_put(capture_0);
+	free(bytecode);
+}
+
+static void test_exclusion(void)
+{
+	struct lttng_event_exclusion *foo = create_exclusion("foo");
+	struct lttng_event_exclusion *foo_copy = create_exclusion("foo");
+	struct lttng_event_exclusion *bar = create_exclusion("bar");
+	const struct lttng_event_exclusion *shared_foo, *shared_foo_copy,
+			*shared_bar;
+
+	shared_foo = blob_store_get_exclusion(foo);
+	shared_foo_copy = blob_store_get_exclusion(foo_copy);
+	ok(shared_foo && shared_foo == shared_foo_copy &&
+					!strcmp(LTTNG_EVENT_EXCLUSION_NAME_AT(
+							shared_foo, 0), "foo"),
+			"Exclusions with identical names share a copy");
+
+	shared_bar = blob_store_get_exclusion(bar);
+	ok(shared_bar && shared_bar != shared_foo,
+			"Exclusions with different names have distinct copies");
+
+	blob_store_put(shared_foo);
+	blob_store_put(shared_foo_copy);
+	blob_store_put(shared_bar);
+	free(foo);
+	free(foo_copy);
+	free(bar);
+}
+
+static void test_put(void)
+{
+	struct lttng_bytecode *bytecode = create_bytecode('d', 0);
+	const struct lttng_bytecode *first, *second, *third, *fresh;
+
+	first = blob_store_get_bytecode(bytecode);
+	second = blob_store_get_bytecode(bytecode);
+	blob_store_put(first);
+
+	third = blob_store_get_bytecode(bytecode);
+	ok(third == second,
+			"Shared copy outlives the release of one of its references");
+	ok(third && bytecode_data_matches(third, bytecode),
+			"Shared copy is intact after the release of one of its references");
+
+	/*
+	 * Hold the RCU read-side lock so that the memory of the released
+	 * entry can't be reclaimed and reused by the next allocation.
+	 */
+	rcu_read_lock();
+	blob_store_put(second);
+	blob_store_put(third);
+	fresh = blob_store_get_bytecode(bytecode);
+	ok(fresh && fresh != third,
+			"Shared copy is removed with its last reference");
+	ok(fresh && bytecode_data_matches(fresh, bytecode),
+			"New shared copy has the content of the original");
+	rcu_read_unlock();
+
+	blob_store_put(fresh);
+	free(bytecode);
+
+	blob_store_put(NULL);
+	pass("Releasing a NULL blob is a no-op");
+}
+
+static void test_destroy(void)
+{
+	struct lttng_bytecode *bytecode = create_bytecode('e', 0);
+	const struct lttng_bytecode *leaked;
+
+	/* The reference is intentionally leaked to the destruction. */
+	leaked = blob_store_get_bytecode(bytecode);
+	LTTNG_ASSERT(leaked);
+	blob_store_destroy();
+	rcu_barrier();
+
+	leaked = blob_store_get_bytecode(bytecode);
+	ok(leaked && bytecode_data_matches(leaked, bytecode),
+			"Blob store is usable after its destruction");
+	blob_store_put(leaked);
+	blob_store_destroy();
+	free(bytecode);
+}
+
+int main(void)
+{
+	plan_tests(NUM_TESTS);
+
+	rcu_register_thread();
+
+	test_bytecode_deduplication();
+	test_capture_bytecode();
+	test_exclusion();
+	test_put();
+	test_destroy();
+
+	rcu_unregister_thread();
+	rcu_barrier();
+
+	return exit_status();
+}
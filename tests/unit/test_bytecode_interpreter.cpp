@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <common/bytecode/bytecode-interpreter.hpp>
+#include <common/bytecode/bytecode.hpp>
+#include <common/filter/filter-bytecode-cache.hpp>
+#include <lttng/event-expr-internal.hpp>
+#include <lttng/event-expr.h>
+#include <tap/tap.h>
+
+#define NUM_TESTS 16
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static const int64_t array_elements[] = { 7, 8, 9 };
+
+static struct bytecode_interpreter_field fields[6];
+static struct bytecode_interpreter_event event;
+
+static void init_event(void)
+{
+	fields[0].scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+	fields[0].name = "intfield";
+	fields[0].value.type = BYTECODE_INTERPRETER_VALUE_TYPE_S64;
+	fields[0].value.u.s64 = 50;
+
+	fields[1].scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+	fields[1].name = "strfield";
+	fields[1].value.type = BYTECODE_INTERPRETER_VALUE_TYPE_STRING;
+	fields[1].value.u.string = "abcdef";
+
+	fields[2].scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+	fields[2].name = "dblfield";
+	fields[2].value.type = BYTECODE_INTERPRETER_VALUE_TYPE_DOUBLE;
+	fields[2].value.u.d = 1.25;
+
+	fields[3].scope = BYTECODE_INTERPRETER_SCOPE_PAYLOAD;
+	fields[3].name = "arrfield";
+	fields[3].value.type = BYTECODE_INTERPRETER_VALUE_TYPE_ARRAY;
+	fields[3].value.u.array.elements = array_elements;
+	fields[3].value.u.array.count = 3;
+
+	fields[4].scope = BYTECODE_INTERPRETER_SCOPE_CONTEXT;
+	fields[4].name = "vpid";
+	fields[4].value.type = BYTECODE_INTERPRETER_VALUE_TYPE_S64;
+	fields[4].value.u.s64 = 1234;
+
+	fields[5].scope = BYTECODE_INTERPRETER_SCOPE_APP_CONTEXT;
+	fields[5].name = "myprovider:myctx";
+	fields[5].value.type = BYTECODE_INTERPRETER_VALUE_TYPE_U64;
+	fields[5].value.u.u64 = 3;
+
+	event.fields = fields;
+	event.field_count = sizeof(fields) / sizeof(fields[0]);
+}
+
+/*
+ * Compile, link and evaluate a filter expression against the event.
+ *
+ * Returns the result of the filter, or the error which occurred while
+ * linking or evaluating it.
+ */
+static int evaluate_filter(const char *expression)
+{
+	int ret;
+	struct lttng_bytecode *bytecode = NULL;
+	struct bytecode_interpreter_program *program = NULL;
+
+	ret = filter_bytecode_cache_generate(expression, &bytecode);
+	if (ret) {
+		diag("Failed to compile filter expression `%s`", expression);
+		goto end;
+	}
+
+	ret = bytecode_interpreter_link(bytecode, &event, &program);
+	if (ret) {
+		goto end;
+	}
+
+	ret = bytecode_interpreter_filter(program, &event);
+
+end:
+	bytecode_interpreter_program_destroy(program);
+	free(bytecode);
+	return ret;
+}
+
+static void test_filters(void)
+{
+	ok(evaluate_filter("intfield > 42 && strfield == \"abc*\"") == 1,
+			"Integer comparison and star-at-the-end string match");
+	ok(evaluate_filter("intfield > 42 && strfield == \"abc\"") == 0,
+			"Plain string literal doesn't match a longer string");
+	ok(evaluate_filter("strfield == \"a*d*f\"") == 1,
+			"Globbing pattern matches");
+	ok(evaluate_filter("strfield != \"*x*\"") == 1,
+			"Globbing pattern doesn't match");
+	ok(evaluate_filter("dblfield < 1.5 && dblfield > 1") == 1,
+			"Floating point comparisons");
+	ok(evaluate_filter("$ctx.vpid == 1234") == 1,
+			"Context field comparison");
+	ok(evaluate_filter("$app.myprovider:myctx == 3") == 1,
+			"Application context field comparison");
+	ok(evaluate_filter("arrfield[2] == 9") == 1,
+			"Array element comparison");
+	ok(evaluate_filter("(intfield & 3) == 2 && !(intfield >> 1 == 0)") == 1,
+			"Bitwise and unary operators");
+	ok(evaluate_filter("intfield == 50 || strfield > 1") == 1,
+			"Logical or short-circuits its right operand");
+	ok(evaluate_filter("strfield > 1") == -EINVAL,
+			"Comparing a string to an integer is a runtime error");
+	ok(evaluate_filter("arrfield[5] == 1") == -EINVAL,
+			"Out of bounds array index is a runtime error");
+	ok(evaluate_filter("nosuchfield == 1") == -ENOENT,
+			"Reference to a missing field fails to link");
+	ok(evaluate_filter("0 && nosuchfield == 1") == 0,
+			"Dead reference to a missing field is optimized out");
+}
+
+static void test_capture(void)
+{
+	int ret;
+	struct lttng_event_expr *expr;
+	struct lttng_bytecode *bytecode = NULL;
+	struct bytecode_interpreter_program *program = NULL;
+	struct bytecode_interpreter_value value = {};
+
+	expr = lttng_event_expr_array_field_element_create(
+			lttng_event_expr_event_payload_field_create("arrfield"),
+			1);
+	ret = lttng_event_expr_to_bytecode(expr, &bytecode);
+	if (!ret) {
+		ret = bytecode_interpreter_link(bytecode, &event, &program);
+	}
+	if (!ret) {
+		ret = bytecode_interpreter_run(program, &event, &value);
+	}
+	ok(ret == 0 && value.type == BYTECODE_INTERPRETER_VALUE_TYPE_S64 &&
+			value.u.s64 == 8,
+			"Capture of an array element");
+
+	bytecode_interpreter_program_destroy(program);
+	program = NULL;
+	free(bytecode);
+	bytecode = NULL;
+	lttng_event_expr_destroy(expr);
+
+	expr = lttng_event_expr_channel_context_field_create("vpid");
+	ret = lttng_event_expr_to_bytecode(expr, &bytecode);
+	if (!ret) {
+		ret = bytecode_interpreter_link(bytecode, &event, &program);
+	}
+	if (!ret) {
+		ret = bytecode_interpreter_run(program, &event, &value);
+	}
+	ok(ret == 0 && value.type == BYTECODE_INTERPRETER_VALUE_TYPE_S64 &&
+			value.u.s64 == 1234,
+			"Capture of a context field");
+
+	bytecode_interpreter_program_destroy(program);
+	free(bytecode);
+	lttng_event_expr_destroy(expr);
+}
+
+int main(void)
+{
+	plan_tests(NUM_TESTS);
+
+	init_event();
+	test_filters();
+	test_capture();
+
+	return exit_status();
+}
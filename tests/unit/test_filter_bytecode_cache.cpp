@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/bytecode/bytecode.hpp>
+#include <common/filter/filter-bytecode-cache.hpp>
+#include <tap/tap.h>
+
+#define NUM_TESTS 12
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_one_normalization(const char *expression,
+		const char *expected)
+{
+	char *normalized;
+
+	normalized = filter_bytecode_cache_normalize_expression(expression);
+	ok(normalized && !strcmp(normalized, expected),
+			"Expression `%s` is normalized to `%s`", expression,
+			expected);
+	free(normalized);
+}
+
+static void test_normalization(void)
+{
+	test_one_normalization("a==1", "a==1");
+	test_one_normalization(" \ta  ==\t\t1  ", "a == 1");
+	test_one_normalization("msg == \"a  b\"  &&  c == 'x  y'",
+			"msg == \"a  b\" && c == 'x  y'");
+	test_one_normalization("msg == \"a\\\"  b\"  ||  c", "msg == \"a\\\"  b\" || c");
+	test_one_normalization("a  == 1  /* two  spaces */", "a == 1 /* two  spaces */");
+}
+
+static bool bytecode_equal(const struct lttng_bytecode *a,
+		const struct lttng_bytecode *b)
+{
+	return a->len == b->len && !memcmp(a, b, sizeof(*a) + a->len);
+}
+
+static void test_generate(void)
+{
+	int ret;
+	struct lttng_bytecode *first = NULL, *second = NULL, *cached = NULL;
+
+	ok(filter_bytecode_cache_lookup("intfield  >  42 && strfield == \"x\"") == NULL,
+			"Expression which was never compiled is not cached");
+
+	ret = filter_bytecode_cache_generate("intfield > 42 && strfield == \"x\"",
+			&first);
+	ok(ret == 0 && first, "Expression is compiled");
+
+	cached = filter_bytecode_cache_lookup("intfield  >  42 && strfield == \"x\"");
+	ok(cached && first && bytecode_equal(first, cached),
+			"Compiled expression is cached under its normalized form");
+
+	ret = filter_bytecode_cache_generate(" intfield > 42  &&  strfield == \"x\" ",
+			&second);
+	ok(ret == 0 && second && first && bytecode_equal(first, second) &&
+			first != second,
+			"Equivalent expression returns a copy of the cached bytecode");
+
+	ok(filter_bytecode_cache_lookup("intfield > 42 && strfield == \"x \"") == NULL,
+			"Expression differing in a literal is not a cache hit");
+
+	free(cached);
+	cached = NULL;
+	ret = filter_bytecode_cache_generate("intfield >", &cached);
+	ok(ret < 0, "Invalid expression is reported as an error");
+
+	ok(filter_bytecode_cache_lookup("intfield >") == NULL,
+			"Invalid expression is not cached");
+
+	free(first);
+	free(second);
+	free(cached);
+}
+
+int main(void)
+{
+	plan_tests(NUM_TESTS);
+
+	test_normalization();
+	test_generate();
+
+	return exit_status();
+}
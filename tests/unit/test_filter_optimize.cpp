@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/bytecode/bytecode.hpp>
+#include <common/filter/filter-bytecode-cache.hpp>
+#include <tap/tap.h>
+
+#define NUM_TESTS 21
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+/*
+ * Check that two filter expressions are compiled to the same bytecode once
+ * optimized.
+ */
+static void test_same_bytecode(const char *expression, const char *optimized)
+{
+	int ret_a, ret_b;
+	struct lttng_bytecode *a = NULL, *b = NULL;
+
+	ret_a = filter_bytecode_cache_generate(expression, &a);
+	ret_b = filter_bytecode_cache_generate(optimized, &b);
+	ok(ret_a == 0 && ret_b == 0 && a->len == b->len &&
+			!memcmp(a, b, sizeof(*a) + a->len),
+			"`%s` is compiled as `%s`", expression, optimized);
+	free(a);
+	free(b);
+}
+
+/*
+ * Check that two filter expressions are compiled to different bytecodes once
+ * optimized, that is that the optimizer didn't rewrite the first one as the
+ * second.
+ */
+static void test_different_bytecode(const char *expression, const char *other)
+{
+	int ret_a, ret_b;
+	struct lttng_bytecode *a = NULL, *b = NULL;
+
+	ret_a = filter_bytecode_cache_generate(expression, &a);
+	ret_b = filter_bytecode_cache_generate(other, &b);
+	ok(ret_a == 0 && ret_b == 0 && (a->len != b->len ||
+			memcmp(a, b, sizeof(*a) + a->len)),
+			"`%s` is not compiled as `%s`", expression, other);
+	free(a);
+	free(b);
+}
+
+int main(void)
+{
+	plan_tests(NUM_TESTS);
+
+	/* Constant folding. */
+	test_same_bytecode("(1 & 3) == 1", "1");
+	test_same_bytecode("intfield == -(+2)", "intfield == -2");
+
+	/* Dead branch elimination. */
+	test_same_bytecode("1 && intfield == 2", "intfield == 2");
+	test_same_bytecode("0 && intfield == 2", "0");
+	test_same_bytecode("intfield == 2 && 0", "0");
+
+	/* Cost-based ordering of the top-level conjunction. */
+	test_same_bytecode("strfield == \"x*y\" && intfield > 42",
+			"intfield > 42 && strfield == \"x*y\"");
+	test_same_bytecode("strfield == \"abc\" && intfield > 42 && 1",
+			"intfield > 42 && strfield == \"abc\"");
+
+	/* Only the top-level conjunction is reordered. */
+	test_different_bytecode("strfield == \"abc\" || intfield > 42",
+			"intfield > 42 || strfield == \"abc\"");
+	test_different_bytecode(
+			"(strfield == \"abc\" && intfield > 42) || intfield == 1",
+			"(intfield > 42 && strfield == \"abc\") || intfield == 1");
+	test_different_bytecode("!(strfield == \"abc\" && intfield > 42)",
+			"!(intfield > 42 && strfield == \"abc\")");
+
+	/*
+	 * A logical operator is only replaced by an operand whose value is
+	 * 0 or 1, and its left operand is always evaluated.
+	 */
+	test_different_bytecode("(intfield & 4 && 1) == 1", "(intfield & 4) == 1");
+	test_different_bytecode("(intfield || 0) == 1", "intfield == 1");
+	test_same_bytecode("(intfield == 4 && 1) == 1", "(intfield == 4) == 1");
+	test_different_bytecode("intfield == 2 || 1", "1");
+
+	/*
+	 * Integers are compared as integers, and converted to double when
+	 * compared to a floating point number, as the tracer does.
+	 */
+	test_same_bytecode("1 == 1.0", "1");
+	test_same_bytecode("3 > 2.5", "1");
+	test_same_bytecode("9007199254740993 == 9007199254740992.0", "1");
+	test_same_bytecode("9007199254740993 == 9007199254740992", "0");
+	test_same_bytecode("!0.5", "0");
+
+	/* The negation of INT64_MIN overflows: it is left to the tracer. */
+	test_different_bytecode("intfield == -0x8000000000000000",
+			"intfield == 0x8000000000000000");
+	test_different_bytecode("-0x8000000000000000 == 0x8000000000000000",
+			"1");
+
+	return exit_status();
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <common/compat/endian.hpp>
+#include <common/index/ctf-index.hpp>
+#include <common/index/packet-compression.hpp>
+#include <tap/tap.h>
+
+#define TEST_COUNT 14
+
+#define PACKET_SIZE	4096
+#define CONTENT_SIZE	1024
+/* Number of tests requiring zstd support. */
+#define ZSTD_TEST_COUNT	9
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static char packet[PACKET_SIZE];
+
+/*
+ * Fill a packet with a repetitive content followed by zeroed padding, as a
+ * ring buffer sub-buffer would be.
+ */
+static void init_packet(void)
+{
+	size_t i;
+
+	memset(packet, 0, sizeof(packet));
+	for (i = 0; i < CONTENT_SIZE; i++) {
+		packet[i] = (char) (i % 61);
+	}
+}
+
+static void test_index_layout(void)
+{
+	ok(offsetof(struct ctf_packet_index, compressed_size) ==
+					ctf_packet_index_len(CTF_INDEX_MAJOR,
+							CTF_INDEX_MINOR),
+			"compressed_size follows the fields of the 1.1 index");
+	ok(ctf_packet_index_len(CTF_INDEX_MAJOR, CTF_INDEX_COMPRESSED_MINOR) ==
+					sizeof(struct ctf_packet_index),
+			"1.2 index entry holds compressed_size");
+}
+
+static void test_supported(void)
+{
+	ok(lttng_packet_compression_is_supported(
+			   LTTNG_CHANNEL_COMPRESSION_NONE),
+			"No compression is always supported");
+	ok(lttng_packet_compressor_create(LTTNG_CHANNEL_COMPRESSION_NONE) ==
+					NULL,
+			"No compressor is created without compression");
+#ifdef HAVE_LIBZSTD
+	ok(lttng_packet_compression_is_supported(
+			   LTTNG_CHANNEL_COMPRESSION_ZSTD),
+			"zstd compression is supported");
+#else
+	ok(!lttng_packet_compression_is_supported(
+			   LTTNG_CHANNEL_COMPRESSION_ZSTD),
+			"zstd compression is not supported without zstd");
+#endif
+}
+
+#ifdef HAVE_LIBZSTD
+static void test_round_trip(void)
+{
+	struct lttng_packet_compressor *compressor;
+	struct lttng_buffer_view view =
+			lttng_buffer_view_init(packet, 0, sizeof(packet));
+	struct lttng_buffer_view compressed = {};
+	struct lttng_buffer_view compressed_view;
+	struct lttng_dynamic_buffer decompressed;
+	struct ctf_packet_index index = {};
+
+	lttng_dynamic_buffer_init(&decompressed);
+	init_packet();
+
+	compressor = lttng_packet_compressor_create(
+			LTTNG_CHANNEL_COMPRESSION_ZSTD);
+	ok(compressor, "Create zstd compressor");
+	if (!compressor) {
+		skip(ZSTD_TEST_COUNT - 1, "No compressor");
+		goto end;
+	}
+
+	ok(lttng_packet_compress(compressor, &view, &compressed) == 0,
+			"Compress packet");
+	ok(compressed.size > 0 && compressed.size < sizeof(packet),
+			"Compressed packet is smaller than the packet: %zu bytes",
+			compressed.size);
+
+	/* Index entry as written by the consumer daemon. */
+	index.offset = htobe64(0);
+	index.packet_size = htobe64(sizeof(packet) * CHAR_BIT);
+	index.content_size = htobe64(CONTENT_SIZE * CHAR_BIT);
+	index.compressed_size = htobe64(compressed.size);
+
+	compressed_view = lttng_buffer_view_init(compressed.data,
+			be64toh(index.offset), be64toh(index.compressed_size));
+	ok(lttng_packet_decompress(LTTNG_CHANNEL_COMPRESSION_ZSTD,
+			   &compressed_view,
+			   be64toh(index.packet_size) / CHAR_BIT,
+			   &decompressed) == 0,
+			"Decompress packet using its index entry");
+	ok(decompressed.size == sizeof(packet) &&
+					memcmp(decompressed.data, packet,
+							sizeof(packet)) == 0,
+			"Decompressed packet is identical to the packet");
+
+	ok(lttng_packet_decompress(LTTNG_CHANNEL_COMPRESSION_ZSTD,
+			   &compressed_view, sizeof(packet) / 2,
+			   &decompressed) != 0,
+			"Reject a packet size which doesn't match the index entry");
+
+	compressed_view.size--;
+	ok(lttng_packet_decompress(LTTNG_CHANNEL_COMPRESSION_ZSTD,
+			   &compressed_view, sizeof(packet),
+			   &decompressed) != 0,
+			"Reject a truncated compressed packet");
+
+	ok(lttng_packet_decompress(LTTNG_CHANNEL_COMPRESSION_NONE,
+			   &compressed, sizeof(packet), &decompressed) != 0,
+			"Reject decompression of an uncompressed packet");
+
+	/* The compressor's buffer is reused for the next packet. */
+	memset(packet, 0x5a, CONTENT_SIZE);
+	ok(lttng_packet_compress(compressor, &view, &compressed) == 0 &&
+					lttng_packet_decompress(
+							LTTNG_CHANNEL_COMPRESSION_ZSTD,
+							&compressed,
+							sizeof(packet),
+							&decompressed) == 0 &&
+					memcmp(decompressed.data, packet,
+							sizeof(packet)) == 0,
+			"Compress and decompress a second packet");
+
+end:
+	lttng_packet_compressor_destroy(compressor);
+	lttng_dynamic_buffer_reset(&decompressed);
+}
+#else
+static void test_round_trip(void)
+{
+	skip(ZSTD_TEST_COUNT, "zstd support is not built");
+}
+#endif /* HAVE_LIBZSTD */
+
+int main(void)
+{
+	plan_tests(TEST_COUNT);
+
+	test_index_layout();
+	test_supported();
+	test_round_trip();
+
+	return exit_status();
+}
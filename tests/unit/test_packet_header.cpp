@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <common/index/packet-header.hpp>
+#include <tap/tap.h>
+
+#define TEST_COUNT 19
+
+#define PACKET_SIZE	4096
+#define EVENT_SIZE	32
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static char packet[PACKET_SIZE];
+
+/*
+ * Write a packet as a ring buffer client would, holding `event_size` bytes of
+ * event records after its header and padded to PACKET_SIZE.
+ */
+static void init_packet(size_t event_size)
+{
+	struct lttng_packet_header header = {};
+
+	header.magic = LTTNG_PACKET_HEADER_MAGIC;
+	memset(header.uuid, 0x2a, sizeof(header.uuid));
+	header.stream_id = 1;
+	header.stream_instance_id = 3;
+	header.ctx.timestamp_begin = 1000;
+	header.ctx.timestamp_end = 2000;
+	header.ctx.content_size = (sizeof(header) + event_size) * CHAR_BIT;
+	header.ctx.packet_size = PACKET_SIZE * CHAR_BIT;
+	header.ctx.packet_seq_num = 42;
+	header.ctx.events_discarded = 7;
+	header.ctx.cpu_id = 2;
+
+	memset(packet, 0, sizeof(packet));
+	memcpy(packet, &header, sizeof(header));
+	memset(packet + sizeof(header), 0xff, event_size);
+}
+
+static void test_layout(void)
+{
+	ok(offsetof(struct lttng_packet_header, ctx.content_size) == 48,
+			"content_size is at offset 48");
+	ok(offsetof(struct lttng_packet_header, ctx.packet_size) == 56,
+			"packet_size is at offset 56");
+	ok(offsetof(struct lttng_packet_header, ctx.events_discarded) == 72,
+			"events_discarded is at offset 72");
+	ok(sizeof(struct lttng_packet_header) ==
+					76 + sizeof(unsigned long),
+			"Packet header and context size is %zu bytes",
+			sizeof(struct lttng_packet_header));
+}
+
+static void test_read(void)
+{
+	struct lttng_packet_header header;
+	struct lttng_buffer_view view;
+
+	init_packet(0);
+	view = lttng_buffer_view_init(packet, 0, sizeof(packet));
+	ok(lttng_packet_header_read(&view, &header) == 0,
+			"Read packet header");
+	ok(header.stream_id == 1 && header.stream_instance_id == 3,
+			"Read stream identifiers");
+	ok(header.ctx.timestamp_begin == 1000 &&
+					header.ctx.timestamp_end == 2000,
+			"Read packet timestamps");
+	ok(header.ctx.content_size == sizeof(header) * CHAR_BIT &&
+					header.ctx.packet_size ==
+							PACKET_SIZE * CHAR_BIT,
+			"Read content and packet sizes");
+	ok(header.ctx.packet_seq_num == 42 &&
+					header.ctx.events_discarded == 7 &&
+					header.ctx.cpu_id == 2,
+			"Read sequence number, discarded events and CPU");
+
+	view = lttng_buffer_view_init(packet, 0, sizeof(header) - 1);
+	ok(lttng_packet_header_read(&view, &header) == -1,
+			"Reject a packet smaller than a header");
+
+	view = lttng_buffer_view_init(packet, 0, sizeof(packet));
+	packet[0] ^= 1;
+	ok(lttng_packet_header_read(&view, &header) == -1,
+			"Reject a packet without the CTF magic number");
+}
+
+static void test_is_empty(void)
+{
+	struct lttng_packet_header header;
+	struct lttng_buffer_view view =
+			lttng_buffer_view_init(packet, 0, sizeof(packet));
+
+	init_packet(0);
+	(void) lttng_packet_header_read(&view, &header);
+	ok(lttng_packet_header_is_empty(&header),
+			"Packet without event records is empty");
+
+	init_packet(EVENT_SIZE);
+	(void) lttng_packet_header_read(&view, &header);
+	ok(!lttng_packet_header_is_empty(&header),
+			"Packet with event records is not empty");
+}
+
+static void test_trim(void)
+{
+	struct lttng_packet_header original, trimmed_header;
+	struct lttng_dynamic_buffer trimmed;
+	struct lttng_buffer_view view =
+			lttng_buffer_view_init(packet, 0, sizeof(packet));
+	struct lttng_buffer_view trimmed_view;
+
+	lttng_dynamic_buffer_init(&trimmed);
+
+	init_packet(0);
+	(void) lttng_packet_header_read(&view, &original);
+	ok(lttng_packet_header_trim(&view, &trimmed) == 0,
+			"Trim empty packet");
+	ok(trimmed.size == sizeof(struct lttng_packet_header),
+			"Trimmed packet only holds its header and context");
+
+	trimmed_view = lttng_buffer_view_from_dynamic_buffer(&trimmed, 0, -1);
+	ok(lttng_packet_header_read(&trimmed_view, &trimmed_header) == 0,
+			"Trimmed packet is a valid packet");
+	ok(trimmed_header.ctx.packet_size == trimmed.size * CHAR_BIT &&
+					trimmed_header.ctx.content_size ==
+							trimmed_header.ctx.packet_size,
+			"Trimmed packet's size is patched");
+
+	trimmed_header.ctx.packet_size = original.ctx.packet_size;
+	ok(memcmp(&trimmed_header, &original, sizeof(original)) == 0,
+			"Trimmed packet's other fields are unchanged");
+
+	init_packet(EVENT_SIZE);
+	ok(lttng_packet_header_trim(&view, &trimmed) == -1,
+			"Packet with event records is not trimmed");
+
+	lttng_dynamic_buffer_reset(&trimmed);
+}
+
+int main(void)
+{
+	plan_tests(TEST_COUNT);
+
+	test_layout();
+	test_read();
+	test_is_empty();
+	test_trim();
+
+	return exit_status();
+}
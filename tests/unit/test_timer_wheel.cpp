@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2022 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tap/tap.h>
+
+#include <common/timer-wheel.hpp>
+
+#define NUM_TESTS 20
+
+/* 1 ms tick. */
+#define TICK_NS UINT64_C(1000000)
+
+static void noop_cb(struct timer_wheel_entry *entry __attribute__((unused)),
+		void *data __attribute__((unused)))
+{
+}
+
+/*
+ * Drive the wheel the way its user does: sleep until the next expiry returned
+ * by the wheel and advance it. Returns the time at which `entry` expired, or
+ * UINT64_MAX if it did not expire before `limit_ns`.
+ */
+static uint64_t run_until_expiry(struct timer_wheel *wheel,
+		const struct timer_wheel_entry *entry, uint64_t limit_ns)
+{
+	uint64_t now_ns;
+
+	while (timer_wheel_get_next_expiry(wheel, &now_ns) && now_ns <= limit_ns) {
+		struct timer_wheel_entry *expired;
+		bool found = false;
+
+		timer_wheel_advance(wheel, now_ns);
+		while ((expired = timer_wheel_pop_expired(wheel))) {
+			if (expired == entry) {
+				found = true;
+			}
+		}
+
+		if (found) {
+			return now_ns;
+		}
+	}
+
+	return UINT64_MAX;
+}
+
+static void test_single_timer(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry entry = {};
+	uint64_t next_ns = 0;
+
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	ok(!timer_wheel_get_next_expiry(&wheel, &next_ns),
+			"Empty wheel has no next expiry");
+
+	timer_wheel_add(&wheel, &entry, 10 * TICK_NS, noop_cb, 3 * TICK_NS);
+	ok(timer_wheel_get_next_expiry(&wheel, &next_ns) &&
+			next_ns == 10 * TICK_NS,
+			"First expiry is aligned on the period");
+	ok(!timer_wheel_advance(&wheel, 9 * TICK_NS),
+			"Timer does not expire before its expiry");
+	ok(timer_wheel_advance(&wheel, 10 * TICK_NS) &&
+			timer_wheel_pop_expired(&wheel) == &entry &&
+			!timer_wheel_pop_expired(&wheel),
+			"Timer expires once on its expiry");
+	ok(timer_wheel_get_next_expiry(&wheel, &next_ns) &&
+			next_ns == 20 * TICK_NS,
+			"Timer is re-armed for its next period");
+}
+
+static void test_coalescing(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry a = {}, b = {};
+	struct timer_wheel_entry *first, *second;
+
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	timer_wheel_add(&wheel, &a, 1000 * TICK_NS, noop_cb, 12 * TICK_NS);
+	timer_wheel_add(&wheel, &b, 1000 * TICK_NS, noop_cb, 567 * TICK_NS);
+
+	ok(timer_wheel_advance(&wheel, 1000 * TICK_NS),
+			"Timers sharing a period expire on the same tick");
+	first = timer_wheel_pop_expired(&wheel);
+	second = timer_wheel_pop_expired(&wheel);
+	ok(first && second && first != second &&
+			!timer_wheel_pop_expired(&wheel),
+			"Both timers are expired");
+}
+
+static void test_cascade(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry entry = {};
+	const uint64_t period_ns = 5000 * TICK_NS;
+
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	timer_wheel_add(&wheel, &entry, period_ns, noop_cb, 42 * TICK_NS);
+
+	ok(run_until_expiry(&wheel, &entry, UINT64_MAX) == period_ns,
+			"Higher level timer expires on time");
+	ok(run_until_expiry(&wheel, &entry, UINT64_MAX) == 2 * period_ns,
+			"Higher level timer expires on time on its second period");
+}
+
+static void test_beyond_range(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry entry = {};
+	/* Longer than the range of the wheel (64^4 ticks). */
+	const uint64_t period_ns = (UINT64_C(1) << 25) * TICK_NS + 3 * TICK_NS;
+
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	timer_wheel_add(&wheel, &entry, period_ns, noop_cb, 0);
+
+	ok(run_until_expiry(&wheel, &entry, UINT64_MAX) == period_ns,
+			"Timer beyond the range of the wheel expires on time");
+}
+
+static void test_remove(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry a = {}, b = {}, never_added = {};
+	uint64_t next_ns;
+
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	timer_wheel_add(&wheel, &a, 10 * TICK_NS, noop_cb, 0);
+	timer_wheel_add(&wheel, &b, 100 * TICK_NS, noop_cb, 0);
+
+	timer_wheel_remove(&wheel, &never_added);
+	timer_wheel_remove(&wheel, &a);
+	ok(a.state == TIMER_WHEEL_ENTRY_STATE_INACTIVE,
+			"Removed timer is inactive");
+	ok(timer_wheel_get_next_expiry(&wheel, &next_ns) &&
+			next_ns == 100 * TICK_NS,
+			"Removed timer does not affect the next expiry");
+	ok(run_until_expiry(&wheel, &a, 1000 * TICK_NS) == UINT64_MAX,
+			"Removed timer does not expire");
+
+	timer_wheel_add(&wheel, &a, 10 * TICK_NS, noop_cb, 1000 * TICK_NS);
+	ok(timer_wheel_advance(&wheel, 1010 * TICK_NS),
+			"Re-added timer expires");
+	timer_wheel_remove(&wheel, &a);
+	ok(!timer_wheel_pop_expired(&wheel),
+			"Expired timer can be removed before being popped");
+
+	timer_wheel_remove(&wheel, &b);
+	ok(!timer_wheel_get_next_expiry(&wheel, &next_ns),
+			"Wheel is empty once all timers are removed");
+}
+
+static void test_missed_expiries(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry entry = {};
+	uint64_t next_ns;
+
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	timer_wheel_add(&wheel, &entry, 10 * TICK_NS, noop_cb, 0);
+
+	ok(timer_wheel_advance(&wheel, 95 * TICK_NS) &&
+			timer_wheel_pop_expired(&wheel) == &entry &&
+			!timer_wheel_pop_expired(&wheel),
+			"Missed expiries are coalesced");
+	ok(timer_wheel_get_next_expiry(&wheel, &next_ns) &&
+			next_ns == 100 * TICK_NS,
+			"Timer is re-armed after the current time");
+}
+
+static void test_idle_catch_up(void)
+{
+	struct timer_wheel wheel;
+	struct timer_wheel_entry entry = {};
+	uint64_t next_ns;
+
+	/* An idle wheel is not advanced; adding a timer catches it up. */
+	timer_wheel_init(&wheel, TICK_NS, 0);
+	timer_wheel_add(&wheel, &entry, 10 * TICK_NS, noop_cb,
+			UINT64_C(86400000) * TICK_NS + 5 * TICK_NS);
+	ok(timer_wheel_get_next_expiry(&wheel, &next_ns) &&
+			next_ns == UINT64_C(86400000) * TICK_NS + 10 * TICK_NS,
+			"Timer added to an idle wheel expires relative to the current time");
+	ok(run_until_expiry(&wheel, &entry, UINT64_MAX) == next_ns,
+			"Timer added to an idle wheel expires on time");
+}
+
+int main(void)
+{
+	plan_tests(NUM_TESTS);
+
+	test_single_timer();
+	test_coalescing();
+	test_cascade();
+	test_beyond_range();
+	test_remove();
+	test_missed_expiries();
+	test_idle_catch_up();
+
+	return exit_status();
+}